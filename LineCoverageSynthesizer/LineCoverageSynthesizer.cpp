@@ -0,0 +1,90 @@
+#include "LineCoverageWriter.h"
+#include "ParallelMerge.h"
+#include "platform/Platform.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * Converts trace files to a line coverage report in Teamscale's SIMPLE format with the Portable PDBs of a symbol
+ * directory, like the upload daemon does, but with bounded memory so it can run on the profiled machine.
+ *
+ * Usage: LineCoverageSynthesizer.exe --symbols=<PDB directory> --out=<report> [--cache=<index directory>] [--threads=N]
+ *            <trace file or directory>...
+ *
+ * The traces are merged into one bitmap of covered methods per assembly first. The methods are then resolved with the
+ * symbol indices in the cache directory (see SymbolCache), which defaults to SymbolCache in the temp directory.
+ * Directories are expanded to the coverage_*.txt files they contain.
+ */
+
+/** Returns the value of the given integer option or the default value if the argument is not that option. */
+static int parseIntOption(const std::string& argument, const std::string& name, int defaultValue) {
+	std::string prefix = "--" + name + "=";
+	if (argument.compare(0, prefix.size(), prefix) != 0) {
+		return defaultValue;
+	}
+	return atoi(argument.substr(prefix.size()).c_str());
+}
+
+int main(int argc, char** argv) {
+	int threads = Platform::getProcessorCount();
+	std::string symbolDirectory;
+	std::string cacheDirectory = Platform::getTempDirectory() + "SymbolCache";
+	std::string outputPath;
+	std::vector<std::string> paths;
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		if (argument.compare(0, 2, "--") != 0) {
+			addTraceFiles(argument, paths);
+			continue;
+		}
+		threads = parseIntOption(argument, "threads", threads);
+		if (argument.compare(0, 10, "--symbols=") == 0) {
+			symbolDirectory = argument.substr(10);
+		}
+		if (argument.compare(0, 8, "--cache=") == 0) {
+			cacheDirectory = argument.substr(8);
+		}
+		if (argument.compare(0, 6, "--out=") == 0) {
+			outputPath = argument.substr(6);
+		}
+	}
+	if (symbolDirectory.empty() || outputPath.empty() || paths.empty()) {
+		fprintf(stderr, "Usage: LineCoverageSynthesizer --symbols=<PDB directory> --out=<report> [--cache=<index directory>] [--threads=N]\n");
+		fprintf(stderr, "           <trace file or directory>...\n");
+		return 2;
+	}
+
+	uint64_t start = Platform::getMonotonicMicroseconds();
+	std::vector<std::string> failedPaths;
+	TraceCoverage coverage = mergeTraceFiles(paths, threads, failedPaths);
+	for (const std::string& path : failedPaths) {
+		fprintf(stderr, "Could not read %s\n", path.c_str());
+	}
+
+	SymbolCache cache(cacheDirectory);
+	LineCoverageWriter writer(symbolDirectory, cache);
+	std::ofstream output(outputPath, std::ios::binary);
+	writer.write(coverage, threads, output);
+	output.close();
+	if (!output) {
+		fprintf(stderr, "Could not write %s\n", outputPath.c_str());
+		return 1;
+	}
+
+	for (const std::string& assembly : writer.getAssembliesWithoutSymbols()) {
+		printf("No Portable PDB for assembly %s in %s\n", assembly.c_str(), symbolDirectory.c_str());
+	}
+	double milliseconds = (Platform::getMonotonicMicroseconds() - start) / 1000.0;
+	printf("Resolved %zu methods of %zu trace files to %zu line ranges in %.1f ms. %zu methods have no lines\n",
+		writer.getResolvedMethodCount(), coverage.getTraceCount(), writer.getLineRangeCount(), milliseconds,
+		writer.getUnresolvedMethodCount());
+	printf("Built %zu and reused %zu symbol indices\n", cache.getBuiltCount(), cache.getReusedCount());
+	if (writer.getLineRangeCount() == 0) {
+		fprintf(stderr, "The traces cover no lines\n");
+		return 1;
+	}
+	return failedPaths.empty() ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+#include "LineCoverageWriter.h"
+#include "platform/Platform.h"
+#include "platform/Thread.h"
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <memory>
+
+/** Returns the given name in lower case, which only matters for ASCII in file names of PDBs. */
+static std::string toLowerCase(std::string name) {
+	for (char& character : name) {
+		character = static_cast<char>(tolower(static_cast<unsigned char>(character)));
+	}
+	return name;
+}
+
+LineCoverageWriter::LineCoverageWriter(const std::string& symbolDirectory, SymbolCache& cache) : cache(cache) {
+	for (const std::string& name : Platform::listFiles(symbolDirectory)) {
+		std::string lowerCaseName = toLowerCase(name);
+		if (lowerCaseName.size() > 4 && lowerCaseName.compare(lowerCaseName.size() - 4, 4, ".pdb") == 0) {
+			pdbPaths[lowerCaseName.substr(0, lowerCaseName.size() - 4)] = symbolDirectory + Platform::PATH_SEPARATOR + name;
+		}
+	}
+}
+
+void LineCoverageWriter::write(const TraceCoverage& coverage, int threadCount, std::ostream& output) {
+	output << "# isMethodAccurate=true\n";
+
+	// the report lists assemblies in a deterministic order
+	std::vector<size_t> assemblies;
+	for (size_t assembly = 0; assembly < coverage.getAssemblyCount(); assembly++) {
+		assemblies.push_back(assembly);
+	}
+	std::sort(assemblies.begin(), assemblies.end(), [&coverage](size_t first, size_t second) {
+		return coverage.getAssemblyName(first) < coverage.getAssemblyName(second);
+	});
+
+	// resolves one batch of assemblies per round, so at most threadCount parts of the report are in memory
+	size_t batchSize = static_cast<size_t>(std::max(threadCount, 1));
+	for (size_t batchStart = 0; batchStart < assemblies.size(); batchStart += batchSize) {
+		size_t batchEnd = std::min(batchStart + batchSize, assemblies.size());
+		std::vector<AssemblyJob> jobs(batchEnd - batchStart);
+		for (size_t i = 0; i < jobs.size(); i++) {
+			AssemblyJob& job = jobs[i];
+			job.writer = this;
+			job.coverage = &coverage;
+			job.assembly = assemblies[batchStart + i];
+			std::unordered_map<std::string, std::string>::iterator pdbPath = pdbPaths.find(toLowerCase(coverage.getAssemblyName(job.assembly)));
+			job.pdbPath = pdbPath == pdbPaths.end() ? "" : pdbPath->second;
+			job.hasSymbols = false;
+		}
+
+		// the calling thread resolves the first assembly of each batch
+		std::vector<std::unique_ptr<Thread>> threads;
+		for (size_t i = 1; i < jobs.size(); i++) {
+			threads.emplace_back(new Thread());
+			if (!threads.back()->start(resolveAssembly, &jobs[i])) {
+				threads.pop_back();
+				resolveAssembly(&jobs[i]);
+			}
+		}
+		resolveAssembly(&jobs[0]);
+		for (std::unique_ptr<Thread>& thread : threads) {
+			thread->join(Platform::INFINITE_WAIT);
+		}
+
+		for (AssemblyJob& job : jobs) {
+			if (!job.hasSymbols) {
+				assembliesWithoutSymbols.push_back(coverage.getAssemblyName(job.assembly));
+			}
+			output << job.report;
+		}
+	}
+}
+
+void LineCoverageWriter::resolveAssembly(void* parameter) {
+	AssemblyJob* job = static_cast<AssemblyJob*>(parameter);
+	LineCoverageWriter* writer = job->writer;
+	std::unique_ptr<SymbolIndexFile> index;
+	if (!job->pdbPath.empty()) {
+		index = writer->cache.getIndex(job->pdbPath);
+	}
+	if (index == NULL) {
+		return;
+	}
+	job->hasSymbols = true;
+
+	// documents are reported by name, which is what the ranges are sorted by
+	std::map<std::string, std::vector<LineRange>> lineRanges;
+	size_t unresolvedMethods = 0;
+	std::vector<uint32_t> methods = job->coverage->getMethods(job->assembly);
+	for (uint32_t token : methods) {
+		std::pair<const MethodLines*, const MethodLines*> ranges = index->find(token);
+		if (ranges.first == ranges.second) {
+			unresolvedMethods++;
+			continue;
+		}
+		for (const MethodLines* range = ranges.first; range != ranges.second; range++) {
+			lineRanges[index->getDocumentName(range->document)].push_back(LineRange(range->startLine, range->endLine));
+		}
+	}
+	writer->resolvedMethodCount += methods.size() - unresolvedMethods;
+	writer->unresolvedMethodCount += unresolvedMethods;
+
+	for (std::pair<const std::string, std::vector<LineRange>>& document : lineRanges) {
+		if (document.first.empty()) {
+			continue;
+		}
+		mergeLineRanges(document.second);
+		writer->lineRangeCount += document.second.size();
+		job->report += document.first + "\n";
+		for (const LineRange& range : document.second) {
+			job->report += std::to_string(range.first) + "-" + std::to_string(range.second) + "\n";
+		}
+	}
+}
+
+void LineCoverageWriter::mergeLineRanges(std::vector<LineRange>& ranges) {
+	std::sort(ranges.begin(), ranges.end());
+	size_t merged = 0;
+	for (size_t i = 1; i < ranges.size(); i++) {
+		if (ranges[i].first <= ranges[merged].second + 1) {
+			ranges[merged].second = std::max(ranges[merged].second, ranges[i].second);
+		}
+		else {
+			ranges[++merged] = ranges[i];
+		}
+	}
+	if (!ranges.empty()) {
+		ranges.resize(merged + 1);
+	}
+}
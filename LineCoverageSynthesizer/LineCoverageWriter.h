@@ -0,0 +1,79 @@
+#pragma once
+#include "SymbolCache.h"
+#include "TraceCoverage.h"
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * Converts method coverage to line coverage with the Portable PDBs of a symbol directory and writes it as a Teamscale
+ * SIMPLE report, like the upload daemon's LineCoverageSynthesizer.
+ *
+ * Assemblies are matched to PDBs by file name, ignoring case. Each assembly is resolved on its own, and its part of
+ * the report is written as soon as the assemblies before it are written, so memory only grows with the number of
+ * threads rather than with the size of the report. A source file that is compiled into several assemblies thus gets
+ * one section per assembly.
+ */
+class LineCoverageWriter
+{
+public:
+	/** A range of lines, both inclusive. */
+	typedef std::pair<uint32_t, uint32_t> LineRange;
+
+	/** Resolves methods with the Portable PDBs in the given directory, whose indices are kept in the given cache. */
+	LineCoverageWriter(const std::string& symbolDirectory, SymbolCache& cache);
+
+	/** Writes the report of the given coverage, resolving up to the given number of assemblies at once. */
+	void write(const TraceCoverage& coverage, int threadCount, std::ostream& output);
+
+	/** Sorts the given ranges and merges those that overlap or touch. */
+	static void mergeLineRanges(std::vector<LineRange>& ranges);
+
+	/** The number of methods that were resolved to lines. */
+	size_t getResolvedMethodCount() const {
+		return resolvedMethodCount;
+	}
+
+	/** The number of methods of assemblies with PDBs that have no lines in them, e.g. compiler-generated methods. */
+	size_t getUnresolvedMethodCount() const {
+		return unresolvedMethodCount;
+	}
+
+	/** The number of written line ranges. */
+	size_t getLineRangeCount() const {
+		return lineRangeCount;
+	}
+
+	/** The names of the assemblies that have no readable Portable PDB in the symbol directory. */
+	const std::vector<std::string>& getAssembliesWithoutSymbols() const {
+		return assembliesWithoutSymbols;
+	}
+
+private:
+	/** An assembly to resolve and the part of the report it results in. */
+	struct AssemblyJob {
+		LineCoverageWriter* writer;
+		const TraceCoverage* coverage;
+		size_t assembly;
+		std::string pdbPath;
+		std::string report;
+		bool hasSymbols;
+	};
+
+	SymbolCache& cache;
+
+	/** Maps lower-case assembly names to the paths of their PDBs. */
+	std::unordered_map<std::string, std::string> pdbPaths;
+
+	std::atomic<size_t> resolvedMethodCount{ 0 };
+	std::atomic<size_t> unresolvedMethodCount{ 0 };
+	std::atomic<size_t> lineRangeCount{ 0 };
+	std::vector<std::string> assembliesWithoutSymbols;
+
+	/** Resolves the assembly of the given job and writes its part of the report into it. */
+	static void resolveAssembly(void* parameter);
+};
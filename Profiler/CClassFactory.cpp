@@ -4,6 +4,8 @@
 
 #define ARRAY_LENGTH(s) (sizeof(s) / sizeof(s[0]))
 
+#ifdef _WIN32
+
 BOOL WINAPI DllMain(HINSTANCE hInstance, DWORD dwReason, LPVOID lpReserved) {
 	if (dwReason == DLL_PROCESS_ATTACH) {
 		// Save off the instance handle for later use.
@@ -81,6 +83,14 @@ STDAPI DllRegisterServer() {
 	return hr;
 }
 
+#else
+
+// On Windows, these come from uuid.lib
+extern "C" const IID IID_IUnknown = { 0x00000000, 0x0000, 0x0000, { 0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46 } };
+extern "C" const IID IID_IClassFactory = { 0x00000001, 0x0000, 0x0000, { 0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46 } };
+
+#endif
+
 /** Sets the class object for the profiler. */
 STDAPI DllGetClassObject(REFCLSID rclsid, REFIID riid, LPVOID FAR *ppv) {
 	HRESULT hr = CLASS_E_CLASSNOTAVAILABLE;
@@ -131,6 +141,8 @@ HRESULT CClassFactory::CreateInstance(IUnknown *pUnkOuter, REFIID riid,
 	return S_OK;
 }
 
+#ifdef _WIN32
+
 HRESULT RegisterClassBase(REFCLSID rclsid, const char *szDesc,
 	const char *szProgID, const char *szIndepProgID, char *szOutCLSID,
 	size_t nOutCLSIDLen) {
@@ -252,3 +264,5 @@ BOOL CreateRegistryKeyAndSetValue(const char *szKeyName, const char *szKeyword,
 
 	return FALSE;
 }
+
+#endif
@@ -1,8 +1,10 @@
 #ifndef _CClassFactory_H_
 #define _CClassFactory_H_
 
+#ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN // Exclude rarely-used stuff from Windows headers
 #include <windows.h>
+#endif
 
 /** Registers the class of the profiler by setting the registry entries. */
 HRESULT RegisterClassBase(REFCLSID rclsid, const char *szDesc,
@@ -90,7 +92,7 @@ public:
 
 private:
 	/** Counts the references to the COM interface of the ClassFactory. */
-	long referenceCount;
+	LONG referenceCount;
 };
 
 /** The CClassFactory instance. */
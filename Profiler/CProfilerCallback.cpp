@@ -1,15 +1,18 @@
 #include "CProfilerCallback.h"
 #include "version.h"
-#include "UploadDaemon.h"
+#include "platform/Platform.h"
 #include "utils/StringUtils.h"
-#include "utils/WindowsUtils.h"
 #include "utils/Debug.h"
+#include "config/ProcessSampling.h"
 #include <fstream>
 #include <algorithm>
+
+#ifdef _WIN32
 #include <winuser.h>
 
 #pragma comment(lib, "version.lib")
 #pragma intrinsic(strcmp,labs,strcpy,_rotl,memcmp,strlen,_rotr,memcpy,_lrotl,_strset,memset,_lrotr,abs,strcat)
+#endif
 
 /**
  * Serializes access to the singleton profiler instance when trying to shut it down.
@@ -18,9 +21,7 @@
 class ShutdownGuard {
 public:
 	ShutdownGuard() {
-		// we never delete this critical section. This is not needed as it's cleaned up on process
-		// death like any other memory
-		InitializeCriticalSection(&section);
+		// the mutex initializes itself
 	}
 
 	virtual ~ShutdownGuard() {}
@@ -35,16 +36,16 @@ public:
 	 * should be set only when calling from a CLR callback.
 	 */
 	void shutdownInstance(bool clrIsAvailable) {
-		EnterCriticalSection(&section);
+		section.lock();
 		if (instance != NULL) {
 			instance->ShutdownOnce(clrIsAvailable);
 			instance = NULL;
 		}
-		LeaveCriticalSection(&section);
+		section.unlock();
 	}
 
 private:
-	CRITICAL_SECTION section;
+	Mutex section;
 	CProfilerCallback* instance = NULL;
 };
 
@@ -60,7 +61,7 @@ void CProfilerCallback::ShutdownFromDllMainDetach() {
 
 CProfilerCallback::CProfilerCallback() {
 	try {
-		InitializeCriticalSection(&callbackSynchronization);
+		selectGenericJitHandlers();
 		getShutdownGuard().setInstance(this);
 	}
 	catch (...) {
@@ -73,7 +74,6 @@ CProfilerCallback::~CProfilerCallback() {
 		// make sure we flush to disk and disable access to this instance for other threads
 		// even if the .NET framework doesn't call Shutdown() itself
 		getShutdownGuard().shutdownInstance(false);
-		DeleteCriticalSection(&callbackSynchronization);
 	}
 	catch (...) {
 		handleException("Destructor");
@@ -96,13 +96,36 @@ HRESULT CProfilerCallback::InitializeImplementation(IUnknown* pICorProfilerInfoU
 	if (!config.isProfilingEnabled()) {
 		return S_OK;
 	}
+	Debug::getInstance().recordEvent("Initialize");
+
+	// Both logs are opened in the background and buffer everything until then, so a slow
+	// target directory does not delay the startup of the profiled application
+	unsigned long spoolTimeout = static_cast<unsigned long>(config.getSpoolTimeout());
 
 	// Place the attach log next to the config and profiler dll
 	std::string configPath = StringUtils::removeLastPartOfPath(config.getConfigPath());
-	attachLog.createLogFile(configPath);
+	attachLog.createLogFile(configPath, spoolTimeout);
 	attachLog.logAttach();
 
-	traceLog.createLogFile(config.getTargetDir());
+	double samplingRate = config.getSamplingRate();
+	if (samplingRate < 1) {
+		// Initialize runs while the runtime starts, so this is the start time of the process
+		Platform::UtcTime now;
+		Platform::getUtcTime(now);
+		char startTime[32];
+		snprintf(startTime, sizeof(startTime), "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ", now.year, now.month, now.day,
+			now.hour, now.minute, now.second, now.millisecond);
+		double draw = ProcessSampling::getDraw(Platform::getMachineName(), Platform::getProcessId(), startTime);
+		isSampledOut = !ProcessSampling::isSampled(draw, samplingRate);
+		attachLog.logSampling(startTime, samplingRate, draw, !isSampledOut);
+		if (isSampledOut) {
+			// Without an event mask, the runtime calls nothing but Shutdown, so the process runs as if it was not profiled.
+			// The attach log stays open until shutdown, so it is not abandoned to the spool if opening is slow
+			return S_OK;
+		}
+	}
+
+	traceLog.createLogFile(config.getTargetDir(), spoolTimeout);
 	traceLog.info("looking for configuration options in: " + config.getConfigPath());
 
 	for (std::string problem : config.getProblems()) {
@@ -118,42 +141,223 @@ HRESULT CProfilerCallback::InitializeImplementation(IUnknown* pICorProfilerInfoU
 
 	traceLog.info("Eagerness: " + std::to_string(config.getEagerness()));
 
+	if (samplingRate < 1) {
+		char rate[32];
+		snprintf(rate, sizeof(rate), "%g", samplingRate);
+		traceLog.info(std::string("Sampling rate: ") + rate);
+	}
+
+	if (config.shouldUseMvidKeys()) {
+		traceLog.info("Assembly numbers: by MVID");
+	}
+
+	std::string baselineDirectory = config.getCoverageBaseline();
+	if (!baselineDirectory.empty() && config.isTestwiseCoverageEnabled()) {
+		// previous runs would hide methods from the tests
+		traceLog.warn("The coverage baseline is not used with test-wise coverage");
+	}
+	else if (!baselineDirectory.empty()) {
+		if (coverageBaseline.open(baselineDirectory)) {
+			traceLog.info("Skipping methods already reported in the coverage baseline " + baselineDirectory);
+		}
+		else {
+			traceLog.error("Failed to open the coverage baseline " + baselineDirectory + ": " + Platform::getLastErrorMessage());
+		}
+	}
+
+#ifdef _WIN32
+	std::string sharedCoverageMapPath = config.getSharedCoverageMap();
+	if (!sharedCoverageMapPath.empty() && config.isTestwiseCoverageEnabled()) {
+		// other processes would hide methods from the tests
+		traceLog.warn("The shared coverage map is not used with test-wise coverage");
+	}
+	else if (!sharedCoverageMapPath.empty()) {
+		if (sharedCoverageMap.open(sharedCoverageMapPath)) {
+			traceLog.info("Skipping methods already reported in the shared coverage map " + sharedCoverageMapPath);
+		}
+		else {
+			traceLog.error("Failed to open the shared coverage map " + sharedCoverageMapPath + ": " + Platform::getLastErrorMessage());
+		}
+	}
+
+	if (config.isTestwiseCoverageEnabled()) {
+		if (testControlChannel.start([this](const std::string& testName) { switchTest(testName); })) {
+			traceLog.info("Test-wise coverage: listening for test markers on " + testControlChannel.getPipeName());
+		}
+		else {
+			traceLog.error("Failed to create the test control channel " + testControlChannel.getPipeName() + ": " + Platform::getLastErrorMessage());
+		}
+		// methods jitted before the first test are reported without a test
+		traceLog.logTestSegment("");
+	}
+	else if (config.shouldUseExecutionProbes()) {
+		traceLog.warn("Execution probes are only used with test-wise coverage");
+	}
+
 	if (config.shouldStartUploadDaemon()) {
 		traceLog.info("Starting upload deamon");
 		createDaemon().launch(traceLog);
 	}
+#else
+	warnAboutWindowsOnlyOptions();
+#endif
 
-	char appPool[BUFFER_SIZE];
-	if (GetEnvironmentVariable("APP_POOL_ID", appPool, sizeof(appPool))) {
-		std::string message = "IIS AppPool: ";
-		message += appPool;
-		traceLog.info(message);
+	std::string appPool = Platform::getEnvironmentVariable("APP_POOL_ID");
+	if (!appPool.empty()) {
+		traceLog.info("IIS AppPool: " + appPool);
 	}
 
-	std::string message = "Command Line: ";
-	message += GetCommandLine();
-	traceLog.info(message);
+	traceLog.info("Command Line: " + Platform::getCommandLine());
 
 	if (config.shouldDumpEnvironment()) {
 		dumpEnvironment();
 	}
 
-	HRESULT hr = pICorProfilerInfoUnkown->QueryInterface(IID_ICorProfilerInfo2, (LPVOID*)&profilerInfo);
-	if (FAILED(hr) || profilerInfo.p == NULL) {
+	HRESULT hr = profilerInfo.query(pICorProfilerInfoUnkown, IID_ICorProfilerInfo2);
+	if (FAILED(hr) || profilerInfo == NULL) {
 		return E_INVALIDARG;
 	}
 
+	if (config.shouldUseExecutionProbes() && config.isTestwiseCoverageEnabled()) {
+		startExecutionProbes(pICorProfilerInfoUnkown);
+	}
+
+	if (config.shouldRecordBlockCoverage()) {
+		blockCoverage.enable(profilerInfo);
+		traceLog.info("Block coverage: instrumenting jitted methods");
+	}
+
+#ifdef _WIN32
+	if (config.shouldCountCalls()) {
+		startCallCounting(pICorProfilerInfoUnkown);
+	}
+#endif
+
+	if (config.getJitCostMethods() > 0) {
+		jitCosts.enable(config.getJitCostMethods());
+		traceLog.info("Measuring JIT costs");
+	}
+
+	if (config.getOverheadBudget() > 0) {
+		governor.enable(config.getOverheadBudget());
+		traceLog.info("Overhead governor: degrading the recording above " + std::to_string(config.getOverheadBudget()) + "% overhead");
+	}
+
+#ifdef _WIN32
+	if (config.getSamplingInterval() > 0) {
+		if (stackSampler.start(profilerInfo, static_cast<DWORD>(config.getSamplingInterval()))) {
+			traceLog.info("Sampling stacks every " + std::to_string(config.getSamplingInterval()) + " ms");
+		}
+		else {
+			traceLog.error("Failed to start the stack sampler: " + Platform::getLastErrorMessage());
+		}
+	}
+#endif
+
+	if (config.shouldRecordEvents()) {
+		eventRecorder.createRecordingFile(config.getTargetDir(), spoolTimeout, profilerInfo);
+		traceLog.info("Recording callback events");
+	}
+
+	if (config.getStartupJitOrderSeconds() > 0) {
+		startupJitOrder.start(config.getTargetDir(), spoolTimeout, profilerInfo, static_cast<DWORD>(config.getStartupJitOrderSeconds()));
+		traceLog.info("Recording the startup JIT order for " + std::to_string(config.getStartupJitOrderSeconds()) + " s or until " + StartupJitOrder::getMarkerEventName() + " is signaled");
+	}
+
+	if (config.shouldWritePerfMap()) {
+		if (perfMap.start(profilerInfo, [this](FunctionID functionId) { return getFunctionName(functionId, true); })) {
+			traceLog.info("Writing the perf map " + PerfMap::getPath());
+		}
+		else {
+			traceLog.error("Failed to create the perf map " + PerfMap::getPath() + ": " + Platform::getLastErrorMessage());
+		}
+	}
+
+	// before the event mask, so no callback sees the switch
+	selectJitHandlers();
+
 	DWORD dwEventMask = getEventMask();
 	profilerInfo->SetEventMask(dwEventMask);
-	profilerInfo->SetFunctionIDMapper(functionMapper);
+	if (!isCountingCalls) {
+		profilerInfo->SetFunctionIDMapper(functionMapper);
+	}
 
-	traceLog.logProcess(WindowsUtils::getPathOfThisProcess());
+	traceLog.logProcess(Platform::getProcessPath());
 
 	return S_OK;
 }
 
+void CProfilerCallback::startExecutionProbes(IUnknown* pICorProfilerInfoUnkown) {
+	ComPtr<ICorProfilerInfo4> profilerInfo4;
+	if (FAILED(profilerInfo4.query(pICorProfilerInfoUnkown, IID_ICorProfilerInfo4))) {
+		traceLog.error("Execution probes require .NET Framework 4.5 or newer");
+		return;
+	}
+
+	if (executionProbes.start(profilerInfo4, [this](const std::vector<ProbedMethod>& methods) { recordExecutedMethods(methods); })) {
+		traceLog.info("Execution probes: re-jitting methods for each test");
+	}
+	else {
+		traceLog.error("Failed to start the execution probes: " + Platform::getLastErrorMessage());
+	}
+}
+
+#ifdef _WIN32
+void CProfilerCallback::startCallCounting(IUnknown* pICorProfilerInfoUnkown) {
+	ComPtr<ICorProfilerInfo3> profilerInfo3;
+	if (FAILED(profilerInfo3.query(pICorProfilerInfoUnkown, IID_ICorProfilerInfo3))) {
+		traceLog.error("Counting calls requires .NET Framework 4 or newer");
+		return;
+	}
+
+	std::string pattern = config.getCallCountingAssemblies();
+	try {
+		callCountingAssemblies = std::wregex(std::wstring(pattern.begin(), pattern.end()), std::regex::icase);
+	}
+	catch (std::regex_error&) {
+		traceLog.error("Invalid count_calls pattern: " + pattern);
+		return;
+	}
+
+	HRESULT hr = callCounter.installHook(profilerInfo3);
+	if (FAILED(hr)) {
+		traceLog.error("Failed to install the call counting hook");
+		return;
+	}
+	profilerInfo3->SetFunctionIDMapper2(functionMapper2, this);
+	isCountingCalls = true;
+	traceLog.info("Counting calls of methods in assemblies matching " + pattern);
+}
+
+UploadDaemon CProfilerCallback::createDaemon() {
+	std::string profilerPath = StringUtils::removeLastPartOfPath(Config::getValueFromEnvironment("PATH"));
+	return UploadDaemon(profilerPath);
+}
+#else
+void CProfilerCallback::warnAboutWindowsOnlyOptions() {
+	if (!config.getSharedCoverageMap().empty()) {
+		traceLog.warn("The shared coverage map is only supported on Windows");
+	}
+	if (config.isTestwiseCoverageEnabled()) {
+		traceLog.warn("Test-wise coverage is only supported on Windows");
+	}
+	if (config.shouldStartUploadDaemon()) {
+		traceLog.warn("The upload daemon is only supported on Windows");
+	}
+	if (config.shouldCountCalls()) {
+		traceLog.warn("Counting calls is only supported on Windows");
+	}
+	if (config.getSamplingInterval() > 0) {
+		traceLog.warn("Stack sampling is only supported on Windows");
+	}
+	if (config.shouldLogAssemblyFileVersion()) {
+		traceLog.warn("Assembly file versions are only supported on Windows");
+	}
+}
+#endif
+
 void CProfilerCallback::dumpEnvironment() {
-	std::vector<std::string> environmentVariables = WindowsUtils::listEnvironmentVariables();
+	std::vector<std::string> environmentVariables = Platform::listEnvironmentVariables();
 	if (environmentVariables.empty()) {
 		traceLog.error("Failed to list the environment variables");
 		return;
@@ -166,39 +370,132 @@ void CProfilerCallback::dumpEnvironment() {
 }
 
 void CProfilerCallback::initializeConfig() {
-	std::string configFile = WindowsUtils::getConfigValueFromEnvironment("CONFIG");
+	std::string configFile = Config::getValueFromEnvironment("CONFIG");
 
 	bool configFileWasManuallySpecified = !configFile.empty();
 	if (!configFileWasManuallySpecified) {
 		configFile = Config::getDefaultConfigPath();
 	}
 
-	config.load(configFile, WindowsUtils::getPathOfThisProcess(), configFileWasManuallySpecified);
-}
-
-UploadDaemon CProfilerCallback::createDaemon() {
-	std::string profilerPath = StringUtils::removeLastPartOfPath(WindowsUtils::getConfigValueFromEnvironment("PATH"));
-	return UploadDaemon(profilerPath);
+	config.load(configFile, Platform::getProcessPath(), configFileWasManuallySpecified);
 }
 
 void CProfilerCallback::ShutdownOnce(bool clrIsAvailable) {
 	if (!config.isProfilingEnabled()) {
 		return;
 	}
+	if (isSampledOut) {
+		// nothing but the attach log was opened
+		attachLog.logDetach();
+		attachLog.shutdown();
+		return;
+	}
 
-	EnterCriticalSection(&callbackSynchronization);
+#ifdef _WIN32
+	// Must happen before entering the callback lock, since the channel waits for a test switch in progress
+	testControlChannel.shutdown();
+#endif
+	if (executionProbes.isStarted()) {
+		// reports the hits since the last poll, which also needs the callback lock
+		executionProbes.shutdown();
+		executionProbes.collectHits();
+	}
+#ifdef _WIN32
+	stackSampler.shutdown();
+	if (config.getSamplingInterval() > 0) {
+		// resolving the function names is slow, so the callbacks are not blocked meanwhile
+		writeStacksToLog(clrIsAvailable);
+	}
+#endif
+
+	callbackSynchronization.lock();
 	writeFunctionInfosToLog();
+	writeCallCountsToLog(0);
+	if (jitCosts.isEnabled()) {
+		writeJitCostsToLog();
+	}
 	attachLog.logDetach();
 
+	bool isSkippingReportedMethods = coverageBaseline.isOpen();
+#ifdef _WIN32
+	if (sharedCoverageMap.isOpen()) {
+		isSkippingReportedMethods = true;
+		publishReportedMethods(0);
+		if (!unpublishedMethods.empty()) {
+			traceLog.warn("The trace file did not reach its target directory completely, so " + std::to_string(unpublishedMethods.size()) + " methods are not marked in the shared coverage map. They are reported again by other processes");
+		}
+		sharedCoverageMap.close();
+	}
+#endif
+	if (isSkippingReportedMethods) {
+		traceLog.info("Skipped " + std::to_string(skippedMethodCount) + " methods that were already reported");
+	}
+	if (coverageBaseline.isOpen() && !traceLog.flushToTarget()) {
+		// the reported methods are only safe once the trace file is where the upload picks it up
+		traceLog.warn("The trace file did not reach its target directory completely, so the coverage baseline is not updated. Its methods are reported again by the next run");
+	}
+	else if (coverageBaseline.isOpen()) {
+		size_t addedMethodCount = coverageBaseline.getAddedMethodCount();
+		size_t failedCount = 0;
+		size_t savedCount = coverageBaseline.save(failedCount);
+		traceLog.info("Coverage baseline: added " + std::to_string(addedMethodCount) + " methods to the baselines of " + std::to_string(savedCount) + " modules");
+		if (failedCount > 0) {
+			traceLog.warn("Failed to update the coverage baseline of " + std::to_string(failedCount) + " modules. Their methods are reported again by the next run");
+		}
+	}
+
+	if (governor.isEnabled()) {
+		traceLog.info("Overhead governor: " + std::to_string(governor.getLevelChangeCount()) + " level changes, highest level " +
+			std::to_string(governor.getHighestLevel()) + ", " + std::to_string(skippedInliningCount) + " inlinings not recorded");
+	}
+
+	if (blockCoverage.isEnabled()) {
+		traceLog.info("Block coverage: instrumented " + std::to_string(blockCoverage.getInstrumentedMethodCount()) + " methods, failed to instrument " + std::to_string(blockCoverage.getFailedMethodCount()));
+	}
+
+	if (perfMap.isStarted()) {
+		perfMap.shutdown();
+		traceLog.info("Perf map: wrote " + std::to_string(perfMap.getEntryCount()) + " code ranges");
+	}
+
+#ifdef _WIN32
+	if (isCountingCalls) {
+		traceLog.info("Call counting: counted calls of " + std::to_string(callCounter.getMethodCount()) + " methods");
+	}
+#endif
+
+	if (executionProbes.getFailedMethodCount() > 0) {
+		traceLog.info("Execution probes: " + std::to_string(executionProbes.getFailedMethodCount()) + " methods could not be probed and are only reported when jitted");
+	}
+
+	for (std::string line : statistics.createReport()) {
+		traceLog.info(line);
+	}
+
+	Debug& debug = Debug::getInstance();
+	debug.recordEvent("Shutdown");
+	if (debug.getErrorCount() > 0) {
+		traceLog.warn(std::to_string(debug.getErrorCount()) + " errors in the profiler. The most recent ones are written to the debug log profiler_debug." + std::to_string(Platform::getProcessId()) + ".log");
+		debug.dump();
+	}
+
 	traceLog.shutdown();
 	attachLog.shutdown();
+	if (config.shouldRecordEvents()) {
+		eventRecorder.shutdown();
+	}
+	if (config.getStartupJitOrderSeconds() > 0) {
+		startupJitOrder.shutdown();
+	}
+#ifdef _WIN32
 	if (config.shouldStartUploadDaemon()) {
 		createDaemon().notifyShutdown();
 	}
+#endif
 	if (clrIsAvailable) {
 		profilerInfo->ForceGC();
 	}
-	LeaveCriticalSection(&callbackSynchronization);
+	callbackSynchronization.unlock();
 }
 
 HRESULT CProfilerCallback::Shutdown() {
@@ -216,6 +513,20 @@ DWORD CProfilerCallback::getEventMask() {
 	dwEventMask |= COR_PRF_MONITOR_JIT_COMPILATION;
 	dwEventMask |= COR_PRF_MONITOR_ASSEMBLY_LOADS;
 
+	if (executionProbes.isStarted()) {
+		dwEventMask |= COR_PRF_ENABLE_REJIT;
+	}
+
+	if (isCountingCalls) {
+		dwEventMask |= COR_PRF_MONITOR_ENTERLEAVE;
+	}
+
+#ifdef _WIN32
+	if (stackSampler.isStarted()) {
+		dwEventMask |= COR_PRF_ENABLE_STACK_SNAPSHOT | COR_PRF_MONITOR_THREADS;
+	}
+#endif
+
 	// disable force re-jitting for the light variant
 	if (!config.shouldUseLightMode()) {
 		dwEventMask |= COR_PRF_DISABLE_ALL_NGEN_IMAGES;
@@ -233,12 +544,51 @@ UINT_PTR CProfilerCallback::functionMapper(FunctionID functionId, BOOL* pbHookFu
 		return functionId;
 	}
 	catch (...) {
-		Debug::getInstance().logErrorWithStracktrace("functionMapper");
+		Debug::getInstance().recordError("functionMapper");
 		// since this function must be static, we have no way to access the config so we always terminate the program.
+		Debug::getInstance().dump();
 		throw;
 	}
 }
 
+#ifdef _WIN32
+UINT_PTR CProfilerCallback::functionMapper2(FunctionID functionId, void* clientData, BOOL* pbHookFunction) {
+	CProfilerCallback* callback = static_cast<CProfilerCallback*>(clientData);
+	try {
+		return callback->mapCountedFunction(functionId, pbHookFunction);
+	}
+	catch (...) {
+		callback->handleException("functionMapper2");
+		*pbHookFunction = false;
+		return functionId;
+	}
+}
+
+UINT_PTR CProfilerCallback::mapCountedFunction(FunctionID functionId, BOOL* pbHookFunction) {
+	*pbHookFunction = false;
+
+	ModuleID moduleId = 0;
+	mdToken functionToken = 0;
+	HRESULT hr = profilerInfo->GetFunctionInfo2(functionId, 0, NULL, &moduleId, &functionToken, 0, NULL, NULL);
+	if (FAILED(hr)) {
+		return functionId;
+	}
+
+	int assemblyNumber = 0;
+	callbackSynchronization.lock();
+	hr = getAssemblyNumber(moduleId, &assemblyNumber);
+	bool isCounted = SUCCEEDED(hr) && countedAssemblies.find(assemblyNumber) != countedAssemblies.end();
+	callbackSynchronization.unlock();
+
+	UINT_PTR counterId = 0;
+	if (isCounted && callCounter.addMethod(assemblyNumber, functionToken, &counterId)) {
+		*pbHookFunction = true;
+		return counterId;
+	}
+	return functionId;
+}
+#endif
+
 HRESULT CProfilerCallback::AssemblyLoadFinished(AssemblyID assemblyId, HRESULT hrStatus) {
 	try {
 		return AssemblyLoadFinishedImplementation(assemblyId, hrStatus);
@@ -254,64 +604,156 @@ HRESULT CProfilerCallback::AssemblyLoadFinishedImplementation(AssemblyID assembl
 		return S_OK;
 	}
 
-	EnterCriticalSection(&callbackSynchronization);
-
-	int assemblyNumber = registerAssembly(assemblyId);
-
-	char assemblyInfo[BUFFER_SIZE];
-	int writtenChars = 0;
+	unsigned __int64 startCycles = CallbackStatistics::now();
+	unsigned __int64 lockWaitCycles = enterCallbackLock();
 
 	WCHAR assemblyName[BUFFER_SIZE];
 	WCHAR assemblyPath[BUFFER_SIZE];
 	ASSEMBLYMETADATA metadata;
-	getAssemblyInfo(assemblyId, assemblyName, assemblyPath, &metadata);
+	ModuleID moduleId = 0;
+	getAssemblyInfo(assemblyId, assemblyName, assemblyPath, &metadata, &moduleId);
+
+	// The MVID identifies the module across processes, unlike the assembly number
+	GUID mvidGuid;
+	std::string mvid;
+	bool hasMvid = getModuleVersionId(moduleId, &mvidGuid);
+	if (hasMvid) {
+		mvid = StringUtils::formatGuid(mvidGuid);
+	}
 
-	LeaveCriticalSection(&callbackSynchronization);
+	bool isNewAssembly = true;
+	int assemblyNumber = registerAssembly(assemblyId, moduleId, mvid, &isNewAssembly);
+
+	if (isNewAssembly && hasMvid && coverageBaseline.isOpen()) {
+		coverageBaseline.addAssembly(assemblyNumber, mvid, getMethodCount(moduleId));
+	}
+
+	if (executionProbes.isStarted()) {
+		executionProbes.registerModule(moduleId, getMethodCount(moduleId));
+	}
+
+#ifdef _WIN32
+	if (isCountingCalls && std::regex_match(assemblyName, callCountingAssemblies)) {
+		countedAssemblies.insert(assemblyNumber);
+	}
+
+	if (isNewAssembly && hasMvid && sharedCoverageMap.isOpen()) {
+		sharedBitmaps[assemblyNumber] = sharedCoverageMap.getBitmap(mvidGuid, getMethodCount(moduleId));
+	}
+#endif
+
+	if (config.shouldRecordEvents()) {
+		eventRecorder.recordAssemblyLoad(assemblyId, assemblyName, assemblyPath, metadata);
+	}
+
+	callbackSynchronization.unlock();
+
+	if (!isNewAssembly) {
+		// the module was already logged under its MVID
+		statistics.recordCall(CALLBACK_ASSEMBLY_LOAD, startCycles, lockWaitCycles);
+		return S_OK;
+	}
 
 	// Log assembly load.
-	writtenChars += sprintf_s(assemblyInfo + writtenChars, BUFFER_SIZE - writtenChars, "%S:%i",
-		assemblyName, assemblyNumber);
+	std::string assemblyInfo = StringUtils::narrow(assemblyName) + ":" + std::to_string(assemblyNumber);
 
-	writtenChars += sprintf_s(assemblyInfo + writtenChars, BUFFER_SIZE - writtenChars, " Version:%i.%i.%i.%i",
+	char version[BUFFER_SIZE];
+	snprintf(version, sizeof(version), " Version:%i.%i.%i.%i",
 		metadata.usMajorVersion, metadata.usMinorVersion, metadata.usBuildNumber, metadata.usRevisionNumber);
+	assemblyInfo += version;
+
+	if (!mvid.empty()) {
+		assemblyInfo += " Mvid:" + mvid;
+	}
 
+#ifdef _WIN32
 	if (config.shouldLogAssemblyFileVersion()) {
-		writtenChars += writeFileVersionInfo(assemblyPath, assemblyInfo + writtenChars, BUFFER_SIZE - writtenChars);
+		char fileVersion[BUFFER_SIZE];
+		if (writeFileVersionInfo(assemblyPath, fileVersion, sizeof(fileVersion)) > 0) {
+			assemblyInfo += fileVersion;
+		}
 	}
+#endif
 
 	if (config.shouldLogAssemblyPaths()) {
-		writtenChars += sprintf_s(assemblyInfo + writtenChars, BUFFER_SIZE - writtenChars, " Path:%S", assemblyPath);
+		assemblyInfo += " Path:" + StringUtils::narrow(assemblyPath);
 	}
 	traceLog.logAssembly(assemblyInfo);
+	statistics.recordCall(CALLBACK_ASSEMBLY_LOAD, startCycles, lockWaitCycles);
 
 	// Always return OK
 	return S_OK;
 }
 
-int CProfilerCallback::registerAssembly(AssemblyID assemblyId) {
+int CProfilerCallback::registerAssembly(AssemblyID assemblyId, ModuleID moduleId, std::string mvid, bool* isNewAssembly) {
+	bool numberByMvid = config.shouldUseMvidKeys() && !mvid.empty();
+	if (numberByMvid) {
+		std::map<std::string, int>::iterator knownMvid = mvidMap.find(mvid);
+		if (knownMvid != mvidMap.end()) {
+			assemblyMap[assemblyId] = knownMvid->second;
+			moduleMap[moduleId] = knownMvid->second;
+			*isNewAssembly = false;
+			return knownMvid->second;
+		}
+	}
+
 	int assemblyNumber = assemblyCounter;
 	assemblyCounter++;
 	assemblyMap[assemblyId] = assemblyNumber;
+	moduleMap[moduleId] = assemblyNumber;
+	if (numberByMvid) {
+		mvidMap[mvid] = assemblyNumber;
+	}
+	*isNewAssembly = true;
 	return assemblyNumber;
 }
 
-void CProfilerCallback::getAssemblyInfo(AssemblyID assemblyId, WCHAR *assemblyName, WCHAR *assemblyPath, ASSEMBLYMETADATA *metadata) {
+bool CProfilerCallback::getModuleVersionId(ModuleID moduleId, GUID* mvid) {
+	IMetaDataImport* metaDataImport = NULL;
+	HRESULT hr = profilerInfo->GetModuleMetaData(moduleId, ofRead, IID_IMetaDataImport, (IUnknown**)&metaDataImport);
+	if (FAILED(hr) || metaDataImport == NULL) {
+		return false;
+	}
+
+	hr = metaDataImport->GetScopeProps(NULL, 0, NULL, mvid);
+	metaDataImport->Release();
+	return SUCCEEDED(hr);
+}
+
+ULONG CProfilerCallback::getMethodCount(ModuleID moduleId) {
+	IMetaDataTables* metaDataTables = NULL;
+	HRESULT hr = profilerInfo->GetModuleMetaData(moduleId, ofRead, IID_IMetaDataTables, (IUnknown**)&metaDataTables);
+	if (FAILED(hr) || metaDataTables == NULL) {
+		return 0;
+	}
+
+	// The MethodDef table has index 6 (ECMA-335, II.22.26)
+	ULONG rowSize = 0, rowCount = 0, columnCount = 0, keyColumn = 0;
+	const char* tableName = NULL;
+	hr = metaDataTables->GetTableInfo(0x06, &rowSize, &rowCount, &columnCount, &keyColumn, &tableName);
+	metaDataTables->Release();
+	if (FAILED(hr)) {
+		return 0;
+	}
+	return rowCount;
+}
+
+void CProfilerCallback::getAssemblyInfo(AssemblyID assemblyId, WCHAR *assemblyName, WCHAR *assemblyPath, ASSEMBLYMETADATA *metadata, ModuleID* moduleId) {
 	ULONG assemblyNameSize = 0;
 	AppDomainID appDomainId = 0;
-	ModuleID moduleId = 0;
 	profilerInfo->GetAssemblyInfo(assemblyId, BUFFER_SIZE,
-		&assemblyNameSize, assemblyName, &appDomainId, &moduleId);
+		&assemblyNameSize, assemblyName, &appDomainId, moduleId);
 
 	// We need the module info to get the path of the assembly
 	LPCBYTE baseLoadAddress;
 	ULONG assemblyPathSize = 0;
 	AssemblyID parentAssembly;
-	profilerInfo->GetModuleInfo(moduleId, &baseLoadAddress, BUFFER_SIZE,
+	profilerInfo->GetModuleInfo(*moduleId, &baseLoadAddress, BUFFER_SIZE,
 		&assemblyPathSize, assemblyPath, &parentAssembly);
 
 	// Call GetModuleMetaData to get a MetaDataAssemblyImport object.
 	IMetaDataAssemblyImport* pMetaDataAssemblyImport = NULL;
-	profilerInfo->GetModuleMetaData(moduleId, ofRead,
+	profilerInfo->GetModuleMetaData(*moduleId, ofRead,
 		IID_IMetaDataAssemblyImport, (IUnknown**)&pMetaDataAssemblyImport);
 
 	// Get the assembly token.
@@ -338,6 +780,46 @@ void CProfilerCallback::getAssemblyInfo(AssemblyID assemblyId, WCHAR *assemblyNa
 		NULL, 0, NULL, metadata, NULL);
 }
 
+HRESULT CProfilerCallback::JITCompilationStarted(FunctionID functionId, BOOL fIsSafeToBlock) {
+	try {
+		return JITCompilationStartedImplementation(functionId, fIsSafeToBlock);
+	}
+	catch (...) {
+		handleException("JITCompilationStarted");
+		return S_OK;
+	}
+}
+
+HRESULT CProfilerCallback::JITCompilationStartedImplementation(FunctionID functionId, BOOL fIsSafeToBlock) {
+	if (config.isProfilingEnabled() && blockCoverage.isEnabled()) {
+		instrumentBlocks(functionId);
+	}
+	if (config.isProfilingEnabled() && jitCosts.isEnabled() && governor.shouldRecordDiagnostics()) {
+		// after instrumenting, so only the JIT itself is measured
+		jitCosts.recordStart(functionId, CallbackStatistics::now());
+	}
+	return S_OK;
+}
+
+void CProfilerCallback::instrumentBlocks(FunctionID functionId) {
+	ModuleID moduleId = 0;
+	mdToken functionToken = 0;
+	HRESULT hr = profilerInfo->GetFunctionInfo2(functionId, 0, NULL, &moduleId, &functionToken, 0, NULL, NULL);
+	if (FAILED(hr) || moduleId == 0) {
+		return;
+	}
+
+	int assemblyNumber = 0;
+	callbackSynchronization.lock();
+	hr = getAssemblyNumber(moduleId, &assemblyNumber);
+	callbackSynchronization.unlock();
+
+	// Instrumenting outside of the callback lock keeps other JIT callbacks from waiting for it
+	if (SUCCEEDED(hr)) {
+		blockCoverage.instrument(moduleId, functionToken, assemblyNumber);
+	}
+}
+
 HRESULT CProfilerCallback::JITCompilationFinished(FunctionID functionId,
 	HRESULT hrStatus, BOOL fIsSafeToBlock) {
 	try {
@@ -350,20 +832,117 @@ HRESULT CProfilerCallback::JITCompilationFinished(FunctionID functionId,
 }
 
 void CProfilerCallback::handleException(std::string context) {
-	Debug::getInstance().logErrorWithStracktrace(context);
+	// cheap enough for error storms, the stack is only symbolized when the recorder is dumped
+	Debug::getInstance().recordError(context);
 	if (!config.shouldIgnoreExceptions()) {
+		// the exception most likely terminates the process
+		Debug::getInstance().dump();
 		throw;
 	}
 }
 
 HRESULT CProfilerCallback::JITCompilationFinishedImplementation(FunctionID functionId,
 	HRESULT hrStatus, BOOL fIsSafeToBlock) {
-	if (config.isProfilingEnabled()) {
-		EnterCriticalSection(&callbackSynchronization);
+	(this->*jitCompilationHandler)(functionId, hrStatus);
+	return S_OK;
+}
+
+template<CProfilerCallback::HotPathMode eager, CProfilerCallback::HotPathMode filtered, CProfilerCallback::HotPathMode extras>
+void CProfilerCallback::handleJitCompilation(FunctionID functionId, HRESULT hrStatus) {
+	// the specialized implementations are only selected if profiling is enabled
+	if (extras == MODE_RUNTIME && !config.isProfilingEnabled()) {
+		return;
+	}
+	if (extras != MODE_OFF) {
+		recordJitCompilationExtras(functionId, hrStatus);
+	}
 
-		recordFunctionInfo(&jittedMethods, functionId);
+	unsigned __int64 startCycles = CallbackStatistics::now();
+	unsigned __int64 lockWaitCycles = enterCallbackLock();
+
+	if (extras != MODE_OFF && config.shouldRecordEvents()) {
+		eventRecorder.recordJitCompilation(functionId);
+	}
+
+	FunctionInfo info;
+	ModuleID moduleId = 0;
+	getFunctionInfo(functionId, &info, &moduleId);
+	recordFunctionInfo<eager, filtered>(&jittedMethods, info);
+	if (extras != MODE_OFF) {
+		if (executionProbes.isStarted()) {
+			executionProbes.registerMethod(moduleId, info.functionToken);
+		}
+		updateGovernor(startCycles, true);
+	}
+
+	callbackSynchronization.unlock();
+	statistics.recordCall(CALLBACK_JIT_COMPILATION, startCycles, lockWaitCycles);
+}
+
+void CProfilerCallback::recordJitCompilationExtras(FunctionID functionId, HRESULT hrStatus) {
+	if (jitCosts.isEnabled() && jitCosts.isStarted(functionId)) {
+		// whenever the start was recorded, even if the governor suspended diagnostics since then
+		recordJitCost(functionId, CallbackStatistics::now());
+	}
+	if (startupJitOrder.isRecording() && SUCCEEDED(hrStatus)) {
+		if (governor.shouldRecordDiagnostics()) {
+			startupJitOrder.recordJitCompilation(functionId);
+		}
+		else {
+			startupJitOrder.recordSkippedCompilation();
+		}
+	}
+	if (perfMap.isStarted() && SUCCEEDED(hrStatus)) {
+		perfMap.recordJitCompilation(functionId);
+	}
+#ifdef _WIN32
+	if (config.getSamplingInterval() > 0) {
+		// lock-free, so it does not need the callback lock
+		stackSampler.registerCode(functionId);
+	}
+#endif
+}
+
+HRESULT CProfilerCallback::ThreadCreated(ThreadID threadId) {
+	try {
+#ifdef _WIN32
+		stackSampler.addThread(threadId);
+#endif
+	}
+	catch (...) {
+		handleException("ThreadCreated");
+	}
+	return S_OK;
+}
+
+HRESULT CProfilerCallback::ThreadDestroyed(ThreadID threadId) {
+	try {
+#ifdef _WIN32
+		stackSampler.removeThread(threadId);
+#endif
+	}
+	catch (...) {
+		handleException("ThreadDestroyed");
+	}
+	return S_OK;
+}
+
+HRESULT CProfilerCallback::GetReJITParameters(ModuleID moduleId, mdMethodDef methodId, ICorProfilerFunctionControl* pFunctionControl) {
+	try {
+		return executionProbes.instrument(moduleId, methodId, pFunctionControl);
+	}
+	catch (...) {
+		handleException("GetReJITParameters");
+		return S_OK;
+	}
+}
 
-		LeaveCriticalSection(&callbackSynchronization);
+HRESULT CProfilerCallback::ReJITError(ModuleID moduleId, mdMethodDef methodId, FunctionID functionId, HRESULT hrStatus) {
+	try {
+		executionProbes.handleError(moduleId, methodId);
+	}
+	catch (...) {
+		handleException("ReJITError");
 	}
 	return S_OK;
 }
@@ -381,16 +960,7 @@ HRESULT CProfilerCallback::JITInlining(FunctionID callerId, FunctionID calleeId,
 
 HRESULT CProfilerCallback::JITInliningImplementation(FunctionID callerId, FunctionID calleeId,
 	BOOL* pfShouldInline) {
-	if (config.isProfilingEnabled()) {
-		// Save information about inlined method (if not already seen)
-		EnterCriticalSection(&callbackSynchronization);
-
-		if (inlinedMethodIds.insert(calleeId).second == true) {
-			recordFunctionInfo(&inlinedMethods, calleeId);
-		}
-
-		LeaveCriticalSection(&callbackSynchronization);
-	}
+	(this->*jitInliningHandler)(callerId, calleeId);
 
 	// Always allow inlining.
 	*pfShouldInline = true;
@@ -398,50 +968,425 @@ HRESULT CProfilerCallback::JITInliningImplementation(FunctionID callerId, Functi
 	return S_OK;
 }
 
-void CProfilerCallback::recordFunctionInfo(std::vector<FunctionInfo>* recordedFunctionInfos, FunctionID calleeId) {
-	// Must be called from synchronized context
+template<CProfilerCallback::HotPathMode eager, CProfilerCallback::HotPathMode filtered, CProfilerCallback::HotPathMode extras>
+void CProfilerCallback::handleJitInlining(FunctionID callerId, FunctionID calleeId) {
+	if (extras == MODE_RUNTIME && !config.isProfilingEnabled()) {
+		return;
+	}
+	if (extras != MODE_OFF) {
+		if (blockCoverage.isEnabled()) {
+			// the JIT reads the IL of the inlined method after this callback
+			instrumentBlocks(calleeId);
+		}
+		if (!governor.shouldRecordInlining()) {
+			// does not even take the callback lock
+			InterlockedIncrement64(&skippedInliningCount);
+			return;
+		}
+	}
 
-	FunctionInfo info;
-	getFunctionInfo(calleeId, &info);
+	// Save information about inlined method (if not already seen)
+	unsigned __int64 startCycles = CallbackStatistics::now();
+	unsigned __int64 lockWaitCycles = enterCallbackLock();
+
+	if (extras != MODE_OFF && config.shouldRecordEvents()) {
+		eventRecorder.recordInlining(callerId, calleeId);
+	}
+	if (inlinedMethodIds.insert(calleeId).second == true) {
+		FunctionInfo info;
+		ModuleID moduleId = 0;
+		getFunctionInfo(calleeId, &info, &moduleId);
+		recordFunctionInfo<eager, filtered>(&inlinedMethods, info);
+	}
+	if (extras != MODE_OFF) {
+		updateGovernor(startCycles, false);
+	}
+
+	callbackSynchronization.unlock();
+	statistics.recordCall(CALLBACK_JIT_INLINING, startCycles, lockWaitCycles);
+}
+
+template<CProfilerCallback::HotPathMode eager, CProfilerCallback::HotPathMode filtered>
+void CProfilerCallback::recordFunctionInfo(std::vector<FunctionInfo>* recordedFunctionInfos, FunctionInfo& info) {
+	// Must be called from synchronized context
+	if (filtered != MODE_OFF && isAlreadyReported(info)) {
+		skippedMethodCount++;
+		return;
+	}
 
 	recordedFunctionInfos->push_back(info);
+	statistics.recordPendingSizes(jittedMethods.size(), inlinedMethods.size());
 
-	if (shouldWriteEagerly()) {
+	bool shouldWrite = false;
+	if (eager == MODE_RUNTIME) {
+		shouldWrite = shouldWriteEagerly();
+	}
+	else if (eager == MODE_ON) {
+		shouldWrite = inlinedMethods.size() + jittedMethods.size() >= eagerWriteThreshold * governor.getFlushFactor();
+	}
+	if (shouldWrite) {
 		writeFunctionInfosToLog();
 	}
 }
 
+template<CProfilerCallback::HotPathMode eager, CProfilerCallback::HotPathMode filtered>
+void CProfilerCallback::selectJitHandlers(bool hasJitCompilationExtras, bool hasJitInliningExtras) {
+	if (hasJitCompilationExtras) {
+		jitCompilationHandler = &CProfilerCallback::handleJitCompilation<eager, filtered, MODE_ON>;
+	}
+	else {
+		jitCompilationHandler = &CProfilerCallback::handleJitCompilation<eager, filtered, MODE_OFF>;
+	}
+	if (hasJitInliningExtras) {
+		jitInliningHandler = &CProfilerCallback::handleJitInlining<eager, filtered, MODE_ON>;
+	}
+	else {
+		jitInliningHandler = &CProfilerCallback::handleJitInlining<eager, filtered, MODE_OFF>;
+	}
+}
+
+void CProfilerCallback::selectJitHandlers() {
+	// In test-wise mode, only switchTest writes methods so they end up in the segment of the right test
+	bool isEager = config.getEagerness() > 0 && !config.isTestwiseCoverageEnabled();
+	eagerWriteThreshold = config.getEagerness();
+	bool isFiltered = coverageBaseline.isOpen();
+#ifdef _WIN32
+	isFiltered = isFiltered || sharedCoverageMap.isOpen();
+#endif
+
+	bool hasJitCompilationExtras = jitCosts.isEnabled() || config.getStartupJitOrderSeconds() > 0 || perfMap.isStarted() ||
+		config.shouldRecordEvents() || executionProbes.isStarted() || governor.isEnabled();
+#ifdef _WIN32
+	hasJitCompilationExtras = hasJitCompilationExtras || config.getSamplingInterval() > 0;
+#endif
+	bool hasJitInliningExtras = blockCoverage.isEnabled() || config.shouldRecordEvents() || governor.isEnabled();
+
+	if (isEager && isFiltered) {
+		selectJitHandlers<MODE_ON, MODE_ON>(hasJitCompilationExtras, hasJitInliningExtras);
+	}
+	else if (isEager) {
+		selectJitHandlers<MODE_ON, MODE_OFF>(hasJitCompilationExtras, hasJitInliningExtras);
+	}
+	else if (isFiltered) {
+		selectJitHandlers<MODE_OFF, MODE_ON>(hasJitCompilationExtras, hasJitInliningExtras);
+	}
+	else {
+		selectJitHandlers<MODE_OFF, MODE_OFF>(hasJitCompilationExtras, hasJitInliningExtras);
+	}
+
+	traceLog.info(std::string("JIT callbacks: ") + (isEager ? "eager" : "batched") + " writes, " +
+		(isFiltered ? "filtered" : "unfiltered") + ", extras " + (hasJitCompilationExtras ? "on" : "off") + " for compilations and " +
+		(hasJitInliningExtras ? "on" : "off") + " for inlinings");
+}
+
+void CProfilerCallback::selectGenericJitHandlers() {
+	jitCompilationHandler = &CProfilerCallback::handleJitCompilation<MODE_RUNTIME, MODE_RUNTIME, MODE_RUNTIME>;
+	jitInliningHandler = &CProfilerCallback::handleJitInlining<MODE_RUNTIME, MODE_RUNTIME, MODE_RUNTIME>;
+}
+
 inline bool CProfilerCallback::shouldWriteEagerly() {
 	// Must be called from synchronized context
-	return config.getEagerness() > 0 && static_cast<int>(inlinedMethods.size() + jittedMethods.size()) >= config.getEagerness();
+	// In test-wise mode, only switchTest writes methods so they end up in the segment of the right test
+	return config.getEagerness() > 0 && !config.isTestwiseCoverageEnabled() && inlinedMethods.size() + jittedMethods.size() >= config.getEagerness() * governor.getFlushFactor();
+}
+
+void CProfilerCallback::updateGovernor(unsigned __int64 startCycles, bool isJitCompilation) {
+	// Must be called from synchronized context
+	if (!governor.isEnabled()) {
+		return;
+	}
+	unsigned __int64 now = CallbackStatistics::now();
+	if (governor.recordCallback(now - startCycles, isJitCompilation, now, Platform::getMonotonicMicroseconds())) {
+		std::string state = "Overhead governor: " + governor.describe();
+		traceLog.info(state);
+		Debug::getInstance().recordEvent(state);
+	}
+}
+
+unsigned __int64 CProfilerCallback::enterCallbackLock() {
+	unsigned __int64 waitStart = CallbackStatistics::now();
+	callbackSynchronization.lock();
+	return CallbackStatistics::now() - waitStart;
+}
+
+void CProfilerCallback::switchTest(std::string testName) {
+	if (executionProbes.isStarted()) {
+		// probes hit so far belong to the finished test
+		executionProbes.collectHits();
+	}
+
+	Debug::getInstance().recordEvent("Test " + testName);
+
+	// Swapping the buffers is constant time, so the callbacks are only blocked for a moment
+	callbackSynchronization.lock();
+	jittedMethods.swap(finishedTestJittedMethods);
+	inlinedMethods.swap(finishedTestInlinedMethods);
+	currentTestName = testName;
+	if (executionProbes.isStarted()) {
+		// re-jitted callers report the methods they inline again
+		inlinedMethodIds.clear();
+	}
+	callbackSynchronization.unlock();
+
+	// The segment of the finished test was started when it began. All other writes of methods
+	// happen in this thread or at shutdown, after this thread has stopped
+	traceLog.writeInlinedFunctionInfosToLog(&finishedTestInlinedMethods);
+	finishedTestInlinedMethods.clear();
+
+	traceLog.writeJittedFunctionInfosToLog(&finishedTestJittedMethods);
+	finishedTestJittedMethods.clear();
+	writeBlockCoverageToLog();
+	writeCallCountsToLog(0);
+
+	traceLog.logTestSegment(testName);
+
+	if (executionProbes.isStarted()) {
+		// all methods jitted so far report their next execution in the new test
+		HRESULT hr = executionProbes.arm();
+		if (FAILED(hr)) {
+			char message[BUFFER_SIZE];
+			snprintf(message, sizeof(message), "Failed to re-jit methods for execution probes: 0x%08lx", static_cast<unsigned long>(hr));
+			traceLog.warn(message);
+		}
+	}
+}
+
+void CProfilerCallback::recordExecutedMethods(const std::vector<ProbedMethod>& methods) {
+	callbackSynchronization.lock();
+	for (const ProbedMethod& method : methods) {
+		FunctionInfo info;
+		info.functionToken = method.methodToken;
+		if (SUCCEEDED(getAssemblyNumber(method.moduleId, &info.assemblyNumber))) {
+			jittedMethods.push_back(info);
+		}
+	}
+	callbackSynchronization.unlock();
 }
 
 void CProfilerCallback::writeFunctionInfosToLog() {
 	// Must be called from synchronized context
+	unsigned __int64 startCycles = CallbackStatistics::now();
+	size_t functionCount = inlinedMethods.size() + jittedMethods.size();
+
 	traceLog.writeInlinedFunctionInfosToLog(&inlinedMethods);
+	markAsReported(inlinedMethods);
 	inlinedMethods.clear();
 
 	traceLog.writeJittedFunctionInfosToLog(&jittedMethods);
+	markAsReported(jittedMethods);
 	jittedMethods.clear();
+
+	writeBlockCoverageToLog();
+	writeCallCountsToLog(CALL_COUNT_FLUSH_INTERVAL_MICROS);
+
+#ifdef _WIN32
+	publishReportedMethods(SHARED_COVERAGE_MAP_FLUSH_INTERVAL);
+	sharedCoverageMap.flush(SHARED_COVERAGE_MAP_FLUSH_INTERVAL);
+#endif
+
+	statistics.recordFlush(CallbackStatistics::now() - startCycles, functionCount);
 }
 
-HRESULT CProfilerCallback::getFunctionInfo(FunctionID functionId, FunctionInfo* info) {
+void CProfilerCallback::writeBlockCoverageToLog() {
+	if (!blockCoverage.isEnabled()) {
+		return;
+	}
+
+	std::vector<std::string> offsetLines;
+	std::vector<std::string> hitLines;
+	blockCoverage.collectNewHits(offsetLines, hitLines);
+	for (std::string& line : offsetLines) {
+		traceLog.logBlockOffsets(line);
+	}
+	for (std::string& line : hitLines) {
+		traceLog.logBlocks(line);
+	}
+}
+
+void CProfilerCallback::writeCallCountsToLog(ULONGLONG minimumIntervalMicros) {
+	if (!isCountingCalls) {
+		return;
+	}
+
+	ULONGLONG now = Platform::getMonotonicMicroseconds();
+	if (now - lastCallCountFlushMicros < minimumIntervalMicros) {
+		return;
+	}
+	lastCallCountFlushMicros = now;
+
+#ifdef _WIN32
+	std::vector<std::string> lines;
+	callCounter.collectCalls(lines);
+	for (std::string& line : lines) {
+		traceLog.logCalls(line);
+	}
+#endif
+}
+
+void CProfilerCallback::recordJitCost(FunctionID functionId, unsigned __int64 finishCycles) {
 	ModuleID moduleId = 0;
-	HRESULT hr = profilerInfo->GetFunctionInfo2(functionId, 0,
-		NULL, &moduleId, &info->functionToken, 0, NULL, NULL);
-
-	if (SUCCEEDED(hr) && moduleId != 0) {
-		AssemblyID assemblyId;
-		hr = profilerInfo->GetModuleInfo(moduleId, NULL, NULL,
-			NULL, NULL, &assemblyId);
-		if (SUCCEEDED(hr)) {
-			info->assemblyNumber = assemblyMap[assemblyId];
+	mdToken functionToken = 0;
+	HRESULT hr = profilerInfo->GetFunctionInfo2(functionId, 0, NULL, &moduleId, &functionToken, 0, NULL, NULL);
+	if (FAILED(hr)) {
+		return;
+	}
+
+	int assemblyNumber = 0;
+	callbackSynchronization.lock();
+	getAssemblyNumber(moduleId, &assemblyNumber);
+	callbackSynchronization.unlock();
+
+	// hot and cold code of the same function are separate ranges
+	COR_PRF_CODE_INFO codeInfos[4];
+	ULONG32 codeInfoCount = 0;
+	size_t nativeSize = 0;
+	if (SUCCEEDED(profilerInfo->GetCodeInfo2(functionId, 4, &codeInfoCount, codeInfos))) {
+		for (ULONG32 i = 0; i < codeInfoCount && i < 4; i++) {
+			nativeSize += codeInfos[i].size;
 		}
 	}
+	jitCosts.recordFinish(functionId, finishCycles, assemblyNumber, functionToken, nativeSize);
+}
+
+void CProfilerCallback::writeJitCostsToLog() {
+	double cyclesPerMillisecond = statistics.getCyclesPerMillisecond();
+	std::vector<std::string> lines;
+	jitCosts.createAssemblyReport(cyclesPerMillisecond, lines);
+	for (std::string& line : lines) {
+		traceLog.logJitCostOfAssembly(line);
+	}
 
+	lines.clear();
+	jitCosts.createMethodReport(cyclesPerMillisecond, lines);
+	for (std::string& line : lines) {
+		traceLog.logJitCostOfMethod(line);
+	}
+}
+
+#ifdef _WIN32
+void CProfilerCallback::writeStacksToLog(bool clrIsAvailable) {
+	std::vector<std::string> lines;
+	stackSampler.collapseStacks([this, clrIsAvailable](FunctionID functionId) { return getFunctionName(functionId, clrIsAvailable); }, lines);
+	for (std::string& line : lines) {
+		traceLog.logStack(line);
+	}
+	traceLog.info("Stack sampling: " + std::to_string(stackSampler.getSampleCount()) + " samples, " + std::to_string(stackSampler.getDroppedSampleCount()) + " dropped");
+}
+#endif
+
+std::string CProfilerCallback::getFunctionName(FunctionID functionId, bool clrIsAvailable) {
+	char name[BUFFER_SIZE];
+	snprintf(name, sizeof(name), "0x%llx", static_cast<unsigned long long>(functionId));
+	if (!clrIsAvailable) {
+		return name;
+	}
+
+	IMetaDataImport* metaDataImport = NULL;
+	mdToken functionToken = 0;
+	HRESULT hr = profilerInfo->GetTokenAndMetaDataFromFunction(functionId, IID_IMetaDataImport, (IUnknown**)&metaDataImport, &functionToken);
+	if (FAILED(hr) || metaDataImport == NULL) {
+		return name;
+	}
+
+	WCHAR methodName[BUFFER_SIZE];
+	WCHAR typeName[BUFFER_SIZE];
+	mdTypeDef typeToken = 0;
+	hr = metaDataImport->GetMethodProps(functionToken, &typeToken, methodName, BUFFER_SIZE, NULL, NULL, NULL, NULL, NULL, NULL);
+	if (SUCCEEDED(hr)) {
+		hr = metaDataImport->GetTypeDefProps(typeToken, typeName, BUFFER_SIZE, NULL, NULL, NULL);
+	}
+	metaDataImport->Release();
+	if (SUCCEEDED(hr)) {
+		return StringUtils::narrow(typeName) + "." + StringUtils::narrow(methodName);
+	}
+	return name;
+}
+
+bool CProfilerCallback::isAlreadyReported(FunctionInfo& info) {
+	if (coverageBaseline.contains(info.assemblyNumber, info.functionToken)) {
+		return true;
+	}
+#ifdef _WIN32
+	if (sharedBitmaps.empty()) {
+		return false;
+	}
+	std::map<int, SharedBitmap>::iterator bitmap = sharedBitmaps.find(info.assemblyNumber);
+	return bitmap != sharedBitmaps.end() && bitmap->second.isSet(info.functionToken);
+#else
+	// there is no shared coverage map
+	return false;
+#endif
+}
+
+void CProfilerCallback::markAsReported(std::vector<FunctionInfo>& functions) {
+	if (coverageBaseline.isOpen()) {
+		for (FunctionInfo& info : functions) {
+			coverageBaseline.add(info.assemblyNumber, info.functionToken);
+		}
+	}
+#ifdef _WIN32
+	if (!sharedBitmaps.empty()) {
+		unpublishedMethods.insert(unpublishedMethods.end(), functions.begin(), functions.end());
+	}
+#endif
+}
+
+#ifdef _WIN32
+void CProfilerCallback::publishReportedMethods(ULONGLONG minimumIntervalMillis) {
+	if (unpublishedMethods.empty()) {
+		return;
+	}
+
+	ULONGLONG now = GetTickCount64();
+	if (now - lastSharedCoveragePublishMillis < minimumIntervalMillis) {
+		return;
+	}
+	lastSharedCoveragePublishMillis = now;
+
+	// like the baseline, the methods may only be skipped by other processes once the trace is where the upload picks
+	// it up. Until then they are kept and published with a later flush
+	if (!traceLog.flushToTarget()) {
+		return;
+	}
+	for (FunctionInfo& info : unpublishedMethods) {
+		std::map<int, SharedBitmap>::iterator bitmap = sharedBitmaps.find(info.assemblyNumber);
+		if (bitmap != sharedBitmaps.end()) {
+			bitmap->second.set(info.functionToken);
+		}
+	}
+	unpublishedMethods.clear();
+}
+#endif
+
+HRESULT CProfilerCallback::getFunctionInfo(FunctionID functionId, FunctionInfo* info, ModuleID* moduleId) {
+	HRESULT hr = profilerInfo->GetFunctionInfo2(functionId, 0,
+		NULL, moduleId, &info->functionToken, 0, NULL, NULL);
+
+	if (SUCCEEDED(hr) && *moduleId != 0) {
+		hr = getAssemblyNumber(*moduleId, &info->assemblyNumber);
+	}
+
+	return hr;
+}
+
+HRESULT CProfilerCallback::getAssemblyNumber(ModuleID moduleId, int* assemblyNumber) {
+	// saves the GetModuleInfo lookup for functions in the main module of their assembly
+	std::map<ModuleID, int>::iterator knownModule = moduleMap.find(moduleId);
+	if (knownModule != moduleMap.end()) {
+		*assemblyNumber = knownModule->second;
+		return S_OK;
+	}
+
+	AssemblyID assemblyId;
+	HRESULT hr = profilerInfo->GetModuleInfo(moduleId, NULL, NULL,
+		NULL, NULL, &assemblyId);
+	if (SUCCEEDED(hr)) {
+		*assemblyNumber = assemblyMap[assemblyId];
+	}
 	return hr;
 }
 
+#ifdef _WIN32
 int CProfilerCallback::writeFileVersionInfo(LPCWSTR assemblyPath, char* buffer, size_t bufferSize) {
 	DWORD infoSize = GetFileVersionInfoSizeW(assemblyPath, NULL);
 	if (!infoSize) {
@@ -479,3 +1424,4 @@ int CProfilerCallback::writeFileVersionInfo(LPCWSTR assemblyPath, char* buffer,
 	delete versionInfo;
 	return writtenChars;
 }
+#endif
@@ -4,18 +4,38 @@
 #include "log/TraceLog.h"
 #include "log/AttachLog.h"
 #include "config/Config.h"
-#include "utils/WindowsUtils.h"
-#include <atlbase.h>
+#include "platform/ComPtr.h"
+#include "platform/Mutex.h"
+#include "utils/CallbackStatistics.h"
+#include "utils/JitCosts.h"
+#include "utils/OverheadGovernor.h"
+#include "recording/EventRecorder.h"
+#include "recording/StartupJitOrder.h"
+#include "recording/PerfMap.h"
+#include "coverage/ExecutionProbes.h"
+#include "coverage/BlockCoverage.h"
+#include "coverage/CoverageBaseline.h"
 #include <string>
 #include <vector>
 #include <map>
 #include <set>
 #include <mutex>
+#include <regex>
+
+#ifdef _WIN32
+#include "coverage/SharedCoverageMap.h"
+#include "coverage/TestControlChannel.h"
+#include "coverage/CallCounter.h"
+#include "sampling/StackSampler.h"
 #include "UploadDaemon.h"
+#endif
 
 /**
  * Coverage profiler class. Implements JIT event hooks to record method
  * coverage.
+ *
+ * The shared coverage map, test-wise coverage, call counting, stack sampling, the upload daemon and assembly file
+ * versions rely on Windows APIs and are not available on Linux.
  */
 class CProfilerCallback : public CProfilerCallbackBase {
 public:
@@ -35,6 +55,15 @@ public:
 	/** Write coverage information to log file at shutdown. */
 	STDMETHOD(Shutdown)();
 
+	/** Inserts block probes into the method if block coverage is enabled. */
+	STDMETHOD(JITCompilationStarted)(FunctionID functionID, BOOL fIsSafeToBlock);
+
+	/** Includes a new managed thread in the stack samples. */
+	STDMETHOD(ThreadCreated)(ThreadID threadId);
+
+	/** Excludes a managed thread from the stack samples. */
+	STDMETHOD(ThreadDestroyed)(ThreadID threadId);
+
 	/** Store information about jitted method. */
 	STDMETHOD(JITCompilationFinished)(FunctionID functionID, HRESULT hrStatus, BOOL fIsSafeToBlock);
 
@@ -44,25 +73,69 @@ public:
 	/** Record inlining of method, but generally allow it. */
 	STDMETHOD(JITInlining)(FunctionID callerID, FunctionID calleeID, BOOL *pfShouldInline);
 
+	/** Inserts the probe into a method that is re-jitted for execution probes. */
+	STDMETHOD(GetReJITParameters)(ModuleID moduleId, mdMethodDef methodId, ICorProfilerFunctionControl *pFunctionControl);
+
+	/** Excludes methods that cannot be re-jitted from execution probes. */
+	STDMETHOD(ReJITError)(ModuleID moduleId, mdMethodDef methodId, FunctionID functionId, HRESULT hrStatus);
+
 	/**
 	 * Implements the actual shutdown procedure. Must only be called once.
 	 * If clrIsAvailable is true, also tries to force a GC.
 	 * Note that forcing a GC after the CLR has shut down can result in deadlocks so this
 	 * should be set only when calling from a CLR callback.
 	 */
-	void CProfilerCallback::ShutdownOnce(bool clrIsAvailable);
+	void ShutdownOnce(bool clrIsAvailable);
+
+#ifdef PROFILER_BENCHMARK
+	/**
+	 * Dispatches the JIT callbacks to the generic implementations, which check every mode on each call, instead of the
+	 * ones specialized for the configuration. Only compiled into the benchmark to compare both. Must be called after
+	 * Initialize.
+	 */
+	void useGenericCallbacks() {
+		selectGenericJitHandlers();
+	}
+#endif
 
 private:
+	/**
+	 * How a mode of the JIT callbacks is decided: at compile time by the implementations specialized for the
+	 * configuration or on every call by the generic implementation.
+	 */
+	enum HotPathMode {
+		MODE_OFF,
+		MODE_ON,
+		MODE_RUNTIME
+	};
+
+	/** Implementations of the JIT callbacks. */
+	typedef void (CProfilerCallback::*JitCompilationHandler)(FunctionID functionId, HRESULT hrStatus);
+	typedef void (CProfilerCallback::*JitInliningHandler)(FunctionID callerId, FunctionID calleeId);
+
+	/** The JIT callback implementations selected by Initialize. Generic until then. */
+	JitCompilationHandler jitCompilationHandler;
+	JitInliningHandler jitInliningHandler;
+
+	/** Number of pending methods after which they are written in eager mode. */
+	size_t eagerWriteThreshold = 0;
+
 	/** Synchronizes profiling callbacks. */
-	CRITICAL_SECTION callbackSynchronization;
+	Mutex callbackSynchronization;
 
 	/** Default size for arrays. */
 	static const int BUFFER_SIZE = 2048;
 
+	/** Minimum time between two writes of the shared coverage map to disk. */
+	static const ULONGLONG SHARED_COVERAGE_MAP_FLUSH_INTERVAL = 60000;
+
+	/** Minimum time between two eager writes of the call counts, since collecting them visits all counters. */
+	static const ULONGLONG CALL_COUNT_FLUSH_INTERVAL_MICROS = 60000000;
+
 	/** Counts the number of assemblies loaded. */
 	int assemblyCounter = 1;
 
-	Config config = Config(WindowsUtils::getConfigValueFromEnvironment);
+	Config config = Config(Config::getValueFromEnvironment);
 
 	/**
 	 * Maps from assembly IDs to assemblyNumbers (determined by assemblyCounter).
@@ -70,6 +143,86 @@ private:
 	 */
 	std::map<AssemblyID, int> assemblyMap;
 
+	/**
+	 * Maps from formatted MVIDs to assemblyNumbers if assemblies are numbered by MVID.
+	 * Modules loaded several times (e.g. into multiple AppDomains) thus share a single number.
+	 */
+	std::map<std::string, int> mvidMap;
+
+	/**
+	 * Maps from the main module of each assembly to its assemblyNumber.
+	 * Saves looking up the assembly of most functions.
+	 */
+	std::map<ModuleID, int> moduleMap;
+
+	/** Methods that previous runs already reported. Only open if configured. */
+	CoverageBaseline coverageBaseline;
+
+#ifdef _WIN32
+	/** Machine-wide map of methods that were already reported by any process. Only open if configured. */
+	SharedCoverageMap sharedCoverageMap;
+
+	/** Maps from assemblyNumbers to their bitmaps in the shared coverage map. */
+	std::map<int, SharedBitmap> sharedBitmaps;
+
+	/**
+	 * Methods written to the trace that are not yet marked in the shared coverage map, since other processes skip them
+	 * for good once they are. Only accessed from synchronized context.
+	 */
+	std::vector<FunctionInfo> unpublishedMethods;
+
+	/** When the reported methods were last published to the shared coverage map. */
+	ULONGLONG lastSharedCoveragePublishMillis = 0;
+
+	/** Receives test start and end markers if test-wise coverage is enabled. */
+	TestControlChannel testControlChannel;
+#endif
+
+	/** Number of methods that were not recorded because they were already reported. */
+	size_t skippedMethodCount = 0;
+
+	/** The test that is currently running or the empty string. Guarded by callbackSynchronization. */
+	std::string currentTestName;
+
+	/**
+	 * Second buffers for the methods of a finished test. They are swapped with jittedMethods and inlinedMethods
+	 * when a test starts or ends, so the callbacks continue with empty buffers while the finished test is written.
+	 * Only accessed by the thread that handles test markers.
+	 */
+	std::vector<FunctionInfo> finishedTestJittedMethods;
+	std::vector<FunctionInfo> finishedTestInlinedMethods;
+
+	/** Detects executions of already jitted methods in test-wise mode. Only started if configured. */
+	ExecutionProbes executionProbes;
+
+	/** Records the executed basic blocks of jitted methods. Only enabled if configured. */
+	BlockCoverage blockCoverage;
+
+#ifdef _WIN32
+	/** Counts the calls of the methods in the configured assemblies. Only hooked if configured. */
+	CallCounter callCounter;
+#endif
+
+	/** Whether the enter hook of the call counter is installed. */
+	bool isCountingCalls = false;
+
+	/** When the call counts were last written. Only accessed while writing them. */
+	ULONGLONG lastCallCountFlushMicros = 0;
+
+	/** Matches the names of the assemblies whose method calls are counted. */
+	std::wregex callCountingAssemblies;
+
+	/** The assemblyNumbers of the assemblies whose method calls are counted. Guarded by callbackSynchronization. */
+	std::set<int> countedAssemblies;
+
+#ifdef _WIN32
+	/** Samples the stacks of all managed threads. Only started if configured. */
+	StackSampler stackSampler;
+#endif
+
+	/** Measures the JIT time and native code size of each method. Only enabled if configured. */
+	JitCosts jitCosts;
+
 	/**
 	 * Info object that keeps track of jitted methods.
 	 */
@@ -88,7 +241,7 @@ private:
 	std::vector<FunctionInfo> inlinedMethods;
 
 	/** Smart pointer to the .NET framework profiler info. */
-	CComQIPtr<ICorProfilerInfo2> profilerInfo;
+	ComPtr<ICorProfilerInfo2> profilerInfo;
 
 	/** The log to write all results and messages to. */
 	TraceLog traceLog;
@@ -96,6 +249,27 @@ private:
 	/** The log to write attach and detatch events to */
 	AttachLog attachLog;
 
+	/** Whether this process is not profiled since only a fraction of processes is. */
+	bool isSampledOut = false;
+
+	/** Measures the overhead of the profiler. Written to the trace log at shutdown. */
+	CallbackStatistics statistics;
+
+	/** Degrades the recording if the overhead exceeds the configured budget. */
+	OverheadGovernor governor;
+
+	/** Number of inlinings that were not recorded because of the governor. */
+	volatile LONG64 skippedInliningCount = 0;
+
+	/** Records the raw callback events if enabled in the config. */
+	EventRecorder eventRecorder;
+
+	/** Records the order of the first compilations during startup if enabled in the config. */
+	StartupJitOrder startupJitOrder;
+
+	/** Writes the code ranges of jitted methods for perf if enabled in the config. */
+	PerfMap perfMap;
+
 	/**
 	* Returns the event mask which tells the CLR which callbacks the profiler wants to subscribe
 	* to. We enable JIT compilation and assembly loads for coverage profiling. In
@@ -116,37 +290,148 @@ private:
 	* enabled in the event mask in order to force JIT-events for each first call to
 	* a function, independent of whether a pre-jitted version exists.)
 	*/
-	static UINT_PTR _stdcall functionMapper(FunctionID functionId, BOOL *pbHookFunction) throw(...);
+	static UINT_PTR __stdcall functionMapper(FunctionID functionId, BOOL *pbHookFunction);
+
+#ifdef _WIN32
+	/**
+	* Replaces functionMapper if calls are counted. Hooks the methods of the counted assemblies and returns
+	* their call counter ID, which the runtime passes to the enter hook instead of the function ID.
+	*/
+	static UINT_PTR __stdcall functionMapper2(FunctionID functionId, void* clientData, BOOL *pbHookFunction);
+
+	/** Assigns a call counter ID to the given function if it belongs to a counted assembly. */
+	UINT_PTR mapCountedFunction(FunctionID functionId, BOOL *pbHookFunction);
+
+	/** Installs the enter hook that counts method calls. */
+	void startCallCounting(IUnknown* pICorProfilerInfoUnkown);
+
+	/** Returns a proxy for the upload daemon process */
+	UploadDaemon createDaemon();
+
+	/** Writes all sampled stacks to the log. */
+	void writeStacksToLog(bool clrIsAvailable);
+
+	/** Writes the fileVersionInfo into the provided buffer. */
+	int writeFileVersionInfo(LPCWSTR moduleFileName, char* buffer, size_t bufferSize);
+#else
+	/** Warns about configured options that rely on Windows APIs. */
+	void warnAboutWindowsOnlyOptions();
+#endif
 
 	/** Dumps all environment variables to the log file. */
 	void dumpEnvironment();
 
 	void initializeConfig();
 
-	/** Returns a proxy for the upload daemon process */
-	UploadDaemon createDaemon();
+	/** Create method info object for a function id and stores the function's module in the passed variable. */
+	HRESULT getFunctionInfo(FunctionID functionID, FunctionInfo* info, ModuleID* moduleId);
+
+	/** Stores the assemblyNumber of the assembly that contains the given module in the passed variable. */
+	HRESULT getAssemblyNumber(ModuleID moduleId, int* assemblyNumber);
+
+	/**
+	 * Store assembly counter for id. If assemblies are numbered by MVID and the MVID is already known,
+	 * returns the existing number and sets isNewAssembly to false.
+	 */
+	int registerAssembly(AssemblyID assemblyId, ModuleID moduleId, std::string mvid, bool* isNewAssembly);
+
+	/** Stores the assmebly name, path, metadata and main module in the passed variables.*/
+	void getAssemblyInfo(AssemblyID assemblyId, WCHAR* assemblyName, WCHAR *assemblyPath, ASSEMBLYMETADATA* metadata, ModuleID* moduleId);
+
+	/** Stores the MVID of the given module in the passed variable. Returns false if it cannot be determined. */
+	bool getModuleVersionId(ModuleID moduleId, GUID* mvid);
+
+	/** Returns the number of methods defined in the given module or 0 if it cannot be determined. */
+	ULONG getMethodCount(ModuleID moduleId);
+
+	/** Returns whether the given function was already reported according to the baseline or the shared coverage map. */
+	bool isAlreadyReported(FunctionInfo& info);
+
+	/**
+	 * Marks all given functions as reported in the baseline and queues them for the shared coverage map. Neither is
+	 * persisted before the trace file reached its target directory.
+	 */
+	void markAsReported(std::vector<FunctionInfo>& functions);
+
+#ifdef _WIN32
+	/**
+	 * Marks the queued methods in the shared coverage map if the last attempt is at least the given time ago and the
+	 * trace file reached its target directory. Must be called from synchronized context.
+	 */
+	void publishReportedMethods(ULONGLONG minimumIntervalMillis);
+#endif
+
+	/**
+	 * Records a jitted or inlined method unless the filter of already reported methods is used and contains it.
+	 * Triggers eagerly writing of function infos to log.
+	 */
+	template<HotPathMode eager, HotPathMode filtered>
+	void recordFunctionInfo(std::vector<FunctionInfo>* list, FunctionInfo& info);
+
+	/**
+	 * Records a jitted method. The extras are the optional features besides coverage, e.g. JIT costs, event recording
+	 * or the overhead governor.
+	 */
+	template<HotPathMode eager, HotPathMode filtered, HotPathMode extras>
+	void handleJitCompilation(FunctionID functionId, HRESULT hrStatus);
+
+	/** Records an inlined method. The extras are block coverage, event recording and the overhead governor. */
+	template<HotPathMode eager, HotPathMode filtered, HotPathMode extras>
+	void handleJitInlining(FunctionID callerId, FunctionID calleeId);
+
+	/** Selects the JIT callback implementations for the given modes. */
+	template<HotPathMode eager, HotPathMode filtered>
+	void selectJitHandlers(bool hasJitCompilationExtras, bool hasJitInliningExtras);
+
+	/** Selects the JIT callback implementations specialized for the configuration and started features. */
+	void selectJitHandlers();
 
-	/** Create method info object for a function id. */
-	HRESULT getFunctionInfo(FunctionID functionID, FunctionInfo* info);
+	/** Selects the generic JIT callback implementations, which check every mode on each call. */
+	void selectGenericJitHandlers();
 
-	/**  Store assembly counter for id. */
-	int registerAssembly(AssemblyID assemblyId);
+	/** Records the optional measurements of a finished compilation that do not need the callback lock. */
+	void recordJitCompilationExtras(FunctionID functionId, HRESULT hrStatus);
 
-	/** Stores the assmebly name, path and metadata in the passed variables.*/
-	void getAssemblyInfo(AssemblyID assemblyId, WCHAR* assemblyName, WCHAR *assemblyPath, ASSEMBLYMETADATA* moduleId);
+	/** Starts the execution probes. Requires at least ICorProfilerInfo4. */
+	void startExecutionProbes(IUnknown* pICorProfilerInfoUnk);
 
-	/** Triggers eagerly writing of function infos to log. */
-	void recordFunctionInfo(std::vector<FunctionInfo>* list, FunctionID calleeId);
+	/** Records the methods whose execution probes were hit in the current test. */
+	void recordExecutedMethods(const std::vector<ProbedMethod>& methods);
 
-	/** Returns whether eager mode is enabled and amount of recorded method calls reached eagerness threshold. */
+	/** Returns whether eager mode is enabled and amount of recorded method calls reached eagerness threshold. Checks the config on each call. */
 	bool shouldWriteEagerly();
 
+	/** Enters the callback critical section and returns the number of cycles spent waiting for it. */
+	unsigned __int64 enterCallbackLock();
+
+	/** Reports a callback that started at the given cycle count to the governor and logs level changes. Must be called from synchronized context. */
+	void updateGovernor(unsigned __int64 startCycles, bool isJitCompilation);
+
+	/** Ends the coverage segment of the current test and starts one for the given test (empty for no test). */
+	void switchTest(std::string testName);
+
+	/** Inserts block probes into the given function unless it was already instrumented. */
+	void instrumentBlocks(FunctionID functionId);
+
+	/** Writes the methods with newly executed basic blocks to the log. */
+	void writeBlockCoverageToLog();
+
+	/** Writes the methods that were called since the last flush to the log if that is at least the given time ago. */
+	void writeCallCountsToLog(ULONGLONG minimumIntervalMicros);
+
+	/** Records the end of a compilation in the JIT costs. */
+	void recordJitCost(FunctionID functionId, unsigned __int64 finishCycles);
+
+	/** Writes the JIT cost report to the log. */
+	void writeJitCostsToLog();
+
+	/** Returns the name of the given function as Namespace.Type.Method or its ID if the name is not available. */
+	std::string getFunctionName(FunctionID functionId, bool clrIsAvailable);
+
 	/** Write all information about the recorded functions to the log and clears the log. */
 	void writeFunctionInfosToLog();
 
-	/** Writes the fileVersionInfo into the provided buffer. */
-	int writeFileVersionInfo(LPCWSTR moduleFileName, char* buffer, size_t bufferSize);
-
+	HRESULT JITCompilationStartedImplementation(FunctionID functionID, BOOL fIsSafeToBlock);
 	HRESULT JITCompilationFinishedImplementation(FunctionID functionID, HRESULT hrStatus, BOOL fIsSafeToBlock);
 	HRESULT AssemblyLoadFinishedImplementation(AssemblyID assemblyID, HRESULT hrStatus);
 	HRESULT JITInliningImplementation(FunctionID callerID, FunctionID calleeID, BOOL *pfShouldInline);
@@ -33,6 +33,10 @@ HRESULT CProfilerCallbackBase::QueryInterface( REFIID riid, void **ppInterface )
 		*ppInterface = static_cast<ICorProfilerCallback3*>(this);
 		return S_OK;
 	}
+	else if(riid == IID_ICorProfilerCallback4) {
+		*ppInterface = static_cast<ICorProfilerCallback4*>(this);
+		return S_OK;
+	}
 	return E_NOTIMPL;
 }
 //====================================================
@@ -371,6 +375,30 @@ STDMETHODIMP CProfilerCallbackBase::ProfilerDetachSucceeded() {
 	return S_OK;
 }
 
+STDMETHODIMP CProfilerCallbackBase::ReJITCompilationStarted(FunctionID functionId, ReJITID rejitId, BOOL fIsSafeToBlock) {
+	return S_OK;
+}
+
+STDMETHODIMP CProfilerCallbackBase::GetReJITParameters(ModuleID moduleId, mdMethodDef methodId, ICorProfilerFunctionControl *pFunctionControl) {
+	return S_OK;
+}
+
+STDMETHODIMP CProfilerCallbackBase::ReJITCompilationFinished(FunctionID functionId, ReJITID rejitId, HRESULT hrStatus, BOOL fIsSafeToBlock) {
+	return S_OK;
+}
+
+STDMETHODIMP CProfilerCallbackBase::ReJITError(ModuleID moduleId, mdMethodDef methodId, FunctionID functionId, HRESULT hrStatus) {
+	return S_OK;
+}
+
+STDMETHODIMP CProfilerCallbackBase::MovedReferences2(ULONG cMovedObjectIDRanges, ObjectID oldObjectIDRangeStart[], ObjectID newObjectIDRangeStart[], SIZE_T cObjectIDRangeLength[]) {
+	return S_OK;
+}
+
+STDMETHODIMP CProfilerCallbackBase::SurvivingReferences2(ULONG cSurvivingObjectIDRanges, ObjectID objectIDRangeStart[], SIZE_T cObjectIDRangeLength[]) {
+	return S_OK;
+}
+
 //====================================================
 // End of Profiling interface implementation
 //====================================================
@@ -1,16 +1,17 @@
 #pragma once
-#include <windows.h>
 #include <stdio.h>
 #include <cor.h>
 #include <corprof.h>
 
+#ifdef _WIN32
 #pragma comment(lib, "corguids.lib")
+#endif
 
 /**
  * Base class of the coverage profiler that adds default implementations for all unneeded callback functions.
  * The callbacks the profiler needs are implemented (overridden) in the subclass.
 */
-class CProfilerCallbackBase : public ICorProfilerCallback3 {
+class CProfilerCallbackBase : public ICorProfilerCallback4 {
 public:
 	/** Constructor */
 	CProfilerCallbackBase();
@@ -131,7 +132,16 @@ public:
 	STDMETHOD(ProfilerDetachSucceeded)();
 	// End of ICorProfilerCallback3 interface implementation
 
+	// ICorProfilerCallback4 interface implementation
+	STDMETHOD(ReJITCompilationStarted)(FunctionID functionId, ReJITID rejitId, BOOL fIsSafeToBlock);
+	STDMETHOD(GetReJITParameters)(ModuleID moduleId, mdMethodDef methodId, ICorProfilerFunctionControl *pFunctionControl);
+	STDMETHOD(ReJITCompilationFinished)(FunctionID functionId, ReJITID rejitId, HRESULT hrStatus, BOOL fIsSafeToBlock);
+	STDMETHOD(ReJITError)(ModuleID moduleId, mdMethodDef methodId, FunctionID functionId, HRESULT hrStatus);
+	STDMETHOD(MovedReferences2)(ULONG cMovedObjectIDRanges, ObjectID oldObjectIDRangeStart[], ObjectID newObjectIDRangeStart[], SIZE_T cObjectIDRangeLength[]);
+	STDMETHOD(SurvivingReferences2)(ULONG cSurvivingObjectIDRanges, ObjectID objectIDRangeStart[], SIZE_T cObjectIDRangeLength[]);
+	// End of ICorProfilerCallback4 interface implementation
+
 private:
 	// COM reference counter (for AddRef() and Release()) of the IUnknown implementation of the profiler
-	long referenceCount;
+	LONG referenceCount;
 };
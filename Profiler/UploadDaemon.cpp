@@ -1,7 +1,7 @@
 #include "UploadDaemon.h"
 #include <windows.h>
 #include <shellapi.h>
-#include "utils/WindowsUtils.h"
+#include "platform/Platform.h"
 
 UploadDaemon::UploadDaemon(std::string profilerPath)
 {
@@ -18,7 +18,7 @@ void UploadDaemon::launch(TraceLog &traceLog)
 	bool successful = execute();
 	if (!successful)
 	{
-		traceLog.error("Failed to launch upload daemon " + pathToExe + ": " + WindowsUtils::getLastErrorAsString());
+		traceLog.error("Failed to launch upload daemon " + pathToExe + ": " + Platform::getLastErrorMessage());
 	}
 }
 
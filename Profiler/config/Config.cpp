@@ -1,19 +1,33 @@
 #include "Config.h"
-#include "utils/WindowsUtils.h"
+#include "platform/Platform.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
 #include <exception>
 
+/**
+ * Largest spool timeout. The trace log waits at most 5 seconds for its target directory at shutdown, so longer timeouts
+ * would only delay spooling until the output is lost.
+ */
+static const size_t MAX_SPOOL_TIMEOUT_MILLIS = 4000;
+
 std::string Config::getDefaultConfigPath()
 {
-	std::string profilerDllPath = WindowsUtils::getConfigValueFromEnvironment("PATH");
+	std::string profilerDllPath = getValueFromEnvironment("PATH");
 	std::string profilerDllDirectory = StringUtils::removeLastPartOfPath(profilerDllPath);
-	return profilerDllDirectory + "\\Profiler.yml";
+	return profilerDllDirectory + Platform::PATH_SEPARATOR + "Profiler.yml";
+}
+
+std::string Config::getValueFromEnvironment(std::string suffix) {
+	std::transform(suffix.begin(), suffix.end(), suffix.begin(), ::toupper);
+	return Platform::getEnvironmentVariable("COR_PROFILER_" + suffix);
 }
 
 void Config::load(std::string configFilePath, std::string processPath, bool logProblemIfConfigFileDoesNotExist) {
 	this->processPath = processPath;
 	this->configPath = configFilePath;
 
-	if (WindowsUtils::isFile(configFilePath)) {
+	if (Platform::isFile(configFilePath)) {
 		std::ifstream stream(configFilePath);
 		if (stream.fail()) {
 			problems.push_back("Failed to open the config file " + configFilePath + " for reading");
@@ -76,19 +90,23 @@ void Config::setOptions()
 	dumpEnvironment = getBooleanOption("dump_environment", false);
 	ignoreExceptions = getBooleanOption("ignore_exceptions", false);
 	startUploadDaemon = getBooleanOption("upload_daemon", false);
-
-	std::string eagernessValue = getOption("eagerness");
-	if (eagernessValue.empty()) {
-		eagerness = 0;
-	}
-	else {
-		try {
-			eagerness = static_cast<size_t>(std::stoi(eagernessValue));
-		}
-		catch (...) {
-			problems.push_back("Invalid eagerness value configured: " + eagernessValue + ". Using the default of no eagerness instead");
-		}
-	}
+	recordEvents = getBooleanOption("record_events", false);
+	useMvidKeys = getBooleanOption("mvid_keys", false);
+	sharedCoverageMap = getOption("shared_coverage_map");
+	coverageBaseline = getOption("baseline");
+	testwiseCoverage = getBooleanOption("testwise_coverage", false);
+	useExecutionProbes = getBooleanOption("execution_probes", false);
+	recordBlockCoverage = getBooleanOption("block_coverage", false);
+	writePerfMap = getBooleanOption("perf_map", false);
+	callCountingAssemblies = getOption("count_calls");
+
+	eagerness = getNumericOption("eagerness", 0);
+	spoolTimeout = getNumericOption("spool_timeout", 500, MAX_SPOOL_TIMEOUT_MILLIS);
+	samplingInterval = getNumericOption("sampling_interval", 0);
+	jitCostMethods = getNumericOption("jit_costs", 0);
+	startupJitOrderSeconds = getNumericOption("startup_jit_order", 0);
+	overheadBudget = getNumericOption("overhead_budget", 0);
+	samplingRate = getRateOption("sampling_rate", 1);
 
 	disableProfilerIfProcessSuffixDoesntMatch();
 }
@@ -122,4 +140,60 @@ bool Config::getBooleanOption(std::string optionName, bool defaultValue) {
 
 	// true comes from the YAML files and 1 is used for the env options so we support both
 	return value == "true" || value == "1";
+}
+
+size_t Config::getNumericOption(std::string optionName, size_t defaultValue, size_t maximum) {
+	std::string value = getOption(optionName);
+	if (value.empty()) {
+		return defaultValue;
+	}
+
+	// stoul skips whitespace, accepts signs and wraps negative numbers around, e.g. -1 to the largest value
+	bool isValid = value.find_first_not_of("0123456789") == std::string::npos;
+	unsigned long long number = 0;
+	if (isValid) {
+		try {
+			number = std::stoull(value);
+		}
+		catch (...) {
+			isValid = false;
+		}
+	}
+	// all numeric options fit into 32 bits, e.g. timeouts passed to the Windows API
+	if (!isValid || number > UINT32_MAX) {
+		problems.push_back("Invalid " + optionName + " value configured: " + value + ". Using the default of " + std::to_string(defaultValue) + " instead");
+		return defaultValue;
+	}
+	if (number > maximum) {
+		problems.push_back("Invalid " + optionName + " value configured: " + value + ". Using the maximum of " + std::to_string(maximum) + " instead");
+		return maximum;
+	}
+	return static_cast<size_t>(number);
+}
+
+/** Formats the given rate without trailing zeros, e.g. 0.25. */
+static std::string formatRate(double rate) {
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%g", rate);
+	return buffer;
+}
+
+double Config::getRateOption(std::string optionName, double defaultValue) {
+	std::string value = getOption(optionName);
+	if (value.empty()) {
+		return defaultValue;
+	}
+
+	try {
+		size_t length = 0;
+		double rate = std::stod(value, &length);
+		if (length == value.size() && rate >= 0 && rate <= 1) {
+			return rate;
+		}
+	}
+	catch (...) {
+		// reported below
+	}
+	problems.push_back("Invalid " + optionName + " value configured: " + value + ". Must be a number between 0 and 1. Using the default of " + formatRate(defaultValue) + " instead");
+	return defaultValue;
 }
\ No newline at end of file
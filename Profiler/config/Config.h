@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <string>
 #include <fstream>
 #include "ConfigParser.h"
@@ -18,6 +19,9 @@ public:
 	/** Returns the path to the default config file. */
 	static std::string getDefaultConfigPath();
 
+	/** Return the value for the environment variable COR_PROFILER_<suffix> or the empty string if it is not set. */
+	static std::string getValueFromEnvironment(std::string suffix);
+
 	Config(EnvironmentVariableReader* _environmentVariableReader) : environmentVariableReader(_environmentVariableReader) {}
 
 	/** Loads the config from the given YAML file and applies all sections that apply to the given profiled process path. */
@@ -81,6 +85,86 @@ public:
 		return eagerness;
 	}
 
+	/** Milliseconds to wait for the target directory before log files are spooled to the local temp directory. At most 4000. */
+	size_t getSpoolTimeout() {
+		return spoolTimeout;
+	}
+
+	/** Milliseconds between two stack samples of all managed threads or 0 if stacks are not sampled. */
+	size_t getSamplingInterval() {
+		return samplingInterval;
+	}
+
+	/** Number of most expensive methods in the JIT cost report or 0 if JIT costs are not measured. */
+	size_t getJitCostMethods() {
+		return jitCostMethods;
+	}
+
+	/** Maximum number of seconds during which the startup JIT order is recorded or 0 if it is not recorded. */
+	size_t getStartupJitOrderSeconds() {
+		return startupJitOrderSeconds;
+	}
+
+	/** Whether to record coverage per test case, as marked through the test control channel. */
+	bool isTestwiseCoverageEnabled() {
+		return testwiseCoverage;
+	}
+
+	/** Whether to count the calls of the methods in the assemblies that match getCallCountingAssemblies(). */
+	bool shouldCountCalls() {
+		return !callCountingAssemblies.empty();
+	}
+
+	/** Regex for the names of the assemblies whose method calls are counted. Empty if calls are not counted. */
+	std::string getCallCountingAssemblies() {
+		return callCountingAssemblies;
+	}
+
+	/** Whether to instrument jitted methods to record which of their basic blocks are executed. */
+	bool shouldRecordBlockCoverage() {
+		return recordBlockCoverage;
+	}
+
+	/** Whether to write the code ranges of jitted methods to /tmp/perf-<pid>.map for perf. */
+	bool shouldWritePerfMap() {
+		return writePerfMap;
+	}
+
+	/** Whether to detect executions of already jitted methods with re-jitted probes in test-wise mode. */
+	bool shouldUseExecutionProbes() {
+		return useExecutionProbes;
+	}
+
+	/** Path of the machine-wide map of already reported methods or the empty string if it should not be used. */
+	std::string getSharedCoverageMap() {
+		return sharedCoverageMap;
+	}
+
+	/** Directory of the baseline of already reported methods per module or the empty string if it should not be used. */
+	std::string getCoverageBaseline() {
+		return coverageBaseline;
+	}
+
+	/** Whether to number assemblies by distinct MVID instead of by load, so each module gets only one number. */
+	bool shouldUseMvidKeys() {
+		return useMvidKeys;
+	}
+
+	/** Percent of the elapsed time the profiler callbacks may take before recording is degraded or 0 for no limit. */
+	size_t getOverheadBudget() {
+		return overheadBudget;
+	}
+
+	/** Fraction of the processes that are profiled, between 0 and 1. See ProcessSampling. */
+	double getSamplingRate() {
+		return samplingRate;
+	}
+
+	/** Whether to record the raw callback events to a file for later replay. */
+	bool shouldRecordEvents() {
+		return recordEvents;
+	}
+
 private:
 
 	std::string processPath;
@@ -97,11 +181,28 @@ private:
 	bool dumpEnvironment;
 	bool ignoreExceptions;
 	bool startUploadDaemon;
+	bool recordEvents;
+	bool useMvidKeys;
+	std::string sharedCoverageMap;
+	std::string coverageBaseline;
+	bool testwiseCoverage;
+	bool useExecutionProbes;
+	bool recordBlockCoverage;
+	bool writePerfMap;
+	std::string callCountingAssemblies;
 	size_t eagerness;
+	size_t spoolTimeout;
+	size_t samplingInterval;
+	size_t jitCostMethods;
+	size_t startupJitOrderSeconds;
+	size_t overheadBudget;
+	double samplingRate;
 
 	void apply(ConfigFile configFile);
 	std::string getOption(std::string key);
 	bool getBooleanOption(std::string key, bool defaultValue);
+	size_t getNumericOption(std::string key, size_t defaultValue, size_t maximum = UINT32_MAX);
+	double getRateOption(std::string key, double defaultValue);
 	void setOptions();
 	void loadYamlConfig(std::istream& configFileContents);
 	bool sectionMatches(ProcessSection& section);
@@ -0,0 +1,18 @@
+#include "ProcessSampling.h"
+#include <cstdint>
+
+double ProcessSampling::getDraw(const std::string& machineName, unsigned long processId, const std::string& startTime) {
+	std::string key = machineName + '\0' + std::to_string(processId) + '\0' + startTime;
+
+	// FNV-1a, followed by the finalizer of SplitMix64 since consecutive process IDs differ only in their last bits
+	uint64_t hash = 14695981039346656037ull;
+	for (char character : key) {
+		hash = (hash ^ static_cast<uint8_t>(character)) * 1099511628211ull;
+	}
+	hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ull;
+	hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBull;
+	hash ^= hash >> 31;
+
+	// the upper 53 bits fit exactly into a double
+	return static_cast<double>(hash >> 11) / 9007199254740992.0;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "utils/Testing.h"
+#include <string>
+
+/**
+ * Decides whether a process is profiled if only a fraction of all processes should be profiled, e.g. to reduce the
+ * overhead on a fleet of servers. The decision only depends on the machine name, process ID and start time of the
+ * process, so it can be reproduced from the attach log, and is independent for different processes.
+ */
+class ProcessSampling
+{
+public:
+	/**
+	 * Returns a number in [0, 1) that is uniformly distributed over processes. A process is profiled if its draw is
+	 * less than the sampling rate.
+	 */
+	static EXPOSE_TO_CPP_TESTS double getDraw(const std::string& machineName, unsigned long processId, const std::string& startTime);
+
+	/** Whether the process with the given draw is profiled at the given sampling rate. */
+	static bool isSampled(double draw, double samplingRate) {
+		return draw < samplingRate;
+	}
+};
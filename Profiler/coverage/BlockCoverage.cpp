@@ -0,0 +1,172 @@
+#include "BlockCoverage.h"
+#include "ILMethodBody.h"
+#include <cstdint>
+#include <string.h>
+
+BlockCoverage::BlockCoverage() {
+	// the mutex initializes itself
+}
+
+BlockCoverage::~BlockCoverage() {
+	// nothing to release
+}
+
+void BlockCoverage::enable(ICorProfilerInfo* profilerInfo) {
+	this->profilerInfo = profilerInfo;
+}
+
+void BlockCoverage::instrument(ModuleID moduleId, mdMethodDef methodToken, int assemblyNumber) {
+	if (RidFromToken(methodToken) == 0) {
+		// e.g. dynamic methods
+		return;
+	}
+
+	// Holding the lock while rewriting makes other threads that jit the same method wait until the probes are in place
+	synchronization.lock();
+	if (knownMethods.insert(std::make_pair(moduleId, methodToken)).second && !insertProbes(moduleId, methodToken, assemblyNumber)) {
+		failedMethodCount++;
+	}
+	synchronization.unlock();
+}
+
+bool BlockCoverage::insertProbes(ModuleID moduleId, mdMethodDef methodToken, int assemblyNumber) {
+	LPCBYTE body = NULL;
+	ULONG bodySize = 0;
+	HRESULT hr = profilerInfo->GetILFunctionBody(moduleId, methodToken, &body, &bodySize);
+	if (FAILED(hr)) {
+		return false;
+	}
+
+	ILMethodBody method;
+	InstrumentedMethod instrumented;
+	if (!method.parse(body, bodySize) || !method.findBasicBlocks(instrumented.blockOffsets) || instrumented.blockOffsets.empty()) {
+		return false;
+	}
+
+	size_t blockCount = instrumented.blockOffsets.size();
+	// padded to whole words, so the flags of each method can be compared word by word. The padding is never set
+	size_t flagCount = (blockCount + sizeof(uint64_t) - 1) / sizeof(uint64_t) * sizeof(uint64_t);
+	BYTE* hits = allocateHitFlags(moduleId, flagCount);
+	std::vector<std::vector<BYTE>> probes;
+	for (size_t i = 0; i < blockCount; i++) {
+		probes.push_back(ILMethodBody::createHitProbe(hits + i));
+	}
+	if (!method.insertAt(instrumented.blockOffsets, probes, ILMethodBody::HIT_PROBE_MAX_STACK)) {
+		return false;
+	}
+
+	std::vector<BYTE> instrumentedBody;
+	method.write(instrumentedBody);
+
+	// The body must come from the module's allocator, since the runtime addresses it relative to the module
+	IMethodMalloc* allocator = NULL;
+	hr = profilerInfo->GetILFunctionBodyAllocator(moduleId, &allocator);
+	if (FAILED(hr) || allocator == NULL) {
+		return false;
+	}
+	void* newBody = allocator->Alloc(static_cast<ULONG>(instrumentedBody.size()));
+	allocator->Release();
+	if (newBody == NULL) {
+		return false;
+	}
+	memcpy(newBody, instrumentedBody.data(), instrumentedBody.size());
+
+	hr = profilerInfo->SetILFunctionBody(moduleId, methodToken, static_cast<LPCBYTE>(newBody));
+	if (FAILED(hr)) {
+		return false;
+	}
+
+	instrumented.assemblyNumber = assemblyNumber;
+	instrumented.methodToken = methodToken;
+	instrumented.hits = hits;
+	instrumented.reportedHits.resize(flagCount / sizeof(uint64_t), 0);
+	methods.push_back(instrumented);
+	return true;
+}
+
+BYTE* BlockCoverage::allocateHitFlags(ModuleID moduleId, size_t count) {
+	// allocated as words, so the flags can be read as words. All counts are multiples of the word size
+	if (count > CHUNK_SIZE) {
+		return reinterpret_cast<BYTE*>(new uint64_t[count / sizeof(uint64_t)]());
+	}
+
+	ModuleChunk& chunk = chunks[moduleId];
+	if (chunk.flags == NULL || chunk.usedFlags + count > CHUNK_SIZE) {
+		// the remainder of a full chunk is left unused
+		chunk.flags = reinterpret_cast<BYTE*>(new uint64_t[CHUNK_SIZE / sizeof(uint64_t)]());
+		chunk.usedFlags = 0;
+	}
+	BYTE* flags = chunk.flags + chunk.usedFlags;
+	chunk.usedFlags += count;
+	return flags;
+}
+
+void BlockCoverage::collectNewHits(std::vector<std::string>& offsetLines, std::vector<std::string>& hitLines) {
+	synchronization.lock();
+	for (InstrumentedMethod& method : methods) {
+		collectNewHits(method, offsetLines, hitLines);
+	}
+	synchronization.unlock();
+}
+
+void BlockCoverage::collectNewHits(InstrumentedMethod& method, std::vector<std::string>& offsetLines, std::vector<std::string>& hitLines) {
+	static const char* HEX_DIGITS = "0123456789abcdef";
+
+	// Most methods have no new hits, so the flags are compared a word at a time. Flags are only ever set, so a hit
+	// that races with this comparison is seen by the next collection
+	volatile uint64_t* hitWords = reinterpret_cast<volatile uint64_t*>(method.hits);
+	bool hasNewHits = false;
+	for (size_t i = 0; i < method.reportedHits.size(); i++) {
+		uint64_t hitWord = hitWords[i];
+		if (hitWord != method.reportedHits[i]) {
+			method.reportedHits[i] = hitWord;
+			hasNewHits = true;
+		}
+	}
+	if (!hasNewHits) {
+		return;
+	}
+
+	std::string prefix = std::to_string(method.assemblyNumber) + ":" + std::to_string(method.methodToken) + ":";
+	size_t blockCount = method.blockOffsets.size();
+	if (!method.isReported) {
+		method.isReported = true;
+		std::string offsets;
+		for (size_t i = 0; i < blockCount; i++) {
+			if (i > 0) {
+				offsets += ",";
+			}
+			offsets += std::to_string(method.blockOffsets[i]);
+		}
+		offsetLines.push_back(prefix + offsets);
+	}
+
+	const BYTE* reportedFlags = reinterpret_cast<const BYTE*>(method.reportedHits.data());
+	std::string bitmap;
+	bitmap.reserve((blockCount + 7) / 8 * 2);
+	for (size_t byteStart = 0; byteStart < blockCount; byteStart += 8) {
+		BYTE bitmapByte = 0;
+		for (size_t i = byteStart; i < blockCount && i < byteStart + 8; i++) {
+			if (reportedFlags[i] != 0) {
+				bitmapByte |= 1u << (i - byteStart);
+			}
+		}
+		bitmap += HEX_DIGITS[bitmapByte >> 4];
+		bitmap += HEX_DIGITS[bitmapByte & 0xF];
+	}
+	hitLines.push_back(prefix + bitmap);
+}
+
+size_t BlockCoverage::getInstrumentedMethodCount() {
+	synchronization.lock();
+	size_t count = methods.size();
+	synchronization.unlock();
+	return count;
+}
+
+size_t BlockCoverage::getFailedMethodCount() {
+	synchronization.lock();
+	size_t count = failedMethodCount;
+	synchronization.unlock();
+	return count;
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <cor.h>
+#include <corprof.h>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "platform/Mutex.h"
+
+/**
+ * Records which basic blocks of the jitted methods were executed.
+ *
+ * Methods are rewritten before they are jitted: each basic block starts with a probe that sets the block's byte in
+ * a per-module array of hit flags. A probe is a single store to a fixed address without locks, so the instrumented
+ * code stays close to native speed. The flags of a method are word-aligned, so collecting the new hits compares
+ * them a word at a time with the ones already reported. The flags are allocated in chunks that are never freed,
+ * since probes may run until the process exits.
+ *
+ * All methods are thread-safe.
+ */
+class BlockCoverage
+{
+public:
+	BlockCoverage();
+	virtual ~BlockCoverage();
+
+	/** Enables the instrumentation. Must be called before any method is instrumented. */
+	void enable(ICorProfilerInfo* profilerInfo);
+
+	/** Whether the instrumentation is enabled. */
+	bool isEnabled() {
+		return profilerInfo != NULL;
+	}
+
+	/**
+	 * Inserts the block probes into the given method unless it was already instrumented. Must be called before the method
+	 * is jitted or inlined for the first time.
+	 */
+	void instrument(ModuleID moduleId, mdMethodDef methodToken, int assemblyNumber);
+
+	/**
+	 * Appends a line for each method in which new blocks were hit since the last call to hitLines in the format
+	 * <assemblyNumber>:<methodToken>:<bitmap>. The bitmap has one bit per block of the method, set if the block was
+	 * hit so far, and is written as hex bytes with the first block in the lowest bit of the first byte. The first
+	 * time a method is reported, a line <assemblyNumber>:<methodToken>:<IL offsets of the blocks> is appended to
+	 * offsetLines, which maps the bits to the blocks.
+	 */
+	void collectNewHits(std::vector<std::string>& offsetLines, std::vector<std::string>& hitLines);
+
+	/** Returns the number of instrumented methods. */
+	size_t getInstrumentedMethodCount();
+
+	/** Returns the number of methods that could not be instrumented. */
+	size_t getFailedMethodCount();
+
+private:
+	/** Number of hit flags allocated at once for a module. */
+	static const size_t CHUNK_SIZE = 64 * 1024;
+
+	/** A method with block probes. */
+	struct InstrumentedMethod {
+		int assemblyNumber;
+		mdMethodDef methodToken;
+		volatile BYTE* hits;
+		/** IL offsets of the blocks in the original code. */
+		std::vector<ULONG> blockOffsets;
+		/** The hit flags that were already reported, as words like the hit flags. */
+		std::vector<uint64_t> reportedHits;
+		/** Whether the block offsets were already reported. */
+		bool isReported = false;
+	};
+
+	/** The current chunk of hit flags of a module. */
+	struct ModuleChunk {
+		BYTE* flags = NULL;
+		size_t usedFlags = 0;
+	};
+
+	Mutex synchronization;
+	ICorProfilerInfo* profilerInfo = NULL;
+	std::map<ModuleID, ModuleChunk> chunks;
+	std::set<std::pair<ModuleID, mdMethodDef>> knownMethods;
+	std::vector<InstrumentedMethod> methods;
+	size_t failedMethodCount = 0;
+
+	/**
+	 * Returns the given number of new hit flags of the given module, which must be a multiple of the word size. The
+	 * flags are word-aligned. Must be called from synchronized context.
+	 */
+	BYTE* allocateHitFlags(ModuleID moduleId, size_t count);
+
+	/** Appends the lines of the given method if it has new hits. Must be called from synchronized context. */
+	void collectNewHits(InstrumentedMethod& method, std::vector<std::string>& offsetLines, std::vector<std::string>& hitLines);
+
+	/** Rewrites the method. Returns false if it cannot be instrumented. Must be called from synchronized context. */
+	bool insertProbes(ModuleID moduleId, mdMethodDef methodToken, int assemblyNumber);
+};
@@ -0,0 +1,119 @@
+#include "CallCounter.h"
+
+thread_local CallCounter::ThreadCounters* CallCounter::currentThreadCounters = NULL;
+
+/** The counter that receives the calls of the enter hook. */
+static CallCounter* hookedCounter = NULL;
+
+/** Called by the enter hook stub with the ID that the function mapper returned for the called method. */
+extern "C" void __stdcall CallCounterEnter(UINT_PTR clientId) {
+	hookedCounter->countCall(clientId);
+}
+
+#ifdef _WIN64
+// Defined in CallCounterHook.asm, since the x64 compiler has no inline assembly
+extern "C" void CallCounterEnterStub(FunctionIDOrClientID functionIDOrClientID);
+#else
+/** Enter hook that preserves the registers of the profiled method, as the runtime requires. */
+static void __declspec(naked) __stdcall CallCounterEnterStub(FunctionIDOrClientID functionIDOrClientID) {
+	__asm {
+		push eax
+		push ecx
+		push edx
+		push [esp + 16]
+		call CallCounterEnter
+		pop edx
+		pop ecx
+		pop eax
+		ret 4
+	}
+}
+#endif
+
+CallCounter::CallCounter() {
+	InitializeCriticalSection(&synchronization);
+}
+
+CallCounter::~CallCounter() {
+	if (hookedCounter != this) {
+		DeleteCriticalSection(&synchronization);
+	}
+}
+
+HRESULT CallCounter::installHook(ICorProfilerInfo3* profilerInfo) {
+	hookedCounter = this;
+	return profilerInfo->SetEnterLeaveFunctionHooks3(CallCounterEnterStub, NULL, NULL);
+}
+
+bool CallCounter::addMethod(int assemblyNumber, mdToken functionToken, UINT_PTR* id) {
+	EnterCriticalSection(&synchronization);
+	bool isAdded = methods.size() < PAGE_SIZE * MAX_PAGES;
+	if (isAdded) {
+		*id = methods.size();
+		methods.push_back({ assemblyNumber, functionToken, 0 });
+	}
+	LeaveCriticalSection(&synchronization);
+	return isAdded;
+}
+
+void CallCounter::countCall(UINT_PTR id) {
+	ThreadCounters* counters = currentThreadCounters;
+	if (counters == NULL || counters->owner != this) {
+		counters = registerThread();
+	}
+
+	volatile UINT_PTR* page = counters->pages[id / PAGE_SIZE];
+	if (page == NULL) {
+		// only this thread writes its pages, so publishing the page needs no lock
+		page = new UINT_PTR[PAGE_SIZE]();
+		counters->pages[id / PAGE_SIZE] = page;
+	}
+	page[id % PAGE_SIZE]++;
+}
+
+CallCounter::ThreadCounters* CallCounter::registerThread() {
+	ThreadCounters* counters = new ThreadCounters();
+	counters->owner = this;
+
+	EnterCriticalSection(&synchronization);
+	threads.push_back(counters);
+	LeaveCriticalSection(&synchronization);
+
+	currentThreadCounters = counters;
+	return counters;
+}
+
+void CallCounter::collectCalls(std::vector<std::string>& lines) {
+	EnterCriticalSection(&synchronization);
+	std::vector<ULONG64> calls(methods.size(), 0);
+	for (ThreadCounters* counters : threads) {
+		for (size_t pageStart = 0; pageStart < methods.size(); pageStart += PAGE_SIZE) {
+			volatile UINT_PTR* page = counters->pages[pageStart / PAGE_SIZE];
+			if (page == NULL) {
+				continue;
+			}
+
+			size_t pageEnd = methods.size() - pageStart < PAGE_SIZE ? methods.size() - pageStart : PAGE_SIZE;
+			for (size_t i = 0; i < pageEnd; i++) {
+				calls[pageStart + i] += page[i];
+			}
+		}
+	}
+
+	for (size_t id = 0; id < methods.size(); id++) {
+		CountedMethod& method = methods[id];
+		if (calls[id] > method.reportedCalls) {
+			lines.push_back(std::to_string(method.assemblyNumber) + ":" + std::to_string(method.functionToken) + ":" +
+				std::to_string(calls[id] - method.reportedCalls));
+			method.reportedCalls = calls[id];
+		}
+	}
+	LeaveCriticalSection(&synchronization);
+}
+
+size_t CallCounter::getMethodCount() {
+	EnterCriticalSection(&synchronization);
+	size_t count = methods.size();
+	LeaveCriticalSection(&synchronization);
+	return count;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <Windows.h>
+#include <cor.h>
+#include <corprof.h>
+#include <string>
+#include <vector>
+#include "utils/Testing.h"
+
+/**
+ * Counts the calls of selected methods with an enter hook.
+ *
+ * Each counted method gets a compact ID when it is jitted, which the runtime passes to the hook as client ID. The hook
+ * increments the method's counter in an array that only the calling thread writes, so counting needs neither locks
+ * nor atomic instructions. The counters of all threads are summed up when the calls are collected.
+ *
+ * Counters are allocated in pages that are never freed, since hooks may run until the process exits.
+ */
+class CallCounter
+{
+public:
+	/** Number of counters that are allocated at once for a thread. */
+	static const size_t PAGE_SIZE = 4096;
+
+	/** Maximum number of pages per thread, which limits the number of counted methods. */
+	static const size_t MAX_PAGES = 1024;
+
+	CallCounter();
+	virtual ~CallCounter();
+
+	/** Makes the runtime call the enter hook of all methods for which the function mapper returns an ID of this counter. */
+	HRESULT installHook(ICorProfilerInfo3* profilerInfo);
+
+	/** Assigns an ID to the given method. Returns false if no more methods can be counted. */
+	bool EXPOSE_TO_CPP_TESTS addMethod(int assemblyNumber, mdToken functionToken, UINT_PTR* id);
+
+	/** Counts a call of the method with the given ID on the current thread. */
+	void EXPOSE_TO_CPP_TESTS countCall(UINT_PTR id);
+
+	/**
+	 * Appends <assemblyNumber>:<functionToken>:<calls> for each method that was called since the last call, with
+	 * the number of calls in between.
+	 */
+	void EXPOSE_TO_CPP_TESTS collectCalls(std::vector<std::string>& lines);
+
+	/** Returns the number of counted methods. */
+	size_t getMethodCount();
+
+private:
+	/** A method with an ID. */
+	struct CountedMethod {
+		int assemblyNumber;
+		mdToken functionToken;
+		ULONG64 reportedCalls;
+	};
+
+	/** The counters of one thread. */
+	struct ThreadCounters {
+		CallCounter* owner;
+		volatile UINT_PTR* volatile pages[MAX_PAGES];
+	};
+
+	/** The counters of the current thread, which are only written by that thread. */
+	static thread_local ThreadCounters* currentThreadCounters;
+
+	/** Guards the methods and the list of threads. Never taken by the hook unless a thread counts its first call. */
+	CRITICAL_SECTION synchronization;
+
+	std::vector<CountedMethod> methods;
+	std::vector<ThreadCounters*> threads;
+
+	/** Creates the counters of the current thread. */
+	ThreadCounters* registerThread();
+};
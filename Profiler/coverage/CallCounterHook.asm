@@ -0,0 +1,58 @@
+; Enter hook of the CallCounter for x64. The runtime calls enter hooks directly from the prolog of the profiled
+; method, so the hook must preserve all registers that may hold arguments of that method.
+
+extern CallCounterEnter:proc
+
+_text segment 'code'
+
+CallCounterEnterStub proc frame
+	push rax
+	.pushreg rax
+	push rcx
+	.pushreg rcx
+	push rdx
+	.pushreg rdx
+	push r8
+	.pushreg r8
+	push r9
+	.pushreg r9
+	push r10
+	.pushreg r10
+	push r11
+	.pushreg r11
+	; shadow space and xmm0-xmm5, keeping the stack 16-byte aligned for the call
+	sub rsp, 80h
+	.allocstack 80h
+	.endprolog
+
+	movdqu [rsp + 20h], xmm0
+	movdqu [rsp + 30h], xmm1
+	movdqu [rsp + 40h], xmm2
+	movdqu [rsp + 50h], xmm3
+	movdqu [rsp + 60h], xmm4
+	movdqu [rsp + 70h], xmm5
+
+	; rcx still holds the client ID
+	call CallCounterEnter
+
+	movdqu xmm0, [rsp + 20h]
+	movdqu xmm1, [rsp + 30h]
+	movdqu xmm2, [rsp + 40h]
+	movdqu xmm3, [rsp + 50h]
+	movdqu xmm4, [rsp + 60h]
+	movdqu xmm5, [rsp + 70h]
+
+	add rsp, 80h
+	pop r11
+	pop r10
+	pop r9
+	pop r8
+	pop rdx
+	pop rcx
+	pop rax
+	ret
+CallCounterEnterStub endp
+
+_text ends
+
+end
@@ -0,0 +1,131 @@
+#include "CoverageBaseline.h"
+#include "platform/Platform.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+/** Changes whenever the layout of baseline files changes, so old files are ignored instead of misread. */
+static const char MAGIC[8] = { 'T', 'S', 'B', 'A', 'S', 'E', 'L', '1' };
+
+bool CoverageBaseline::open(const std::string& directory) {
+	if (directory.empty() || !Platform::createDirectory(directory)) {
+		return false;
+	}
+	this->directory = directory;
+	return true;
+}
+
+void CoverageBaseline::addAssembly(int assemblyNumber, const std::string& mvid, uint32_t methodCount) {
+	if (!isOpen() || assemblyNumber < 0 || mvid.empty()) {
+		return;
+	}
+	if (static_cast<size_t>(assemblyNumber) >= modules.size()) {
+		modules.resize(assemblyNumber + 1);
+	}
+	std::unique_ptr<Module> module(new Module());
+	module->mvid = mvid;
+	module->methodCount = methodCount;
+	mapBaseline(getPath(mvid), methodCount, module->file, module->baselineWords, module->baselineWordCount);
+	modules[assemblyNumber] = std::move(module);
+}
+
+void CoverageBaseline::add(int assemblyNumber, uint32_t methodToken) {
+	if (assemblyNumber < 0 || static_cast<size_t>(assemblyNumber) >= modules.size() || !modules[assemblyNumber]) {
+		return;
+	}
+	Module& module = *modules[assemblyNumber];
+	uint32_t rid = methodToken & 0x00FFFFFF;
+	if (rid > module.methodCount) {
+		return;
+	}
+	if (module.addedWords.empty()) {
+		// RIDs start at 1
+		module.addedWords.resize((static_cast<size_t>(module.methodCount) + 1 + 63) / 64);
+	}
+	uint64_t bit = static_cast<uint64_t>(1) << (rid % 64);
+	if ((module.addedWords[rid / 64] & bit) == 0) {
+		module.addedWords[rid / 64] |= bit;
+		addedMethodCount++;
+	}
+}
+
+size_t CoverageBaseline::save(size_t& failedCount) {
+	size_t savedCount = 0;
+	failedCount = 0;
+	for (std::unique_ptr<Module>& module : modules) {
+		if (!module) {
+			continue;
+		}
+		// Windows cannot replace mapped files
+		module->file.close();
+		if (module->addedWords.empty()) {
+			continue;
+		}
+
+		// other processes may have saved the module since it was mapped
+		std::string path = getPath(module->mvid);
+		std::vector<uint64_t> words = module->addedWords;
+		{
+			MappedFile current;
+			const uint64_t* currentWords = NULL;
+			size_t currentWordCount = 0;
+			if (mapBaseline(path, module->methodCount, current, currentWords, currentWordCount)) {
+				for (size_t i = 0; i < words.size() && i < currentWordCount; i++) {
+					words[i] |= currentWords[i];
+				}
+			}
+		}
+
+		Header header;
+		memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.methodCount = module->methodCount;
+		header.wordCount = static_cast<uint32_t>(words.size());
+		std::string temporaryPath = path + "." + std::to_string(Platform::getProcessId()) + ".tmp";
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint64_t));
+		file.close();
+		if (!file) {
+			Platform::removeFile(temporaryPath);
+			failedCount++;
+			continue;
+		}
+		if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+			// on Windows, renaming fails if the file exists
+			Platform::removeFile(path);
+			if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+				Platform::removeFile(temporaryPath);
+				failedCount++;
+				continue;
+			}
+		}
+		savedCount++;
+	}
+	modules.clear();
+	return savedCount;
+}
+
+std::string CoverageBaseline::getPath(const std::string& mvid) const {
+	return directory + Platform::PATH_SEPARATOR + mvid + ".baseline";
+}
+
+bool CoverageBaseline::mapBaseline(const std::string& path, uint32_t methodCount, MappedFile& file, const uint64_t*& words, size_t& wordCount) {
+	words = NULL;
+	wordCount = 0;
+	if (!file.open(path) || file.getSize() < sizeof(Header)) {
+		file.close();
+		return false;
+	}
+	Header header;
+	memcpy(&header, file.getData(), sizeof(header));
+	if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.methodCount != methodCount ||
+		file.getSize() != sizeof(Header) + static_cast<uint64_t>(header.wordCount) * sizeof(uint64_t)) {
+		// e.g. a module rebuilt with the same MVID or a file of another version
+		file.close();
+		return false;
+	}
+	// the mapping is page-aligned and the header is a multiple of 8 bytes long
+	words = reinterpret_cast<const uint64_t*>(file.getData() + sizeof(Header));
+	wordCount = header.wordCount;
+	return true;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include "platform/MappedFile.h"
+#include "utils/Testing.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * The methods that previous runs already reported, as one bitmap file per module named after its MVID. Bit i stands
+ * for the method with RID i.
+ *
+ * Unlike the shared coverage map, the baseline does not change while the process runs: the bitmaps are mapped
+ * read-only when their assemblies load, methods in them are not reported, and the methods this process reported are
+ * added to the files at shutdown. Files are replaced by renaming a new version over them, so concurrent processes
+ * never see a half-written baseline. If two processes save the same module at once, the methods of one of them are
+ * missing and simply reported again by the next run.
+ *
+ * Not thread-safe. The profiler uses it from synchronized context only.
+ */
+class CoverageBaseline
+{
+public:
+	/** Uses the baseline files in the given directory, which is created if it does not exist. Returns false if that fails. */
+	bool EXPOSE_TO_CPP_TESTS open(const std::string& directory);
+
+	/** Whether the baseline is used. */
+	bool isOpen() const {
+		return !directory.empty();
+	}
+
+	/** The directory of the baseline files. */
+	const std::string& getDirectory() const {
+		return directory;
+	}
+
+	/**
+	 * Maps the baseline of the module with the given MVID, which has the given number of methods, and makes it the
+	 * baseline of the assembly with the given number. A missing file or one with another method count is an empty baseline.
+	 */
+	void EXPOSE_TO_CPP_TESTS addAssembly(int assemblyNumber, const std::string& mvid, uint32_t methodCount);
+
+	/** Whether the baseline of the given assembly contains the given method. */
+	bool contains(int assemblyNumber, uint32_t methodToken) const {
+		if (assemblyNumber < 0 || static_cast<size_t>(assemblyNumber) >= modules.size() || !modules[assemblyNumber]) {
+			return false;
+		}
+		const Module& module = *modules[assemblyNumber];
+		uint32_t rid = methodToken & 0x00FFFFFF;
+		return rid / 64 < module.baselineWordCount && (module.baselineWords[rid / 64] & (static_cast<uint64_t>(1) << (rid % 64))) != 0;
+	}
+
+	/** Records that the given method was reported, so it is added to the baseline of its assembly by save(). */
+	void EXPOSE_TO_CPP_TESTS add(int assemblyNumber, uint32_t methodToken);
+
+	/** The number of distinct methods that were added since the baseline was loaded. */
+	size_t getAddedMethodCount() const {
+		return addedMethodCount;
+	}
+
+	/**
+	 * Writes the baselines of all assemblies with added methods, merged with their current files, and unmaps all
+	 * baselines. Returns the number of written files. Files that cannot be written are counted in failedCount.
+	 */
+	size_t EXPOSE_TO_CPP_TESTS save(size_t& failedCount);
+
+private:
+	/** The first bytes of a baseline file. All numbers are little-endian. */
+	struct Header {
+		/** Identifies baseline files and their version. */
+		char magic[8];
+		uint32_t methodCount;
+		uint32_t wordCount;
+	};
+
+	/** The baseline of an assembly and the methods added to it. */
+	struct Module {
+		std::string mvid;
+		uint32_t methodCount = 0;
+		MappedFile file;
+		const uint64_t* baselineWords = NULL;
+		size_t baselineWordCount = 0;
+		std::vector<uint64_t> addedWords;
+	};
+
+	std::string directory;
+
+	/** Indexed by assembly number. Assemblies without MVID have no module. */
+	std::vector<std::unique_ptr<Module>> modules;
+
+	size_t addedMethodCount = 0;
+
+	/** Returns the path of the baseline file of the module with the given MVID. */
+	std::string getPath(const std::string& mvid) const;
+
+	/** Maps the given baseline file. Returns false if it is missing or does not belong to a module with the given method count. */
+	static bool mapBaseline(const std::string& path, uint32_t methodCount, MappedFile& file, const uint64_t*& words, size_t& wordCount);
+};
@@ -0,0 +1,183 @@
+#include "ExecutionProbes.h"
+#include "ILMethodBody.h"
+
+/** Milliseconds to wait for the polling thread at shutdown. */
+static const unsigned long SHUTDOWN_TIMEOUT = 1000;
+
+ExecutionProbes::ExecutionProbes() {
+	// the mutexes and the event initialize themselves
+}
+
+ExecutionProbes::~ExecutionProbes() {
+	shutdown();
+}
+
+bool ExecutionProbes::start(ICorProfilerInfo4* profilerInfo, ExecutedMethodsHandler handler) {
+	this->profilerInfo = profilerInfo;
+	this->handler = handler;
+
+	return pollingThread.start(runPollingThread, this);
+}
+
+void ExecutionProbes::runPollingThread(void* parameter) {
+	ExecutionProbes* probes = static_cast<ExecutionProbes*>(parameter);
+	while (!probes->stopEvent.wait(POLL_INTERVAL)) {
+		probes->collectHits();
+	}
+}
+
+void ExecutionProbes::shutdown() {
+	if (!pollingThread.isStarted()) {
+		return;
+	}
+
+	isShuttingDown = true;
+	stopEvent.set();
+	// if the thread is stuck in the handler, e.g. because we are called from DllMain, it is left behind
+	pollingThread.join(SHUTDOWN_TIMEOUT);
+}
+
+void ExecutionProbes::registerModule(ModuleID moduleId, ULONG methodCount) {
+	probeSynchronization.lock();
+	if (modules.find(moduleId) == modules.end()) {
+		// RIDs start at 1
+		ModuleProbes& probes = modules[moduleId];
+		probes.hits = new BYTE[methodCount + 1]();
+		// copied, since resize takes a reference and the constant has no out-of-class definition
+		probes.states.resize(methodCount + 1, static_cast<BYTE>(METHOD_UNKNOWN));
+	}
+	probeSynchronization.unlock();
+}
+
+ExecutionProbes::ModuleProbes* ExecutionProbes::findModule(ModuleID moduleId, mdMethodDef methodToken) {
+	// Must be called from synchronized context
+	std::map<ModuleID, ModuleProbes>::iterator module = modules.find(moduleId);
+	if (module == modules.end() || RidFromToken(methodToken) >= module->second.states.size()) {
+		return NULL;
+	}
+	return &module->second;
+}
+
+void ExecutionProbes::registerMethod(ModuleID moduleId, mdMethodDef methodToken) {
+	probeSynchronization.lock();
+	ModuleProbes* probes = findModule(moduleId, methodToken);
+	ULONG rid = RidFromToken(methodToken);
+	if (probes != NULL && probes->states[rid] == METHOD_UNKNOWN) {
+		probes->states[rid] = METHOD_REGISTERED;
+		probes->methods.push_back(rid);
+	}
+	probeSynchronization.unlock();
+}
+
+HRESULT ExecutionProbes::arm() {
+	// Prevents reverting a method that was hit before it is armed again
+	collectSynchronization.lock();
+
+	std::vector<ModuleID> moduleIds;
+	std::vector<mdMethodDef> methodTokens;
+	probeSynchronization.lock();
+	for (std::pair<const ModuleID, ModuleProbes>& module : modules) {
+		ModuleProbes& probes = module.second;
+		for (ULONG rid : probes.methods) {
+			if (probes.states[rid] == METHOD_REGISTERED) {
+				probes.states[rid] = METHOD_ARMED;
+				probes.hits[rid] = 0;
+				moduleIds.push_back(module.first);
+				methodTokens.push_back(TokenFromRid(rid, mdtMethodDef));
+			}
+		}
+	}
+	probeSynchronization.unlock();
+
+	HRESULT hr = S_OK;
+	if (!moduleIds.empty()) {
+		hr = profilerInfo->RequestReJIT(static_cast<ULONG>(moduleIds.size()), moduleIds.data(), methodTokens.data());
+	}
+	collectSynchronization.unlock();
+	return hr;
+}
+
+void ExecutionProbes::collectHits() {
+	collectSynchronization.lock();
+
+	std::vector<ProbedMethod> hitMethods;
+	probeSynchronization.lock();
+	for (std::pair<const ModuleID, ModuleProbes>& module : modules) {
+		ModuleProbes& probes = module.second;
+		for (ULONG rid : probes.methods) {
+			if (probes.states[rid] == METHOD_ARMED && probes.hits[rid] != 0) {
+				probes.states[rid] = METHOD_REGISTERED;
+				hitMethods.push_back({ module.first, TokenFromRid(rid, mdtMethodDef) });
+			}
+		}
+	}
+	probeSynchronization.unlock();
+
+	if (!hitMethods.empty()) {
+		handler(hitMethods);
+
+		// The runtime may already be gone at shutdown
+		if (!isShuttingDown) {
+			std::vector<ModuleID> moduleIds;
+			std::vector<mdMethodDef> methodTokens;
+			for (ProbedMethod& method : hitMethods) {
+				moduleIds.push_back(method.moduleId);
+				methodTokens.push_back(method.methodToken);
+			}
+			profilerInfo->RequestRevert(static_cast<ULONG>(moduleIds.size()), moduleIds.data(), methodTokens.data(), NULL);
+		}
+	}
+	collectSynchronization.unlock();
+}
+
+HRESULT ExecutionProbes::instrument(ModuleID moduleId, mdMethodDef methodToken, ICorProfilerFunctionControl* functionControl) {
+	volatile BYTE* hitFlag = NULL;
+	probeSynchronization.lock();
+	ModuleProbes* probes = findModule(moduleId, methodToken);
+	if (probes != NULL && probes->states[RidFromToken(methodToken)] == METHOD_ARMED) {
+		hitFlag = probes->hits + RidFromToken(methodToken);
+	}
+	probeSynchronization.unlock();
+
+	if (hitFlag == NULL) {
+		// keep the original IL
+		return S_OK;
+	}
+
+	LPCBYTE body = NULL;
+	ULONG bodySize = 0;
+	ILMethodBody method;
+	HRESULT hr = profilerInfo->GetILFunctionBody(moduleId, methodToken, &body, &bodySize);
+	if (FAILED(hr) || !method.parse(body, bodySize)) {
+		handleError(moduleId, methodToken);
+		return S_OK;
+	}
+
+	method.insertAtStart(ILMethodBody::createHitProbe(hitFlag), ILMethodBody::HIT_PROBE_MAX_STACK);
+	std::vector<BYTE> instrumentedBody;
+	method.write(instrumentedBody);
+
+	// The runtime copies the body
+	hr = functionControl->SetILFunctionBody(static_cast<ULONG>(instrumentedBody.size()), instrumentedBody.data());
+	if (FAILED(hr)) {
+		handleError(moduleId, methodToken);
+	}
+	return hr;
+}
+
+void ExecutionProbes::handleError(ModuleID moduleId, mdMethodDef methodToken) {
+	probeSynchronization.lock();
+	ModuleProbes* probes = findModule(moduleId, methodToken);
+	if (probes != NULL && probes->states[RidFromToken(methodToken)] != METHOD_FAILED) {
+		probes->states[RidFromToken(methodToken)] = METHOD_FAILED;
+		failedMethodCount++;
+	}
+	probeSynchronization.unlock();
+}
+
+size_t ExecutionProbes::getFailedMethodCount() {
+	probeSynchronization.lock();
+	size_t count = failedMethodCount;
+	probeSynchronization.unlock();
+	return count;
+}
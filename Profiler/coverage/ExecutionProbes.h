@@ -0,0 +1,111 @@
+#pragma once
+#include <cor.h>
+#include <corprof.h>
+#include "platform/ComPtr.h"
+#include "platform/Event.h"
+#include "platform/Mutex.h"
+#include "platform/Thread.h"
+#include <atomic>
+#include <functional>
+#include <map>
+#include <vector>
+
+/** A method that is identified by its module and metadata token. */
+struct ProbedMethod {
+	ModuleID moduleId;
+	mdMethodDef methodToken;
+};
+
+/** Called with the methods whose probes were hit since the last call. */
+typedef std::function<void(const std::vector<ProbedMethod>& methods)> ExecutedMethodsHandler;
+
+/**
+ * Detects the next execution of methods that have already been jitted by re-jitting them with a probe.
+ *
+ * Each probe is a few IL instructions at the start of the method that set the method's byte in a per-module array of
+ * hit flags. A background thread polls these flags, reports hit methods to the handler and reverts them to their
+ * original native code with RequestRevert, so a method only pays for the probe until its first execution.
+ *
+ * Arming the probes is explicit: arm() re-jits all registered methods that are not armed yet, e.g. when a new test
+ * starts. Re-jitting is lazy, so only methods that are actually called again are compiled again.
+ */
+class ExecutionProbes
+{
+public:
+	ExecutionProbes();
+	virtual ~ExecutionProbes();
+
+	/** Starts polling the probes in a background thread. Returns false if that fails. */
+	bool start(ICorProfilerInfo4* profilerInfo, ExecutedMethodsHandler handler);
+
+	/** Whether the probes were started. */
+	bool isStarted() {
+		return pollingThread.isStarted();
+	}
+
+	/** Allocates the hit flags for the methods of the given module. Must be called before its methods are registered. */
+	void registerModule(ModuleID moduleId, ULONG methodCount);
+
+	/** Registers a jitted method so it is armed by the next call of arm(). */
+	void registerMethod(ModuleID moduleId, mdMethodDef methodToken);
+
+	/** Re-jits all registered methods with a probe unless they are still armed. */
+	HRESULT arm();
+
+	/** Reports all methods whose probes were hit to the handler and reverts them. */
+	void collectHits();
+
+	/** Inserts the probe into the given method. Called from GetReJITParameters. */
+	HRESULT instrument(ModuleID moduleId, mdMethodDef methodToken, ICorProfilerFunctionControl* functionControl);
+
+	/** Excludes a method that cannot be re-jitted from further arming. Called from ReJITError. */
+	void handleError(ModuleID moduleId, mdMethodDef methodToken);
+
+	/** Returns the number of methods that could not be probed. */
+	size_t getFailedMethodCount();
+
+	/** Stops polling. Call collectHits() afterwards to report the remaining hits. */
+	void shutdown();
+
+private:
+	/** Milliseconds between two polls of the hit flags. */
+	static const unsigned long POLL_INTERVAL = 200;
+
+	/** States of a registered method. */
+	static const BYTE METHOD_UNKNOWN = 0;
+	static const BYTE METHOD_REGISTERED = 1;
+	static const BYTE METHOD_ARMED = 2;
+	static const BYTE METHOD_FAILED = 3;
+
+	/** The probes and states of the methods of one module, indexed by RID. */
+	struct ModuleProbes {
+		/**
+		 * One flag per method. Never freed since jitted probes may run until the process exits,
+		 * even after the profiler was shut down.
+		 */
+		volatile BYTE* hits;
+		std::vector<BYTE> states;
+		/** RIDs of all registered methods. */
+		std::vector<ULONG> methods;
+	};
+
+	/** Guards the modules and method states. Never held while calling into the runtime. */
+	Mutex probeSynchronization;
+
+	/** Serializes collecting hits, so the handler receives them in order. */
+	Mutex collectSynchronization;
+
+	ComPtr<ICorProfilerInfo4> profilerInfo;
+	ExecutedMethodsHandler handler;
+	std::map<ModuleID, ModuleProbes> modules;
+	size_t failedMethodCount = 0;
+	Thread pollingThread;
+	Event stopEvent;
+	std::atomic<bool> isShuttingDown{ false };
+
+	/** Entry point of the polling thread. */
+	static void runPollingThread(void* parameter);
+
+	/** Returns the probes of the module of the given method if it is registered and the RID is valid. */
+	ModuleProbes* findModule(ModuleID moduleId, mdMethodDef methodToken);
+};
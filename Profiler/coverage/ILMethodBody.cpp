@@ -0,0 +1,461 @@
+#include "ILMethodBody.h"
+#include <string.h>
+#include <cstddef>
+#include <set>
+
+/** Size of a fat header in bytes. */
+static const ULONG FAT_HEADER_SIZE = 12;
+
+/** Sizes of the section header and of a single clause in small and fat exception handling sections. */
+static const ULONG SECTION_HEADER_SIZE = 4;
+static const ULONG SMALL_CLAUSE_SIZE = 12;
+static const ULONG FAT_CLAUSE_SIZE = 24;
+
+template<typename T> static T readValue(const BYTE* position) {
+	T value;
+	memcpy(&value, position, sizeof(T));
+	return value;
+}
+
+template<typename T> static void appendValue(std::vector<BYTE>& output, T value) {
+	const BYTE* bytes = reinterpret_cast<const BYTE*>(&value);
+	output.insert(output.end(), bytes, bytes + sizeof(T));
+}
+
+/** The IL opcodes used by hit probes. */
+static const BYTE OPCODE_LDC_I8 = 0x21;
+static const BYTE OPCODE_CONV_U = 0xE0;
+static const BYTE OPCODE_LDC_I4_1 = 0x17;
+static const BYTE OPCODE_STIND_I1 = 0x52;
+
+/** Operand sizes of opcodes that are not valid or have a variable size. */
+static const BYTE INVALID_OPCODE = 0xFF;
+static const BYTE SWITCH_OPERAND = 0xFE;
+
+/** The prefix of two-byte opcodes. */
+static const BYTE TWO_BYTE_PREFIX = 0xFE;
+
+/** Opcodes that need special treatment when decoding or moving code (ECMA-335, III). */
+static const USHORT OPCODE_JMP = 0x27;
+static const USHORT OPCODE_RET = 0x2A;
+static const USHORT OPCODE_BR_S = 0x2B;
+static const USHORT OPCODE_BLT_UN_S = 0x37;
+static const USHORT OPCODE_BR = 0x38;
+static const USHORT OPCODE_BLT_UN = 0x44;
+static const USHORT OPCODE_SWITCH = 0x45;
+static const USHORT OPCODE_THROW = 0x7A;
+static const USHORT OPCODE_ENDFINALLY = 0xDC;
+static const USHORT OPCODE_LEAVE = 0xDD;
+static const USHORT OPCODE_LEAVE_S = 0xDE;
+static const USHORT OPCODE_ENDFILTER = 0xFE11;
+static const USHORT OPCODE_RETHROW = 0xFE1A;
+
+/** Marks offsets that are not the start of an instruction. */
+static const ULONG UNMAPPED = 0xFFFFFFFF;
+
+/** Size of a long branch instruction. */
+static const ULONG LONG_BRANCH_SIZE = 5;
+
+/** Returns the operand size of the given one-byte opcode. */
+static BYTE getOperandSize(BYTE opcode) {
+	if (opcode <= 0x0D || (opcode >= 0x14 && opcode <= 0x1E) || opcode == 0x25 || opcode == 0x26 || opcode == OPCODE_RET
+		|| (opcode >= 0x46 && opcode <= 0x6E) || opcode == 0x76 || opcode == OPCODE_THROW || (opcode >= 0x82 && opcode <= 0x8B)
+		|| opcode == 0x8E || (opcode >= 0x90 && opcode <= 0xA2) || (opcode >= 0xB3 && opcode <= 0xBA) || opcode == 0xC3
+		|| (opcode >= 0xD1 && opcode <= OPCODE_ENDFINALLY) || opcode == 0xDF || opcode == 0xE0) {
+		return 0;
+	}
+	if ((opcode >= 0x0E && opcode <= 0x13) || opcode == 0x1F || (opcode >= OPCODE_BR_S && opcode <= OPCODE_BLT_UN_S) || opcode == OPCODE_LEAVE_S) {
+		return 1;
+	}
+	if (opcode == 0x20 || opcode == 0x22 || (opcode >= OPCODE_JMP && opcode <= 0x29) || (opcode >= OPCODE_BR && opcode <= OPCODE_BLT_UN)
+		|| (opcode >= 0x6F && opcode <= 0x75) || opcode == 0x79 || (opcode >= 0x7B && opcode <= 0x81) || opcode == 0x8C || opcode == 0x8D
+		|| opcode == 0x8F || (opcode >= 0xA3 && opcode <= 0xA5) || opcode == 0xC2 || opcode == 0xC6 || opcode == 0xD0
+		|| opcode == OPCODE_LEAVE) {
+		return 4;
+	}
+	if (opcode == 0x21 || opcode == 0x23) {
+		return 8;
+	}
+	if (opcode == OPCODE_SWITCH) {
+		return SWITCH_OPERAND;
+	}
+	return INVALID_OPCODE;
+}
+
+/** Returns the operand size of the two-byte opcode with the given second byte. */
+static BYTE getTwoByteOperandSize(BYTE opcode) {
+	if (opcode <= 0x05 || opcode == 0x0F || opcode == 0x11 || opcode == 0x13 || opcode == 0x14 || opcode == 0x17 || opcode == 0x18
+		|| opcode == 0x1A || opcode == 0x1D || opcode == 0x1E) {
+		return 0;
+	}
+	if (opcode == 0x12 || opcode == 0x19) {
+		return 1;
+	}
+	if (opcode >= 0x09 && opcode <= 0x0E) {
+		return 2;
+	}
+	if (opcode == 0x06 || opcode == 0x07 || opcode == 0x15 || opcode == 0x16 || opcode == 0x1C) {
+		return 4;
+	}
+	return INVALID_OPCODE;
+}
+
+/** Whether the given opcode is a short branch that is widened when code is moved. */
+static bool isShortBranch(USHORT opcode) {
+	return (opcode >= OPCODE_BR_S && opcode <= OPCODE_BLT_UN_S) || opcode == OPCODE_LEAVE_S;
+}
+
+/** Whether the given opcode never continues with the next instruction or is a conditional branch. */
+static bool endsBlock(USHORT opcode) {
+	return (opcode >= OPCODE_BR_S && opcode <= OPCODE_SWITCH) || opcode == OPCODE_JMP || opcode == OPCODE_RET
+		|| opcode == OPCODE_THROW || opcode == OPCODE_ENDFINALLY || opcode == OPCODE_LEAVE || opcode == OPCODE_LEAVE_S
+		|| opcode == OPCODE_ENDFILTER || opcode == OPCODE_RETHROW;
+}
+
+/** Whether the region starts and ends at offsets that are mapped to new offsets. */
+static bool isMappedRegion(const std::vector<ULONG>& newOffsets, ULONG offset, ULONG length) {
+	return offset < newOffsets.size() && length <= newOffsets.size() - 1 - offset
+		&& newOffsets[offset] != UNMAPPED && newOffsets[offset + length] != UNMAPPED;
+}
+
+/** Returns the offset aligned to the next multiple of four. */
+static size_t alignToDword(size_t offset) {
+	return (offset + 3) & ~static_cast<size_t>(3);
+}
+
+bool ILMethodBody::parse(const BYTE* body, ULONG size) {
+	code.clear();
+	exceptionClauses.clear();
+	if (size < 1) {
+		return false;
+	}
+
+	if ((body[0] & 0x3) == CorILMethod_TinyFormat) {
+		ULONG codeSize = body[0] >> 2;
+		if (1 + codeSize > size) {
+			return false;
+		}
+		code.assign(body + 1, body + 1 + codeSize);
+		maxStack = 8;
+		localVarSigToken = 0;
+		initLocals = false;
+		return true;
+	}
+
+	if (size < FAT_HEADER_SIZE || (body[0] & CorILMethod_FormatMask) != CorILMethod_FatFormat) {
+		return false;
+	}
+
+	USHORT flagsAndSize = readValue<USHORT>(body);
+	ULONG headerSize = (flagsAndSize >> 12) * 4;
+	maxStack = readValue<USHORT>(body + 2);
+	ULONG codeSize = readValue<ULONG>(body + 4);
+	localVarSigToken = readValue<ULONG>(body + 8);
+	initLocals = (flagsAndSize & CorILMethod_InitLocals) != 0;
+	if (headerSize < FAT_HEADER_SIZE || headerSize > size || codeSize > size - headerSize) {
+		return false;
+	}
+	code.assign(body + headerSize, body + headerSize + codeSize);
+
+	if ((flagsAndSize & CorILMethod_MoreSects) == 0) {
+		return true;
+	}
+	size_t sectionsOffset = alignToDword(headerSize + codeSize);
+	if (sectionsOffset > size) {
+		return false;
+	}
+	return parseExtraSections(body + sectionsOffset, body + size);
+}
+
+bool ILMethodBody::parseExtraSections(const BYTE* position, const BYTE* end) {
+	bool hasMoreSections = true;
+	while (hasMoreSections) {
+		if (end - position < static_cast<ptrdiff_t>(SECTION_HEADER_SIZE)) {
+			return false;
+		}
+		BYTE kind = position[0];
+		if ((kind & CorILMethod_Sect_KindMask) != CorILMethod_Sect_EHTable) {
+			return false;
+		}
+
+		bool isFat = (kind & CorILMethod_Sect_FatFormat) != 0;
+		ULONG dataSize = isFat ? (readValue<ULONG>(position) >> 8) : position[1];
+		ULONG clauseSize = isFat ? FAT_CLAUSE_SIZE : SMALL_CLAUSE_SIZE;
+		if (dataSize < SECTION_HEADER_SIZE || end - position < static_cast<ptrdiff_t>(dataSize)) {
+			return false;
+		}
+
+		ULONG clauseCount = (dataSize - SECTION_HEADER_SIZE) / clauseSize;
+		const BYTE* clause = position + SECTION_HEADER_SIZE;
+		for (ULONG i = 0; i < clauseCount; i++, clause += clauseSize) {
+			ExceptionClause parsed;
+			if (isFat) {
+				parsed.flags = readValue<ULONG>(clause);
+				parsed.tryOffset = readValue<ULONG>(clause + 4);
+				parsed.tryLength = readValue<ULONG>(clause + 8);
+				parsed.handlerOffset = readValue<ULONG>(clause + 12);
+				parsed.handlerLength = readValue<ULONG>(clause + 16);
+				parsed.classTokenOrFilterOffset = readValue<ULONG>(clause + 20);
+			}
+			else {
+				parsed.flags = readValue<USHORT>(clause);
+				parsed.tryOffset = readValue<USHORT>(clause + 2);
+				parsed.tryLength = clause[4];
+				parsed.handlerOffset = readValue<USHORT>(clause + 5);
+				parsed.handlerLength = clause[7];
+				parsed.classTokenOrFilterOffset = readValue<ULONG>(clause + 8);
+			}
+			exceptionClauses.push_back(parsed);
+		}
+
+		hasMoreSections = (kind & CorILMethod_Sect_MoreSects) != 0;
+		position += alignToDword(dataSize);
+	}
+	return true;
+}
+
+void ILMethodBody::insertAtStart(const std::vector<BYTE>& insertedCode, USHORT insertedMaxStack) {
+	code.insert(code.begin(), insertedCode.begin(), insertedCode.end());
+	if (insertedMaxStack > maxStack) {
+		maxStack = insertedMaxStack;
+	}
+
+	ULONG shift = static_cast<ULONG>(insertedCode.size());
+	for (ExceptionClause& clause : exceptionClauses) {
+		clause.tryOffset += shift;
+		clause.handlerOffset += shift;
+		if ((clause.flags & COR_ILEXCEPTION_CLAUSE_FILTER) != 0) {
+			clause.classTokenOrFilterOffset += shift;
+		}
+	}
+}
+
+bool ILMethodBody::decode(std::vector<ILInstruction>& instructions) const {
+	ULONG codeSize = static_cast<ULONG>(code.size());
+	ULONG offset = 0;
+	while (offset < codeSize) {
+		ILInstruction instruction;
+		instruction.offset = offset;
+		instruction.opcode = code[offset];
+		ULONG opcodeSize = 1;
+		BYTE operandSize = getOperandSize(code[offset]);
+		if (code[offset] == TWO_BYTE_PREFIX) {
+			if (offset + 1 >= codeSize) {
+				return false;
+			}
+			instruction.opcode = static_cast<USHORT>((TWO_BYTE_PREFIX << 8) | code[offset + 1]);
+			opcodeSize = 2;
+			operandSize = getTwoByteOperandSize(code[offset + 1]);
+		}
+		if (operandSize == INVALID_OPCODE) {
+			return false;
+		}
+
+		ULONG operandOffset = offset + opcodeSize;
+		if (operandSize == SWITCH_OPERAND) {
+			if (operandOffset + 4 > codeSize) {
+				return false;
+			}
+			ULONG targetCount = readValue<ULONG>(&code[operandOffset]);
+			if (targetCount > (codeSize - operandOffset - 4) / 4) {
+				return false;
+			}
+			instruction.size = opcodeSize + 4 + 4 * targetCount;
+			for (ULONG i = 0; i < targetCount; i++) {
+				LONG delta = readValue<LONG>(&code[operandOffset + 4 + 4 * i]);
+				instruction.targets.push_back(offset + instruction.size + delta);
+			}
+		}
+		else {
+			instruction.size = opcodeSize + operandSize;
+			if (offset + instruction.size > codeSize) {
+				return false;
+			}
+			if (isShortBranch(instruction.opcode)) {
+				instruction.targets.push_back(offset + instruction.size + static_cast<signed char>(code[operandOffset]));
+			}
+			else if ((instruction.opcode >= OPCODE_BR && instruction.opcode <= OPCODE_BLT_UN) || instruction.opcode == OPCODE_LEAVE) {
+				instruction.targets.push_back(offset + instruction.size + readValue<LONG>(&code[operandOffset]));
+			}
+		}
+
+		for (ULONG target : instruction.targets) {
+			if (target >= codeSize) {
+				return false;
+			}
+		}
+		instructions.push_back(instruction);
+		offset += instruction.size;
+	}
+	return true;
+}
+
+bool ILMethodBody::findBasicBlocks(std::vector<ULONG>& blockOffsets) const {
+	std::vector<ILInstruction> instructions;
+	if (!decode(instructions)) {
+		return false;
+	}
+
+	ULONG codeSize = static_cast<ULONG>(code.size());
+	std::set<ULONG> starts;
+	starts.insert(0);
+	for (const ILInstruction& instruction : instructions) {
+		starts.insert(instruction.targets.begin(), instruction.targets.end());
+		if (endsBlock(instruction.opcode)) {
+			starts.insert(instruction.offset + instruction.size);
+		}
+	}
+	for (const ExceptionClause& clause : exceptionClauses) {
+		starts.insert(clause.tryOffset);
+		starts.insert(clause.tryOffset + clause.tryLength);
+		starts.insert(clause.handlerOffset);
+		starts.insert(clause.handlerOffset + clause.handlerLength);
+		if ((clause.flags & COR_ILEXCEPTION_CLAUSE_FILTER) != 0) {
+			starts.insert(clause.classTokenOrFilterOffset);
+		}
+	}
+
+	// Block starts must be instructions, which also drops the end of the code
+	std::set<ULONG> instructionOffsets;
+	for (const ILInstruction& instruction : instructions) {
+		instructionOffsets.insert(instruction.offset);
+	}
+	blockOffsets.clear();
+	for (ULONG start : starts) {
+		if (instructionOffsets.count(start) > 0) {
+			blockOffsets.push_back(start);
+		}
+		else if (start < codeSize) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool ILMethodBody::insertAt(const std::vector<ULONG>& offsets, const std::vector<std::vector<BYTE>>& insertedCode, USHORT insertedMaxStack) {
+	std::vector<ILInstruction> instructions;
+	if (!decode(instructions) || offsets.size() != insertedCode.size()) {
+		return false;
+	}
+
+	// Maps old offsets to the new offsets of the instructions and of the code inserted before them.
+	// The end of the code is mapped as well, since exception handling regions may end there
+	ULONG codeSize = static_cast<ULONG>(code.size());
+	std::vector<ULONG> newInstructionOffsets(codeSize + 1, UNMAPPED);
+	std::vector<ULONG> newTargetOffsets(codeSize + 1, UNMAPPED);
+	std::vector<const std::vector<BYTE>*> codeBefore(instructions.size(), NULL);
+	size_t nextInsertion = 0;
+	ULONG newOffset = 0;
+	for (size_t i = 0; i < instructions.size(); i++) {
+		const ILInstruction& instruction = instructions[i];
+		newTargetOffsets[instruction.offset] = newOffset;
+		if (nextInsertion < offsets.size() && offsets[nextInsertion] == instruction.offset) {
+			codeBefore[i] = &insertedCode[nextInsertion];
+			newOffset += static_cast<ULONG>(insertedCode[nextInsertion].size());
+			nextInsertion++;
+		}
+		newInstructionOffsets[instruction.offset] = newOffset;
+		newOffset += isShortBranch(instruction.opcode) ? LONG_BRANCH_SIZE : instruction.size;
+	}
+	if (nextInsertion != offsets.size()) {
+		return false;
+	}
+	newTargetOffsets[codeSize] = newOffset;
+
+	std::vector<BYTE> newCode;
+	newCode.reserve(newOffset);
+	for (size_t i = 0; i < instructions.size(); i++) {
+		const ILInstruction& instruction = instructions[i];
+		if (codeBefore[i] != NULL) {
+			newCode.insert(newCode.end(), codeBefore[i]->begin(), codeBefore[i]->end());
+		}
+
+		ULONG newEnd = newInstructionOffsets[instruction.offset];
+		if (isShortBranch(instruction.opcode)) {
+			newCode.push_back(static_cast<BYTE>(instruction.opcode == OPCODE_LEAVE_S ? OPCODE_LEAVE : instruction.opcode + (OPCODE_BR - OPCODE_BR_S)));
+			newEnd += LONG_BRANCH_SIZE;
+			appendValue<LONG>(newCode, static_cast<LONG>(newTargetOffsets[instruction.targets[0]] - newEnd));
+		}
+		else if (!instruction.targets.empty() || instruction.opcode == OPCODE_SWITCH) {
+			// long branches and switch keep their size, only the relative targets change
+			newEnd += instruction.size;
+			ULONG targetsOffset = instruction.size - 4 * static_cast<ULONG>(instruction.targets.size());
+			newCode.insert(newCode.end(), code.begin() + instruction.offset, code.begin() + instruction.offset + targetsOffset);
+			for (ULONG target : instruction.targets) {
+				appendValue<LONG>(newCode, static_cast<LONG>(newTargetOffsets[target] - newEnd));
+			}
+		}
+		else {
+			newCode.insert(newCode.end(), code.begin() + instruction.offset, code.begin() + instruction.offset + instruction.size);
+		}
+	}
+
+	for (const ExceptionClause& clause : exceptionClauses) {
+		if (!isMappedRegion(newTargetOffsets, clause.tryOffset, clause.tryLength)
+			|| !isMappedRegion(newTargetOffsets, clause.handlerOffset, clause.handlerLength)
+			|| ((clause.flags & COR_ILEXCEPTION_CLAUSE_FILTER) != 0 && !isMappedRegion(newTargetOffsets, clause.classTokenOrFilterOffset, 0))) {
+			return false;
+		}
+	}
+	for (ExceptionClause& clause : exceptionClauses) {
+		ULONG tryEnd = newTargetOffsets[clause.tryOffset + clause.tryLength];
+		ULONG handlerEnd = newTargetOffsets[clause.handlerOffset + clause.handlerLength];
+		clause.tryOffset = newTargetOffsets[clause.tryOffset];
+		clause.tryLength = tryEnd - clause.tryOffset;
+		clause.handlerOffset = newTargetOffsets[clause.handlerOffset];
+		clause.handlerLength = handlerEnd - clause.handlerOffset;
+		if ((clause.flags & COR_ILEXCEPTION_CLAUSE_FILTER) != 0) {
+			clause.classTokenOrFilterOffset = newTargetOffsets[clause.classTokenOrFilterOffset];
+		}
+	}
+
+	code.swap(newCode);
+	ULONG newMaxStack = static_cast<ULONG>(maxStack) + insertedMaxStack;
+	maxStack = static_cast<USHORT>(newMaxStack > 0xFFFF ? 0xFFFF : newMaxStack);
+	return true;
+}
+
+void ILMethodBody::write(std::vector<BYTE>& output) const {
+	output.clear();
+
+	USHORT flags = CorILMethod_FatFormat;
+	if (initLocals) {
+		flags |= CorILMethod_InitLocals;
+	}
+	if (!exceptionClauses.empty()) {
+		flags |= CorILMethod_MoreSects;
+	}
+	appendValue<USHORT>(output, static_cast<USHORT>(flags | ((FAT_HEADER_SIZE / 4) << 12)));
+	appendValue<USHORT>(output, maxStack);
+	appendValue<ULONG>(output, static_cast<ULONG>(code.size()));
+	appendValue<ULONG>(output, localVarSigToken);
+	output.insert(output.end(), code.begin(), code.end());
+
+	if (exceptionClauses.empty()) {
+		return;
+	}
+
+	output.resize(alignToDword(output.size()), 0);
+	ULONG dataSize = SECTION_HEADER_SIZE + FAT_CLAUSE_SIZE * static_cast<ULONG>(exceptionClauses.size());
+	appendValue<ULONG>(output, (dataSize << 8) | CorILMethod_Sect_EHTable | CorILMethod_Sect_FatFormat);
+	for (const ExceptionClause& clause : exceptionClauses) {
+		appendValue<ULONG>(output, clause.flags);
+		appendValue<ULONG>(output, clause.tryOffset);
+		appendValue<ULONG>(output, clause.tryLength);
+		appendValue<ULONG>(output, clause.handlerOffset);
+		appendValue<ULONG>(output, clause.handlerLength);
+		appendValue<ULONG>(output, clause.classTokenOrFilterOffset);
+	}
+}
+
+std::vector<BYTE> ILMethodBody::createHitProbe(volatile BYTE* hitFlag) {
+	// *hitFlag = 1. The address is loaded as a 64 bit constant, which conv.u truncates on 32 bit platforms
+	unsigned __int64 address = reinterpret_cast<UINT_PTR>(hitFlag);
+	std::vector<BYTE> probe;
+	probe.push_back(OPCODE_LDC_I8);
+	appendValue<unsigned __int64>(probe, address);
+	probe.push_back(OPCODE_CONV_U);
+	probe.push_back(OPCODE_LDC_I4_1);
+	probe.push_back(OPCODE_STIND_I1);
+	return probe;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <cor.h>
+#include <vector>
+#include "utils/Testing.h"
+
+/** An exception handling clause of a method body. All offsets are relative to the start of the code. */
+struct ExceptionClause {
+	ULONG flags;
+	ULONG tryOffset;
+	ULONG tryLength;
+	ULONG handlerOffset;
+	ULONG handlerLength;
+	/** The class token for typed handlers or the offset of the filter code for filters. */
+	ULONG classTokenOrFilterOffset;
+};
+
+/** A decoded IL instruction. */
+struct ILInstruction {
+	ULONG offset;
+	ULONG size;
+	/** The opcode. Two-byte opcodes have 0xFE in the high byte. */
+	USHORT opcode;
+	/** Absolute offsets of the branch targets. */
+	std::vector<ULONG> targets;
+};
+
+/**
+ * IL method body (ECMA-335, II.25.4) that can be modified and written back for instrumentation.
+ *
+ * Reads tiny and fat headers and exception handling sections. Always writes a fat header and fat exception
+ * handling sections, so the code may grow beyond the limits of the tiny formats.
+ */
+class ILMethodBody
+{
+public:
+	/** The IL code without header and extra sections. */
+	std::vector<BYTE> code;
+
+	/** Maximum number of items on the evaluation stack. */
+	USHORT maxStack = 0;
+
+	/** Token of the signature of the local variables or 0 if there are none. */
+	mdSignature localVarSigToken = 0;
+
+	/** Whether the local variables are initialized to zero. */
+	bool initLocals = false;
+
+	std::vector<ExceptionClause> exceptionClauses;
+
+	/** Reads the given method body. Returns false if it is malformed or has extra sections other than exception handling. */
+	bool EXPOSE_TO_CPP_TESTS parse(const BYTE* body, ULONG size);
+
+	/**
+	 * Inserts code before the first instruction and moves the exception handling clauses accordingly. The inserted code
+	 * must leave the evaluation stack empty and needs at most the given stack size. Branches are relative, so they
+	 * remain valid.
+	 */
+	void EXPOSE_TO_CPP_TESTS insertAtStart(const std::vector<BYTE>& insertedCode, USHORT insertedMaxStack);
+
+	/**
+	 * Stores the offsets at which basic blocks start in ascending order: the first instruction, branch targets,
+	 * instructions following branches and other instructions that leave the block, and the starts and ends of
+	 * exception handling regions. Returns false if the code cannot be decoded.
+	 */
+	bool EXPOSE_TO_CPP_TESTS findBasicBlocks(std::vector<ULONG>& blockOffsets) const;
+
+	/**
+	 * Inserts code before each of the instructions at the given offsets, which must be ascending. Branches and
+	 * exception handling regions that start at such an instruction then start at the inserted code. Short branches are
+	 * widened. The inserted code must leave the evaluation stack as it found it and needs at most the given additional
+	 * stack size. Returns false and leaves the body unchanged if an offset is not the start of an instruction.
+	 */
+	bool EXPOSE_TO_CPP_TESTS insertAt(const std::vector<ULONG>& offsets, const std::vector<std::vector<BYTE>>& insertedCode, USHORT insertedMaxStack);
+
+	/** Writes the method body in the format expected by SetILFunctionBody. */
+	void EXPOSE_TO_CPP_TESTS write(std::vector<BYTE>& output) const;
+
+	/** Evaluation stack size needed by a hit probe. */
+	static const USHORT HIT_PROBE_MAX_STACK = 2;
+
+	/** Returns IL that sets the given flag to 1 with a single store and leaves the evaluation stack unchanged. */
+	static std::vector<BYTE> createHitProbe(volatile BYTE* hitFlag);
+
+private:
+	/** Decodes all instructions of the code. Returns false if the code is malformed. */
+	bool decode(std::vector<ILInstruction>& instructions) const;
+
+	/** Reads the extra sections at the given position. Returns false if they are malformed or unsupported. */
+	bool parseExtraSections(const BYTE* position, const BYTE* end);
+};
@@ -0,0 +1,148 @@
+#include "SharedCoverageMap.h"
+
+SharedCoverageMap::~SharedCoverageMap() {
+	close();
+}
+
+bool SharedCoverageMap::open(std::string path) {
+	file = CreateFile(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+		OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	// Extends the file with zeros if necessary, which is a valid empty map
+	mapping = CreateFileMapping(file, NULL, PAGE_READWRITE, 0, FILE_SIZE, NULL);
+	if (mapping == NULL) {
+		close();
+		return false;
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, FILE_SIZE);
+	if (view == NULL) {
+		close();
+		return false;
+	}
+
+	header = static_cast<Header*>(view);
+	LONG magic = InterlockedCompareExchange(&header->magic, MAGIC, 0);
+	if (magic != 0 && magic != MAGIC) {
+		close();
+		return false;
+	}
+
+	entries = reinterpret_cast<Entry*>(static_cast<char*>(view) + sizeof(Header));
+	char* bitmapStart = reinterpret_cast<char*>(entries + ENTRY_COUNT);
+	bitmapArea = reinterpret_cast<volatile LONG*>(bitmapStart);
+	bitmapCapacityWords = static_cast<ULONG>((FILE_SIZE - (bitmapStart - static_cast<char*>(view))) / sizeof(LONG));
+	lastFlush = GetTickCount64();
+	return true;
+}
+
+SharedBitmap SharedCoverageMap::getBitmap(const GUID& mvid, ULONG methodCount) {
+	if (!isOpen() || methodCount == 0) {
+		return SharedBitmap();
+	}
+
+	ULONG hash = mvid.Data1 ^ (mvid.Data2 << 16) ^ mvid.Data3;
+	for (ULONG probe = 0; probe < ENTRY_COUNT; probe++) {
+		Entry* entry = &entries[(hash + probe) % ENTRY_COUNT];
+
+		LONG64 claim = getClaimTime();
+		LONG64 state = InterlockedCompareExchange64(&entry->state, claim, ENTRY_FREE);
+		if (state == ENTRY_FREE) {
+			return initializeEntry(entry, claim, mvid, methodCount);
+		}
+
+		while (state != ENTRY_READY) {
+			// another process is creating this entry. If it died while doing so, the first one to notice takes over
+			claim = getClaimTime();
+			if (claim - state > CLAIM_TIMEOUT || claim < state) {
+				if (InterlockedCompareExchange64(&entry->state, claim, state) == state) {
+					return initializeEntry(entry, claim, mvid, methodCount);
+				}
+			}
+			else {
+				Sleep(0);
+			}
+			state = entry->state;
+		}
+
+		if (IsEqualGUID(entry->mvid, mvid)) {
+			if (entry->methodCount != methodCount) {
+				return SharedBitmap();
+			}
+			return SharedBitmap(bitmapArea + entry->bitmapOffset, methodCount + 1);
+		}
+	}
+	return SharedBitmap();
+}
+
+LONG64 SharedCoverageMap::getClaimTime() {
+	FILETIME now;
+	GetSystemTimeAsFileTime(&now);
+	return (static_cast<LONG64>(now.dwHighDateTime) << 32) | now.dwLowDateTime;
+}
+
+bool SharedCoverageMap::allocateWords(ULONG words, ULONG* offset) {
+	LONG used = header->usedWords;
+	while (true) {
+		if (used < 0 || static_cast<ULONG>(used) > bitmapCapacityWords || words > bitmapCapacityWords - used) {
+			return false;
+		}
+		LONG previous = InterlockedCompareExchange(&header->usedWords, used + static_cast<LONG>(words), used);
+		if (previous == used) {
+			*offset = static_cast<ULONG>(used);
+			return true;
+		}
+		used = previous;
+	}
+}
+
+SharedBitmap SharedCoverageMap::initializeEntry(Entry* entry, LONG64 claim, const GUID& mvid, ULONG methodCount) {
+	// RIDs start at 1
+	ULONG words = (methodCount + 1 + 31) / 32;
+	ULONG offset = 0;
+	bool isAllocated = allocateWords(words, &offset);
+
+	entry->mvid = mvid;
+	// the map is full if nothing was allocated. Record the module without methods so other processes don't retry
+	entry->methodCount = isAllocated ? methodCount : 0;
+	entry->bitmapOffset = offset;
+
+	// only publish if no other process took the claim over in the meantime
+	if (InterlockedCompareExchange64(&entry->state, ENTRY_READY, claim) != claim || !isAllocated) {
+		return SharedBitmap();
+	}
+	return SharedBitmap(bitmapArea + offset, methodCount + 1);
+}
+
+void SharedCoverageMap::flush(ULONGLONG minimumIntervalMillis) {
+	if (!isOpen()) {
+		return;
+	}
+
+	ULONGLONG now = GetTickCount64();
+	if (now - lastFlush >= minimumIntervalMillis) {
+		FlushViewOfFile(header, 0);
+		lastFlush = now;
+	}
+}
+
+void SharedCoverageMap::close() {
+	if (header != NULL) {
+		FlushViewOfFile(header, 0);
+		UnmapViewOfFile(header);
+		header = NULL;
+		entries = NULL;
+		bitmapArea = NULL;
+	}
+	if (mapping != NULL) {
+		CloseHandle(mapping);
+		mapping = NULL;
+	}
+	if (file != INVALID_HANDLE_VALUE) {
+		CloseHandle(file);
+		file = INVALID_HANDLE_VALUE;
+	}
+}
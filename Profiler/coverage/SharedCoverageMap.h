@@ -0,0 +1,124 @@
+#pragma once
+#include <Windows.h>
+#include <cor.h>
+#include <string>
+
+/**
+ * Bitmap of the methods of one assembly in a SharedCoverageMap. Bit i stands for the method with RID i.
+ * All methods are thread-safe and may be called concurrently from several processes.
+ */
+class SharedBitmap
+{
+public:
+	SharedBitmap() {}
+	SharedBitmap(volatile LONG* words, ULONG bitCount) : words(words), bitCount(bitCount) {}
+
+	/** Whether this bitmap is backed by shared memory at all. */
+	bool isValid() const {
+		return words != NULL;
+	}
+
+	/** Whether the given method has already been reported. */
+	bool isSet(mdToken methodToken) const {
+		ULONG rid = methodToken & 0x00FFFFFF;
+		return rid < bitCount && (static_cast<ULONG>(words[rid / 32]) & (1u << (rid % 32))) != 0;
+	}
+
+	/** Marks the given method as reported. */
+	void set(mdToken methodToken) {
+		ULONG rid = methodToken & 0x00FFFFFF;
+		if (rid < bitCount) {
+			InterlockedOr(&words[rid / 32], static_cast<LONG>(1u << (rid % 32)));
+		}
+	}
+
+private:
+	volatile LONG* words = NULL;
+	ULONG bitCount = 0;
+};
+
+/**
+ * Machine-wide map from module MVIDs to bitmaps of methods that have already been reported by any process.
+ *
+ * The map is a memory-mapped file, so all processes that open the same file share it and it survives process
+ * restarts. The file starts with a fixed-size open-addressing table of assemblies, followed by the bitmaps, which
+ * are allocated by atomically bumping a counter in the header. Entries are claimed with compare-and-swap, so no
+ * locks are needed across processes. A claim records the time it was made, so an entry claimed by a process that
+ * crashed before finishing it is taken over by the next process that needs it once the claim has timed out.
+ *
+ * Not thread-safe except for the returned bitmaps. The profiler uses it from synchronized context only.
+ */
+class SharedCoverageMap
+{
+public:
+	SharedCoverageMap() {}
+	virtual ~SharedCoverageMap();
+
+	/** Opens or creates the map in the given file. Returns false if that fails or the file has an incompatible format. */
+	bool open(std::string path);
+
+	/** Whether the map is open. */
+	bool isOpen() {
+		return header != NULL;
+	}
+
+	/**
+	 * Returns the bitmap of the module with the given MVID, creating it with room for the given number of methods if
+	 * necessary. Returns an invalid bitmap if the map is full or the module has a different number of methods.
+	 */
+	SharedBitmap getBitmap(const GUID& mvid, ULONG methodCount);
+
+	/** Asynchronously writes the map to disk if the last flush is at least the given time ago. */
+	void flush(ULONGLONG minimumIntervalMillis);
+
+	/** Flushes and closes the map. */
+	void close();
+
+private:
+	/** Identifies the file format. */
+	static const LONG MAGIC = 0x32564354;
+
+	/** Number of assemblies the map can hold. */
+	static const ULONG ENTRY_COUNT = 8192;
+
+	/** Total size of the file. Leaves room for roughly 400 million methods. */
+	static const ULONG FILE_SIZE = 64 * 1024 * 1024;
+
+	/** Time after which a claimed entry is considered abandoned by a crashed process, in 100 ns units. */
+	static const LONG64 CLAIM_TIMEOUT = 1000 * 10000;
+
+	/** States of an entry. Any other state is the system time at which a process claimed the entry. */
+	static const LONG64 ENTRY_FREE = 0;
+	static const LONG64 ENTRY_READY = 1;
+
+	struct Header {
+		volatile LONG magic;
+		/** Number of 32 bit words allocated for bitmaps. */
+		volatile LONG usedWords;
+	};
+
+	struct Entry {
+		volatile LONG64 state;
+		ULONG methodCount;
+		/** Offset of the bitmap from the start of the bitmap area in 32 bit words. */
+		ULONG bitmapOffset;
+		GUID mvid;
+	};
+
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = NULL;
+	Header* header = NULL;
+	Entry* entries = NULL;
+	volatile LONG* bitmapArea = NULL;
+	ULONG bitmapCapacityWords = 0;
+	ULONGLONG lastFlush = 0;
+
+	/** Returns the current system time in 100 ns units, which is always a valid claim. */
+	static LONG64 getClaimTime();
+
+	/** Allocates the given number of bitmap words. Returns false if the map is full. */
+	bool allocateWords(ULONG words, ULONG* offset);
+
+	/** Allocates the bitmap for an entry that was claimed at the given time and publishes it. */
+	SharedBitmap initializeEntry(Entry* entry, LONG64 claim, const GUID& mvid, ULONG methodCount);
+};
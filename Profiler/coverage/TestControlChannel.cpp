@@ -0,0 +1,144 @@
+#include "TestControlChannel.h"
+#include "platform/Platform.h"
+
+TestControlChannel::~TestControlChannel() {
+	shutdown();
+}
+
+std::string TestControlChannel::getPipeName() {
+	return "\\\\.\\pipe\\TeamscaleProfiler_" + std::to_string(Platform::getProcessId());
+}
+
+bool TestControlChannel::start(TestMarkerHandler handler) {
+	this->handler = handler;
+	stopEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	if (stopEvent == NULL) {
+		return false;
+	}
+
+	pipe = CreateNamedPipe(getPipeName().c_str(), PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED,
+		PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT, 1, 0, 0, 0, NULL);
+	if (pipe != INVALID_HANDLE_VALUE) {
+		listenerThread = CreateThread(NULL, 0, runListenerThread, this, 0, NULL);
+	}
+
+	if (listenerThread == NULL) {
+		if (pipe != INVALID_HANDLE_VALUE) {
+			CloseHandle(pipe);
+			pipe = INVALID_HANDLE_VALUE;
+		}
+		CloseHandle(stopEvent);
+		stopEvent = NULL;
+		return false;
+	}
+	return true;
+}
+
+void TestControlChannel::shutdown() {
+	if (listenerThread == NULL) {
+		return;
+	}
+
+	InterlockedExchange(&isShuttingDown, 1);
+	SetEvent(stopEvent);
+
+	// Only pipe operations are cancelled, so the thread exits as soon as a command that is being handled is done.
+	// The handler may write the trace, which must not be closed before that
+	WaitForSingleObject(listenerThread, INFINITE);
+	CloseHandle(listenerThread);
+	listenerThread = NULL;
+	CloseHandle(pipe);
+	pipe = INVALID_HANDLE_VALUE;
+	CloseHandle(stopEvent);
+	stopEvent = NULL;
+}
+
+DWORD WINAPI TestControlChannel::runListenerThread(LPVOID parameter) {
+	static_cast<TestControlChannel*>(parameter)->listen();
+	return 0;
+}
+
+bool TestControlChannel::completeIo(BOOL isStarted, OVERLAPPED* overlapped, DWORD* bytesTransferred) {
+	if (!isStarted && GetLastError() != ERROR_IO_PENDING) {
+		return false;
+	}
+
+	HANDLE events[] = { overlapped->hEvent, stopEvent };
+	if (WaitForMultipleObjects(2, events, FALSE, INFINITE) != WAIT_OBJECT_0) {
+		// the operation still uses the overlapped structure until the cancellation completes
+		CancelIoEx(pipe, overlapped);
+		GetOverlappedResult(pipe, overlapped, bytesTransferred, TRUE);
+		return false;
+	}
+	return GetOverlappedResult(pipe, overlapped, bytesTransferred, FALSE) != FALSE;
+}
+
+void TestControlChannel::listen() {
+	OVERLAPPED overlapped = {};
+	overlapped.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	if (overlapped.hEvent == NULL) {
+		return;
+	}
+
+	while (!isShuttingDown) {
+		DWORD bytesTransferred = 0;
+		BOOL isStarted = ConnectNamedPipe(pipe, &overlapped);
+		bool isConnected = (!isStarted && GetLastError() == ERROR_PIPE_CONNECTED) ||
+			completeIo(isStarted, &overlapped, &bytesTransferred);
+		if (isConnected && !isShuttingDown) {
+			handleClient();
+		}
+		DisconnectNamedPipe(pipe);
+	}
+	CloseHandle(overlapped.hEvent);
+}
+
+void TestControlChannel::handleClient() {
+	std::string pendingInput;
+	char buffer[512];
+	DWORD bytesRead = 0;
+	OVERLAPPED overlapped = {};
+	overlapped.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	if (overlapped.hEvent == NULL) {
+		return;
+	}
+
+	while (!isShuttingDown && completeIo(ReadFile(pipe, buffer, sizeof(buffer), NULL, &overlapped), &overlapped, &bytesRead)
+		&& bytesRead > 0) {
+		pendingInput.append(buffer, bytesRead);
+
+		size_t lineEnd;
+		while ((lineEnd = pendingInput.find('\n')) != std::string::npos) {
+			std::string command = pendingInput.substr(0, lineEnd);
+			pendingInput.erase(0, lineEnd + 1);
+			if (!command.empty() && command.back() == '\r') {
+				command.pop_back();
+			}
+
+			std::string response = handleCommand(command) + "\n";
+			DWORD bytesWritten = 0;
+			completeIo(WriteFile(pipe, response.c_str(), static_cast<DWORD>(response.size()), NULL, &overlapped), &overlapped,
+				&bytesWritten);
+		}
+
+		if (pendingInput.size() > MAX_COMMAND_LENGTH) {
+			break;
+		}
+	}
+	CloseHandle(overlapped.hEvent);
+}
+
+std::string TestControlChannel::handleCommand(const std::string& command) {
+	if (isShuttingDown) {
+		return "error the profiler is shutting down";
+	}
+	if (command.compare(0, 6, "start ") == 0 && command.size() > 6) {
+		handler(command.substr(6));
+		return "ok";
+	}
+	if (command == "end") {
+		handler("");
+		return "ok";
+	}
+	return "error unknown command: " + command;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <Windows.h>
+#include <string>
+#include <functional>
+
+/** Called when a test starts (with its name) or ends (with the empty string). */
+typedef std::function<void(const std::string& testName)> TestMarkerHandler;
+
+/**
+ * Named pipe \\.\pipe\TeamscaleProfiler_<pid> through which a test runner marks the start and end of test cases.
+ *
+ * The protocol is line-based. "start <test name>" marks the start of a test, "end" marks its end. Every command is
+ * answered with "ok" once it was handled or "error <message>", so the runner can wait for the marker to take effect
+ * before running the test. Only one client can be connected at a time.
+ *
+ * The pipe uses overlapped I/O, so shutdown can cancel exactly the pending pipe operation by signaling an event
+ * without affecting other I/O that the listener thread does while handling a command, e.g. writing the trace.
+ */
+class TestControlChannel
+{
+public:
+	virtual ~TestControlChannel();
+
+	/** Starts listening on the pipe in a background thread. Returns false if the pipe cannot be created. */
+	bool start(TestMarkerHandler handler);
+
+	/** Stops listening. Waits for a command that is currently being handled. */
+	void shutdown();
+
+	/** Returns the name of the pipe. */
+	std::string getPipeName();
+
+private:
+	/** Maximum length of a command line. */
+	static const size_t MAX_COMMAND_LENGTH = 4096;
+
+	HANDLE pipe = INVALID_HANDLE_VALUE;
+	HANDLE listenerThread = NULL;
+
+	/** Signaled on shutdown to cancel the pending pipe operation. */
+	HANDLE stopEvent = NULL;
+
+	volatile LONG isShuttingDown = 0;
+	TestMarkerHandler handler;
+
+	/** Entry point of the listener thread. */
+	static DWORD WINAPI runListenerThread(LPVOID parameter);
+
+	/** Accepts clients until shutdown. */
+	void listen();
+
+	/** Handles the commands of the connected client until it disconnects. */
+	void handleClient();
+
+	/**
+	 * Completes a pipe operation that was started with the given overlapped structure and returned the given result.
+	 * Returns false if it failed or was cancelled by shutdown.
+	 */
+	bool completeIo(BOOL isStarted, OVERLAPPED* overlapped, DWORD* bytesTransferred);
+
+	/** Handles a single command and returns the response. */
+	std::string handleCommand(const std::string& command);
+};
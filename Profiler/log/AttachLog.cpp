@@ -1,5 +1,6 @@
 #include "AttachLog.h"
-#include "utils/WindowsUtils.h"
+#include "platform/Platform.h"
+#include <cstdio>
 
 
 AttachLog::~AttachLog() {
@@ -7,22 +8,31 @@ AttachLog::~AttachLog() {
 }
 
 
-void AttachLog::createLogFile(std::string path) {
-	FileLogBase::createLogFile(path, "attach.log", false);
+void AttachLog::createLogFile(std::string path, unsigned long spoolTimeoutMillis) {
+	FileLogBase::createLogFile(path, "attach.log", false, spoolTimeoutMillis);
 }
 
 
 void AttachLog::logAttach() {
 	std::string timeStamp = getFormattedCurrentTime();
-	std::string message = timeStamp + " Attached to \"" + WindowsUtils::getPathOfThisProcess() + 
-		"\" with PID " + std::to_string(WindowsUtils::getPidOfThisProcess());
+	std::string message = timeStamp + " Attached to \"" + Platform::getProcessPath() + 
+		"\" with PID " + std::to_string(Platform::getProcessId());
 	writeTupleToFile(LOG_KEY_ATTACH, message.c_str());
 }
 
 
+void AttachLog::logSampling(const std::string& startTime, double samplingRate, double draw, bool isProfiled) {
+	char numbers[64];
+	snprintf(numbers, sizeof(numbers), " with rate %g and draw %.6f: ", samplingRate, draw);
+	std::string message = getFormattedCurrentTime() + " Sampled PID " + std::to_string(Platform::getProcessId()) + " on \"" +
+		Platform::getMachineName() + "\" started at " + startTime + numbers + (isProfiled ? "profiled" : "not profiled");
+	writeTupleToFile(LOG_KEY_SAMPLING, message.c_str());
+}
+
+
 void AttachLog::logDetach() {
 	std::string timeStamp = getFormattedCurrentTime();
-	std::string message = timeStamp + " Detached from \"" + WindowsUtils::getPathOfThisProcess() +
-		"\" with PID " + std::to_string(WindowsUtils::getPidOfThisProcess());
+	std::string message = timeStamp + " Detached from \"" + Platform::getProcessPath() +
+		"\" with PID " + std::to_string(Platform::getProcessId());
 	writeTupleToFile(LOG_KEY_DETACH, message.c_str());
 }
@@ -15,13 +15,19 @@ public:
 	 * Can be called as an alternative for createLogFile method of the base class as first method called on the object.
 	 * This method is not thread-safe or reentrant.
 	 */
-	void createLogFile(std::string path);
+	void createLogFile(std::string path, unsigned long spoolTimeoutMillis);
 
 	/**
 	 * Log an attach event with time, executable name and process ID
 	 */
 	void logAttach();
 
+	/**
+	 * Log whether the process is profiled if only the given fraction of processes is, together with the start time
+	 * and draw that decided it, so coverage from sampled processes can be weighted
+	 */
+	void logSampling(const std::string& startTime, double samplingRate, double draw, bool isProfiled);
+
 	/**
 	 * Log an detach event with time, executable name and process ID
 	 */
@@ -31,6 +37,9 @@ protected :
 	/** The key to log information about processes to which the profiler is attached to. */
 	const char* LOG_KEY_ATTACH = "Attach";
 
+	/** The key to log the sampling decision for the process to which the profiler is attached. */
+	const char* LOG_KEY_SAMPLING = "Sampling";
+
 	/** The key to log information about processes to which the profiler was attached to and is currently detatching from. */
 	const char* LOG_KEY_DETACH = "Detach";
 };
@@ -1,81 +1,386 @@
 #include "FileLogBase.h"
-#include <winuser.h>
+#include <atomic>
+#include <functional>
+#include <stdio.h>
+#include <string.h>
 #include "version.h"
+#include "platform/Platform.h"
+#include "utils/StringUtils.h"
+
+/** Name of the directory below the local temp directory that holds spooled log files. */
+static const char* SPOOL_DIRECTORY_NAME = "TeamscaleProfilerSpool";
+
+/**
+ * Time to wait for the opener thread at shutdown. Shutdown also runs from DllMain, where the thread may never exit,
+ * e.g. because it needs the loader lock, so this must not be infinite.
+ */
+static const unsigned long SHUTDOWN_TIMEOUT_MILLIS = 5000;
+
+/**
+ * Time the opener thread still waits for a slow target directory once shutdown was requested. Leaves enough of
+ * SHUTDOWN_TIMEOUT_MILLIS to spool the output instead, so it is never discarded because the thread did not stop in time.
+ */
+static const unsigned long SHUTDOWN_OPEN_TIMEOUT_MILLIS = 2000;
+
+/**
+ * Opens a file on a detached thread so the caller can stop waiting for it, e.g. when the file lives on a network
+ * share that doesn't respond. The object is shared by the opener thread and the caller and deletes itself once both
+ * have released it. If the caller releases it before the file is open, the opener closes the file again.
+ */
+class DetachedFileOpen {
+public:
+	/** Signaled once the open attempt finished, successfully or not. */
+	Event finishedEvent;
+
+	/** Starts opening the given file. Returns NULL if the thread could not be started. */
+	static DetachedFileOpen* start(std::string path, File::Mode mode) {
+		DetachedFileOpen* open = new DetachedFileOpen(path, mode);
+		if (!Thread::startDetached(run, open)) {
+			open->release();
+			open->release();
+			return NULL;
+		}
+		return open;
+	}
+
+	/** Gives up the caller's reference. Returns the opened file if the open already succeeded, which the caller then owns. */
+	File release() {
+		File result;
+		int expectedState = STATE_PENDING;
+		if (!state.compare_exchange_strong(expectedState, STATE_ABANDONED) && expectedState == STATE_DONE) {
+			result = std::move(file);
+		}
+		if (--references == 0) {
+			delete this;
+		}
+		return result;
+	}
+
+private:
+	static const int STATE_PENDING = 0;
+	static const int STATE_DONE = 1;
+	static const int STATE_ABANDONED = 2;
+
+	std::string path;
+	File::Mode mode;
+	File file;
+	std::atomic<int> state{ STATE_PENDING };
+	std::atomic<int> references{ 2 };
+
+	DetachedFileOpen(std::string path, File::Mode mode) : path(path), mode(mode) {
+		// the opener thread is started by start()
+	}
+
+	static void run(void* parameter) {
+		DetachedFileOpen* open = static_cast<DetachedFileOpen*>(parameter);
+		open->file.open(open->path, open->mode);
+		int expectedState = STATE_PENDING;
+		if (!open->state.compare_exchange_strong(expectedState, STATE_DONE)) {
+			// abandoned by the caller
+			open->file.close();
+		}
+		open->finishedEvent.set();
+		open->release();
+	}
+};
+
+/** Appends the remaining contents of the source file to the target file. Returns false if reading or writing failed. */
+static bool appendFileContents(File& source, File& target) {
+	char buffer[64 * 1024];
+	int bytesRead = 0;
+	while ((bytesRead = source.read(buffer, sizeof(buffer))) > 0) {
+		if (!target.write(buffer, bytesRead)) {
+			return false;
+		}
+	}
+	return bytesRead == 0;
+}
 
 FileLogBase::FileLogBase()
 {
-	InitializeCriticalSection(&criticalSection);
+	// the log file is created by createLogFile
 }
 
 
 FileLogBase::~FileLogBase()
 {
-	DeleteCriticalSection(&criticalSection);
+	if (openerThread.isStarted()) {
+		// the thread uses this object, so it must have exited before the object is gone. Never runs from DllMain
+		shutdownEvent.set();
+		openerThread.join(Platform::INFINITE_WAIT);
+	}
 }
 
-void FileLogBase::createLogFile(std::string directory, std::string name, bool overwriteIfExists) {
+void FileLogBase::createLogFile(std::string directory, std::string name, bool overwriteIfExists, unsigned long spoolTimeoutMillis) {
 	if (directory.empty()) {
+#ifdef _WIN32
 		// c:\users\public is usually writable for everyone
 		// we must use backslashes here or the WinAPI path manipulation functions will fail
 		// to split the path correctly
 		directory = "c:\\users\\public\\";
+#else
+		directory = Platform::getTempDirectory();
+#endif
 	}
 
-	std::string logFilePath = directory + "\\" + name;
+	this->targetDirectory = directory;
+	this->fileName = name;
+	this->overwriteIfExists = overwriteIfExists;
+	this->spoolTimeout = spoolTimeoutMillis;
+
+	// one spool directory per target directory so leftover spool files can be migrated to the right place
+	size_t targetDirectoryHash = std::hash<std::string>()(StringUtils::uppercase(directory));
+	spoolDirectory = tempDirectory + SPOOL_DIRECTORY_NAME + Platform::PATH_SEPARATOR + std::to_string(targetDirectoryHash);
+
+	isOpening = true;
+	if (!openerThread.start(runOpenerThread, this)) {
+		// fall back to opening the file synchronously
+		openInBackground();
+	}
+}
+
+void FileLogBase::runOpenerThread(void* parameter) {
+	static_cast<FileLogBase*>(parameter)->openInBackground();
+}
 
-	DWORD creationPolicy = OPEN_ALWAYS;
+void FileLogBase::openInBackground() {
+	std::string targetPath = targetDirectory + Platform::PATH_SEPARATOR + fileName;
+	File::Mode mode = File::APPEND;
 	if (overwriteIfExists) {
-		creationPolicy = CREATE_ALWAYS;
+		mode = File::OVERWRITE;
+	}
+
+	DetachedFileOpen* open = DetachedFileOpen::start(targetPath, mode);
+	if (open == NULL) {
+		File targetFile;
+		if (targetFile.open(targetPath, mode) || !startSpooling()) {
+			// without a thread to retry, the output is lost if neither file can be opened
+			useFile(std::move(targetFile));
+		}
+		return;
+	}
+
+	bool isSpooling = false;
+	unsigned long waitTimeout = spoolTimeout;
+	unsigned long shutdownWaitTimeout = spoolTimeout < SHUTDOWN_OPEN_TIMEOUT_MILLIS ? spoolTimeout : SHUTDOWN_OPEN_TIMEOUT_MILLIS;
+	while (true) {
+		Event* events[] = { &open->finishedEvent, &shutdownEvent };
+		int waitResult = Event::waitForAny(events, 2, waitTimeout);
+		if (waitResult == 1 && !isSpooling && open->finishedEvent.wait(shutdownWaitTimeout)) {
+			// shutdown right after startup. A responsive target directory still gets the output instead of the spool
+			waitResult = 0;
+		}
+
+		if (waitResult == 0) {
+			File targetFile = open->release();
+			if (targetFile.isOpen()) {
+				if (isSpooling) {
+					migrateSpoolTo(std::move(targetFile));
+				}
+				else {
+					useFile(std::move(targetFile));
+				}
+				migrateLeftoverSpoolFiles();
+				return;
+			}
+
+			// the target directory is unavailable. Spool until it comes back
+			if (!isSpooling) {
+				isSpooling = startSpooling();
+			}
+			if (waitForShutdown(retryIntervalMillis)) {
+				return;
+			}
+			open = DetachedFileOpen::start(targetPath, mode);
+			if (open == NULL) {
+				return;
+			}
+			continue;
+		}
+
+		// the target directory is slow or we are shutting down. Either way, pending output must go to the spool
+		if (!isSpooling) {
+			isSpooling = startSpooling();
+		}
+		if (waitResult != Event::TIMED_OUT) {
+			// leave the spool file for the next profiler run to migrate. The target file is closed if it was opened
+			open->release();
+			return;
+		}
+		waitTimeout = Platform::INFINITE_WAIT;
 	}
+}
 
-	logFile = CreateFile(logFilePath.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ,
-		NULL, creationPolicy, FILE_ATTRIBUTE_NORMAL, NULL);
+bool FileLogBase::waitForShutdown(unsigned long millis) {
+	return shutdownEvent.wait(millis);
+}
+
+void FileLogBase::useFile(File file) {
+	criticalSection.lock();
+	if (isShutDown) {
+		// the opener thread was left behind by shutdown. The file is closed when it goes out of scope
+		criticalSection.unlock();
+		return;
+	}
+	logFile = std::move(file);
+	isOpening = false;
+	if (!logFile.isOpen() || (!pendingOutput.empty() && !logFile.write(pendingOutput.data(), pendingOutput.size()))) {
+		hasLostOutput = true;
+	}
+	pendingOutput.clear();
+	pendingOutput.shrink_to_fit();
+	criticalSection.unlock();
+}
+
+bool FileLogBase::startSpooling() {
+	Platform::createDirectory(tempDirectory + SPOOL_DIRECTORY_NAME);
+	Platform::createDirectory(spoolDirectory);
+
+	// prefix with the PID so concurrent processes never share a spool file
+	std::string processPrefix = std::to_string(Platform::getProcessId()) + ".";
+	std::string path = spoolDirectory + Platform::PATH_SEPARATOR + processPrefix + fileName;
+	File spoolFile;
+	if (!spoolFile.open(path, File::OVERWRITE)) {
+		// e.g. another user owns the spool directory. Later runs do not migrate this file, but this one still does
+		path = tempDirectory + SPOOL_DIRECTORY_NAME + "." + processPrefix + fileName;
+		if (!spoolFile.open(path, File::OVERWRITE)) {
+			if (hasLoggedSpoolProblem) {
+				return false;
+			}
+			hasLoggedSpoolProblem = true;
+			std::string reason = Platform::getLastErrorMessage();
+			logOpenProblem("Failed to create a spool file in " + tempDirectory + ": " + reason +
+				". The output is kept in memory until " + targetDirectory + " is available");
+			return false;
+		}
+	}
+
+	spoolPath = path;
+	useFile(std::move(spoolFile));
+	return true;
+}
+
+void FileLogBase::logOpenProblem(const std::string&) {
+	// only subclasses with a text format can log problems
+}
+
+void FileLogBase::migrateSpoolTo(File targetFile) {
+	criticalSection.lock();
+	if (isShutDown) {
+		criticalSection.unlock();
+		return;
+	}
+	File spoolReader;
+	bool migrated = spoolReader.open(spoolPath, File::READ) && appendFileContents(spoolReader, targetFile);
+	spoolReader.close();
+
+	if (migrated) {
+		logFile = std::move(targetFile);
+		Platform::removeFile(spoolPath);
+		spoolPath.clear();
+	}
+	// otherwise keep spooling. The next profiler run will migrate the spool file
+	criticalSection.unlock();
+}
+
+void FileLogBase::migrateLeftoverSpoolFiles() {
+	for (const std::string& spoolFileName : Platform::listFiles(spoolDirectory)) {
+		if (waitForShutdown(0)) {
+			return;
+		}
+		size_t pidSeparator = spoolFileName.find('.');
+		if (pidSeparator == std::string::npos) {
+			continue;
+		}
+
+		// spool files of running processes are still open for writing, so this fails for them
+		File leftover;
+		if (!leftover.open(spoolDirectory + Platform::PATH_SEPARATOR + spoolFileName, File::READ_EXCLUSIVE)) {
+			continue;
+		}
+
+		File target;
+		if (target.open(targetDirectory + Platform::PATH_SEPARATOR + spoolFileName.substr(pidSeparator + 1), File::APPEND)
+			&& appendFileContents(leftover, target)) {
+			leftover.deleteOnClose();
+		}
+	}
 }
 
 void FileLogBase::shutdown()
 {
-	EnterCriticalSection(&criticalSection);
-	if (logFile != INVALID_HANDLE_VALUE) {
-		CloseHandle(logFile);
+	if (openerThread.isStarted()) {
+		shutdownEvent.set();
+		// the thread is left behind if it does not stop in time. It only writes to the log under the critical section
+		openerThread.join(SHUTDOWN_TIMEOUT_MILLIS);
 	}
-	LeaveCriticalSection(&criticalSection);
+
+	criticalSection.lock();
+	logFile.close();
+	isShutDown = true;
+	isOpening = false;
+	pendingOutput.clear();
+	criticalSection.unlock();
+}
+
+bool FileLogBase::flushToTarget() {
+	criticalSection.lock();
+	bool isInTarget = logFile.isOpen() && spoolPath.empty() && !hasLostOutput && logFile.flush();
+	criticalSection.unlock();
+	return isInTarget;
 }
 
 
 int FileLogBase::writeToFile(const char* string) {
+	return writeToFile(string, strlen(string));
+}
+
+int FileLogBase::writeToFile(const char* data, size_t length) {
 	int retVal = 0;
-	DWORD dwWritten = 0;
 
-	if (logFile != INVALID_HANDLE_VALUE) {
-		EnterCriticalSection(&criticalSection);
-		if (TRUE == WriteFile(logFile, string,
-			(DWORD)strlen(string), &dwWritten, NULL)) {
-			retVal = dwWritten;
+	criticalSection.lock();
+	if (logFile.isOpen()) {
+		if (logFile.write(data, length)) {
+			retVal = static_cast<int>(length);
 		}
 		else {
+			hasLostOutput = true;
 			retVal = 0;
 		}
-		LeaveCriticalSection(&criticalSection);
 	}
+	else if (isOpening) {
+		// the file is still being opened in the background
+		pendingOutput.append(data, length);
+		retVal = static_cast<int>(length);
+	}
+	criticalSection.unlock();
 
 	return retVal;
 }
 
 void FileLogBase::writeTupleToFile(const char* key, const char* value) {
-	char buffer[BUFFER_SIZE];
-	sprintf_s(buffer, "%s=%s\r\n", key, value);
-	writeToFile(buffer);
+	// values such as collapsed stacks can be arbitrarily long, so they must not be cut off at a fixed buffer size.
+	// Written in one piece so lines of concurrent writers are never interleaved
+	std::string line;
+	size_t keyLength = strlen(key);
+	size_t valueLength = strlen(value);
+	line.reserve(keyLength + valueLength + 3);
+	line.append(key, keyLength);
+	line.push_back('=');
+	line.append(value, valueLength);
+	line.append("\r\n");
+	writeToFile(line.data(), line.size());
 }
 
 std::string FileLogBase::getFormattedCurrentTime() {
 	char formattedTime[BUFFER_SIZE];
-	SYSTEMTIME time;
-	GetSystemTime(&time);
+	Platform::UtcTime time;
+	Platform::getUtcTime(time);
 	// Four digits for milliseconds means we always have a leading 0 there.
 	// We consider this legacy and keep it here for compatibility reasons.
-	sprintf_s(formattedTime, sizeof(formattedTime), "%04d%02d%02d_%02d%02d%02d%04d", time.wYear,
-		time.wMonth, time.wDay, time.wHour, time.wMinute, time.wSecond,
-		time.wMilliseconds);
+	snprintf(formattedTime, sizeof(formattedTime), "%04d%02d%02d_%02d%02d%02d%04d", time.year,
+		time.month, time.day, time.hour, time.minute, time.second,
+		time.millisecond);
 
 	std::string result(formattedTime);
 	return result;
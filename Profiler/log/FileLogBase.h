@@ -1,41 +1,135 @@
 #pragma once
 #include <string>
-#include <atlbase.h>
+#include "platform/Event.h"
+#include "platform/File.h"
+#include "platform/Mutex.h"
+#include "platform/Platform.h"
+#include "platform/Thread.h"
+#include "utils/Testing.h"
 
 static const int BUFFER_SIZE = 2048;
 
 /**
  * Manages a log file on the file system.
  * Unless mentioned otherwise, all methods in this class are thread-safe and perform their own synchronization.
+ *
+ * The log file is opened on a background thread so a slow or unavailable target directory (e.g. a network share)
+ * does not delay the profiled application. Everything written before the file is open is buffered in memory.
+ * If the target directory does not respond in time, the log is spooled to a local temp directory and moved to
+ * the target directory as soon as it becomes available. If no spool file can be created either, the output stays
+ * in memory until the target directory is available.
  */
 class FileLogBase
 {
 public:
-	FileLogBase();
-	virtual ~FileLogBase() noexcept;
+	EXPOSE_TO_CPP_TESTS FileLogBase();
+	virtual EXPOSE_TO_CPP_TESTS ~FileLogBase() noexcept;
 
 	/** Closes the log. Further calls to logging methods will be ignored. */
-	void shutdown();
+	void EXPOSE_TO_CPP_TESTS shutdown();
+
+	/**
+	 * Writes everything logged so far to the disk. Returns false unless all of it is in the file in the target
+	 * directory, e.g. because the log is still being opened or spooled or because a write failed.
+	 */
+	bool EXPOSE_TO_CPP_TESTS flushToTarget();
 
 protected:
 	/** Synchronizes access to the log file. */
-	CRITICAL_SECTION criticalSection;
+	Mutex criticalSection;
+
+	/** File into which results are written. Not open if the file has not been opened yet. */
+	File logFile;
 
-	/** File into which results are written. INVALID_HANDLE if the file has not been opened yet. */
-	HANDLE logFile = INVALID_HANDLE_VALUE;
+	/** Local directory for temporary files, below which the log is spooled. Only changed by tests. */
+	std::string tempDirectory = Platform::getTempDirectory();
+
+	/** Time to wait between attempts to open the target file if the target directory is unavailable. Only changed by tests. */
+	unsigned long retryIntervalMillis = 5000;
 
 	/**
-	 * Create the log file. Must be the first method called on this object.
+	 * Create the log file in the background. Must be the first method called on this object.
+	 * If the target directory does not respond within spoolTimeoutMillis, the log is spooled locally.
 	 * This method is not thread-safe or reentrant.
 	 */
-	void createLogFile(std::string directory, std::string name, bool overwriteIfExists);
+	void EXPOSE_TO_CPP_TESTS createLogFile(std::string directory, std::string name, bool overwriteIfExists, unsigned long spoolTimeoutMillis);
 
 	/** Writes the given string to the log file. */
-	int writeToFile(const char* string);
+	int EXPOSE_TO_CPP_TESTS writeToFile(const char* string);
+
+	/** Writes the given bytes to the log file. */
+	int writeToFile(const char* data, size_t length);
 
-	/** Writes the given name-value pair to the log file. */
-	void writeTupleToFile(const char* key, const char* value);
+	/** Writes the given name-value pair to the log file as one line, regardless of its length. */
+	void EXPOSE_TO_CPP_TESTS writeTupleToFile(const char* key, const char* value);
 
 	/** Fills the given buffer with a string representing the current time. */
 	std::string getFormattedCurrentTime();
+
+	/**
+	 * Called on the opener thread if the log can be written neither to the target directory nor to a spool file.
+	 * Output written now is buffered until the file is open. Does nothing by default.
+	 */
+	virtual void logOpenProblem(const std::string& message);
+
+private:
+	/** Output written while the log file is still being opened. */
+	std::string pendingOutput;
+
+	/** Whether the log file is still being opened, i.e. output must be buffered. */
+	bool isOpening = false;
+
+	/** Whether shutdown closed the log, so the opener thread must not open it again. */
+	bool isShutDown = false;
+
+	/** Whether output was lost because writing it to the log file failed. */
+	bool hasLostOutput = false;
+
+	/** Thread that opens the log file and migrates the spool. Not started if opening failed. */
+	Thread openerThread;
+
+	/** Signaled on shutdown to stop the opener thread. */
+	Event shutdownEvent;
+
+	/** The directory the log file should end up in. */
+	std::string targetDirectory;
+
+	/** Name of the log file. */
+	std::string fileName;
+
+	/** Whether an existing log file in the target directory should be overwritten. */
+	bool overwriteIfExists = false;
+
+	/** Time to wait for the target directory before spooling. */
+	unsigned long spoolTimeout = 0;
+
+	/** Local directory for spooled log files of the target directory. */
+	std::string spoolDirectory;
+
+	/** Path of the spool file if the log is currently being spooled, the empty string otherwise. */
+	std::string spoolPath;
+
+	/** Whether the failure to create a spool file was logged, so retries do not log it again. */
+	bool hasLoggedSpoolProblem = false;
+
+	/** Entry point of the opener thread. */
+	static void runOpenerThread(void* parameter);
+
+	/** Opens the log file in the target directory, spooling locally as long as it is not available. */
+	void openInBackground();
+
+	/** Starts writing to the given file and flushes all pending output to it. */
+	void useFile(File file);
+
+	/** Starts writing to a new spool file. Returns false and keeps buffering the output if it cannot be created. */
+	bool startSpooling();
+
+	/** Moves the contents of the current spool file to the given target file and continues writing there. */
+	void migrateSpoolTo(File targetFile);
+
+	/** Appends spool files of previous processes that could not reach the target directory to their target files. */
+	void migrateLeftoverSpoolFiles();
+
+	/** Waits for the given time or until shutdown is requested. Returns true on shutdown. */
+	bool waitForShutdown(unsigned long millis);
 };
@@ -1,53 +1,52 @@
-#include "TraceLog.h"
-#include "version.h"
-#include <vector>
-#include <fstream>
-#include <algorithm>
-#include <winuser.h>
-#include "utils/WindowsUtils.h"
-#include <string>
-
-TraceLog::~TraceLog() {
-	// Nothing to do here, destructing is handled in FileLogBase
-}
-
-void TraceLog::writeJittedFunctionInfosToLog(std::vector<FunctionInfo>* functions)
-{
-	writeFunctionInfosToLog(LOG_KEY_JITTED, functions);
-}
-
-void TraceLog::writeInlinedFunctionInfosToLog(std::vector<FunctionInfo>* functions)
-{
-	writeFunctionInfosToLog(LOG_KEY_INLINED, functions);
-}
-
-void TraceLog::createLogFile(std::string targetDir) {
-
-	std::string timeStamp = getFormattedCurrentTime();
-
-	std::string fileName = "";
-	fileName = fileName + "coverage_" + timeStamp + ".txt";
-
-	FileLogBase::createLogFile(targetDir, fileName, true);
-
-	writeTupleToFile(LOG_KEY_INFO, VERSION_DESCRIPTION);
-	writeTupleToFile(LOG_KEY_STARTED, timeStamp.c_str());
-}
-
-void TraceLog::writeFunctionInfosToLog(const char* key, std::vector<FunctionInfo>* functions) {
-	for (std::vector<FunctionInfo>::iterator i = functions->begin(); i != functions->end(); i++) {
-		writeSingleFunctionInfoToLog(key, *i);
-	}
-}
-
-void TraceLog::writeSingleFunctionInfoToLog(const char* key, FunctionInfo& info) {
-	char signature[BUFFER_SIZE];
-	signature[0] = '\0';
-	sprintf_s(signature, "%i:%i", info.assemblyNumber,
-		info.functionToken);
-	writeTupleToFile(key, signature);
-}
-
+#include "TraceLog.h"
+#include "version.h"
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <stdio.h>
+#include <string>
+
+TraceLog::~TraceLog() {
+	// Nothing to do here, destructing is handled in FileLogBase
+}
+
+void TraceLog::writeJittedFunctionInfosToLog(std::vector<FunctionInfo>* functions)
+{
+	writeFunctionInfosToLog(LOG_KEY_JITTED, functions);
+}
+
+void TraceLog::writeInlinedFunctionInfosToLog(std::vector<FunctionInfo>* functions)
+{
+	writeFunctionInfosToLog(LOG_KEY_INLINED, functions);
+}
+
+void TraceLog::createLogFile(std::string targetDir, unsigned long spoolTimeoutMillis) {
+
+	std::string timeStamp = getFormattedCurrentTime();
+
+	std::string fileName = "";
+	fileName = fileName + "coverage_" + timeStamp + ".txt";
+
+	FileLogBase::createLogFile(targetDir, fileName, true, spoolTimeoutMillis);
+
+	writeTupleToFile(LOG_KEY_INFO, VERSION_DESCRIPTION);
+	writeTupleToFile(LOG_KEY_STARTED, timeStamp.c_str());
+}
+
+void TraceLog::writeFunctionInfosToLog(const char* key, std::vector<FunctionInfo>* functions) {
+	for (std::vector<FunctionInfo>::iterator i = functions->begin(); i != functions->end(); i++) {
+		writeSingleFunctionInfoToLog(key, *i);
+	}
+}
+
+void TraceLog::writeSingleFunctionInfoToLog(const char* key, FunctionInfo& info) {
+	char signature[BUFFER_SIZE];
+	signature[0] = '\0';
+	snprintf(signature, sizeof(signature), "%i:%i", info.assemblyNumber,
+		static_cast<int>(info.functionToken));
+	writeTupleToFile(key, signature);
+}
+
 void TraceLog::info(std::string message) {
 	writeTupleToFile(LOG_KEY_INFO, message.c_str());
 }
@@ -77,11 +76,51 @@ void TraceLog::logAssembly(std::string assembly)
 	writeTupleToFile(LOG_KEY_ASSEMBLY, assembly.c_str());
 }
 
+void TraceLog::logTestSegment(std::string testName)
+{
+	writeTupleToFile(LOG_KEY_TEST, testName.c_str());
+}
+
+void TraceLog::logBlockOffsets(std::string offsets)
+{
+	writeTupleToFile(LOG_KEY_BLOCK_OFFSETS, offsets.c_str());
+}
+
+void TraceLog::logBlocks(std::string blocks)
+{
+	writeTupleToFile(LOG_KEY_BLOCKS, blocks.c_str());
+}
+
+void TraceLog::logCalls(std::string calls)
+{
+	writeTupleToFile(LOG_KEY_CALLS, calls.c_str());
+}
+
+void TraceLog::logStack(std::string stack)
+{
+	writeTupleToFile(LOG_KEY_STACK, stack.c_str());
+}
+
+void TraceLog::logJitCostOfAssembly(std::string costs)
+{
+	writeTupleToFile(LOG_KEY_JIT_COST_ASSEMBLY, costs.c_str());
+}
+
+void TraceLog::logJitCostOfMethod(std::string costs)
+{
+	writeTupleToFile(LOG_KEY_JIT_COST_METHOD, costs.c_str());
+}
+
+void TraceLog::logOpenProblem(const std::string& message)
+{
+	warn(message);
+}
+
 void TraceLog::shutdown() {
-	std::string timeStamp = getFormattedCurrentTime();
-	writeTupleToFile(LOG_KEY_STOPPED, timeStamp.c_str());
-
-	writeTupleToFile(LOG_KEY_INFO, "Shutting down coverage profiler");
-
-	FileLogBase::shutdown();
+	std::string timeStamp = getFormattedCurrentTime();
+	writeTupleToFile(LOG_KEY_STOPPED, timeStamp.c_str());
+
+	writeTupleToFile(LOG_KEY_INFO, "Shutting down coverage profiler");
+
+	FileLogBase::shutdown();
 }
\ No newline at end of file
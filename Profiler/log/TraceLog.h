@@ -1,7 +1,6 @@
 #pragma once
 #include "FunctionInfo.h"
 #include "FileLogBase.h"
-#include <atlbase.h>
 #include <string>
 #include <vector>
 #include <map>
@@ -27,7 +26,7 @@ public:
 	 * Can be called as an alternative for createLogFile method of the base class as first method called on the object.
 	 * This method is not thread-safe or reentrant.
 	 */
-	void createLogFile(std::string targetDir);
+	void createLogFile(std::string targetDir, unsigned long spoolTimeoutMillis);
 
 	/** Writes a closing log entry to the file and closes the log file. Further calls to logging methods will be ignored. */
 	void shutdown();
@@ -50,7 +49,31 @@ public:
 	/** Writes info about a profiled assembly into the log. Should only be called once. */
 	void logAssembly(std::string assembly);
 
+	/** Starts a segment of the trace that contains the coverage of the given test. The empty name stands for no test. */
+	void logTestSegment(std::string testName);
+
+	/** Writes the IL offsets of the basic blocks of a method into the log. */
+	void logBlockOffsets(std::string offsets);
+
+	/** Writes the bitmap of the executed basic blocks of a method into the log. */
+	void logBlocks(std::string blocks);
+
+	/** Writes the number of calls of a method into the log. */
+	void logCalls(std::string calls);
+
+	/** Writes a sampled stack in collapsed format into the log. */
+	void logStack(std::string stack);
+
+	/** Writes the JIT costs of an assembly into the log. */
+	void logJitCostOfAssembly(std::string costs);
+
+	/** Writes the JIT costs of a method into the log. */
+	void logJitCostOfMethod(std::string costs);
+
 protected:
+	/** Writes the problem as a warning, which ends up in the trace once it can be written. */
+	virtual void logOpenProblem(const std::string& message) override;
+
 	/** The key to log information about the profiler startup. */
 	const char* LOG_KEY_STARTED = "Started";
 
@@ -81,6 +104,27 @@ protected:
 	/** The key to log information about the environment variables the profiled process sees. */
 	const char* LOG_KEY_ENVIRONMENT = "Environment";
 
+	/** The key to start the coverage of a single test. */
+	const char* LOG_KEY_TEST = "Test";
+
+	/** The key to log the IL offsets of the basic blocks of a method. */
+	const char* LOG_KEY_BLOCK_OFFSETS = "BlockOffsets";
+
+	/** The key to log the executed basic blocks of a method. */
+	const char* LOG_KEY_BLOCKS = "Blocks";
+
+	/** The key to log the number of calls of a method. */
+	const char* LOG_KEY_CALLS = "Calls";
+
+	/** The key to log a sampled stack. */
+	const char* LOG_KEY_STACK = "Stack";
+
+	/** The key to log the JIT costs of an assembly. */
+	const char* LOG_KEY_JIT_COST_ASSEMBLY = "JitCostAssembly";
+
+	/** The key to log the JIT costs of a method. */
+	const char* LOG_KEY_JIT_COST_METHOD = "JitCostMethod";
+
 
 private:
 	/** Write all information about the given functions to the log. */
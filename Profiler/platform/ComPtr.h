@@ -0,0 +1,74 @@
+#pragma once
+#include <cor.h>
+
+/**
+ * Holds a reference to a COM interface and releases it when it is destroyed or replaced.
+ *
+ * Replaces ATL's CComQIPtr, which does not exist on Linux. Since __uuidof is not available there either, interfaces
+ * are queried with their explicit IID.
+ */
+template<class T>
+class ComPtr
+{
+public:
+	ComPtr() {
+		// holds no reference yet
+	}
+
+	~ComPtr() {
+		release();
+	}
+
+	ComPtr(const ComPtr& other) : pointer(other.pointer) {
+		if (pointer != NULL) {
+			pointer->AddRef();
+		}
+	}
+
+	/** Holds a new reference to the given interface, like ATL's CComPtr. */
+	ComPtr& operator=(T* object) {
+		if (object != NULL) {
+			object->AddRef();
+		}
+		release();
+		pointer = object;
+		return *this;
+	}
+
+	ComPtr& operator=(const ComPtr& other) {
+		if (other.pointer != NULL) {
+			other.pointer->AddRef();
+		}
+		release();
+		pointer = other.pointer;
+		return *this;
+	}
+
+	/** Replaces the held reference with the given interface of the given object. Returns the result of QueryInterface. */
+	HRESULT query(IUnknown* object, REFIID iid) {
+		release();
+		if (object == NULL) {
+			return E_POINTER;
+		}
+		return object->QueryInterface(iid, reinterpret_cast<void**>(&pointer));
+	}
+
+	/** Releases the held reference. */
+	void release() {
+		if (pointer != NULL) {
+			pointer->Release();
+			pointer = NULL;
+		}
+	}
+
+	T* operator->() const {
+		return pointer;
+	}
+
+	operator T*() const {
+		return pointer;
+	}
+
+private:
+	T* pointer = NULL;
+};
@@ -0,0 +1,109 @@
+#include "Event.h"
+#include "Platform.h"
+
+#ifdef _WIN32
+#include <vector>
+
+Event::Event() {
+	handle = CreateEvent(NULL, TRUE, FALSE, NULL);
+}
+
+Event::~Event() {
+	if (handle != NULL) {
+		CloseHandle(handle);
+	}
+}
+
+bool Event::openNamed(const std::string& name) {
+	HANDLE namedHandle = CreateEventA(NULL, TRUE, FALSE, name.c_str());
+	if (namedHandle == NULL) {
+		return false;
+	}
+	if (handle != NULL) {
+		CloseHandle(handle);
+	}
+	handle = namedHandle;
+	return true;
+}
+
+void Event::set() {
+	SetEvent(handle);
+}
+
+bool Event::wait(unsigned long timeoutMillis) {
+	return WaitForSingleObject(handle, timeoutMillis) == WAIT_OBJECT_0;
+}
+
+int Event::waitForAny(Event* const* events, int eventCount, unsigned long timeoutMillis) {
+	std::vector<HANDLE> handles;
+	for (int i = 0; i < eventCount; i++) {
+		handles.push_back(events[i]->handle);
+	}
+	DWORD result = WaitForMultipleObjects(static_cast<DWORD>(eventCount), handles.data(), FALSE, timeoutMillis);
+	if (result - WAIT_OBJECT_0 < static_cast<DWORD>(eventCount)) {
+		return static_cast<int>(result - WAIT_OBJECT_0);
+	}
+	return TIMED_OUT;
+}
+
+#else
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/** Incremented by every set() of any event. Waiters sleep on it until it changes. */
+static int eventGeneration = 0;
+
+Event::Event() {
+	// the state is initialized in the declaration
+}
+
+Event::~Event() {
+	// nothing to release
+}
+
+bool Event::openNamed(const std::string&) {
+	// named events only exist on Windows
+	return false;
+}
+
+void Event::set() {
+	__atomic_store_n(&isSet, 1, __ATOMIC_SEQ_CST);
+	__atomic_add_fetch(&eventGeneration, 1, __ATOMIC_SEQ_CST);
+	syscall(SYS_futex, &eventGeneration, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+bool Event::wait(unsigned long timeoutMillis) {
+	Event* self = this;
+	return waitForAny(&self, 1, timeoutMillis) == 0;
+}
+
+int Event::waitForAny(Event* const* events, int eventCount, unsigned long timeoutMillis) {
+	uint64_t deadline = Platform::getMonotonicMicroseconds() + static_cast<uint64_t>(timeoutMillis) * 1000;
+	while (true) {
+		// read the generation before the events, so a set() in between makes the futex wait return immediately
+		int generation = __atomic_load_n(&eventGeneration, __ATOMIC_SEQ_CST);
+		for (int i = 0; i < eventCount; i++) {
+			if (__atomic_load_n(&events[i]->isSet, __ATOMIC_SEQ_CST)) {
+				return i;
+			}
+		}
+
+		struct timespec remaining;
+		struct timespec* timeout = NULL;
+		if (timeoutMillis != Platform::INFINITE_WAIT) {
+			uint64_t now = Platform::getMonotonicMicroseconds();
+			if (now >= deadline) {
+				return TIMED_OUT;
+			}
+			remaining.tv_sec = static_cast<time_t>((deadline - now) / 1000000);
+			remaining.tv_nsec = static_cast<long>((deadline - now) % 1000000) * 1000;
+			timeout = &remaining;
+		}
+		syscall(SYS_futex, &eventGeneration, FUTEX_WAIT_PRIVATE, generation, timeout, NULL, 0);
+	}
+}
+
+#endif
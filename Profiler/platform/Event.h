@@ -0,0 +1,54 @@
+#pragma once
+#include <string>
+#include "utils/Testing.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+/**
+ * A manual-reset event that threads can wait for with a timeout. Once set, it stays set and releases all waiters.
+ *
+ * On Linux, all events of the process share one futex that counts the calls of set(), so a thread can wait for
+ * any of several events. Events are only set to stop or wake up background threads, so waking all waiters on
+ * every set() costs nothing measurable.
+ */
+class Event
+{
+public:
+	/** Returned by the wait methods if the timeout elapsed. */
+	static const int TIMED_OUT = -1;
+
+	/** Creates an unnamed event that is not set. */
+	EXPOSE_TO_CPP_TESTS Event();
+	virtual EXPOSE_TO_CPP_TESTS ~Event();
+
+	/**
+	 * Replaces this event by the named event of the current session, which other processes can set, and creates it
+	 * if it does not exist yet. Returns false if that fails or named events are not supported, i.e. on Linux.
+	 */
+	bool openNamed(const std::string& name);
+
+	/** Sets the event and releases all threads that wait for it. */
+	void EXPOSE_TO_CPP_TESTS set();
+
+	/** Waits until the event is set. Returns false if the timeout in milliseconds elapsed first. */
+	bool EXPOSE_TO_CPP_TESTS wait(unsigned long timeoutMillis);
+
+	/**
+	 * Waits until one of the given events is set and returns its index, or TIMED_OUT if the timeout in milliseconds
+	 * elapsed first. Returns the lowest index if several events are set.
+	 */
+	static int EXPOSE_TO_CPP_TESTS waitForAny(Event* const* events, int eventCount, unsigned long timeoutMillis);
+
+private:
+	Event(const Event&) = delete;
+	Event& operator=(const Event&) = delete;
+
+#ifdef _WIN32
+	HANDLE handle = NULL;
+#else
+	/** 1 once the event is set. */
+	int isSet = 0;
+#endif
+};
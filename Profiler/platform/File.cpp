@@ -0,0 +1,182 @@
+#include "File.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+File::File() {
+	// nothing is open yet
+}
+
+File::~File() {
+	close();
+}
+
+File::File(File&& other) {
+	*this = std::move(other);
+}
+
+File& File::operator=(File&& other) {
+	if (this != &other) {
+		close();
+#ifdef _WIN32
+		handle = other.handle;
+		other.handle = INVALID_HANDLE_VALUE;
+#else
+		descriptor = other.descriptor;
+		writeOffset = other.writeOffset;
+		path = std::move(other.path);
+		other.descriptor = -1;
+#endif
+	}
+	return *this;
+}
+
+#ifdef _WIN32
+
+bool File::open(const std::string& path, Mode mode) {
+	close();
+	switch (mode) {
+	case APPEND:
+		handle = CreateFile(path.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		break;
+	case APPEND_SHARED:
+		handle = CreateFile(path.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_WRITE,
+			NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		break;
+	case OVERWRITE:
+		handle = CreateFile(path.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		break;
+	case READ:
+		handle = CreateFile(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+			NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		break;
+	case READ_EXCLUSIVE:
+		handle = CreateFile(path.c_str(), GENERIC_READ | DELETE, 0, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		break;
+	}
+	return isOpen();
+}
+
+bool File::write(const char* data, size_t length) {
+	DWORD written = 0;
+	return WriteFile(handle, data, static_cast<DWORD>(length), &written, NULL) && written == length;
+}
+
+int File::read(char* buffer, int size) {
+	DWORD bytesRead = 0;
+	if (!ReadFile(handle, buffer, size, &bytesRead, NULL)) {
+		return -1;
+	}
+	return static_cast<int>(bytesRead);
+}
+
+bool File::flush() {
+	return FlushFileBuffers(handle) != FALSE;
+}
+
+bool File::deleteOnClose() {
+	FILE_DISPOSITION_INFO disposition = { TRUE };
+	return SetFileInformationByHandle(handle, FileDispositionInfo, &disposition, sizeof(disposition)) != FALSE;
+}
+
+void File::close() {
+	if (handle != INVALID_HANDLE_VALUE) {
+		CloseHandle(handle);
+		handle = INVALID_HANDLE_VALUE;
+	}
+}
+
+#else
+
+bool File::open(const std::string& path, Mode mode) {
+	close();
+	int flags = O_CLOEXEC;
+	switch (mode) {
+	case APPEND:
+	case APPEND_SHARED:
+		flags |= O_WRONLY | O_CREAT | O_APPEND;
+		break;
+	case OVERWRITE:
+		flags |= O_WRONLY | O_CREAT | O_TRUNC;
+		break;
+	case READ:
+	case READ_EXCLUSIVE:
+		flags |= O_RDONLY;
+		break;
+	}
+	descriptor = ::open(path.c_str(), flags, 0666);
+	if (descriptor < 0) {
+		return false;
+	}
+
+	// Linux has no mandatory share modes, so writers hold a shared advisory lock that an exclusive reader cannot get
+	int lockOperation = LOCK_SH;
+	if (mode == READ_EXCLUSIVE) {
+		lockOperation = LOCK_EX | LOCK_NB;
+	}
+	if (mode != READ && flock(descriptor, lockOperation) != 0) {
+		close();
+		return false;
+	}
+
+	writeOffset = -1;
+	if (mode == OVERWRITE) {
+		writeOffset = 0;
+	}
+	this->path = path;
+	return true;
+}
+
+bool File::write(const char* data, size_t length) {
+	while (length > 0) {
+		ssize_t written;
+		if (writeOffset >= 0) {
+			written = pwrite(descriptor, data, length, writeOffset);
+		}
+		else {
+			written = ::write(descriptor, data, length);
+		}
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		if (writeOffset >= 0) {
+			writeOffset += written;
+		}
+		data += written;
+		length -= written;
+	}
+	return true;
+}
+
+int File::read(char* buffer, int size) {
+	ssize_t bytesRead;
+	do {
+		bytesRead = ::read(descriptor, buffer, size);
+	} while (bytesRead < 0 && errno == EINTR);
+	return static_cast<int>(bytesRead);
+}
+
+bool File::flush() {
+	return fsync(descriptor) == 0;
+}
+
+bool File::deleteOnClose() {
+	// we hold the exclusive lock, so nobody writes to the file anymore. Removing the name does not affect reading
+	return unlink(path.c_str()) == 0;
+}
+
+void File::close() {
+	if (descriptor >= 0) {
+		::close(descriptor);
+		descriptor = -1;
+	}
+}
+
+#endif
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "utils/Testing.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+/**
+ * An open file. Closed by the destructor.
+ *
+ * On Linux, files that only this process writes are written with pwrite at an offset that this object tracks, so
+ * writes need no seek and no shared file position. Files that other processes may append to use O_APPEND instead.
+ */
+class File
+{
+public:
+	/** How a file is opened. */
+	enum Mode {
+		/** Appends to the file, which is created if it does not exist. Others may read it. */
+		APPEND,
+		/** Like APPEND, but other processes may append to the file at the same time. */
+		APPEND_SHARED,
+		/** Replaces the file with an empty one that only this process writes. Others may read it. */
+		OVERWRITE,
+		/** Reads an existing file that others may still write. */
+		READ,
+		/** Reads an existing file and fails if anyone else has it open for writing. Allows deleteOnClose(). */
+		READ_EXCLUSIVE,
+	};
+
+	EXPOSE_TO_CPP_TESTS File();
+	virtual EXPOSE_TO_CPP_TESTS ~File();
+
+	File(File&& other);
+	File& operator=(File&& other);
+
+	/** Opens the given file, closing the currently open one. Returns false if that fails. */
+	bool EXPOSE_TO_CPP_TESTS open(const std::string& path, Mode mode);
+
+	/** Whether a file is open. */
+	bool isOpen() {
+#ifdef _WIN32
+		return handle != INVALID_HANDLE_VALUE;
+#else
+		return descriptor >= 0;
+#endif
+	}
+
+	/** Writes the given bytes. Returns false if not all of them could be written. */
+	bool EXPOSE_TO_CPP_TESTS write(const char* data, size_t length);
+
+	/** Reads up to the given number of bytes. Returns the number of bytes read, 0 at the end of the file or -1 on errors. */
+	int EXPOSE_TO_CPP_TESTS read(char* buffer, int size);
+
+	/** Writes all data written so far to the disk. Returns false if that fails. */
+	bool EXPOSE_TO_CPP_TESTS flush();
+
+	/** Deletes the file once it is closed. Only works for files opened with READ_EXCLUSIVE. */
+	bool EXPOSE_TO_CPP_TESTS deleteOnClose();
+
+	/** Closes the file if it is open. */
+	void EXPOSE_TO_CPP_TESTS close();
+
+private:
+	File(const File&) = delete;
+	File& operator=(const File&) = delete;
+
+#ifdef _WIN32
+	HANDLE handle = INVALID_HANDLE_VALUE;
+#else
+	int descriptor = -1;
+
+	/** The offset of the next write or -1 if the file is written with O_APPEND. */
+	int64_t writeOffset = -1;
+
+	/** The path of the file, which deleteOnClose() needs. */
+	std::string path;
+#endif
+};
@@ -0,0 +1,104 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() {
+	// nothing is mapped yet
+}
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path) {
+	close();
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+		OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize)) {
+		CloseHandle(file);
+		return false;
+	}
+	if (fileSize.QuadPart == 0) {
+		// empty files cannot be mapped
+		CloseHandle(file);
+		return true;
+	}
+
+	// the view keeps the mapping and the file open
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (mapping == NULL) {
+		return false;
+	}
+	data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	CloseHandle(mapping);
+	if (data == NULL) {
+		return false;
+	}
+	size = static_cast<size_t>(fileSize.QuadPart);
+	return true;
+}
+
+void MappedFile::close() {
+	if (data != NULL) {
+		UnmapViewOfFile(data);
+		data = NULL;
+	}
+	size = 0;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path) {
+	close();
+	int descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (descriptor < 0) {
+		return false;
+	}
+
+	struct stat status;
+	if (fstat(descriptor, &status) != 0) {
+		::close(descriptor);
+		return false;
+	}
+	if (status.st_size == 0) {
+		// empty files cannot be mapped
+		::close(descriptor);
+		return true;
+	}
+
+	// the mapping keeps the file open
+	void* mapping = mmap(NULL, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+	::close(descriptor);
+	if (mapping == MAP_FAILED) {
+		return false;
+	}
+	madvise(mapping, static_cast<size_t>(status.st_size), MADV_SEQUENTIAL);
+	data = static_cast<const char*>(mapping);
+	size = static_cast<size_t>(status.st_size);
+	return true;
+}
+
+void MappedFile::close() {
+	if (data != NULL) {
+		munmap(const_cast<char*>(data), size);
+		data = NULL;
+	}
+	size = 0;
+}
+
+#endif
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include "utils/Testing.h"
+
+/**
+ * A file mapped read-only into memory, so it can be scanned without copying it into a buffer first.
+ * Unmapped by the destructor. The file must not be truncated while it is mapped.
+ */
+class MappedFile
+{
+public:
+	EXPOSE_TO_CPP_TESTS MappedFile();
+	virtual EXPOSE_TO_CPP_TESTS ~MappedFile();
+
+	/** Maps the given file, unmapping the current one. Returns false if that fails. Empty files have no data. */
+	bool EXPOSE_TO_CPP_TESTS open(const std::string& path);
+
+	/** The mapped bytes or NULL if nothing or an empty file is mapped. */
+	const char* getData() {
+		return data;
+	}
+
+	/** The number of mapped bytes. */
+	size_t getSize() {
+		return size;
+	}
+
+	/** Unmaps the file if it is mapped. */
+	void EXPOSE_TO_CPP_TESTS close();
+
+private:
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const char* data = NULL;
+	size_t size = 0;
+};
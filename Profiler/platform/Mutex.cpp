@@ -0,0 +1,76 @@
+#include "Mutex.h"
+
+#ifdef _WIN32
+
+Mutex::Mutex() {
+	InitializeCriticalSection(&section);
+}
+
+Mutex::~Mutex() {
+	DeleteCriticalSection(&section);
+}
+
+void Mutex::lock() {
+	EnterCriticalSection(&section);
+}
+
+void Mutex::unlock() {
+	LeaveCriticalSection(&section);
+}
+
+#else
+#include "Platform.h"
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+Mutex::Mutex() {
+	// the state is initialized in the declaration
+}
+
+Mutex::~Mutex() {
+	// nothing to release
+}
+
+void Mutex::lock() {
+	unsigned long self = Platform::getThreadId();
+	if (__atomic_load_n(&owner, __ATOMIC_RELAXED) == self) {
+		recursion++;
+		return;
+	}
+
+	// Drepper, "Futexes Are Tricky", mutex 2: waiters mark the state as contended so unlock() knows to wake them
+	int expected = 0;
+	for (int spin = 0; spin < SPIN_COUNT; spin++) {
+		expected = 0;
+		if (__atomic_compare_exchange_n(&state, &expected, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+			break;
+		}
+		if (expected == 2) {
+			break;
+		}
+	}
+	if (expected != 0) {
+		int current = __atomic_exchange_n(&state, 2, __ATOMIC_ACQUIRE);
+		while (current != 0) {
+			syscall(SYS_futex, &state, FUTEX_WAIT_PRIVATE, 2, NULL, NULL, 0);
+			current = __atomic_exchange_n(&state, 2, __ATOMIC_ACQUIRE);
+		}
+	}
+
+	__atomic_store_n(&owner, self, __ATOMIC_RELAXED);
+	recursion = 1;
+}
+
+void Mutex::unlock() {
+	if (--recursion > 0) {
+		return;
+	}
+
+	__atomic_store_n(&owner, 0, __ATOMIC_RELAXED);
+	if (__atomic_exchange_n(&state, 0, __ATOMIC_RELEASE) == 2) {
+		syscall(SYS_futex, &state, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+	}
+}
+
+#endif
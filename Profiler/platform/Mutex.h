@@ -0,0 +1,46 @@
+#pragma once
+#include "utils/Testing.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+/**
+ * A recursive lock: the thread that holds it may lock it again, e.g. when a log writes to its file while it already
+ * holds the lock for its buffer. Every lock() must be matched by an unlock().
+ *
+ * On Windows this is a critical section. On Linux it is a futex, so locking and unlocking an uncontended mutex are
+ * single atomic operations and only a thread that has to wait enters the kernel.
+ */
+class Mutex
+{
+public:
+	EXPOSE_TO_CPP_TESTS Mutex();
+	virtual EXPOSE_TO_CPP_TESTS ~Mutex();
+
+	/** Waits until the calling thread holds the lock. */
+	void EXPOSE_TO_CPP_TESTS lock();
+
+	/** Releases the lock once. */
+	void EXPOSE_TO_CPP_TESTS unlock();
+
+private:
+	Mutex(const Mutex&) = delete;
+	Mutex& operator=(const Mutex&) = delete;
+
+#ifdef _WIN32
+	CRITICAL_SECTION section;
+#else
+	/** Number of spins before a contended lock waits in the kernel. */
+	static const int SPIN_COUNT = 100;
+
+	/** 0 if unlocked, 1 if locked without waiters, 2 if locked and other threads may be waiting. */
+	int state = 0;
+
+	/** Thread ID of the owner or 0 if unlocked. Only the owner writes it while it holds the lock. */
+	unsigned long owner = 0;
+
+	/** Number of times the owner locked the mutex. Only accessed by the owner. */
+	unsigned int recursion = 0;
+#endif
+};
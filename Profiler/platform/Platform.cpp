@@ -0,0 +1,371 @@
+#include "Platform.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <stdlib.h>
+
+/** Maximum size of an enironment variable value according to http://msdn.microsoft.com/en-us/library/ms683188.aspx */
+static const size_t MAX_ENVIRONMENT_VARIABLE_VALUE_SIZE = 32767 * sizeof(char);
+
+std::string Platform::getEnvironmentVariable(const std::string& name) {
+	char value[MAX_ENVIRONMENT_VARIABLE_VALUE_SIZE];
+	if (!GetEnvironmentVariable(name.c_str(), value, MAX_ENVIRONMENT_VARIABLE_VALUE_SIZE)) {
+		return "";
+	}
+	return value;
+}
+
+std::vector<std::string> Platform::listEnvironmentVariables() {
+	std::vector<std::string> variables;
+
+	if (_environ == NULL) {
+		return variables;
+	}
+
+	char** nextVariable = _environ;
+	while (*nextVariable) {
+		variables.push_back(*nextVariable);
+		nextVariable++;
+	}
+
+	return variables;
+}
+
+std::string Platform::getProcessPath() {
+	char appPath[_MAX_PATH];
+	appPath[0] = 0;
+
+	size_t length = GetModuleFileName(NULL, appPath, MAX_PATH);
+	if (length == 0) {
+		return "Failed to read application path";
+	}
+	return std::string(appPath, length);
+}
+
+std::string Platform::getCommandLine() {
+	return GetCommandLine();
+}
+
+std::string Platform::getMachineName() {
+	char name[MAX_COMPUTERNAME_LENGTH + 1];
+	DWORD length = sizeof(name);
+	if (!GetComputerNameA(name, &length)) {
+		return "";
+	}
+	return std::string(name, length);
+}
+
+unsigned long Platform::getProcessId() {
+	return GetCurrentProcessId();
+}
+
+unsigned long Platform::getThreadId() {
+	return GetCurrentThreadId();
+}
+
+std::string Platform::getTempDirectory() {
+	char tempPath[MAX_PATH + 1];
+	DWORD length = GetTempPath(sizeof(tempPath), tempPath);
+	if (length == 0 || length > sizeof(tempPath)) {
+		return "c:\\users\\public\\";
+	}
+	return std::string(tempPath, length);
+}
+
+bool Platform::isFile(const std::string& path) {
+	DWORD dwAttrib = GetFileAttributes(path.c_str());
+	// check if it's a valid path and not a directory
+	return (dwAttrib != INVALID_FILE_ATTRIBUTES && !(dwAttrib & FILE_ATTRIBUTE_DIRECTORY));
+}
+
+bool Platform::createDirectory(const std::string& path) {
+	return CreateDirectory(path.c_str(), NULL) || GetLastError() == ERROR_ALREADY_EXISTS;
+}
+
+std::vector<std::string> Platform::listFiles(const std::string& directory) {
+	std::vector<std::string> files;
+	WIN32_FIND_DATA findData;
+	HANDLE search = FindFirstFile((directory + "\\*").c_str(), &findData);
+	if (search == INVALID_HANDLE_VALUE) {
+		return files;
+	}
+
+	do {
+		if (!(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+			files.push_back(findData.cFileName);
+		}
+	} while (FindNextFile(search, &findData));
+
+	FindClose(search);
+	return files;
+}
+
+int64_t Platform::getFileSize(const std::string& path) {
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesEx(path.c_str(), GetFileExInfoStandard, &attributes)) {
+		return -1;
+	}
+	return (static_cast<int64_t>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+}
+
+int64_t Platform::getModificationTime(const std::string& path) {
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesEx(path.c_str(), GetFileExInfoStandard, &attributes)) {
+		return -1;
+	}
+	// file times count 100 ns intervals since 1601-01-01
+	int64_t intervals = (static_cast<int64_t>(attributes.ftLastWriteTime.dwHighDateTime) << 32) |
+		attributes.ftLastWriteTime.dwLowDateTime;
+	return (intervals - 116444736000000000LL) / 10000000;
+}
+
+bool Platform::removeFile(const std::string& path) {
+	return DeleteFile(path.c_str()) != FALSE;
+}
+
+bool Platform::removeDirectory(const std::string& path) {
+	return RemoveDirectory(path.c_str()) != FALSE;
+}
+
+std::string Platform::getLastErrorMessage() {
+	DWORD errorMessageID = ::GetLastError();
+	if (errorMessageID == 0) {
+		// No error message has been recorded
+		return std::string();
+	}
+
+	// Adapted from https://stackoverflow.com/a/17387176/1396068
+	LPSTR messageBuffer = nullptr;
+	size_t size = FormatMessageA(FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
+		NULL, errorMessageID, MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT), (LPSTR)&messageBuffer, 0, NULL);
+
+	std::string message(messageBuffer, size);
+	LocalFree(messageBuffer);
+	return message;
+}
+
+void Platform::getUtcTime(UtcTime& time) {
+	SYSTEMTIME systemTime;
+	GetSystemTime(&systemTime);
+	time.year = systemTime.wYear;
+	time.month = systemTime.wMonth;
+	time.day = systemTime.wDay;
+	time.hour = systemTime.wHour;
+	time.minute = systemTime.wMinute;
+	time.second = systemTime.wSecond;
+	time.millisecond = systemTime.wMilliseconds;
+}
+
+uint64_t Platform::getMonotonicMicroseconds() {
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	// split to avoid overflowing the multiplication
+	uint64_t seconds = counter.QuadPart / frequency.QuadPart;
+	uint64_t remainder = counter.QuadPart % frequency.QuadPart;
+	return seconds * 1000000 + remainder * 1000000 / frequency.QuadPart;
+}
+
+void Platform::sleep(unsigned long milliseconds) {
+	Sleep(milliseconds);
+}
+
+int Platform::getProcessorCount() {
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+	return systemInfo.dwNumberOfProcessors > 0 ? static_cast<int>(systemInfo.dwNumberOfProcessors) : 1;
+}
+
+int Platform::captureStackTrace(void** frames, int maxFrames) {
+	return RtlCaptureStackBackTrace(1, static_cast<DWORD>(maxFrames < MAX_STACK_FRAMES ? maxFrames : MAX_STACK_FRAMES), frames, NULL);
+}
+
+#else
+#include <dirent.h>
+#include <errno.h>
+#include <execinfo.h>
+#include <fstream>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <system_error>
+#include <time.h>
+#include <unistd.h>
+
+extern char** environ;
+
+std::string Platform::getEnvironmentVariable(const std::string& name) {
+	const char* value = getenv(name.c_str());
+	if (value == NULL) {
+		return "";
+	}
+	return value;
+}
+
+std::vector<std::string> Platform::listEnvironmentVariables() {
+	std::vector<std::string> variables;
+	for (char** nextVariable = environ; nextVariable != NULL && *nextVariable != NULL; nextVariable++) {
+		variables.push_back(*nextVariable);
+	}
+	return variables;
+}
+
+std::string Platform::getProcessPath() {
+	char appPath[4096];
+	ssize_t length = readlink("/proc/self/exe", appPath, sizeof(appPath));
+	if (length <= 0) {
+		return "Failed to read application path";
+	}
+	return std::string(appPath, length);
+}
+
+std::string Platform::getCommandLine() {
+	// the arguments are separated by null characters
+	std::ifstream commandLineFile("/proc/self/cmdline", std::ios::binary);
+	std::string commandLine;
+	std::string argument;
+	while (std::getline(commandLineFile, argument, '\0')) {
+		if (!commandLine.empty()) {
+			commandLine += ' ';
+		}
+		commandLine += argument;
+	}
+	return commandLine;
+}
+
+std::string Platform::getMachineName() {
+	char name[256];
+	if (gethostname(name, sizeof(name)) != 0) {
+		return "";
+	}
+	name[sizeof(name) - 1] = '\0';
+	return name;
+}
+
+unsigned long Platform::getProcessId() {
+	return static_cast<unsigned long>(getpid());
+}
+
+unsigned long Platform::getThreadId() {
+	static thread_local unsigned long threadId = static_cast<unsigned long>(syscall(SYS_gettid));
+	return threadId;
+}
+
+std::string Platform::getTempDirectory() {
+	std::string directory = getEnvironmentVariable("TMPDIR");
+	if (directory.empty()) {
+		directory = "/tmp";
+	}
+	if (directory.back() != PATH_SEPARATOR) {
+		directory += PATH_SEPARATOR;
+	}
+	return directory;
+}
+
+bool Platform::isFile(const std::string& path) {
+	struct stat status;
+	return stat(path.c_str(), &status) == 0 && S_ISREG(status.st_mode);
+}
+
+bool Platform::createDirectory(const std::string& path) {
+	return mkdir(path.c_str(), 0777) == 0 || errno == EEXIST;
+}
+
+std::vector<std::string> Platform::listFiles(const std::string& directory) {
+	std::vector<std::string> files;
+	DIR* search = opendir(directory.c_str());
+	if (search == NULL) {
+		return files;
+	}
+
+	while (struct dirent* entry = readdir(search)) {
+		if (isFile(directory + PATH_SEPARATOR + entry->d_name)) {
+			files.push_back(entry->d_name);
+		}
+	}
+
+	closedir(search);
+	return files;
+}
+
+int64_t Platform::getFileSize(const std::string& path) {
+	struct stat status;
+	if (stat(path.c_str(), &status) != 0) {
+		return -1;
+	}
+	return static_cast<int64_t>(status.st_size);
+}
+
+int64_t Platform::getModificationTime(const std::string& path) {
+	struct stat status;
+	if (stat(path.c_str(), &status) != 0) {
+		return -1;
+	}
+	return static_cast<int64_t>(status.st_mtime);
+}
+
+bool Platform::removeFile(const std::string& path) {
+	return unlink(path.c_str()) == 0;
+}
+
+bool Platform::removeDirectory(const std::string& path) {
+	return rmdir(path.c_str()) == 0;
+}
+
+std::string Platform::getLastErrorMessage() {
+	if (errno == 0) {
+		return std::string();
+	}
+	return std::system_category().message(errno);
+}
+
+void Platform::getUtcTime(UtcTime& time) {
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	struct tm parts;
+	gmtime_r(&now.tv_sec, &parts);
+	time.year = parts.tm_year + 1900;
+	time.month = parts.tm_mon + 1;
+	time.day = parts.tm_mday;
+	time.hour = parts.tm_hour;
+	time.minute = parts.tm_min;
+	time.second = parts.tm_sec;
+	time.millisecond = static_cast<int>(now.tv_nsec / 1000000);
+}
+
+uint64_t Platform::getMonotonicMicroseconds() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return static_cast<uint64_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+void Platform::sleep(unsigned long milliseconds) {
+	struct timespec duration;
+	duration.tv_sec = milliseconds / 1000;
+	duration.tv_nsec = static_cast<long>(milliseconds % 1000) * 1000000;
+	while (nanosleep(&duration, &duration) != 0 && errno == EINTR) {
+		// continue with the remaining time
+	}
+}
+
+int Platform::getProcessorCount() {
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? static_cast<int>(count) : 1;
+}
+
+int Platform::captureStackTrace(void** frames, int maxFrames) {
+	if (maxFrames <= 0) {
+		return 0;
+	}
+	void* buffer[MAX_STACK_FRAMES + 1];
+	int count = backtrace(buffer, (maxFrames < MAX_STACK_FRAMES ? maxFrames : MAX_STACK_FRAMES) + 1);
+	if (count <= 1) {
+		return 0;
+	}
+	memcpy(frames, buffer + 1, (count - 1) * sizeof(void*));
+	return count - 1;
+}
+
+#endif
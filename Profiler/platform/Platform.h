@@ -0,0 +1,144 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "utils/Testing.h"
+
+#ifdef _WIN32
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * The operating system services the profiler core needs, implemented for Windows and for Linux, where the profiler
+ * is loaded by CoreCLR. Locks, events, threads and files have their own classes in this directory.
+ *
+ * Features that only exist on Windows (e.g. the test control pipe or the upload daemon) keep using the Win32 API
+ * directly and are not built on Linux.
+ */
+class Platform
+{
+public:
+	/** Separator of the parts of file system paths. */
+#ifdef _WIN32
+	static const char PATH_SEPARATOR = '\\';
+#else
+	static const char PATH_SEPARATOR = '/';
+#endif
+
+	/** Timeout value that waits forever. */
+	static const unsigned long INFINITE_WAIT = 0xFFFFFFFF;
+
+	/** The most return addresses captureStackTrace returns, since older Windows versions cannot capture more. */
+	static const int MAX_STACK_FRAMES = 62;
+
+	/** A point in time in UTC. */
+	struct UtcTime {
+		int year;
+		int month;
+		int day;
+		int hour;
+		int minute;
+		int second;
+		int millisecond;
+	};
+
+	/** Returns the value of the given environment variable or the empty string if it is not set. */
+	static EXPOSE_TO_CPP_TESTS std::string getEnvironmentVariable(const std::string& name);
+
+	/** Returns all environment variables in the format NAME=VALUE. */
+	static std::vector<std::string> listEnvironmentVariables();
+
+	/** Returns the path of the executable of this process. */
+	static std::string getProcessPath();
+
+	/** Returns the command line of this process. */
+	static std::string getCommandLine();
+
+	/** Returns the network name of this machine or the empty string if it is unknown. */
+	static EXPOSE_TO_CPP_TESTS std::string getMachineName();
+
+	/** Returns the ID of this process. */
+	static EXPOSE_TO_CPP_TESTS unsigned long getProcessId();
+
+	/** Returns the operating system ID of the calling thread. */
+	static EXPOSE_TO_CPP_TESTS unsigned long getThreadId();
+
+	/** Returns the directory for temporary files of the current user, including a trailing path separator. */
+	static EXPOSE_TO_CPP_TESTS std::string getTempDirectory();
+
+	/** Returns true only if the given path exists and is a file. */
+	static EXPOSE_TO_CPP_TESTS bool isFile(const std::string& path);
+
+	/** Creates the given directory. Returns true if it exists afterwards. */
+	static EXPOSE_TO_CPP_TESTS bool createDirectory(const std::string& path);
+
+	/** Returns the names of the files, but not the directories, in the given directory. */
+	static EXPOSE_TO_CPP_TESTS std::vector<std::string> listFiles(const std::string& directory);
+
+	/** Returns the size of the given file in bytes or -1 if it does not exist. */
+	static EXPOSE_TO_CPP_TESTS int64_t getFileSize(const std::string& path);
+
+	/** Returns the last modification time of the given file in seconds since 1970-01-01 UTC or -1 if it does not exist. */
+	static EXPOSE_TO_CPP_TESTS int64_t getModificationTime(const std::string& path);
+
+	/** Deletes the given file. Returns false if that fails. */
+	static EXPOSE_TO_CPP_TESTS bool removeFile(const std::string& path);
+
+	/** Deletes the given directory, which must be empty. Returns false if that fails. */
+	static EXPOSE_TO_CPP_TESTS bool removeDirectory(const std::string& path);
+
+	/** Returns the message of the last error of a system call on the calling thread. */
+	static std::string getLastErrorMessage();
+
+	/** Returns the current UTC time. */
+	static EXPOSE_TO_CPP_TESTS void getUtcTime(UtcTime& time);
+
+	/** Returns the microseconds since an arbitrary but fixed point in time. Not affected by changes of the clock. */
+	static EXPOSE_TO_CPP_TESTS uint64_t getMonotonicMicroseconds();
+
+	/** Suspends the calling thread for the given time. */
+	static EXPOSE_TO_CPP_TESTS void sleep(unsigned long milliseconds);
+
+	/** Returns the number of logical processors the process may run on, at least 1. */
+	static EXPOSE_TO_CPP_TESTS int getProcessorCount();
+
+	/**
+	 * Stores up to maxFrames, but at most MAX_STACK_FRAMES, return addresses of the calling thread's stack, innermost
+	 * first and without the frame of this method, and returns their number. Does not symbolize them, so it is cheap
+	 * enough for error paths.
+	 */
+	static EXPOSE_TO_CPP_TESTS int captureStackTrace(void** frames, int maxFrames);
+
+	/** Returns the current value of the CPU's cycle counter, which is cheap enough to read on every callback. */
+	static inline uint64_t readCycleCounter() {
+#if defined(_WIN32) || defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#elif defined(__aarch64__)
+		uint64_t ticks;
+		asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+		return ticks;
+#else
+		return getMonotonicMicroseconds();
+#endif
+	}
+
+	/** Returns the index of the highest set bit of the given value, which must not be 0. */
+	static inline unsigned int getHighestSetBit(uint64_t value) {
+#if defined(_WIN64)
+		unsigned long index = 0;
+		_BitScanReverse64(&index, value);
+		return index;
+#elif defined(_WIN32)
+		unsigned long index = 0;
+		if (_BitScanReverse(&index, static_cast<unsigned long>(value >> 32))) {
+			return index + 32;
+		}
+		_BitScanReverse(&index, static_cast<unsigned long>(value));
+		return index;
+#else
+		return 63 - __builtin_clzll(value);
+#endif
+	}
+};
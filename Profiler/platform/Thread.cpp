@@ -0,0 +1,110 @@
+#include "Thread.h"
+
+Thread::Thread() {
+	// nothing is started yet
+}
+
+Thread::~Thread() {
+	if (started != NULL) {
+		// the thread may still use its start, so it is left behind with the thread
+#ifdef _WIN32
+		CloseHandle(handle);
+#else
+		pthread_detach(handle);
+#endif
+	}
+}
+
+bool Thread::start(EntryPoint entryPoint, void* parameter) {
+	Start* start = new Start();
+	start->entryPoint = entryPoint;
+	start->parameter = parameter;
+	start->detached = false;
+	if (!create(start)) {
+		delete start;
+		return false;
+	}
+	started = start;
+	return true;
+}
+
+bool Thread::startDetached(EntryPoint entryPoint, void* parameter) {
+	Start* start = new Start();
+	start->entryPoint = entryPoint;
+	start->parameter = parameter;
+	start->detached = true;
+	Thread thread;
+	if (!thread.create(start)) {
+		delete start;
+		return false;
+	}
+
+#ifdef _WIN32
+	CloseHandle(thread.handle);
+#else
+	pthread_detach(thread.handle);
+#endif
+	return true;
+}
+
+bool Thread::join(unsigned long timeoutMillis) {
+	if (started == NULL) {
+		return true;
+	}
+
+#ifdef _WIN32
+	// unlike the finished event, the handle is also signaled if the thread was killed, e.g. by ExitProcess before DllMain runs
+	if (WaitForSingleObject(handle, timeoutMillis) != WAIT_OBJECT_0) {
+		return false;
+	}
+	CloseHandle(handle);
+	handle = NULL;
+#else
+	if (!started->finished.wait(timeoutMillis)) {
+		return false;
+	}
+	pthread_join(handle, NULL);
+#endif
+	delete started;
+	started = NULL;
+	return true;
+}
+
+#ifdef _WIN32
+
+bool Thread::create(Start* start) {
+	handle = CreateThread(NULL, 0, run, start, 0, NULL);
+	return handle != NULL;
+}
+
+DWORD WINAPI Thread::run(LPVOID parameter) {
+	Start* start = static_cast<Start*>(parameter);
+	start->entryPoint(start->parameter);
+	if (start->detached) {
+		delete start;
+	}
+	else {
+		start->finished.set();
+	}
+	return 0;
+}
+
+#else
+
+bool Thread::create(Start* start) {
+	return pthread_create(&handle, NULL, run, start) == 0;
+}
+
+void* Thread::run(void* parameter) {
+	Start* start = static_cast<Start*>(parameter);
+	start->entryPoint(start->parameter);
+	if (start->detached) {
+		delete start;
+	}
+	else {
+		start->finished.set();
+	}
+	return NULL;
+}
+
+#endif
@@ -0,0 +1,67 @@
+#pragma once
+#include "Event.h"
+#include "utils/Testing.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+/** A background thread that runs a function with a parameter. */
+class Thread
+{
+public:
+	/** The function a thread runs. */
+	typedef void (*EntryPoint)(void* parameter);
+
+	EXPOSE_TO_CPP_TESTS Thread();
+
+	/** Does not wait for the thread. A thread that is still running keeps running. */
+	virtual EXPOSE_TO_CPP_TESTS ~Thread();
+
+	/** Starts running the given function. Returns false if the thread could not be created. */
+	bool EXPOSE_TO_CPP_TESTS start(EntryPoint entryPoint, void* parameter);
+
+	/** Whether the thread was started and has not been joined yet. */
+	bool isStarted() {
+		return started != NULL;
+	}
+
+	/**
+	 * Waits until the thread has exited. Returns false if the timeout in milliseconds elapsed first, e.g. because the
+	 * thread waits for a lock that the caller holds. The thread is then left behind and this object stays started.
+	 */
+	bool EXPOSE_TO_CPP_TESTS join(unsigned long timeoutMillis);
+
+	/** Starts running the given function on a thread that nobody waits for. Returns false if that fails. */
+	static bool EXPOSE_TO_CPP_TESTS startDetached(EntryPoint entryPoint, void* parameter);
+
+private:
+	Thread(const Thread&) = delete;
+	Thread& operator=(const Thread&) = delete;
+
+	/** What the new thread runs. Shared by both threads until the new one exits. */
+	struct Start {
+		EntryPoint entryPoint;
+		void* parameter;
+		/** Whether nobody waits for the thread, so it deletes its start when it is done. */
+		bool detached;
+		/** Set when the entry point has returned. Only waited for on Linux, where threads cannot be joined with a timeout. */
+		Event finished;
+	};
+
+	/** The start of the running thread or NULL. Leaked if the thread is left behind. */
+	Start* started = NULL;
+
+#ifdef _WIN32
+	HANDLE handle = NULL;
+
+	static DWORD WINAPI run(LPVOID parameter);
+#else
+	pthread_t handle;
+
+	static void* run(void* parameter);
+#endif
+
+	/** Creates the operating system thread. Returns false if that fails. */
+	bool create(Start* start);
+};
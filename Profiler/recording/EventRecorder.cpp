@@ -0,0 +1,100 @@
+#include "EventRecorder.h"
+#include "platform/Platform.h"
+
+/** Copies the given string of the runtime, whose characters are UTF-16 code units on all platforms. */
+static std::wstring toWideString(const WCHAR* value) {
+	std::wstring result;
+	for (; *value != 0; value++) {
+		result += static_cast<wchar_t>(*value);
+	}
+	return result;
+}
+
+EventRecorder::~EventRecorder() {
+	// Nothing to do here, destructing is handled in FileLogBase
+}
+
+void EventRecorder::createRecordingFile(std::string targetDir, unsigned long spoolTimeoutMillis, ICorProfilerInfo2* profilerInfo) {
+	this->profilerInfo = profilerInfo;
+	startMicroseconds = Platform::getMonotonicMicroseconds();
+
+	FileLogBase::createLogFile(targetDir, "events_" + getFormattedCurrentTime() + ".bin", true, spoolTimeoutMillis);
+
+	criticalSection.lock();
+	EventRecording::writeHeader(buffer);
+	isRecording = true;
+	criticalSection.unlock();
+}
+
+void EventRecorder::recordAssemblyLoad(AssemblyID assemblyId, const WCHAR* assemblyName, const WCHAR* assemblyPath, ASSEMBLYMETADATA& metadata) {
+	RecordedEvent event = createEvent(EVENT_ASSEMBLY_LOAD);
+	event.assemblyId = assemblyId;
+	event.assemblyName = toWideString(assemblyName);
+	event.assemblyPath = toWideString(assemblyPath);
+	event.version[0] = metadata.usMajorVersion;
+	event.version[1] = metadata.usMinorVersion;
+	event.version[2] = metadata.usBuildNumber;
+	event.version[3] = metadata.usRevisionNumber;
+
+	ModuleID moduleId = 0;
+	if (SUCCEEDED(profilerInfo->GetAssemblyInfo(assemblyId, 0, NULL, NULL, NULL, &moduleId))) {
+		event.moduleId = moduleId;
+	}
+	append(event);
+}
+
+void EventRecorder::recordJitCompilation(FunctionID functionId) {
+	RecordedEvent event = createEvent(EVENT_JIT_COMPILATION);
+	resolveFunction(functionId, &event);
+	append(event);
+}
+
+void EventRecorder::recordInlining(FunctionID callerId, FunctionID calleeId) {
+	RecordedEvent event = createEvent(EVENT_JIT_INLINING);
+	event.callerId = callerId;
+	resolveFunction(calleeId, &event);
+	append(event);
+}
+
+void EventRecorder::shutdown() {
+	criticalSection.lock();
+	if (isRecording) {
+		writeToFile(buffer.data(), buffer.size());
+		buffer.clear();
+		isRecording = false;
+	}
+	criticalSection.unlock();
+
+	FileLogBase::shutdown();
+}
+
+RecordedEvent EventRecorder::createEvent(RecordedEventType type) {
+	RecordedEvent event;
+	event.type = type;
+	event.threadId = Platform::getThreadId();
+	event.timestamp = Platform::getMonotonicMicroseconds() - startMicroseconds;
+	return event;
+}
+
+void EventRecorder::resolveFunction(FunctionID functionId, RecordedEvent* event) {
+	event->functionId = functionId;
+
+	ModuleID moduleId = 0;
+	mdToken token = 0;
+	if (SUCCEEDED(profilerInfo->GetFunctionInfo2(functionId, 0, NULL, &moduleId, &token, 0, NULL, NULL))) {
+		event->moduleId = moduleId;
+		event->functionToken = token;
+	}
+}
+
+void EventRecorder::append(const RecordedEvent& event) {
+	criticalSection.lock();
+	if (isRecording) {
+		EventRecording::writeEvent(event, buffer);
+		if (buffer.size() >= FLUSH_THRESHOLD) {
+			writeToFile(buffer.data(), buffer.size());
+			buffer.clear();
+		}
+	}
+	criticalSection.unlock();
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "log/FileLogBase.h"
+#include "EventRecording.h"
+#include <cor.h>
+#include <corprof.h>
+#include <string>
+
+/**
+ * Records the raw stream of profiler callbacks to a binary file (events_<timestamp>.bin in the target directory)
+ * so it can be replayed later without the profiled application, e.g. by the profiler benchmark.
+ * All methods are thread-safe. Events are buffered and written in large chunks.
+ */
+class EventRecorder : public FileLogBase
+{
+public:
+	virtual ~EventRecorder() noexcept;
+
+	/** Creates the recording file. Must be the first method called on this object. Not thread-safe. */
+	void createRecordingFile(std::string targetDir, unsigned long spoolTimeoutMillis, ICorProfilerInfo2* profilerInfo);
+
+	/** Records the load of the given assembly. */
+	void recordAssemblyLoad(AssemblyID assemblyId, const WCHAR* assemblyName, const WCHAR* assemblyPath, ASSEMBLYMETADATA& metadata);
+
+	/** Records the JIT compilation of the given function. */
+	void recordJitCompilation(FunctionID functionId);
+
+	/** Records the inlining of the callee into the caller. */
+	void recordInlining(FunctionID callerId, FunctionID calleeId);
+
+	/** Writes all buffered events and closes the file. Further events are ignored. */
+	void shutdown();
+
+private:
+	/** Number of buffered bytes after which the buffer is written to the file. */
+	static const size_t FLUSH_THRESHOLD = 64 * 1024;
+
+	/** Events that have not been written to the file yet. Guarded by the critical section of the base class. */
+	std::string buffer;
+
+	/** Whether events are currently recorded. */
+	bool isRecording = false;
+
+	/** Used to look up the modules and tokens of functions. */
+	ICorProfilerInfo2* profilerInfo = NULL;
+
+	/** Monotonic clock at the start of the recording in microseconds. */
+	uint64_t startMicroseconds = 0;
+
+	/** Creates an event of the given type for the current thread and time. */
+	RecordedEvent createEvent(RecordedEventType type);
+
+	/** Looks up the module and token of the given function and stores them in the event. */
+	void resolveFunction(FunctionID functionId, RecordedEvent* event);
+
+	/** Appends the event to the buffer and flushes the buffer if it is full. */
+	void append(const RecordedEvent& event);
+};
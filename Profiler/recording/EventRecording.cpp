@@ -0,0 +1,134 @@
+#include "EventRecording.h"
+#include <cstddef>
+#include <cstring>
+
+const char EventRecording::MAGIC[8] = { 'T', 'S', 'E', 'V', 'E', 'N', 'T', '1' };
+
+void EventRecording::writeHeader(std::string& buffer) {
+	buffer.append(MAGIC, sizeof(MAGIC));
+}
+
+void EventRecording::writeEvent(const RecordedEvent& event, std::string& buffer) {
+	buffer.push_back(static_cast<char>(event.type));
+	writeNumber(event.threadId, buffer);
+	writeNumber(event.timestamp, buffer);
+
+	switch (event.type) {
+	case EVENT_ASSEMBLY_LOAD:
+		writeNumber(event.assemblyId, buffer);
+		writeNumber(event.moduleId, buffer);
+		writeString(event.assemblyName, buffer);
+		writeString(event.assemblyPath, buffer);
+		for (uint16_t part : event.version) {
+			writeNumber(part, buffer);
+		}
+		break;
+	case EVENT_JIT_INLINING:
+		// the inlined function is encoded like a jitted one
+		writeNumber(event.callerId, buffer);
+		writeNumber(event.functionId, buffer);
+		writeNumber(event.moduleId, buffer);
+		writeNumber(event.functionToken, buffer);
+		break;
+	case EVENT_JIT_COMPILATION:
+		writeNumber(event.functionId, buffer);
+		writeNumber(event.moduleId, buffer);
+		writeNumber(event.functionToken, buffer);
+		break;
+	}
+}
+
+bool EventRecording::readHeader(const char*& position, const char* end) {
+	if (end - position < static_cast<ptrdiff_t>(sizeof(MAGIC)) || memcmp(position, MAGIC, sizeof(MAGIC)) != 0) {
+		return false;
+	}
+	position += sizeof(MAGIC);
+	return true;
+}
+
+bool EventRecording::readEvent(const char*& position, const char* end, RecordedEvent* event) {
+	if (position >= end) {
+		return false;
+	}
+
+	const char* current = position;
+	*event = RecordedEvent();
+	event->type = static_cast<RecordedEventType>(*current++);
+
+	uint64_t threadId = 0, token = 0;
+	bool success = readNumber(current, end, &threadId) && readNumber(current, end, &event->timestamp);
+	event->threadId = static_cast<uint32_t>(threadId);
+
+	switch (event->type) {
+	case EVENT_ASSEMBLY_LOAD:
+		success = success && readNumber(current, end, &event->assemblyId) && readNumber(current, end, &event->moduleId)
+			&& readString(current, end, &event->assemblyName) && readString(current, end, &event->assemblyPath);
+		for (uint16_t& part : event->version) {
+			uint64_t value = 0;
+			success = success && readNumber(current, end, &value);
+			part = static_cast<uint16_t>(value);
+		}
+		break;
+	case EVENT_JIT_INLINING:
+		success = success && readNumber(current, end, &event->callerId) && readNumber(current, end, &event->functionId)
+			&& readNumber(current, end, &event->moduleId) && readNumber(current, end, &token);
+		event->functionToken = static_cast<uint32_t>(token);
+		break;
+	case EVENT_JIT_COMPILATION:
+		success = success && readNumber(current, end, &event->functionId) && readNumber(current, end, &event->moduleId)
+			&& readNumber(current, end, &token);
+		event->functionToken = static_cast<uint32_t>(token);
+		break;
+	default:
+		// unknown event type, we cannot know how long it is
+		return false;
+	}
+
+	if (success) {
+		position = current;
+	}
+	return success;
+}
+
+void EventRecording::writeNumber(uint64_t value, std::string& buffer) {
+	while (value >= 0x80) {
+		buffer.push_back(static_cast<char>((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	buffer.push_back(static_cast<char>(value));
+}
+
+void EventRecording::writeString(const std::wstring& value, std::string& buffer) {
+	writeNumber(value.size(), buffer);
+	for (wchar_t character : value) {
+		buffer.push_back(static_cast<char>(character & 0xFF));
+		buffer.push_back(static_cast<char>((character >> 8) & 0xFF));
+	}
+}
+
+bool EventRecording::readNumber(const char*& position, const char* end, uint64_t* value) {
+	*value = 0;
+	for (int shift = 0; shift < 64 && position < end; shift += 7) {
+		unsigned char byte = static_cast<unsigned char>(*position++);
+		*value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool EventRecording::readString(const char*& position, const char* end, std::wstring* value) {
+	uint64_t length = 0;
+	if (!readNumber(position, end, &length) || static_cast<uint64_t>(end - position) < length * 2) {
+		return false;
+	}
+
+	value->resize(static_cast<size_t>(length));
+	for (size_t i = 0; i < length; i++) {
+		unsigned char low = static_cast<unsigned char>(*position++);
+		unsigned char high = static_cast<unsigned char>(*position++);
+		(*value)[i] = static_cast<wchar_t>(low | (high << 8));
+	}
+	return true;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include "utils/Testing.h"
+
+/** Types of the callback events in a recording. */
+enum RecordedEventType : unsigned char {
+	EVENT_ASSEMBLY_LOAD = 1,
+	EVENT_JIT_COMPILATION = 2,
+	EVENT_JIT_INLINING = 3,
+};
+
+/**
+ * A single profiler callback with all IDs and tokens the profiler looked up while handling it.
+ * Which fields are set depends on the type.
+ */
+struct RecordedEvent {
+	RecordedEventType type = EVENT_JIT_COMPILATION;
+
+	/** The Win32 ID of the thread on which the callback happened. */
+	uint32_t threadId = 0;
+
+	/** Microseconds since the start of the recording. */
+	uint64_t timestamp = 0;
+
+	/** Assembly loads: the loaded assembly. */
+	uint64_t assemblyId = 0;
+
+	/** Assembly loads: the main module of the assembly. Otherwise: the module of the jitted or inlined function. */
+	uint64_t moduleId = 0;
+
+	/** JIT compilations: the jitted function. Inlinings: the inlined function. */
+	uint64_t functionId = 0;
+
+	/** Inlinings: the function into which the other function is inlined. */
+	uint64_t callerId = 0;
+
+	/** The metadata token of functionId. */
+	uint32_t functionToken = 0;
+
+	/** Assembly loads: name, path and version of the assembly. */
+	std::wstring assemblyName;
+	std::wstring assemblyPath;
+	uint16_t version[4] = {};
+};
+
+/**
+ * Encodes and decodes the compact binary format of event recordings.
+ *
+ * A recording consists of a header followed by the events. Each event is its type byte followed by
+ * its fields as LEB128 varints. Strings are encoded as their length followed by their UTF-16 code units.
+ */
+class EventRecording
+{
+public:
+	/** Appends the file header to the given buffer. */
+	static EXPOSE_TO_CPP_TESTS void writeHeader(std::string& buffer);
+
+	/** Appends the given event to the given buffer. */
+	static EXPOSE_TO_CPP_TESTS void writeEvent(const RecordedEvent& event, std::string& buffer);
+
+	/** Reads the file header and advances the position. Returns false if the data is not a recording of this version. */
+	static EXPOSE_TO_CPP_TESTS bool readHeader(const char*& position, const char* end);
+
+	/** Reads the next event and advances the position. Returns false at the end of the data or if it is truncated. */
+	static EXPOSE_TO_CPP_TESTS bool readEvent(const char*& position, const char* end, RecordedEvent* event);
+
+private:
+	/** Identifies recordings and their format version. */
+	static const char MAGIC[8];
+
+	static void writeNumber(uint64_t value, std::string& buffer);
+	static void writeString(const std::wstring& value, std::string& buffer);
+	static bool readNumber(const char*& position, const char* end, uint64_t* value);
+	static bool readString(const char*& position, const char* end, std::wstring* value);
+};
@@ -0,0 +1,119 @@
+#include "PerfMap.h"
+#include "platform/Platform.h"
+
+PerfMap::PerfMap() {
+	// started explicitly
+}
+
+PerfMap::~PerfMap() {
+	shutdown();
+}
+
+std::string PerfMap::getPath() {
+	return "/tmp/perf-" + std::to_string(Platform::getProcessId()) + ".map";
+}
+
+bool PerfMap::start(ICorProfilerInfo2* profilerInfo, FunctionNameResolver resolver) {
+	this->profilerInfo = profilerInfo;
+	this->resolver = resolver;
+
+	// The runtime's own perf map support appends to the same file
+	if (!file.open(getPath(), File::APPEND_SHARED)) {
+		return false;
+	}
+	if (!writerThread.start(runWriterThread, this)) {
+		file.close();
+		return false;
+	}
+	return true;
+}
+
+void PerfMap::runWriterThread(void* parameter) {
+	PerfMap* map = static_cast<PerfMap*>(parameter);
+	while (!map->stopEvent.wait(FLUSH_INTERVAL)) {
+		map->flush();
+	}
+}
+
+void PerfMap::recordJitCompilation(FunctionID functionId) {
+	ModuleID moduleId = 0;
+	mdToken functionToken = 0;
+	if (FAILED(profilerInfo->GetFunctionInfo2(functionId, 0, NULL, &moduleId, &functionToken, 0, NULL, NULL))) {
+		return;
+	}
+
+	// hot and cold code of the same function are separate ranges
+	COR_PRF_CODE_INFO codeInfos[MAX_CODE_RANGES];
+	ULONG32 codeInfoCount = 0;
+	if (FAILED(profilerInfo->GetCodeInfo2(functionId, MAX_CODE_RANGES, &codeInfoCount, codeInfos)) || codeInfoCount == 0) {
+		return;
+	}
+
+	std::string name = getName(functionId, moduleId, functionToken);
+	std::string lines;
+	for (ULONG32 i = 0; i < codeInfoCount && i < MAX_CODE_RANGES; i++) {
+		char range[64];
+		snprintf(range, sizeof(range), "%llx %llx ", static_cast<unsigned long long>(codeInfos[i].startAddress),
+			static_cast<unsigned long long>(codeInfos[i].size));
+		// perf splits lines at \n only
+		lines += range + name + (i > 0 ? " [cold]\n" : "\n");
+	}
+
+	bufferSynchronization.lock();
+	buffer += lines;
+	entryCount += codeInfoCount < MAX_CODE_RANGES ? codeInfoCount : MAX_CODE_RANGES;
+	bufferSynchronization.unlock();
+}
+
+std::string PerfMap::getName(FunctionID functionId, ModuleID moduleId, mdToken functionToken) {
+	std::pair<ModuleID, mdToken> method = std::make_pair(moduleId, functionToken);
+	bufferSynchronization.lock();
+	std::map<std::pair<ModuleID, mdToken>, std::string>::iterator knownName = names.find(method);
+	if (knownName != names.end()) {
+		std::string name = knownName->second;
+		bufferSynchronization.unlock();
+		return name;
+	}
+	bufferSynchronization.unlock();
+
+	// Resolving outside the lock may resolve a name twice if two instantiations are jitted at once, which is harmless
+	std::string name = resolver(functionId);
+	bufferSynchronization.lock();
+	names[method] = name;
+	bufferSynchronization.unlock();
+	return name;
+}
+
+void PerfMap::flush() {
+	std::string lines;
+	bufferSynchronization.lock();
+	lines.swap(buffer);
+	bufferSynchronization.unlock();
+
+	if (lines.empty() || !file.isOpen()) {
+		return;
+	}
+	file.write(lines.data(), lines.size());
+}
+
+size_t PerfMap::getEntryCount() {
+	bufferSynchronization.lock();
+	size_t count = entryCount;
+	bufferSynchronization.unlock();
+	return count;
+}
+
+void PerfMap::shutdown() {
+	if (!writerThread.isStarted()) {
+		return;
+	}
+
+	stopEvent.set();
+	if (!writerThread.join(SHUTDOWN_TIMEOUT)) {
+		// the thread is stuck writing, e.g. because we are called from DllMain. Leave it behind
+		return;
+	}
+
+	flush();
+	file.close();
+}
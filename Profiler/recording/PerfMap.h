@@ -0,0 +1,85 @@
+#pragma once
+#include <cor.h>
+#include <corprof.h>
+#include <functional>
+#include <map>
+#include <string>
+#include "platform/Event.h"
+#include "platform/File.h"
+#include "platform/Mutex.h"
+#include "platform/Thread.h"
+
+/** Returns the name of the given function. */
+typedef std::function<std::string(FunctionID functionId)> FunctionNameResolver;
+
+/**
+ * Writes the native code ranges of jitted methods to /tmp/perf-<pid>.map, so perf can symbolize managed frames.
+ *
+ * Each line is "<start> <size> <name>" with hexadecimal start address and size. Callers only append to a buffer, a
+ * background thread writes it to the file, so the JIT does not wait for the disk. Names are resolved once per method
+ * and reused for its generic instantiations.
+ *
+ * All methods are thread-safe.
+ */
+class PerfMap
+{
+public:
+	PerfMap();
+	virtual ~PerfMap();
+
+	/** Creates the map file and starts the writer thread. Returns false if that fails. */
+	bool start(ICorProfilerInfo2* profilerInfo, FunctionNameResolver resolver);
+
+	/** Whether the map is written. */
+	bool isStarted() {
+		return writerThread.isStarted();
+	}
+
+	/** Appends the code ranges of the given function, which has just been jitted. */
+	void recordJitCompilation(FunctionID functionId);
+
+	/** Returns the number of code ranges written to the map. */
+	size_t getEntryCount();
+
+	/** Returns the path of the map file of this process. */
+	static std::string getPath();
+
+	/** Stops the writer thread, writes the remaining entries and closes the file. */
+	void shutdown();
+
+private:
+	/** Milliseconds between two writes of the buffer. */
+	static const DWORD FLUSH_INTERVAL = 100;
+
+	/** Milliseconds to wait for the writer thread at shutdown. */
+	static const DWORD SHUTDOWN_TIMEOUT = 1000;
+
+	/** Maximum number of code ranges per function, i.e. hot and cold code. */
+	static const ULONG32 MAX_CODE_RANGES = 4;
+
+	/** Guards the buffer, the names and the entry count. Never held while writing to the file. */
+	Mutex bufferSynchronization;
+
+	ICorProfilerInfo2* profilerInfo = NULL;
+	FunctionNameResolver resolver;
+	File file;
+	Thread writerThread;
+	Event stopEvent;
+
+	/** Lines that have not been written to the file yet. */
+	std::string buffer;
+
+	/** The names of the methods that were already jitted. */
+	std::map<std::pair<ModuleID, mdToken>, std::string> names;
+
+	size_t entryCount = 0;
+
+	/** Entry point of the writer thread. */
+	static void runWriterThread(void* parameter);
+
+	/** Writes the buffered lines to the file. Only called by the writer thread or after it has stopped. */
+	void flush();
+
+	/** Returns the cached name of the given method or resolves it. */
+	std::string getName(FunctionID functionId, ModuleID moduleId, mdToken functionToken);
+};
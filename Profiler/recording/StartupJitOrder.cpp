@@ -0,0 +1,142 @@
+#include "StartupJitOrder.h"
+#include "platform/Platform.h"
+#include "utils/StringUtils.h"
+
+StartupJitOrder::~StartupJitOrder() {
+	// Nothing to do here, destructing is handled in FileLogBase
+}
+
+std::string StartupJitOrder::getMarkerEventName() {
+	return "Local\\TeamscaleProfilerStartup_" + std::to_string(Platform::getProcessId());
+}
+
+void StartupJitOrder::start(std::string targetDir, unsigned long spoolTimeoutMillis, ICorProfilerInfo2* profilerInfo, DWORD maxSeconds) {
+	this->profilerInfo = profilerInfo;
+	this->maxSeconds = maxSeconds;
+	startMicroseconds = Platform::getMonotonicMicroseconds();
+
+	FileLogBase::createLogFile(targetDir, "startup_jit_order_" + getFormattedCurrentTime() + ".txt", true, spoolTimeoutMillis);
+
+	criticalSection.lock();
+	buffer = "# Startup JIT order of " + Platform::getProcessPath() + "\r\n";
+	buffer += "# microseconds\tthread\tmodule MVID\tmodule name\tmethod token\r\n";
+	recording = 1;
+	criticalSection.unlock();
+
+	// A missing event only means that recording stops after the timeout
+	hasMarkerEvent = markerEvent.openNamed(getMarkerEventName());
+	timerThread.start(runTimerThread, this);
+}
+
+void StartupJitOrder::runTimerThread(void* parameter) {
+	StartupJitOrder* order = static_cast<StartupJitOrder*>(parameter);
+	Event* events[] = { &order->stopEvent, &order->markerEvent };
+	int eventCount = order->hasMarkerEvent ? 2 : 1;
+	int result = Event::waitForAny(events, eventCount, order->maxSeconds * 1000);
+	if (result == 1) {
+		order->stop("marker event");
+	}
+	else if (result == Event::TIMED_OUT) {
+		order->stop("timeout");
+	}
+}
+
+void StartupJitOrder::recordJitCompilation(FunctionID functionId) {
+	if (!recording) {
+		return;
+	}
+
+	uint64_t microseconds = Platform::getMonotonicMicroseconds() - startMicroseconds;
+	ModuleID moduleId = 0;
+	mdToken functionToken = 0;
+	if (FAILED(profilerInfo->GetFunctionInfo2(functionId, 0, NULL, &moduleId, &functionToken, 0, NULL, NULL))) {
+		return;
+	}
+
+	criticalSection.lock();
+	if (recording) {
+		writeSkippedCompilations();
+	}
+	// generic instantiations of a method are only listed once
+	if (recording && recordedMethods.insert(std::make_pair(moduleId, functionToken)).second) {
+		char line[BUFFER_SIZE];
+		snprintf(line, sizeof(line), "%llu\t%lu\t%s\t0x%08lx\r\n", static_cast<unsigned long long>(microseconds),
+			Platform::getThreadId(), getModuleIdentity(moduleId).c_str(), static_cast<unsigned long>(functionToken));
+		buffer += line;
+		if (buffer.size() >= FLUSH_THRESHOLD) {
+			writeToFile(buffer.data(), buffer.size());
+			buffer.clear();
+		}
+	}
+	criticalSection.unlock();
+}
+
+void StartupJitOrder::recordSkippedCompilation() {
+	if (!recording) {
+		return;
+	}
+
+	criticalSection.lock();
+	if (recording && skippedCompilations++ == 0) {
+		uint64_t microseconds = Platform::getMonotonicMicroseconds() - startMicroseconds;
+		buffer += "# " + std::to_string(microseconds) + "\tdiagnostics suspended by the overhead governor\r\n";
+	}
+	criticalSection.unlock();
+}
+
+void StartupJitOrder::writeSkippedCompilations() {
+	if (skippedCompilations == 0) {
+		return;
+	}
+	uint64_t microseconds = Platform::getMonotonicMicroseconds() - startMicroseconds;
+	buffer += "# " + std::to_string(microseconds) + "\tdiagnostics resumed, " + std::to_string(skippedCompilations) +
+		" compilations not recorded\r\n";
+	skippedCompilations = 0;
+}
+
+std::string& StartupJitOrder::getModuleIdentity(ModuleID moduleId) {
+	std::map<ModuleID, std::string>::iterator knownModule = moduleIdentities.find(moduleId);
+	if (knownModule != moduleIdentities.end()) {
+		return knownModule->second;
+	}
+
+	std::string& identity = moduleIdentities[moduleId];
+	identity = "unknown\tunknown";
+	IMetaDataImport* metaDataImport = NULL;
+	HRESULT hr = profilerInfo->GetModuleMetaData(moduleId, ofRead, IID_IMetaDataImport, (IUnknown**)&metaDataImport);
+	if (FAILED(hr) || metaDataImport == NULL) {
+		return identity;
+	}
+
+	WCHAR moduleName[BUFFER_SIZE];
+	GUID mvid;
+	hr = metaDataImport->GetScopeProps(moduleName, BUFFER_SIZE, NULL, &mvid);
+	metaDataImport->Release();
+	if (SUCCEEDED(hr)) {
+		identity = StringUtils::formatGuid(mvid) + "\t" + StringUtils::narrow(moduleName);
+	}
+	return identity;
+}
+
+void StartupJitOrder::stop(const char* reason) {
+	criticalSection.lock();
+	if (recording) {
+		recording = 0;
+		writeSkippedCompilations();
+		buffer += "# stopped by " + std::string(reason) + " after " + std::to_string(recordedMethods.size()) + " methods\r\n";
+		writeToFile(buffer.data(), buffer.size());
+		buffer.clear();
+	}
+	criticalSection.unlock();
+}
+
+void StartupJitOrder::shutdown() {
+	if (timerThread.isStarted()) {
+		stopEvent.set();
+		// the timer thread is left behind if it does not stop in time
+		timerThread.join(SHUTDOWN_TIMEOUT);
+	}
+	stop("shutdown");
+
+	FileLogBase::shutdown();
+}
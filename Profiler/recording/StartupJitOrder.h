@@ -0,0 +1,98 @@
+#pragma once
+#include "log/FileLogBase.h"
+#include "platform/Event.h"
+#include "platform/Thread.h"
+#include <cor.h>
+#include <corprof.h>
+#include <map>
+#include <set>
+#include <string>
+
+/**
+ * Records the order in which methods are jitted during startup to startup_jit_order_<timestamp>.txt in the target
+ * directory, e.g. to select the methods to precompile with crossgen or to seed a multicore JIT profile.
+ *
+ * Each method is listed once, at its first compilation, with the microseconds since the profiler was initialized,
+ * the compiling thread, the MVID and name of its module and its token, separated by tabs. Recording stops after
+ * the configured number of seconds or when the application signals the marker event, whichever comes first. The
+ * marker event only exists on Windows.
+ *
+ * All methods are thread-safe.
+ */
+class StartupJitOrder : public FileLogBase
+{
+public:
+	virtual ~StartupJitOrder() noexcept;
+
+	/**
+	 * Creates the file and starts recording until the marker event is signaled or the given number of seconds has
+	 * passed. Must be the first method called on this object. Not thread-safe.
+	 */
+	void start(std::string targetDir, unsigned long spoolTimeoutMillis, ICorProfilerInfo2* profilerInfo, DWORD maxSeconds);
+
+	/** Whether compilations are still recorded. */
+	bool isRecording() {
+		return recording != 0;
+	}
+
+	/** Records the compilation of the given function unless it was already compiled before. */
+	void recordJitCompilation(FunctionID functionId);
+
+	/**
+	 * Records that a compilation was not recorded because the overhead governor suspended diagnostics. The file
+	 * marks where compilations are missing and how many.
+	 */
+	void recordSkippedCompilation();
+
+	/** Returns the name of the event that ends the recording, Local\TeamscaleProfilerStartup_<pid>. */
+	static std::string getMarkerEventName();
+
+	/** Stops recording and closes the file. */
+	void shutdown();
+
+private:
+	/** Number of buffered bytes after which the buffer is written to the file. */
+	static const size_t FLUSH_THRESHOLD = 64 * 1024;
+
+	/** Milliseconds to wait for the timer thread at shutdown. */
+	static const DWORD SHUTDOWN_TIMEOUT = 1000;
+
+	/** 1 while compilations are recorded. */
+	volatile LONG recording = 0;
+
+	/** Used to look up the modules and tokens of functions. */
+	ICorProfilerInfo2* profilerInfo = NULL;
+
+	/** Monotonic clock at the start of the recording in microseconds. */
+	uint64_t startMicroseconds = 0;
+
+	DWORD maxSeconds = 0;
+	bool hasMarkerEvent = false;
+	Event markerEvent;
+	Event stopEvent;
+	Thread timerThread;
+
+	/** Lines that have not been written to the file yet. Guarded by the critical section of the base class. */
+	std::string buffer;
+
+	/** Number of compilations skipped since the last recorded one. Guarded by the critical section of the base class. */
+	size_t skippedCompilations = 0;
+
+	/** The methods that were already recorded. Guarded by the critical section of the base class. */
+	std::set<std::pair<ModuleID, mdToken>> recordedMethods;
+
+	/** The MVID and name of each module, separated by a tab. Guarded by the critical section of the base class. */
+	std::map<ModuleID, std::string> moduleIdentities;
+
+	/** Entry point of the thread that ends the recording. */
+	static void runTimerThread(void* parameter);
+
+	/** Marks the end of skipped compilations in the buffer. Must be called from synchronized context. */
+	void writeSkippedCompilations();
+
+	/** Stops recording and writes the remaining lines with the given reason. */
+	void stop(const char* reason);
+
+	/** Returns the MVID and name of the given module. Must be called from synchronized context. */
+	std::string& getModuleIdentity(ModuleID moduleId);
+};
@@ -0,0 +1,81 @@
+#include "CodeAddressIndex.h"
+
+CodeAddressIndex::CodeAddressIndex(size_t maxRanges) : maxRanges(maxRanges) {
+	slots = new PageSlot[SLOT_COUNT]();
+	// left uninitialized so untouched ranges need no physical memory
+	ranges = new Range[maxRanges];
+}
+
+CodeAddressIndex::~CodeAddressIndex() {
+	delete[] slots;
+	delete[] ranges;
+}
+
+bool CodeAddressIndex::add(UINT_PTR start, SIZE_T size, FunctionID functionId) {
+	if (size == 0) {
+		return true;
+	}
+
+	UINT_PTR end = start + size;
+	for (UINT_PTR page = start >> PAGE_SHIFT; page <= (end - 1) >> PAGE_SHIFT; page++) {
+		LONG index = InterlockedIncrement(&usedRanges) - 1;
+		if (static_cast<size_t>(index) >= maxRanges) {
+			return false;
+		}
+		PageSlot* slot = findSlot(page + 1, true);
+		if (slot == NULL) {
+			return false;
+		}
+
+		Range* range = &ranges[index];
+		range->start = start;
+		range->end = end;
+		range->functionId = functionId;
+		Range* head;
+		do {
+			head = slot->ranges;
+			range->next = head;
+		} while (InterlockedCompareExchangePointer(reinterpret_cast<PVOID volatile*>(&slot->ranges), range, head) != head);
+	}
+	return true;
+}
+
+FunctionID CodeAddressIndex::find(UINT_PTR address) {
+	PageSlot* slot = findSlot((address >> PAGE_SHIFT) + 1, false);
+	if (slot == NULL) {
+		return 0;
+	}
+
+	for (Range* range = slot->ranges; range != NULL; range = range->next) {
+		if (address >= range->start && address < range->end) {
+			return range->functionId;
+		}
+	}
+	return 0;
+}
+
+CodeAddressIndex::PageSlot* CodeAddressIndex::findSlot(UINT_PTR key, bool create) {
+	// Fibonacci hashing spreads the consecutive pages of the code heap
+	size_t hash = static_cast<size_t>((static_cast<unsigned __int64>(key) * 0x9E3779B97F4A7C15ull) >> 32);
+	for (size_t probe = 0; probe < SLOT_COUNT; probe++) {
+		PageSlot* slot = &slots[(hash + probe) & (SLOT_COUNT - 1)];
+		UINT_PTR slotKey = slot->key;
+		if (slotKey == key) {
+			return slot;
+		}
+		if (slotKey != 0) {
+			continue;
+		}
+		if (!create) {
+			return NULL;
+		}
+
+		slotKey = reinterpret_cast<UINT_PTR>(InterlockedCompareExchangePointer(reinterpret_cast<PVOID volatile*>(&slot->key),
+			reinterpret_cast<PVOID>(key), NULL));
+		if (slotKey == 0 || slotKey == key) {
+			// claimed by us or by a thread that added the same page concurrently
+			return slot;
+		}
+	}
+	return NULL;
+}
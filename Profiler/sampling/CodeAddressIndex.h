@@ -0,0 +1,58 @@
+#pragma once
+#include <Windows.h>
+#include <cor.h>
+#include <corprof.h>
+#include "utils/Testing.h"
+
+/**
+ * Maps native code addresses to the jitted functions that contain them.
+ *
+ * The index is a hash table keyed by code page. Each slot holds a list of the code ranges that overlap its page.
+ * Adding and finding ranges is lock-free and never allocates, so the index can be read while other threads are
+ * suspended, even if they hold the heap lock. Ranges and slots are allocated once, which bounds the memory of the
+ * index. Ranges are never removed, since the profiler does not track unloaded code.
+ */
+class CodeAddressIndex
+{
+public:
+	/** Default maximum number of ranges. A range that spans several pages needs one range per page. */
+	static const size_t DEFAULT_MAX_RANGES = 128 * 1024;
+
+	CodeAddressIndex(size_t maxRanges = DEFAULT_MAX_RANGES);
+	virtual ~CodeAddressIndex();
+
+	/** Adds the code range of the given function. Returns false if the index is full. */
+	bool EXPOSE_TO_CPP_TESTS add(UINT_PTR start, SIZE_T size, FunctionID functionId);
+
+	/** Returns the function whose code contains the given address or 0 if there is none. */
+	FunctionID EXPOSE_TO_CPP_TESTS find(UINT_PTR address);
+
+private:
+	/** Addresses are indexed by pages of 4 KB. */
+	static const int PAGE_SHIFT = 12;
+
+	/** Number of hash slots, which limits the number of indexed pages. Must be a power of two. */
+	static const size_t SLOT_COUNT = 64 * 1024;
+
+	/** A code range in the list of a page. */
+	struct Range {
+		UINT_PTR start;
+		UINT_PTR end;
+		FunctionID functionId;
+		Range* volatile next;
+	};
+
+	/** A hash slot. Its key is the page number plus 1, so 0 marks an empty slot. */
+	struct PageSlot {
+		volatile UINT_PTR key;
+		Range* volatile ranges;
+	};
+
+	PageSlot* slots;
+	Range* ranges;
+	size_t maxRanges;
+	volatile LONG usedRanges = 0;
+
+	/** Returns the slot of the given key or NULL if it does not exist and should not be created. */
+	PageSlot* findSlot(UINT_PTR key, bool create);
+};
@@ -0,0 +1,250 @@
+#include "StackSampler.h"
+
+/** Milliseconds to wait for the sampling thread at shutdown. */
+static const DWORD SHUTDOWN_TIMEOUT = 1000;
+
+StackSampler::StackSampler() {
+	InitializeCriticalSection(&threadSynchronization);
+	InitializeCriticalSection(&stackSynchronization);
+}
+
+StackSampler::~StackSampler() {
+	shutdown();
+	if (samplingThread == NULL) {
+		DeleteCriticalSection(&threadSynchronization);
+		DeleteCriticalSection(&stackSynchronization);
+	}
+}
+
+bool StackSampler::start(ICorProfilerInfo2* profilerInfo, DWORD interval) {
+	this->profilerInfo = profilerInfo;
+	this->interval = interval;
+
+	stopEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	if (stopEvent == NULL) {
+		return false;
+	}
+	samplingThread = CreateThread(NULL, 0, runSamplingThread, this, 0, NULL);
+	return samplingThread != NULL;
+}
+
+DWORD WINAPI StackSampler::runSamplingThread(LPVOID parameter) {
+	StackSampler* sampler = static_cast<StackSampler*>(parameter);
+	while (WaitForSingleObject(sampler->stopEvent, sampler->interval) == WAIT_TIMEOUT) {
+		sampler->sampleAllThreads();
+	}
+	return 0;
+}
+
+void StackSampler::shutdown() {
+	if (samplingThread == NULL) {
+		return;
+	}
+
+	SetEvent(stopEvent);
+	if (WaitForSingleObject(samplingThread, SHUTDOWN_TIMEOUT) != WAIT_OBJECT_0) {
+		// e.g. because we are called from DllMain. Leave the thread behind
+		return;
+	}
+	CloseHandle(samplingThread);
+	samplingThread = NULL;
+	CloseHandle(stopEvent);
+	stopEvent = NULL;
+}
+
+void StackSampler::registerCode(FunctionID functionId) {
+	COR_PRF_CODE_INFO codeInfos[4];
+	ULONG32 codeInfoCount = 0;
+	HRESULT hr = profilerInfo->GetCodeInfo2(functionId, 4, &codeInfoCount, codeInfos);
+	if (FAILED(hr)) {
+		return;
+	}
+
+	// hot and cold code of the same function are separate ranges
+	for (ULONG32 i = 0; i < codeInfoCount && i < 4; i++) {
+		codeIndex.add(codeInfos[i].startAddress, codeInfos[i].size, functionId);
+	}
+}
+
+void StackSampler::addThread(ThreadID threadId) {
+	EnterCriticalSection(&threadSynchronization);
+	threads.insert(threadId);
+	LeaveCriticalSection(&threadSynchronization);
+}
+
+void StackSampler::removeThread(ThreadID threadId) {
+	EnterCriticalSection(&threadSynchronization);
+	threads.erase(threadId);
+	LeaveCriticalSection(&threadSynchronization);
+}
+
+void StackSampler::sampleAllThreads() {
+	EnterCriticalSection(&threadSynchronization);
+	for (ThreadID threadId : threads) {
+		sampleThread(threadId);
+	}
+	LeaveCriticalSection(&threadSynchronization);
+}
+
+void StackSampler::sampleThread(ThreadID threadId) {
+	DWORD osThreadId = 0;
+	HRESULT hr = profilerInfo->GetThreadInfo(threadId, &osThreadId);
+	if (FAILED(hr) || osThreadId == 0 || osThreadId == GetCurrentThreadId()) {
+		return;
+	}
+
+	HANDLE thread = OpenThread(THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT | THREAD_QUERY_INFORMATION, FALSE, osThreadId);
+	if (thread == NULL) {
+		return;
+	}
+	if (SuspendThread(thread) == static_cast<DWORD>(-1)) {
+		CloseHandle(thread);
+		return;
+	}
+
+	// Nothing may be allocated until the thread is resumed
+	sampleDepth = 0;
+	hr = E_FAIL;
+	CONTEXT context;
+	context.ContextFlags = CONTEXT_FULL;
+	if (GetThreadContext(thread, &context)) {
+#ifdef _WIN64
+		UINT_PTR instructionPointer = context.Rip;
+#else
+		UINT_PTR instructionPointer = context.Eip;
+#endif
+		// Without a seed, the walk of a thread in jitted code starts at the last transition frame
+		bool isInJittedCode = codeIndex.find(instructionPointer) != 0;
+		hr = profilerInfo->DoStackSnapshot(threadId, recordFrame, COR_PRF_SNAPSHOT_DEFAULT, this,
+			isInJittedCode ? reinterpret_cast<BYTE*>(&context) : NULL, isInJittedCode ? sizeof(context) : 0);
+	}
+	ResumeThread(thread);
+	CloseHandle(thread);
+
+	if (SUCCEEDED(hr) && sampleDepth > 0) {
+		addStack(sampleFrames, sampleDepth);
+	}
+	else if (FAILED(hr)) {
+		EnterCriticalSection(&stackSynchronization);
+		droppedSampleCount++;
+		LeaveCriticalSection(&stackSynchronization);
+	}
+}
+
+HRESULT StackSampler::recordFrame(FunctionID functionId, UINT_PTR ip, COR_PRF_FRAME_INFO frameInfo,
+	ULONG32 contextSize, BYTE context[], void* clientData) {
+	StackSampler* sampler = static_cast<StackSampler*>(clientData);
+	if (functionId == 0) {
+		// native frames are only reported with an ID if the runtime knows the code
+		functionId = sampler->codeIndex.find(ip);
+	}
+	if (functionId != 0) {
+		sampler->sampleFrames[sampler->sampleDepth++] = functionId;
+	}
+	return sampler->sampleDepth < MAX_STACK_DEPTH ? S_OK : S_FALSE;
+}
+
+bool StackSampler::addStack(const FunctionID* frames, size_t depth) {
+	ULONG64 hash = 14695981039346656037ull;
+	for (size_t i = 0; i < depth; i++) {
+		hash = (hash ^ frames[i]) * 1099511628211ull;
+	}
+
+	bool isCounted = false;
+	EnterCriticalSection(&stackSynchronization);
+	if (stacks.empty()) {
+		// twice the capacity keeps the probe sequences short
+		stacks.resize(2 * MAX_STACKS);
+	}
+
+	size_t mask = stacks.size() - 1;
+	for (size_t probe = 0; probe < stacks.size(); probe++) {
+		StackEntry& entry = stacks[(hash + probe) & mask];
+		if (entry.count == 0) {
+			if (stackCount < MAX_STACKS && stackFrames.size() + depth <= MAX_FRAMES) {
+				entry.hash = hash;
+				entry.firstFrame = stackFrames.size();
+				entry.depth = depth;
+				entry.count = 1;
+				stackFrames.insert(stackFrames.end(), frames, frames + depth);
+				stackCount++;
+				isCounted = true;
+			}
+			break;
+		}
+		if (entry.hash == hash && isSameStack(entry, frames, depth)) {
+			entry.count++;
+			isCounted = true;
+			break;
+		}
+	}
+
+	if (isCounted) {
+		sampleCount++;
+	}
+	else {
+		droppedSampleCount++;
+	}
+	LeaveCriticalSection(&stackSynchronization);
+	return isCounted;
+}
+
+bool StackSampler::isSameStack(const StackEntry& entry, const FunctionID* frames, size_t depth) {
+	if (entry.depth != depth) {
+		return false;
+	}
+	for (size_t i = 0; i < depth; i++) {
+		if (stackFrames[entry.firstFrame + i] != frames[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void StackSampler::collapseStacks(FunctionNameResolver resolver, std::vector<std::string>& lines) {
+	EnterCriticalSection(&stackSynchronization);
+	// Resolving a name is expensive and most functions occur in many stacks
+	std::unordered_map<FunctionID, std::string> names;
+	for (StackEntry& entry : stacks) {
+		if (entry.count == 0) {
+			continue;
+		}
+		for (size_t i = 0; i < entry.depth; i++) {
+			FunctionID functionId = stackFrames[entry.firstFrame + i];
+			if (names.find(functionId) == names.end()) {
+				names[functionId] = resolver(functionId);
+			}
+		}
+	}
+
+	for (StackEntry& entry : stacks) {
+		if (entry.count == 0) {
+			continue;
+		}
+
+		std::string line;
+		for (size_t i = entry.depth; i > 0; i--) {
+			if (i < entry.depth) {
+				line += ";";
+			}
+			line += names[stackFrames[entry.firstFrame + i - 1]];
+		}
+		line += " " + std::to_string(entry.count);
+		lines.push_back(line);
+	}
+	LeaveCriticalSection(&stackSynchronization);
+}
+
+size_t StackSampler::getSampleCount() {
+	EnterCriticalSection(&stackSynchronization);
+	size_t count = sampleCount;
+	LeaveCriticalSection(&stackSynchronization);
+	return count;
+}
+
+size_t StackSampler::getDroppedSampleCount() {
+	EnterCriticalSection(&stackSynchronization);
+	size_t count = droppedSampleCount;
+	LeaveCriticalSection(&stackSynchronization);
+	return count;
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <Windows.h>
+#include <cor.h>
+#include <corprof.h>
+#include <atlbase.h>
+#include <functional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "CodeAddressIndex.h"
+#include "utils/Testing.h"
+
+/** Returns a frame name for the given function, which must not contain ';' or spaces. */
+typedef std::function<std::string(FunctionID functionId)> FunctionNameResolver;
+
+/**
+ * Statistical CPU profiler that samples the stacks of all managed threads.
+ *
+ * A background thread wakes up every interval, suspends each managed thread in turn and walks its stack with
+ * DoStackSnapshot. If the thread was suspended in jitted code, which the code address index tells without
+ * allocating, its context seeds the walk so the topmost frames are not skipped. Nothing is allocated while a
+ * thread is suspended, since it might hold the heap lock.
+ *
+ * Distinct stacks are counted in a hash table of fixed capacity. Samples of new stacks are dropped once it is full,
+ * which bounds the memory of the sampler.
+ */
+class StackSampler
+{
+public:
+	/** Maximum number of frames recorded per sample. Deeper stacks are truncated at the root. */
+	static const size_t MAX_STACK_DEPTH = 128;
+
+	/** Maximum number of distinct stacks. */
+	static const size_t MAX_STACKS = 32 * 1024;
+
+	/** Maximum number of frames of all distinct stacks together. */
+	static const size_t MAX_FRAMES = 1024 * 1024;
+
+	StackSampler();
+	virtual ~StackSampler();
+
+	/** Starts sampling every given number of milliseconds. Returns false if that fails. */
+	bool start(ICorProfilerInfo2* profilerInfo, DWORD interval);
+
+	/** Whether sampling was started. */
+	bool isStarted() {
+		return samplingThread != NULL;
+	}
+
+	/** Adds the native code of a jitted function to the code address index. */
+	void registerCode(FunctionID functionId);
+
+	/** Includes a managed thread in the samples. */
+	void addThread(ThreadID threadId);
+
+	/** Excludes a managed thread from the samples. Waits for a sample in progress. */
+	void removeThread(ThreadID threadId);
+
+	/** Stops sampling. */
+	void shutdown();
+
+	/** Counts one sample of the given stack, leaf first. Returns false if the sample was dropped. */
+	bool EXPOSE_TO_CPP_TESTS addStack(const FunctionID* frames, size_t depth);
+
+	/**
+	 * Appends one line per distinct stack in the collapsed format of flame graph tools:
+	 * the frames from the root to the leaf separated by ';', a space and the number of samples.
+	 * Resolves the name of each distinct function only once.
+	 */
+	void EXPOSE_TO_CPP_TESTS collapseStacks(FunctionNameResolver resolver, std::vector<std::string>& lines);
+
+	/** Returns the number of samples that were counted. */
+	size_t getSampleCount();
+
+	/** Returns the number of samples that could not be taken or counted. */
+	size_t getDroppedSampleCount();
+
+private:
+	/** A distinct stack in the hash table. */
+	struct StackEntry {
+		ULONG64 hash;
+		size_t firstFrame;
+		size_t depth;
+		size_t count;
+	};
+
+	CComPtr<ICorProfilerInfo2> profilerInfo;
+	DWORD interval = 0;
+	HANDLE samplingThread = NULL;
+	HANDLE stopEvent = NULL;
+
+	/** Finds the functions of instruction pointers in jitted code. */
+	CodeAddressIndex codeIndex;
+
+	/** Guards the set of threads. Held while sampling, so threads are not destroyed while they are walked. */
+	CRITICAL_SECTION threadSynchronization;
+	std::set<ThreadID> threads;
+
+	/** Guards the stack table. */
+	CRITICAL_SECTION stackSynchronization;
+	std::vector<StackEntry> stacks;
+	std::vector<FunctionID> stackFrames;
+	size_t stackCount = 0;
+	size_t sampleCount = 0;
+	size_t droppedSampleCount = 0;
+
+	/** The frames of the sample in progress. Only used by the sampling thread. */
+	FunctionID sampleFrames[MAX_STACK_DEPTH];
+	size_t sampleDepth = 0;
+
+	/** Entry point of the sampling thread. */
+	static DWORD WINAPI runSamplingThread(LPVOID parameter);
+
+	/** Takes one sample of each managed thread. */
+	void sampleAllThreads();
+
+	/** Walks the stack of the given thread and counts it. */
+	void sampleThread(ThreadID threadId);
+
+	/** Stack snapshot callback that records one frame. */
+	static HRESULT __stdcall recordFrame(FunctionID functionId, UINT_PTR ip, COR_PRF_FRAME_INFO frameInfo,
+		ULONG32 contextSize, BYTE context[], void* clientData);
+
+	/** Whether the given stack entry holds the given frames. Must be called from synchronized context. */
+	bool isSameStack(const StackEntry& entry, const FunctionID* frames, size_t depth);
+};
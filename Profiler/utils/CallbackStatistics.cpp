@@ -0,0 +1,145 @@
+#include "CallbackStatistics.h"
+#include <atomic>
+#include <stdio.h>
+
+/** The callback names used in the report, indexed by CallbackType. */
+static const char* CALLBACK_NAMES[CALLBACK_TYPE_COUNT] = {
+	"AssemblyLoadFinished",
+	"JITCompilationFinished",
+	"JITInlining",
+};
+
+thread_local CallbackStatistics::ThreadCounters* CallbackStatistics::currentThreadCounters = NULL;
+thread_local unsigned long CallbackStatistics::currentThreadOwnerId = 0;
+
+/** The last ID given to statistics. 0 is never used, so new threads always register. */
+static std::atomic<unsigned long> lastOwnerId(0);
+
+CallbackStatistics::CallbackStatistics() {
+	ownerId = ++lastOwnerId;
+	startCycles = now();
+	startMicroseconds = Platform::getMonotonicMicroseconds();
+}
+
+CallbackStatistics::~CallbackStatistics() {
+	for (ThreadCounters* threadCounters : threads) {
+		delete threadCounters;
+	}
+}
+
+void CallbackStatistics::recordCall(CallbackType type, unsigned __int64 callStartCycles, unsigned __int64 lockWaitCycles) {
+	unsigned __int64 cycles = now() - callStartCycles;
+	ThreadCounters* threadCounters = currentThreadCounters;
+	if (currentThreadOwnerId != ownerId) {
+		threadCounters = registerThread();
+	}
+
+	// only this thread writes its counters, so plain increments suffice
+	CallbackCounters& callbackCounters = threadCounters->counters[type];
+	callbackCounters.calls++;
+	callbackCounters.cycles += static_cast<LONG64>(cycles);
+	callbackCounters.lockWaitCycles += static_cast<LONG64>(lockWaitCycles);
+
+	unsigned int bucket = 0;
+	if (cycles > 1) {
+		bucket = Platform::getHighestSetBit(cycles);
+	}
+	callbackCounters.histogram[bucket]++;
+}
+
+CallbackStatistics::ThreadCounters* CallbackStatistics::registerThread() {
+	ThreadCounters* threadCounters = new ThreadCounters();
+
+	threadsSection.lock();
+	threads.push_back(threadCounters);
+	threadsSection.unlock();
+
+	currentThreadCounters = threadCounters;
+	currentThreadOwnerId = ownerId;
+	return threadCounters;
+}
+
+void CallbackStatistics::recordFlush(unsigned __int64 cycles, size_t functionCount) {
+	InterlockedIncrement64(&flushes);
+	InterlockedExchangeAdd64(&flushCycles, static_cast<LONG64>(cycles));
+	InterlockedExchangeAdd64(&flushedFunctions, static_cast<LONG64>(functionCount));
+}
+
+void CallbackStatistics::recordPendingSizes(size_t jittedCount, size_t inlinedCount) {
+	if (jittedCount > peakPendingJitted) {
+		peakPendingJitted = jittedCount;
+	}
+	if (inlinedCount > peakPendingInlined) {
+		peakPendingInlined = inlinedCount;
+	}
+}
+
+unsigned __int64 CallbackStatistics::getPercentile(CallbackCounters& callbackCounters, double percentile) {
+	LONG64 threshold = static_cast<LONG64>(callbackCounters.calls * percentile / 100.0);
+	LONG64 seen = 0;
+	for (int bucket = 0; bucket < HISTOGRAM_BUCKETS - 1; bucket++) {
+		seen += callbackCounters.histogram[bucket];
+		if (seen > threshold) {
+			return 2ull << bucket;
+		}
+	}
+	return ~0ull;
+}
+
+double CallbackStatistics::getCyclesPerMillisecond() {
+	double elapsedMillis = (Platform::getMonotonicMicroseconds() - startMicroseconds) / 1000.0;
+	if (elapsedMillis <= 0) {
+		return 1;
+	}
+	return (now() - startCycles) / elapsedMillis;
+}
+
+std::vector<std::string> CallbackStatistics::createReport() {
+	double elapsedMillis = (Platform::getMonotonicMicroseconds() - startMicroseconds) / 1000.0;
+	double cyclesPerMilli = getCyclesPerMillisecond();
+
+	std::vector<std::string> report;
+	char line[512];
+	LONG64 totalCycles = flushCycles;
+
+	CallbackCounters counters[CALLBACK_TYPE_COUNT];
+	threadsSection.lock();
+	for (ThreadCounters* threadCounters : threads) {
+		for (int type = 0; type < CALLBACK_TYPE_COUNT; type++) {
+			CallbackCounters& sum = counters[type];
+			CallbackCounters& callbackCounters = threadCounters->counters[type];
+			sum.calls += callbackCounters.calls;
+			sum.cycles += callbackCounters.cycles;
+			sum.lockWaitCycles += callbackCounters.lockWaitCycles;
+			for (int bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++) {
+				sum.histogram[bucket] += callbackCounters.histogram[bucket];
+			}
+		}
+	}
+	threadsSection.unlock();
+
+	for (int type = 0; type < CALLBACK_TYPE_COUNT; type++) {
+		CallbackCounters& callbackCounters = counters[type];
+		totalCycles += callbackCounters.cycles;
+		snprintf(line, sizeof(line), "Overhead %s: %lld calls, %.1f ms total, %.1f ms lock wait, p50 < %.0f ns, p99 < %.0f ns",
+			CALLBACK_NAMES[type], static_cast<long long>(callbackCounters.calls), callbackCounters.cycles / cyclesPerMilli,
+			callbackCounters.lockWaitCycles / cyclesPerMilli,
+			getPercentile(callbackCounters, 50) * 1e6 / cyclesPerMilli,
+			getPercentile(callbackCounters, 99) * 1e6 / cyclesPerMilli);
+		report.push_back(line);
+	}
+
+	snprintf(line, sizeof(line), "Overhead flushes: %lld flushes of %lld methods, %.1f ms total",
+		static_cast<long long>(flushes), static_cast<long long>(flushedFunctions), flushCycles / cyclesPerMilli);
+	report.push_back(line);
+
+	snprintf(line, sizeof(line), "Overhead peak pending methods: %zu jitted, %zu inlined", peakPendingJitted, peakPendingInlined);
+	report.push_back(line);
+
+	// flushes during callbacks are counted twice, which is acceptable for an upper bound
+	snprintf(line, sizeof(line), "Overhead total: %.1f ms in profiler callbacks and flushes during %.1f ms of process runtime",
+		totalCycles / cyclesPerMilli, elapsedMillis);
+	report.push_back(line);
+
+	return report;
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <cor.h>
+#include <string>
+#include <vector>
+#include "platform/Mutex.h"
+#include "platform/Platform.h"
+
+/** The profiler callbacks whose overhead is measured. */
+enum CallbackType {
+	CALLBACK_ASSEMBLY_LOAD,
+	CALLBACK_JIT_COMPILATION,
+	CALLBACK_JIT_INLINING,
+	CALLBACK_TYPE_COUNT
+};
+
+/**
+ * Measures the overhead the profiler adds to the profiled process: call counts, time spent in each callback type
+ * as a latency histogram, time spent waiting for the callback lock, time spent flushing to the trace file and the
+ * peak number of pending function infos.
+ *
+ * Time is measured in CPU cycles (rdtsc), which is cheap enough to do on every call. Each thread records its calls
+ * in its own counters, so recording needs neither locks nor atomic instructions and threads do not contend for the
+ * same cache lines. The counters of all threads are summed up when the report is created. The cycle counter is
+ * calibrated against the monotonic clock at that point, too.
+ */
+class CallbackStatistics
+{
+public:
+	CallbackStatistics();
+	virtual ~CallbackStatistics();
+
+	/** Returns the current value of the cycle counter. */
+	static inline unsigned __int64 now() {
+		return Platform::readCycleCounter();
+	}
+
+	/** Records a finished call of the given type that started at the given cycle count. */
+	void recordCall(CallbackType type, unsigned __int64 startCycles, unsigned __int64 lockWaitCycles);
+
+	/** Records a flush of function infos to the trace file. */
+	void recordFlush(unsigned __int64 cycles, size_t functionCount);
+
+	/** Records the current sizes of the pending function info lists. Must be called from synchronized context. */
+	void recordPendingSizes(size_t jittedCount, size_t inlinedCount);
+
+	/** Returns the cycles per millisecond, calibrated over the runtime of the process so far. */
+	double getCyclesPerMillisecond();
+
+	/** Returns the human-readable overhead report, one line per entry. */
+	std::vector<std::string> createReport();
+
+private:
+	/** Number of buckets of the latency histograms. Bucket i counts calls that took less than 2^(i+1) cycles. */
+	static const int HISTOGRAM_BUCKETS = 64;
+
+	/** Measured values for a single callback type. */
+	struct CallbackCounters {
+		volatile LONG64 calls = 0;
+		volatile LONG64 cycles = 0;
+		volatile LONG64 lockWaitCycles = 0;
+		volatile LONG64 histogram[HISTOGRAM_BUCKETS] = {};
+	};
+
+	/** The counters of one thread, which are only written by that thread. */
+	struct ThreadCounters {
+		CallbackCounters counters[CALLBACK_TYPE_COUNT];
+
+		/** Keeps the counters of other threads off the cache line of the last counter. */
+		char padding[64];
+	};
+
+	/** The counters of the current thread and the ID of the statistics they belong to. */
+	static thread_local ThreadCounters* currentThreadCounters;
+	static thread_local unsigned long currentThreadOwnerId;
+
+	/** Unique ID of these statistics, so a thread never uses counters of statistics that were already destroyed. */
+	unsigned long ownerId;
+
+	/** Guards the list of threads. Only taken when a thread records its first call. */
+	Mutex threadsSection;
+
+	std::vector<ThreadCounters*> threads;
+
+	volatile LONG64 flushes = 0;
+	volatile LONG64 flushCycles = 0;
+	volatile LONG64 flushedFunctions = 0;
+
+	size_t peakPendingJitted = 0;
+	size_t peakPendingInlined = 0;
+
+	/** Cycle counter and monotonic clock at startup for calibration. */
+	unsigned __int64 startCycles;
+	uint64_t startMicroseconds;
+
+	/** Creates the counters of the current thread. */
+	ThreadCounters* registerThread();
+
+	/** Returns the number of cycles below which the given percentile (0-100) of calls of the given type finished. */
+	unsigned __int64 getPercentile(CallbackCounters& callbackCounters, double percentile);
+};
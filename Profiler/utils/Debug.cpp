@@ -1,16 +1,22 @@
 #include "Debug.h"
-#include "StackWalker.h"
+#include "platform/Platform.h"
+#include <stdio.h>
 #include <string>
-#include <processthreadsapi.h>
+
+#ifdef _WIN32
+#include "StackWalker.h"
 
 class CustomStackWalker : public StackWalker {
 public:
 	std::string output;
 	void OnOutput(LPCSTR szText) {
 		output += szText;
-		output += "\r\n";
 	}
 };
+#else
+#include <execinfo.h>
+#include <stdlib.h>
+#endif
 
 /**
  * Implements a thread-safe singleton pattern and ensures that the instance
@@ -23,38 +29,97 @@ Debug& Debug::getInstance() {
 }
 
 Debug::Debug() {
-	InitializeCriticalSection(&loggingSynchronization);
-	DWORD pid = GetCurrentProcessId();
-	std::string logFilePath = "C:\\Users\\Public\\profiler_debug." + std::to_string(pid) + ".log";
-	logFile = CreateFile(logFilePath.c_str(), GENERIC_WRITE, FILE_SHARE_READ,
-		NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	startMicroseconds = Platform::getMonotonicMicroseconds();
 }
 
 void Debug::log(std::string message)
 {
-	if (logFile == INVALID_HANDLE_VALUE) {
-		return;
-	}
+	loggingSynchronization.lock();
+	write(message + "\r\n");
+	loggingSynchronization.unlock();
+}
 
-	message += "\r\n";
+void Debug::recordEvent(const std::string& message) {
+	flightRecorder.recordEvent(message.c_str());
+}
 
-	EnterCriticalSection(&loggingSynchronization);
-	DWORD dwWritten = 0;
-	WriteFile(logFile, message.c_str(), static_cast<DWORD>(strlen(message.c_str())), &dwWritten, NULL);
-	LeaveCriticalSection(&loggingSynchronization);
+void Debug::recordError(const std::string& context) {
+	flightRecorder.recordError(("Error in " + context).c_str());
 }
 
-void Debug::logErrorWithStracktrace(std::string context) {
-	log("Error in " + context + ". Stacktrace: ");
+/** Formats the given entries one per line, each error followed by its symbolized stack. */
+static std::string formatEntries(const std::vector<FlightRecorder::Entry>& entries, uint64_t startMicroseconds) {
+	std::string output;
+#ifdef _WIN32
+	// loads the symbols of all modules on first use, so only once per dump
 	CustomStackWalker stackWalker;
-	stackWalker.ShowCallstack();
-	log(stackWalker.output);
+#endif
+	for (const FlightRecorder::Entry& entry : entries) {
+		char header[64];
+		snprintf(header, sizeof(header), "%.3f ms thread %lu: ", (entry.microseconds - startMicroseconds) / 1000.0, entry.threadId);
+		output += header;
+		output += entry.message;
+		output += "\r\n";
+
+#ifdef _WIN32
+		for (int i = 0; i < entry.frameCount; i++) {
+			char address[32];
+			snprintf(address, sizeof(address), " (%p)\r\n", entry.frames[i]);
+			stackWalker.output = "    at ";
+			if (!stackWalker.ShowObject(entry.frames[i])) {
+				stackWalker.output += "?";
+			}
+			output += stackWalker.output + address;
+		}
+#else
+		char** symbols = backtrace_symbols(entry.frames, entry.frameCount);
+		for (int i = 0; symbols != NULL && i < entry.frameCount; i++) {
+			output += std::string("    at ") + symbols[i] + "\r\n";
+		}
+		free(symbols);
+#endif
+	}
+	return output;
+}
+
+void Debug::dump() {
+	if (flightRecorder.getErrorCount() == 0) {
+		return;
+	}
+
+	loggingSynchronization.lock();
+	std::vector<FlightRecorder::Entry> entries = flightRecorder.getEntriesAfter(lastDumpedSequence);
+	if (!entries.empty()) {
+		uint64_t firstSequence = entries.front().sequence;
+		uint64_t lastSequence = entries.back().sequence;
+		std::string output;
+		if (firstSequence > lastDumpedSequence + 1) {
+			output += "Flight recorder: " + std::to_string(firstSequence - lastDumpedSequence - 1) + " entries were overwritten before they could be written\r\n";
+		}
+		output += formatEntries(entries, startMicroseconds);
+		write(output);
+		lastDumpedSequence = lastSequence;
+	}
+	loggingSynchronization.unlock();
+}
+
+void Debug::write(const std::string& message) {
+	if (!isLogFileOpened) {
+		isLogFileOpened = true;
+#ifdef _WIN32
+		std::string logDirectory = "C:\\Users\\Public\\";
+#else
+		std::string logDirectory = Platform::getTempDirectory();
+#endif
+		std::string logFilePath = logDirectory + "profiler_debug." + std::to_string(Platform::getProcessId()) + ".log";
+		logFile.open(logFilePath, File::OVERWRITE);
+	}
+	if (logFile.isOpen()) {
+		logFile.write(message.c_str(), message.size());
+	}
 }
 
 Debug::~Debug()
 {
-	if (logFile != INVALID_HANDLE_VALUE) {
-		CloseHandle(logFile);
-	}
-	DeleteCriticalSection(&loggingSynchronization);
+	// the file closes itself
 }
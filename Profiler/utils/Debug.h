@@ -1,10 +1,15 @@
 #pragma once
-#include <atlbase.h>
 #include <string>
+#include "platform/File.h"
+#include "platform/Mutex.h"
+#include "utils/FlightRecorder.h"
 
 /**
- * Helper for debugging. Logs messages to C:\Users\Public\profiler_debug.PID.log where
- * PID is the ID of the profiled process.
+ * Helper for debugging. Logs messages to C:\Users\Public\profiler_debug.PID.log (on Linux to the temp directory)
+ * where PID is the ID of the profiled process. The file is only created once there is something to write.
+ *
+ * Errors and notable events are kept in a flight recorder in memory and only written, with symbolized stacks, by
+ * dump(), so errors on hot paths do not stall the profiled process.
  * This class implements the singleton pattern so we are able to log from every class of the profiler.
  */
 class Debug
@@ -14,8 +19,22 @@ public:
 	/** Logs the given message to the debug log. */
 	void log(std::string message);
 
-	/** Logs the given context and the current stacktrace to the debug log. */
-	void logErrorWithStracktrace(std::string context);
+	/** Records a notable event in the flight recorder, so it shows up in the context of later errors. */
+	void recordEvent(const std::string& message);
+
+	/** Records an error in the given context together with the raw stack in the flight recorder. */
+	void recordError(const std::string& context);
+
+	/**
+	 * Writes the flight recorder entries that were not written yet to the debug log if it contains any errors.
+	 * Symbolizes the stacks, which is slow, so call this only when the profiler fails or shuts down.
+	 */
+	void dump();
+
+	/** The number of errors recorded so far. */
+	uint64_t getErrorCount() const {
+		return flightRecorder.getErrorCount();
+	}
 
 	static Debug& getInstance();
 
@@ -23,6 +42,20 @@ private:
 	Debug();
 	virtual ~Debug();
 
-	HANDLE logFile = INVALID_HANDLE_VALUE;
-	CRITICAL_SECTION loggingSynchronization;
+	File logFile;
+	Mutex loggingSynchronization;
+
+	/** Whether opening the log file was attempted, so a failure is not retried on every message. */
+	bool isLogFileOpened = false;
+
+	FlightRecorder flightRecorder;
+
+	/** Monotonic time of the creation, to which the entries' times are relative. */
+	uint64_t startMicroseconds;
+
+	/** The sequence of the last entry written by dump(). Entries up to it are not written again. */
+	uint64_t lastDumpedSequence = 0;
+
+	/** Writes the given message to the log file, which is opened if necessary. Must be called from synchronized context. */
+	void write(const std::string& message);
 };
@@ -0,0 +1,53 @@
+#include "FlightRecorder.h"
+#include <cstring>
+
+void FlightRecorder::recordEvent(const char* message) {
+	record(message, false);
+}
+
+void FlightRecorder::recordError(const char* message) {
+	errorCount.fetch_add(1, std::memory_order_relaxed);
+	record(message, true);
+}
+
+void FlightRecorder::record(const char* message, bool isError) {
+	uint64_t sequence = nextSequence.fetch_add(1, std::memory_order_relaxed) + 1;
+	Slot& slot = slots[sequence % CAPACITY];
+
+	// readers skip the slot until it is published again
+	slot.publishedSequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	Entry& entry = slot.entry;
+	entry.sequence = sequence;
+	entry.microseconds = Platform::getMonotonicMicroseconds();
+	entry.threadId = Platform::getThreadId();
+	entry.isError = isError;
+	strncpy(entry.message, message, MESSAGE_LENGTH - 1);
+	entry.message[MESSAGE_LENGTH - 1] = '\0';
+	entry.frameCount = isError ? Platform::captureStackTrace(entry.frames, MAX_FRAMES) : 0;
+
+	slot.publishedSequence.store(sequence, std::memory_order_release);
+}
+
+std::vector<FlightRecorder::Entry> FlightRecorder::getEntriesAfter(uint64_t sequence) const {
+	std::vector<Entry> entries;
+	uint64_t last = nextSequence.load(std::memory_order_acquire);
+	uint64_t first = last > CAPACITY ? last - CAPACITY + 1 : 1;
+	if (first <= sequence) {
+		first = sequence + 1;
+	}
+	for (uint64_t current = first; current <= last; current++) {
+		const Slot& slot = slots[current % CAPACITY];
+		if (slot.publishedSequence.load(std::memory_order_acquire) != current) {
+			// still being written or already overwritten
+			continue;
+		}
+		Entry copy = slot.entry;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.publishedSequence.load(std::memory_order_relaxed) == current && copy.sequence == current) {
+			entries.push_back(copy);
+		}
+	}
+	return entries;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "platform/Platform.h"
+#include "utils/Testing.h"
+
+/**
+ * Keeps the most recent profiler events and errors in memory, with the raw return addresses of the stack for errors.
+ *
+ * Recording is lock-free, does not allocate and does not touch the file system, so even a storm of errors inside
+ * JIT callbacks does not stall the profiled application. The stacks are only symbolized when the entries are
+ * written, e.g. by Debug when the profiler fails or shuts down.
+ *
+ * The buffer holds the last CAPACITY entries. An entry that is overwritten while it is copied is skipped, as is the
+ * slot of a writer that was interrupted while other threads recorded CAPACITY more entries.
+ */
+class FlightRecorder
+{
+public:
+	/** Number of entries kept. */
+	static const size_t CAPACITY = 256;
+
+	/** Maximum number of characters of a message that are kept. */
+	static const size_t MESSAGE_LENGTH = 96;
+
+	/** Maximum number of return addresses kept per error. */
+	static const int MAX_FRAMES = 32;
+
+	/** A recorded event or error. */
+	struct Entry {
+		/** Increases by one for each recorded entry, starting at 1. */
+		uint64_t sequence = 0;
+		uint64_t microseconds = 0;
+		unsigned long threadId = 0;
+		bool isError = false;
+		char message[MESSAGE_LENGTH] = {};
+		int frameCount = 0;
+		void* frames[MAX_FRAMES] = {};
+	};
+
+	/** Records an event. Thread-safe and lock-free. */
+	void EXPOSE_TO_CPP_TESTS recordEvent(const char* message);
+
+	/** Records an error together with the stack of the calling thread. Thread-safe and lock-free. */
+	void EXPOSE_TO_CPP_TESTS recordError(const char* message);
+
+	/** Returns the entries with a sequence greater than the given one that are still in the buffer, oldest first. Thread-safe. */
+	std::vector<Entry> EXPOSE_TO_CPP_TESTS getEntriesAfter(uint64_t sequence) const;
+
+	/** The number of entries recorded so far, including overwritten ones. */
+	uint64_t getEntryCount() const {
+		return nextSequence.load(std::memory_order_relaxed);
+	}
+
+	/** The number of errors recorded so far, including overwritten ones. */
+	uint64_t getErrorCount() const {
+		return errorCount.load(std::memory_order_relaxed);
+	}
+
+private:
+	/** An entry and its sequence, which is 0 while the entry is written. */
+	struct Slot {
+		std::atomic<uint64_t> publishedSequence{ 0 };
+		Entry entry;
+	};
+
+	Slot slots[CAPACITY];
+	std::atomic<uint64_t> nextSequence{ 0 };
+	std::atomic<uint64_t> errorCount{ 0 };
+
+	void record(const char* message, bool isError);
+};
@@ -0,0 +1,96 @@
+#include "JitCosts.h"
+#include <algorithm>
+#include <stdio.h>
+
+thread_local std::vector<JitCosts::Compilation> JitCosts::compilations;
+
+JitCosts::JitCosts() {
+	// the mutex initializes itself
+}
+
+JitCosts::~JitCosts() {
+	// nothing to release
+}
+
+void JitCosts::enable(size_t topMethodCount) {
+	this->topMethodCount = topMethodCount;
+	topMethods.reserve(topMethodCount);
+}
+
+void JitCosts::recordStart(FunctionID functionId, unsigned __int64 cycles) {
+	compilations.push_back({ functionId, cycles });
+}
+
+bool JitCosts::isStarted(FunctionID functionId) {
+	for (const Compilation& compilation : compilations) {
+		if (compilation.functionId == functionId) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void JitCosts::recordFinish(FunctionID functionId, unsigned __int64 cycles, int assemblyNumber, mdToken functionToken,
+	size_t nativeSize) {
+	// compilations nest if the JIT needs to run a class constructor
+	for (size_t i = compilations.size(); i > 0; i--) {
+		if (compilations[i - 1].functionId == functionId) {
+			unsigned __int64 startCycles = compilations[i - 1].startCycles;
+			compilations.erase(compilations.begin() + (i - 1));
+			recordMethod(assemblyNumber, functionToken, cycles - startCycles, nativeSize);
+			return;
+		}
+	}
+}
+
+void JitCosts::recordMethod(int assemblyNumber, mdToken functionToken, unsigned __int64 cycles, size_t nativeSize) {
+	synchronization.lock();
+	AssemblyCosts& assembly = assemblies[assemblyNumber];
+	assembly.methods++;
+	assembly.cycles += cycles;
+	assembly.nativeSize += nativeSize;
+
+	MethodCosts method = { assemblyNumber, functionToken, cycles, nativeSize };
+	if (topMethods.size() < topMethodCount) {
+		topMethods.push_back(method);
+		std::push_heap(topMethods.begin(), topMethods.end());
+	}
+	else if (!topMethods.empty() && cycles > topMethods.front().cycles) {
+		std::pop_heap(topMethods.begin(), topMethods.end());
+		topMethods.back() = method;
+		std::push_heap(topMethods.begin(), topMethods.end());
+	}
+	synchronization.unlock();
+}
+
+void JitCosts::createAssemblyReport(double cyclesPerMillisecond, std::vector<std::string>& lines) {
+	synchronization.lock();
+	std::vector<std::pair<int, AssemblyCosts>> sortedAssemblies(assemblies.begin(), assemblies.end());
+	synchronization.unlock();
+
+	std::sort(sortedAssemblies.begin(), sortedAssemblies.end(),
+		[](const std::pair<int, AssemblyCosts>& first, const std::pair<int, AssemblyCosts>& second) {
+			return first.second.cycles > second.second.cycles;
+		});
+	char line[128];
+	for (std::pair<int, AssemblyCosts>& assembly : sortedAssemblies) {
+		snprintf(line, sizeof(line), "%i:%zu:%.0f:%zu", assembly.first, assembly.second.methods,
+			assembly.second.cycles * 1000 / cyclesPerMillisecond, assembly.second.nativeSize);
+		lines.push_back(line);
+	}
+}
+
+void JitCosts::createMethodReport(double cyclesPerMillisecond, std::vector<std::string>& lines) {
+	synchronization.lock();
+	std::vector<MethodCosts> sortedMethods = topMethods;
+	synchronization.unlock();
+
+	// ascending in the inverted order of the heap is most expensive first
+	std::sort(sortedMethods.begin(), sortedMethods.end());
+	char line[128];
+	for (MethodCosts& method : sortedMethods) {
+		snprintf(line, sizeof(line), "%i:%lu:%.0f:%zu", method.assemblyNumber, static_cast<unsigned long>(method.functionToken),
+			method.cycles * 1000 / cyclesPerMillisecond, method.nativeSize);
+		lines.push_back(line);
+	}
+}
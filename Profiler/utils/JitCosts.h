@@ -0,0 +1,96 @@
+#pragma once
+#include <cor.h>
+#include <corprof.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "platform/Mutex.h"
+#include "utils/Testing.h"
+
+/**
+ * Measures how long the JIT takes for each method and how much native code it produces.
+ *
+ * The costs are summed up per assembly. Only the most expensive methods are kept individually in a min-heap of
+ * fixed size, so memory does not grow with the number of jitted methods.
+ *
+ * All methods are thread-safe.
+ */
+class JitCosts
+{
+public:
+	JitCosts();
+	virtual ~JitCosts();
+
+	/** Enables the measurement and keeps the given number of most expensive methods. */
+	void EXPOSE_TO_CPP_TESTS enable(size_t topMethodCount);
+
+	/** Whether the measurement is enabled. */
+	bool isEnabled() {
+		return topMethodCount > 0;
+	}
+
+	/** Marks the start of the compilation of the given function on the current thread. */
+	void recordStart(FunctionID functionId, unsigned __int64 cycles);
+
+	/**
+	 * Whether the start of the compilation of the given function was recorded on the current thread and its end was
+	 * not. recordFinish() must be called in that case, so the compilation does not stay in the list of this thread.
+	 */
+	bool EXPOSE_TO_CPP_TESTS isStarted(FunctionID functionId);
+
+	/**
+	 * Records the end of the compilation of the given function on the current thread. Ignored if its start was not
+	 * recorded, e.g. because the profiler attached during the compilation.
+	 */
+	void recordFinish(FunctionID functionId, unsigned __int64 cycles, int assemblyNumber, mdToken functionToken,
+		size_t nativeSize);
+
+	/** Records a compiled method. */
+	void EXPOSE_TO_CPP_TESTS recordMethod(int assemblyNumber, mdToken functionToken, unsigned __int64 cycles, size_t nativeSize);
+
+	/**
+	 * Appends the costs per assembly as <assemblyNumber>:<methods>:<microseconds>:<native bytes>, most expensive first.
+	 */
+	void EXPOSE_TO_CPP_TESTS createAssemblyReport(double cyclesPerMillisecond, std::vector<std::string>& lines);
+
+	/**
+	 * Appends the most expensive methods as <assemblyNumber>:<functionToken>:<microseconds>:<native bytes>,
+	 * most expensive first.
+	 */
+	void EXPOSE_TO_CPP_TESTS createMethodReport(double cyclesPerMillisecond, std::vector<std::string>& lines);
+
+private:
+	/** The summed up costs of an assembly. */
+	struct AssemblyCosts {
+		size_t methods = 0;
+		unsigned __int64 cycles = 0;
+		size_t nativeSize = 0;
+	};
+
+	/** The costs of a single method. */
+	struct MethodCosts {
+		int assemblyNumber;
+		mdToken functionToken;
+		unsigned __int64 cycles;
+		size_t nativeSize;
+
+		/** Orders the heap so the cheapest method is on top. */
+		bool operator<(const MethodCosts& other) const {
+			return cycles > other.cycles;
+		}
+	};
+
+	/** A compilation in progress on the current thread. */
+	struct Compilation {
+		FunctionID functionId;
+		unsigned __int64 startCycles;
+	};
+
+	/** The compilations in progress on the current thread, innermost last. */
+	static thread_local std::vector<Compilation> compilations;
+
+	Mutex synchronization;
+	size_t topMethodCount = 0;
+	std::map<int, AssemblyCosts> assemblies;
+	std::vector<MethodCosts> topMethods;
+};
@@ -0,0 +1,63 @@
+#include "OverheadGovernor.h"
+#include <stdio.h>
+
+/** The level names used in the trace file, indexed by Level. */
+static const char* LEVEL_NAMES[OverheadGovernor::LEVEL_COUNT] = {
+	"full recording",
+	"inlined methods not recorded",
+	"eager writes deferred",
+	"diagnostics suspended",
+};
+
+void OverheadGovernor::enable(size_t budgetPercent) {
+	this->budgetPercent = budgetPercent;
+}
+
+bool OverheadGovernor::recordCallback(uint64_t cycles, bool isJitCompilation, uint64_t nowCycles, uint64_t nowMicroseconds) {
+	if (windowStartMicroseconds == 0) {
+		windowStartCycles = nowCycles - cycles;
+		windowStartMicroseconds = nowMicroseconds;
+	}
+	windowCycles += cycles;
+	if (isJitCompilation) {
+		windowJitCompilations++;
+	}
+
+	uint64_t elapsedMicroseconds = nowMicroseconds - windowStartMicroseconds;
+	if (elapsedMicroseconds < WINDOW_MICROSECONDS || nowCycles <= windowStartCycles) {
+		return false;
+	}
+
+	// callbacks on several threads can add up to more than 100%
+	lastOverheadPercent = windowCycles * 100.0 / (nowCycles - windowStartCycles);
+	lastJitRate = windowJitCompilations * 1e6 / elapsedMicroseconds;
+	windowStartCycles = nowCycles;
+	windowStartMicroseconds = nowMicroseconds;
+	windowCycles = 0;
+	windowJitCompilations = 0;
+
+	int newLevel = level;
+	if (lastOverheadPercent > budgetPercent && newLevel < LEVEL_COUNT - 1) {
+		newLevel++;
+	}
+	else if (lastOverheadPercent < budgetPercent / 2.0 && newLevel > LEVEL_FULL) {
+		newLevel--;
+	}
+	if (newLevel == level) {
+		return false;
+	}
+
+	level = newLevel;
+	levelChangeCount++;
+	if (newLevel > highestLevel) {
+		highestLevel = static_cast<Level>(newLevel);
+	}
+	return true;
+}
+
+std::string OverheadGovernor::describe() const {
+	char description[256];
+	snprintf(description, sizeof(description), "level %d (%s), %.1f%% overhead at %.0f JIT compilations/s with a budget of %zu%%",
+		static_cast<int>(level), LEVEL_NAMES[level], lastOverheadPercent, lastJitRate, budgetPercent);
+	return description;
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "utils/Testing.h"
+
+/**
+ * Keeps the overhead of the profiler within a budget by degrading step by step under load and recovering once the
+ * load is gone.
+ *
+ * Every second, the governor compares the time spent in profiler callbacks, including waiting for the callback lock
+ * and flushes during callbacks, to the elapsed time. If the budget is exceeded, it goes to the next level, which
+ * gives up one more part of the recording. Once the overhead is below half of the budget, it goes back one level.
+ * The JIT rate of each second is reported along with the levels, since the overhead mostly follows it.
+ *
+ * Recording calls must be synchronized. The level may be read from any thread.
+ */
+class OverheadGovernor
+{
+public:
+	/** The steps of degradation. Each level includes all lower ones. */
+	enum Level {
+		/** Everything is recorded. */
+		LEVEL_FULL,
+
+		/** Inlined methods are not recorded, which saves a lookup under the callback lock for every inlining. */
+		LEVEL_NO_INLINING,
+
+		/** Eager writes happen after more methods, so the trace file is written less often. */
+		LEVEL_DEFERRED_FLUSH,
+
+		/** JIT costs and the startup JIT order are not measured. */
+		LEVEL_NO_DIAGNOSTICS,
+
+		LEVEL_COUNT
+	};
+
+	/** Factor by which eager writes are deferred from LEVEL_DEFERRED_FLUSH on. */
+	static const size_t DEFERRED_FLUSH_FACTOR = 16;
+
+	/** Enables the governor with the given budget in percent of the elapsed time. */
+	void EXPOSE_TO_CPP_TESTS enable(size_t budgetPercent);
+
+	/** Whether the governor is enabled. */
+	bool isEnabled() const {
+		return budgetPercent > 0;
+	}
+
+	/**
+	 * Records a callback that took the given number of cycles and ended at the given time. Returns true if the level
+	 * changed, so it can be logged with describe(). Must be called from synchronized context.
+	 */
+	bool EXPOSE_TO_CPP_TESTS recordCallback(uint64_t cycles, bool isJitCompilation, uint64_t nowCycles, uint64_t nowMicroseconds);
+
+	/** The current level. */
+	Level getLevel() const {
+		return static_cast<Level>(level);
+	}
+
+	/** Whether inlined methods are recorded. */
+	bool shouldRecordInlining() const {
+		return level < LEVEL_NO_INLINING;
+	}
+
+	/** The factor by which the configured eagerness is multiplied. */
+	size_t getFlushFactor() const {
+		return level < LEVEL_DEFERRED_FLUSH ? 1 : DEFERRED_FLUSH_FACTOR;
+	}
+
+	/** Whether optional diagnostics like JIT costs are measured. */
+	bool shouldRecordDiagnostics() const {
+		return level < LEVEL_NO_DIAGNOSTICS;
+	}
+
+	/** The highest level so far. */
+	Level getHighestLevel() const {
+		return highestLevel;
+	}
+
+	/** The number of level changes so far. */
+	size_t getLevelChangeCount() const {
+		return levelChangeCount;
+	}
+
+	/** Describes the current level and the measurements of the last second, e.g. to log a level change. */
+	std::string EXPOSE_TO_CPP_TESTS describe() const;
+
+private:
+	/** Length of a measurement window. */
+	static const uint64_t WINDOW_MICROSECONDS = 1000000;
+
+	size_t budgetPercent = 0;
+
+	/** The current Level. Written under the callback lock, read without it. */
+	volatile int level = LEVEL_FULL;
+
+	Level highestLevel = LEVEL_FULL;
+	size_t levelChangeCount = 0;
+
+	/** The start of the current window. Zero until the first callback. */
+	uint64_t windowStartCycles = 0;
+	uint64_t windowStartMicroseconds = 0;
+
+	uint64_t windowCycles = 0;
+	size_t windowJitCompilations = 0;
+
+	/** Measurements of the last finished window. */
+	double lastOverheadPercent = 0;
+	double lastJitRate = 0;
+};
@@ -1,5 +1,34 @@
 #include "StringUtils.h"
+#include <cor.h>
+#include <stdio.h>
+
+#ifdef _WIN32
 #include <Shlwapi.h>
+#endif
+
+/** Appends the UTF-8 encoding of the given code point. */
+static void appendUtf8(uint32_t codePoint, std::string& result) {
+	if (codePoint < 0x80) {
+		result += static_cast<char>(codePoint);
+	}
+	else if (codePoint < 0x800) {
+		result += static_cast<char>(0xC0 | (codePoint >> 6));
+		result += static_cast<char>(0x80 | (codePoint & 0x3F));
+	}
+	else if (codePoint < 0x10000) {
+		result += static_cast<char>(0xE0 | (codePoint >> 12));
+		result += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+		result += static_cast<char>(0x80 | (codePoint & 0x3F));
+	}
+	else {
+		result += static_cast<char>(0xF0 | (codePoint >> 18));
+		result += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+		result += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+		result += static_cast<char>(0x80 | (codePoint & 0x3F));
+	}
+}
+
+#ifdef _WIN32
 
 std::string StringUtils::removeLastPartOfPath(std::string path) {
 	char* chars = _strdup(path.c_str());
@@ -17,6 +46,56 @@ std::string StringUtils::getLastPartOfPath(std::string path) {
 	return result;
 }
 
+std::string StringUtils::narrow(const wchar_t* value) {
+	int length = snprintf(NULL, 0, "%S", value);
+	if (length <= 0) {
+		return "";
+	}
+	std::string result(length, '\0');
+	snprintf(&result[0], length + 1, "%S", value);
+	return result;
+}
+
+#else
+
+std::string StringUtils::removeLastPartOfPath(std::string path) {
+	size_t separator = path.find_last_of('/');
+	if (separator == std::string::npos) {
+		return "";
+	}
+	if (separator == 0) {
+		return "/";
+	}
+	return path.substr(0, separator);
+}
+
+std::string StringUtils::getLastPartOfPath(std::string path) {
+	return path.substr(path.find_last_of('/') + 1);
+}
+
+std::string StringUtils::narrow(const wchar_t* value) {
+	std::string result;
+	for (; *value != 0; value++) {
+		appendUtf8(static_cast<uint32_t>(*value), result);
+	}
+	return result;
+}
+
+#endif
+
+std::string StringUtils::narrow(const char16_t* value) {
+	std::string result;
+	for (; *value != 0; value++) {
+		uint32_t codePoint = *value;
+		if (codePoint >= 0xD800 && codePoint < 0xDC00 && value[1] >= 0xDC00 && value[1] < 0xE000) {
+			value++;
+			codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (*value - 0xDC00);
+		}
+		appendUtf8(codePoint, result);
+	}
+	return result;
+}
+
 std::string StringUtils::uppercase(std::string const & value)
 {
 	std::string result(value);
@@ -43,4 +122,13 @@ bool StringUtils::endsWithCaseInsensitive(std::string const & value, std::string
 		}
 	}
 	return true;
+}
+
+std::string StringUtils::formatGuid(const GUID& guid)
+{
+	char formattedGuid[37];
+	snprintf(formattedGuid, sizeof(formattedGuid), "%08lx-%04hx-%04hx-%02x%02x-%02x%02x%02x%02x%02x%02x",
+		static_cast<unsigned long>(guid.Data1), guid.Data2, guid.Data3, guid.Data4[0], guid.Data4[1], guid.Data4[2],
+		guid.Data4[3], guid.Data4[4], guid.Data4[5], guid.Data4[6], guid.Data4[7]);
+	return formattedGuid;
 }
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include <map>
 #include "Testing.h"
 
+struct _GUID;
+
 /** Utility functions for strings. */
 class StringUtils {
 public:
@@ -22,7 +24,16 @@ public:
 	static EXPOSE_TO_CPP_TESTS bool equalsIgnoreCase(std::string const & value1, std::string const & value2);
 
 	/** Returns a new string that is the uppercase variant of the given string. */
-	static EXPOSE_TO_CPP_TESTS std::string StringUtils::uppercase(std::string const & value);
+	static EXPOSE_TO_CPP_TESTS std::string uppercase(std::string const & value);
+
+	/** Converts the given wide string to a narrow one the way the "%S" format specifier does on Windows. */
+	static EXPOSE_TO_CPP_TESTS std::string narrow(const wchar_t* value);
+
+	/** Converts the given UTF-16 string, i.e. a WCHAR string on Linux, to UTF-8. */
+	static EXPOSE_TO_CPP_TESTS std::string narrow(const char16_t* value);
+
+	/** Formats the given GUID in the usual lowercase 8-4-4-4-12 form, e.g. for MVIDs. */
+	static std::string formatGuid(const _GUID& guid);
 
 	/** Compares strings regardless of their casing. */
 	struct CaseInsensitiveComparator {
@@ -5,4 +5,8 @@
  * The unit tests link against the profiler Dll so we must explicitly export any
  * functions we wish to call from the unit test code.
  */
-#define EXPOSE_TO_CPP_TESTS __declspec(dllexport)
\ No newline at end of file
+#ifdef _WIN32
+#define EXPOSE_TO_CPP_TESTS __declspec(dllexport)
+#else
+#define EXPOSE_TO_CPP_TESTS __attribute__((visibility("default")))
+#endif
\ No newline at end of file
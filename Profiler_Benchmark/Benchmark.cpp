@@ -0,0 +1,428 @@
+#include "CProfilerCallback.h"
+#include "FakeProfilerInfo.h"
+#include "LatencyHistogram.h"
+#include "ReplayProfilerInfo.h"
+#include "platform/Platform.h"
+#include <psapi.h>
+#include <intrin.h>
+#include <atomic>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <thread>
+#include <vector>
+#include <string>
+#include <cstdio>
+
+#pragma comment(lib, "psapi.lib")
+
+/**
+ * Drives the profiler callbacks against a FakeProfilerInfo from several threads and reports
+ * throughput, latency percentiles and memory usage of the profiler's hot paths.
+ *
+ * Usage: Profiler_Benchmark.exe [--threads=N] [--methods=N] [--inlinings=N] [--assemblies=N] [--generic | --compare [--rounds=N]]
+ *        Profiler_Benchmark.exe --replay=<events_*.bin> [--parallel] [--generic]
+ *
+ * The second form replays a callback recording (see the record_events option) instead of a synthetic workload.
+ * Events are replayed in recorded order on a single thread, or with --parallel on one thread per recorded thread.
+ * In the latter case, all assembly loads are replayed first, so no JIT event sees its assembly still unloaded.
+ *
+ * With --generic, the JIT callbacks check the configuration on every call instead of using the implementation
+ * specialized for it at Initialize. --compare runs the synthetic workload with both for several rounds and prints the
+ * speedup. The order alternates between rounds, so neither variant always runs on a warmed-up process.
+ *
+ * The profiler is configured via the usual COR_PROFILER_* environment variables, e.g. to
+ * benchmark eager mode. Trace files are written to %TEMP%\ProfilerBenchmark unless
+ * COR_PROFILER_TARGETDIR is set.
+ */
+
+/** Options of a benchmark run. */
+struct BenchmarkOptions {
+	/** Number of threads that call the profiler concurrently. */
+	int threads = 4;
+
+	/** Total number of jitted methods. */
+	int methods = 1000000;
+
+	/** Number of inlining callbacks per jitted method. */
+	int inliningsPerMethod = 2;
+
+	/** Number of loaded assemblies. The jitted methods are spread evenly across them. */
+	int assemblies = 200;
+
+	/** Number of distinct methods per assembly that get inlined. Most inlinings are thus repeated. */
+	int inlinedMethodsPerAssembly = 500;
+
+	/** The callback recording to replay or the empty string to run the synthetic workload. */
+	std::string replayFile;
+
+	/** Whether to replay the events of each recorded thread on a separate thread. */
+	bool parallelReplay = false;
+
+	/** Whether to use the generic JIT callbacks instead of the specialized ones. */
+	bool genericCallbacks = false;
+
+	/** Whether to run the synthetic workload with both the specialized and the generic JIT callbacks. */
+	bool compareCallbacks = false;
+
+	/** Number of rounds in which both variants are run when comparing them. */
+	int compareRounds = 3;
+};
+
+/** Latencies of all callback types recorded by one thread. */
+struct ThreadResults {
+	LatencyHistogram assemblyLoads;
+	LatencyHistogram jitCompilations;
+	LatencyHistogram inlinings;
+};
+
+/** Spins until all threads have arrived, so they hit the profiler at the same time. */
+static void waitForAllThreads(std::atomic<int>& arrivedThreads, int threadCount) {
+	arrivedThreads++;
+	while (arrivedThreads.load() < threadCount) {
+		std::this_thread::yield();
+	}
+}
+
+/** Simple deterministic pseudo-random number generator (xorshift). */
+static uint32_t nextRandom(uint32_t& state) {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+static void runAssemblyLoads(CProfilerCallback* profiler, FakeProfilerInfo* info, BenchmarkOptions& options,
+	int threadIndex, std::atomic<int>& arrivedThreads, ThreadResults& results) {
+	waitForAllThreads(arrivedThreads, options.threads);
+	for (int assembly = threadIndex; assembly < options.assemblies; assembly += options.threads) {
+		uint64_t start = __rdtsc();
+		profiler->AssemblyLoadFinished(info->getAssemblyId(assembly), S_OK);
+		results.assemblyLoads.record(__rdtsc() - start);
+	}
+}
+
+static void runJitCompilations(CProfilerCallback* profiler, FakeProfilerInfo* info, BenchmarkOptions& options,
+	int threadIndex, std::atomic<int>& arrivedThreads, ThreadResults& results) {
+	uint32_t random = 2463534242u + threadIndex;
+	BOOL shouldInline = TRUE;
+
+	waitForAllThreads(arrivedThreads, options.threads);
+	for (int method = threadIndex; method < options.methods; method += options.threads) {
+		FunctionID functionId = info->getFunctionId(method % options.assemblies, method / options.assemblies);
+		uint64_t start = __rdtsc();
+		profiler->JITCompilationFinished(functionId, S_OK, TRUE);
+		results.jitCompilations.record(__rdtsc() - start);
+
+		for (int i = 0; i < options.inliningsPerMethod; i++) {
+			int calleeAssembly = nextRandom(random) % options.assemblies;
+			int calleeMethod = nextRandom(random) % options.inlinedMethodsPerAssembly;
+			FunctionID calleeId = info->getFunctionId(calleeAssembly, calleeMethod);
+			start = __rdtsc();
+			profiler->JITInlining(functionId, calleeId, &shouldInline);
+			results.inlinings.record(__rdtsc() - start);
+		}
+	}
+}
+
+/** Feeds the given recorded events to the profiler in order. */
+static void replayEvents(CProfilerCallback* profiler, const std::vector<RecordedEvent>* events,
+	std::atomic<int>* arrivedThreads, int threadCount, ThreadResults* results) {
+	BOOL shouldInline = TRUE;
+
+	waitForAllThreads(*arrivedThreads, threadCount);
+	for (const RecordedEvent& event : *events) {
+		uint64_t start = __rdtsc();
+		switch (event.type) {
+		case EVENT_ASSEMBLY_LOAD:
+			profiler->AssemblyLoadFinished(event.assemblyId, S_OK);
+			results->assemblyLoads.record(__rdtsc() - start);
+			break;
+		case EVENT_JIT_COMPILATION:
+			profiler->JITCompilationFinished(event.functionId, S_OK, TRUE);
+			results->jitCompilations.record(__rdtsc() - start);
+			break;
+		case EVENT_JIT_INLINING:
+			profiler->JITInlining(event.callerId, event.functionId, &shouldInline);
+			results->inlinings.record(__rdtsc() - start);
+			break;
+		}
+	}
+}
+
+/** Reads all events of the given recording. Returns false if the file cannot be read or is not a complete recording. */
+static bool readRecording(const std::string& path, std::vector<RecordedEvent>& events) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+	std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	const char* position = contents.data();
+	const char* end = position + contents.size();
+	if (!EventRecording::readHeader(position, end)) {
+		return false;
+	}
+
+	RecordedEvent event;
+	while (EventRecording::readEvent(position, end, &event)) {
+		events.push_back(event);
+	}
+	return position == end;
+}
+
+/** Runs the given phase on all threads and returns its wall clock duration in seconds. */
+template<typename Phase>
+static double runPhase(Phase phase, CProfilerCallback* profiler, FakeProfilerInfo* info, BenchmarkOptions& options,
+	std::vector<ThreadResults>& results) {
+	std::atomic<int> arrivedThreads(0);
+	std::vector<std::thread> threads;
+
+	LARGE_INTEGER frequency, start, end;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&start);
+	for (int i = 0; i < options.threads; i++) {
+		threads.push_back(std::thread(phase, profiler, info, std::ref(options), i, std::ref(arrivedThreads), std::ref(results[i])));
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	QueryPerformanceCounter(&end);
+	return static_cast<double>(end.QuadPart - start.QuadPart) / frequency.QuadPart;
+}
+
+/** Measures the TSC frequency against the performance counter. */
+static double measureCyclesPerNanosecond() {
+	LARGE_INTEGER frequency, start, now;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&start);
+	uint64_t startCycles = __rdtsc();
+	do {
+		QueryPerformanceCounter(&now);
+	} while (now.QuadPart - start.QuadPart < frequency.QuadPart / 10);
+	uint64_t cycles = __rdtsc() - startCycles;
+	double nanoseconds = (now.QuadPart - start.QuadPart) * 1e9 / frequency.QuadPart;
+	return cycles / nanoseconds;
+}
+
+static void printResult(const char* operation, LatencyHistogram histogram, double seconds, double cyclesPerNanosecond) {
+	printf("%-24s %12llu %14.0f %10.0f %10.0f\n", operation, histogram.getCount(), histogram.getCount() / seconds,
+		histogram.getPercentile(50) / cyclesPerNanosecond, histogram.getPercentile(99) / cyclesPerNanosecond);
+}
+
+static size_t getPeakWorkingSetInMegabytes() {
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return 0;
+	}
+	return counters.PeakWorkingSetSize / (1024 * 1024);
+}
+
+static int parseIntOption(const std::string& argument, const std::string& name, int currentValue) {
+	std::string prefix = "--" + name + "=";
+	if (argument.compare(0, prefix.size(), prefix) != 0) {
+		return currentValue;
+	}
+	return std::stoi(argument.substr(prefix.size()));
+}
+
+/** Points the profiler to a private target directory unless the user configured one. */
+static void configureEnvironment() {
+	std::string benchmarkDirectory = Platform::getTempDirectory() + "ProfilerBenchmark";
+	CreateDirectory(benchmarkDirectory.c_str(), NULL);
+	if (Config::getValueFromEnvironment("TARGETDIR").empty()) {
+		SetEnvironmentVariable("COR_PROFILER_TARGETDIR", benchmarkDirectory.c_str());
+	}
+	if (Config::getValueFromEnvironment("CONFIG").empty()) {
+		SetEnvironmentVariable("COR_PROFILER_CONFIG", (benchmarkDirectory + "\\Profiler.yml").c_str());
+	}
+	SetEnvironmentVariable("COR_PROFILER_UPLOAD_DAEMON", "0");
+}
+
+/** Replays the recording given in the options and prints the results. */
+static int runReplay(BenchmarkOptions& options, double cyclesPerNanosecond) {
+	std::vector<RecordedEvent> events;
+	if (!readRecording(options.replayFile, events)) {
+		if (events.empty()) {
+			fprintf(stderr, "Could not read the recording %s\n", options.replayFile.c_str());
+			return 1;
+		}
+		fprintf(stderr, "The recording %s is truncated. Replaying the first %zu events.\n", options.replayFile.c_str(), events.size());
+	}
+
+	// The recorded order is kept within each thread. Assembly loads are not tied to the JIT events of other threads
+	// when replayed in parallel, so they are replayed up front to keep them ahead of all JIT events of their modules.
+	std::vector<RecordedEvent> assemblyLoads;
+	std::map<uint32_t, std::vector<RecordedEvent>> eventsByThread;
+	if (options.parallelReplay) {
+		for (const RecordedEvent& event : events) {
+			if (event.type == EVENT_ASSEMBLY_LOAD) {
+				assemblyLoads.push_back(event);
+			}
+			else {
+				eventsByThread[event.threadId].push_back(event);
+			}
+		}
+	}
+	else {
+		eventsByThread[0] = events;
+	}
+
+	size_t baselineMemory = getPeakWorkingSetInMegabytes();
+	ReplayProfilerInfo info(events);
+	CProfilerCallback* profiler = new CProfilerCallback();
+	profiler->Initialize(&info);
+	if (options.genericCallbacks) {
+		profiler->useGenericCallbacks();
+	}
+
+	int threadCount = static_cast<int>(eventsByThread.size());
+	std::vector<ThreadResults> results(threadCount + 1);
+	std::vector<std::thread> threads;
+	std::atomic<int> arrivedThreads(0);
+	std::atomic<int> arrivedLoadThreads(0);
+
+	LARGE_INTEGER frequency, start, end;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&start);
+	replayEvents(profiler, &assemblyLoads, &arrivedLoadThreads, 1, &results[threadCount]);
+	int threadIndex = 0;
+	for (auto& threadEvents : eventsByThread) {
+		threads.push_back(std::thread(replayEvents, profiler, &threadEvents.second, &arrivedThreads, threadCount, &results[threadIndex++]));
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	QueryPerformanceCounter(&end);
+	double replaySeconds = static_cast<double>(end.QuadPart - start.QuadPart) / frequency.QuadPart;
+
+	profiler->Shutdown();
+	size_t peakMemory = getPeakWorkingSetInMegabytes();
+	delete profiler;
+
+	ThreadResults total;
+	for (ThreadResults& threadResults : results) {
+		total.assemblyLoads.merge(threadResults.assemblyLoads);
+		total.jitCompilations.merge(threadResults.jitCompilations);
+		total.inlinings.merge(threadResults.inlinings);
+	}
+
+	printf("Replayed %zu events of %s on %i thread(s) in %.1f ms with the %s JIT callbacks\n\n", events.size(),
+		options.replayFile.c_str(), threadCount, replaySeconds * 1000, options.genericCallbacks ? "generic" : "specialized");
+	printf("%-24s %12s %14s %10s %10s\n", "Callback", "Calls", "Ops/sec", "p50 [ns]", "p99 [ns]");
+	printResult("AssemblyLoadFinished", total.assemblyLoads, replaySeconds, cyclesPerNanosecond);
+	printResult("JITCompilationFinished", total.jitCompilations, replaySeconds, cyclesPerNanosecond);
+	printResult("JITInlining", total.inlinings, replaySeconds, cyclesPerNanosecond);
+	printf("\nPeak working set: %zu MB (%zu MB before the profiler was created)\n", peakMemory, baselineMemory);
+	return 0;
+}
+
+/** Runs the synthetic workload with a new profiler, prints the results and returns the JIT callbacks per second. */
+static double runSynthetic(BenchmarkOptions& options, double cyclesPerNanosecond) {
+	std::vector<ThreadResults> results(options.threads);
+	size_t baselineMemory = getPeakWorkingSetInMegabytes();
+
+	FakeProfilerInfo info(options.assemblies);
+	CProfilerCallback* profiler = new CProfilerCallback();
+	profiler->Initialize(&info);
+	if (options.genericCallbacks) {
+		profiler->useGenericCallbacks();
+	}
+
+	double assemblyLoadSeconds = runPhase(runAssemblyLoads, profiler, &info, options, results);
+	double jitSeconds = runPhase(runJitCompilations, profiler, &info, options, results);
+
+	LARGE_INTEGER frequency, shutdownStart, shutdownEnd;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&shutdownStart);
+	profiler->Shutdown();
+	QueryPerformanceCounter(&shutdownEnd);
+	double shutdownMilliseconds = (shutdownEnd.QuadPart - shutdownStart.QuadPart) * 1000.0 / frequency.QuadPart;
+
+	size_t peakMemory = getPeakWorkingSetInMegabytes();
+	delete profiler;
+
+	ThreadResults total;
+	for (ThreadResults& threadResults : results) {
+		total.assemblyLoads.merge(threadResults.assemblyLoads);
+		total.jitCompilations.merge(threadResults.jitCompilations);
+		total.inlinings.merge(threadResults.inlinings);
+	}
+
+	printf("Threads: %i, methods: %i, inlinings per method: %i, assemblies: %i, %s JIT callbacks\n\n",
+		options.threads, options.methods, options.inliningsPerMethod, options.assemblies,
+		options.genericCallbacks ? "generic" : "specialized");
+	printf("%-24s %12s %14s %10s %10s\n", "Callback", "Calls", "Ops/sec", "p50 [ns]", "p99 [ns]");
+	printResult("AssemblyLoadFinished", total.assemblyLoads, assemblyLoadSeconds, cyclesPerNanosecond);
+	printResult("JITCompilationFinished", total.jitCompilations, jitSeconds, cyclesPerNanosecond);
+	printResult("JITInlining", total.inlinings, jitSeconds, cyclesPerNanosecond);
+	printf("\nShutdown (final flush): %.1f ms\n", shutdownMilliseconds);
+	printf("Peak working set: %zu MB (%zu MB before the profiler was created)\n", peakMemory, baselineMemory);
+	return (total.jitCompilations.getCount() + total.inlinings.getCount()) / jitSeconds;
+}
+
+int main(int argc, char** argv) {
+	BenchmarkOptions options;
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		options.threads = parseIntOption(argument, "threads", options.threads);
+		options.methods = parseIntOption(argument, "methods", options.methods);
+		options.inliningsPerMethod = parseIntOption(argument, "inlinings", options.inliningsPerMethod);
+		options.assemblies = parseIntOption(argument, "assemblies", options.assemblies);
+		options.compareRounds = parseIntOption(argument, "rounds", options.compareRounds);
+		if (argument.compare(0, 9, "--replay=") == 0) {
+			options.replayFile = argument.substr(9);
+		}
+		if (argument == "--parallel") {
+			options.parallelReplay = true;
+		}
+		if (argument == "--generic") {
+			options.genericCallbacks = true;
+		}
+		if (argument == "--compare") {
+			options.compareCallbacks = true;
+		}
+	}
+
+	configureEnvironment();
+	double cyclesPerNanosecond = measureCyclesPerNanosecond();
+	if (!options.replayFile.empty()) {
+		return runReplay(options, cyclesPerNanosecond);
+	}
+	if (!options.compareCallbacks) {
+		runSynthetic(options, cyclesPerNanosecond);
+		return 0;
+	}
+
+	// each run has its own profiler. A coverage baseline would skew later runs, as they find the methods of the first one in it.
+	// Later runs profit from a warmed-up process, so the variant that runs first alternates between rounds
+	std::vector<double> specializedRates;
+	std::vector<double> genericRates;
+	for (int round = 0; round < options.compareRounds; round++) {
+		for (int run = 0; run < 2; run++) {
+			options.genericCallbacks = (round + run) % 2 == 1;
+			double rate = runSynthetic(options, cyclesPerNanosecond);
+			printf("\n");
+			if (options.genericCallbacks) {
+				genericRates.push_back(rate);
+			}
+			else {
+				specializedRates.push_back(rate);
+			}
+		}
+	}
+
+	double specializedTotal = 0;
+	double genericTotal = 0;
+	printf("%-8s %20s %20s\n", "Round", "Specialized [ops/s]", "Generic [ops/s]");
+	for (int round = 0; round < options.compareRounds; round++) {
+		printf("%-8i %20.0f %20.0f%s\n", round + 1, specializedRates[round], genericRates[round], round % 2 == 0 ? "  (specialized first)" : "  (generic first)");
+		specializedTotal += specializedRates[round];
+		genericTotal += genericRates[round];
+	}
+	if (options.compareRounds > 0) {
+		printf("\nJIT callbacks per second on average: %.0f specialized, %.0f generic (%.2fx)\n", specializedTotal / options.compareRounds,
+			genericTotal / options.compareRounds, specializedTotal / genericTotal);
+	}
+	return 0;
+}
@@ -0,0 +1,436 @@
+#include "FakeProfilerInfo.h"
+
+/** IDs are offset so the different kinds of IDs never overlap. */
+static const UINT_PTR ASSEMBLY_ID_BASE = 0x10000;
+static const UINT_PTR MODULE_ID_BASE = 0x20000;
+static const UINT_PTR FUNCTION_ID_BASE = 0x1000000;
+
+/** Token of the first method definition of a module. */
+static const mdToken FIRST_METHOD_TOKEN = 0x06000001;
+
+//====================================================
+// FakeMetaDataImport
+//====================================================
+
+ULONG FakeMetaDataImport::AddRef() {
+	return 1;
+}
+
+ULONG FakeMetaDataImport::Release() {
+	return 1;
+}
+
+HRESULT FakeMetaDataImport::QueryInterface(REFIID riid, void **ppInterface) {
+	if (riid == IID_IUnknown || riid == IID_IMetaDataAssemblyImport) {
+		*ppInterface = static_cast<IMetaDataAssemblyImport*>(this);
+		return S_OK;
+	}
+	*ppInterface = NULL;
+	return E_NOINTERFACE;
+}
+
+HRESULT FakeMetaDataImport::GetAssemblyProps(mdAssembly mda, const void **ppbPublicKey, ULONG *pcbPublicKey, ULONG *pulHashAlgId, LPWSTR szName, ULONG cchName, ULONG *pchName, ASSEMBLYMETADATA *pMetaData, DWORD *pdwAssemblyFlags) {
+	if (pMetaData != NULL) {
+		pMetaData->usMajorVersion = 1;
+		pMetaData->usMinorVersion = 0;
+		pMetaData->usBuildNumber = 0;
+		pMetaData->usRevisionNumber = 0;
+		pMetaData->cbLocale = 0;
+		pMetaData->ulProcessor = 0;
+		pMetaData->ulOS = 0;
+	}
+	return S_OK;
+}
+
+HRESULT FakeMetaDataImport::GetAssemblyRefProps(mdAssemblyRef mdar, const void **ppbPublicKeyOrToken, ULONG *pcbPublicKeyOrToken, LPWSTR szName, ULONG cchName, ULONG *pchName, ASSEMBLYMETADATA *pMetaData, const void **ppbHashValue, ULONG *pcbHashValue, DWORD *pdwAssemblyRefFlags) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeMetaDataImport::GetFileProps(mdFile mdf, LPWSTR szName, ULONG cchName, ULONG *pchName, const void **ppbHashValue, ULONG *pcbHashValue, DWORD *pdwFileFlags) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeMetaDataImport::GetExportedTypeProps(mdExportedType mdct, LPWSTR szName, ULONG cchName, ULONG *pchName, mdToken *ptkImplementation, mdTypeDef *ptkTypeDef, DWORD *pdwExportedTypeFlags) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeMetaDataImport::GetManifestResourceProps(mdManifestResource mdmr, LPWSTR szName, ULONG cchName, ULONG *pchName, mdToken *ptkImplementation, DWORD *pdwOffset, DWORD *pdwResourceFlags) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeMetaDataImport::EnumAssemblyRefs(HCORENUM *phEnum, mdAssemblyRef rAssemblyRefs[], ULONG cMax, ULONG *pcTokens) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeMetaDataImport::EnumFiles(HCORENUM *phEnum, mdFile rFiles[], ULONG cMax, ULONG *pcTokens) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeMetaDataImport::EnumExportedTypes(HCORENUM *phEnum, mdExportedType rExportedTypes[], ULONG cMax, ULONG *pcTokens) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeMetaDataImport::EnumManifestResources(HCORENUM *phEnum, mdManifestResource rManifestResources[], ULONG cMax, ULONG *pcTokens) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeMetaDataImport::GetAssemblyFromScope(mdAssembly *ptkAssembly) {
+	*ptkAssembly = 0x20000001;
+	return S_OK;
+}
+
+HRESULT FakeMetaDataImport::FindExportedTypeByName(LPCWSTR szName, mdToken mdtExportedType, mdExportedType *ptkExportedType) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeMetaDataImport::FindManifestResourceByName(LPCWSTR szName, mdManifestResource *ptkManifestResource) {
+	return E_NOTIMPL;
+}
+
+void FakeMetaDataImport::CloseEnum(HCORENUM hEnum) {
+	// nothing to do
+}
+
+HRESULT FakeMetaDataImport::FindAssembliesByName(LPCWSTR szAppBase, LPCWSTR szPrivateBin, LPCWSTR szAssemblyName, IUnknown *ppIUnk[], ULONG cMax, ULONG *pcAssemblies) {
+	return E_NOTIMPL;
+}
+
+//====================================================
+// FakeProfilerInfo
+//====================================================
+
+FakeProfilerInfo::FakeProfilerInfo(int assemblyCount) : assemblyCount(assemblyCount) {
+	// nothing to do
+}
+
+AssemblyID FakeProfilerInfo::getAssemblyId(int assemblyIndex) {
+	return ASSEMBLY_ID_BASE + assemblyIndex;
+}
+
+ModuleID FakeProfilerInfo::getModuleId(int assemblyIndex) {
+	return MODULE_ID_BASE + assemblyIndex;
+}
+
+FunctionID FakeProfilerInfo::getFunctionId(int assemblyIndex, int methodIndex) {
+	return FUNCTION_ID_BASE + static_cast<UINT_PTR>(methodIndex) * assemblyCount + assemblyIndex;
+}
+
+bool FakeProfilerInfo::resolveFunction(FunctionID functionId, ModuleID* moduleId, mdToken* token) {
+	if (functionId < FUNCTION_ID_BASE) {
+		return false;
+	}
+	UINT_PTR index = functionId - FUNCTION_ID_BASE;
+	*moduleId = getModuleId(static_cast<int>(index % assemblyCount));
+	*token = FIRST_METHOD_TOKEN + static_cast<mdToken>(index / assemblyCount);
+	return true;
+}
+
+bool FakeProfilerInfo::resolveModule(ModuleID moduleId, AssemblyID* assemblyId, std::wstring* path) {
+	if (moduleId < MODULE_ID_BASE || moduleId >= MODULE_ID_BASE + assemblyCount) {
+		return false;
+	}
+	int assemblyIndex = static_cast<int>(moduleId - MODULE_ID_BASE);
+	*assemblyId = getAssemblyId(assemblyIndex);
+	*path = L"C:\\Fake\\Assembly" + std::to_wstring(assemblyIndex) + L".dll";
+	return true;
+}
+
+bool FakeProfilerInfo::resolveAssembly(AssemblyID assemblyId, ModuleID* moduleId, std::wstring* name) {
+	if (assemblyId < ASSEMBLY_ID_BASE || assemblyId >= ASSEMBLY_ID_BASE + assemblyCount) {
+		return false;
+	}
+	int assemblyIndex = static_cast<int>(assemblyId - ASSEMBLY_ID_BASE);
+	*moduleId = getModuleId(assemblyIndex);
+	*name = L"Assembly" + std::to_wstring(assemblyIndex);
+	return true;
+}
+
+void FakeProfilerInfo::copyName(const std::wstring& name, ULONG cchName, ULONG* pcchName, WCHAR szName[]) {
+	if (pcchName != NULL) {
+		*pcchName = static_cast<ULONG>(name.size() + 1);
+	}
+	if (szName != NULL && cchName > 0) {
+		wcsncpy_s(szName, cchName, name.c_str(), _TRUNCATE);
+	}
+}
+
+ULONG FakeProfilerInfo::AddRef() {
+	return 1;
+}
+
+ULONG FakeProfilerInfo::Release() {
+	return 1;
+}
+
+HRESULT FakeProfilerInfo::QueryInterface(REFIID riid, void **ppInterface) {
+	if (riid == IID_IUnknown || riid == IID_ICorProfilerInfo || riid == IID_ICorProfilerInfo2) {
+		*ppInterface = static_cast<ICorProfilerInfo2*>(this);
+		return S_OK;
+	}
+	*ppInterface = NULL;
+	return E_NOINTERFACE;
+}
+
+HRESULT FakeProfilerInfo::GetFunctionInfo(FunctionID functionId, ClassID *pClassId, ModuleID *pModuleId, mdToken *pToken) {
+	return GetFunctionInfo2(functionId, 0, pClassId, pModuleId, pToken, 0, NULL, NULL);
+}
+
+HRESULT FakeProfilerInfo::GetFunctionInfo2(FunctionID funcId, COR_PRF_FRAME_INFO frameInfo, ClassID *pClassId, ModuleID *pModuleId, mdToken *pToken, ULONG32 cTypeArgs, ULONG32 *pcTypeArgs, ClassID typeArgs[]) {
+	ModuleID moduleId = 0;
+	mdToken token = 0;
+	if (!resolveFunction(funcId, &moduleId, &token)) {
+		return E_INVALIDARG;
+	}
+	if (pClassId != NULL) {
+		*pClassId = 0;
+	}
+	if (pModuleId != NULL) {
+		*pModuleId = moduleId;
+	}
+	if (pToken != NULL) {
+		*pToken = token;
+	}
+	if (pcTypeArgs != NULL) {
+		*pcTypeArgs = 0;
+	}
+	return S_OK;
+}
+
+HRESULT FakeProfilerInfo::GetModuleInfo(ModuleID moduleId, LPCBYTE *ppBaseLoadAddress, ULONG cchName, ULONG *pcchName, WCHAR szName[], AssemblyID *pAssemblyId) {
+	AssemblyID assemblyId = 0;
+	std::wstring path;
+	if (!resolveModule(moduleId, &assemblyId, &path)) {
+		return E_INVALIDARG;
+	}
+	if (ppBaseLoadAddress != NULL) {
+		*ppBaseLoadAddress = NULL;
+	}
+	copyName(path, cchName, pcchName, szName);
+	if (pAssemblyId != NULL) {
+		*pAssemblyId = assemblyId;
+	}
+	return S_OK;
+}
+
+HRESULT FakeProfilerInfo::GetModuleMetaData(ModuleID moduleId, DWORD dwOpenFlags, REFIID riid, IUnknown **ppOut) {
+	return metaDataImport.QueryInterface(riid, reinterpret_cast<void**>(ppOut));
+}
+
+HRESULT FakeProfilerInfo::GetAssemblyInfo(AssemblyID assemblyId, ULONG cchName, ULONG *pcchName, WCHAR szName[], AppDomainID *pAppDomainId, ModuleID *pModuleId) {
+	ModuleID moduleId = 0;
+	std::wstring name;
+	if (!resolveAssembly(assemblyId, &moduleId, &name)) {
+		return E_INVALIDARG;
+	}
+	copyName(name, cchName, pcchName, szName);
+	if (pAppDomainId != NULL) {
+		*pAppDomainId = 1;
+	}
+	if (pModuleId != NULL) {
+		*pModuleId = moduleId;
+	}
+	return S_OK;
+}
+
+HRESULT FakeProfilerInfo::SetEventMask(DWORD dwEvents) {
+	eventMask = dwEvents;
+	return S_OK;
+}
+
+HRESULT FakeProfilerInfo::GetEventMask(DWORD *pdwEvents) {
+	*pdwEvents = eventMask;
+	return S_OK;
+}
+
+HRESULT FakeProfilerInfo::SetFunctionIDMapper(FunctionIDMapper *pFunc) {
+	return S_OK;
+}
+
+HRESULT FakeProfilerInfo::ForceGC() {
+	return S_OK;
+}
+
+HRESULT FakeProfilerInfo::GetCurrentThreadID(ThreadID *pThreadId) {
+	*pThreadId = GetCurrentThreadId();
+	return S_OK;
+}
+
+//====================================================
+// Methods the profiler does not call
+//====================================================
+
+HRESULT FakeProfilerInfo::GetClassFromObject(ObjectID objectId, ClassID *pClassId) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetClassFromToken(ModuleID moduleId, mdTypeDef typeDef, ClassID *pClassId) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetCodeInfo(FunctionID functionId, LPCBYTE *pStart, ULONG *pcSize) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetFunctionFromIP(LPCBYTE ip, FunctionID *pFunctionId) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetFunctionFromToken(ModuleID moduleId, mdToken token, FunctionID *pFunctionId) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetHandleFromThread(ThreadID threadId, HANDLE *phThread) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetObjectSize(ObjectID objectId, ULONG *pcSize) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::IsArrayClass(ClassID classId, CorElementType *pBaseElemType, ClassID *pBaseClassId, ULONG *pcRank) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetThreadInfo(ThreadID threadId, DWORD *pdwWin32ThreadId) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetClassIDInfo(ClassID classId, ModuleID *pModuleId, mdTypeDef *pTypeDefToken) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::SetEnterLeaveFunctionHooks(FunctionEnter *pFuncEnter, FunctionLeave *pFuncLeave, FunctionTailcall *pFuncTailcall) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetTokenAndMetaDataFromFunction(FunctionID functionId, REFIID riid, IUnknown **ppImport, mdToken *pToken) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetILFunctionBody(ModuleID moduleId, mdMethodDef methodId, LPCBYTE *ppMethodHeader, ULONG *pcbMethodSize) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetILFunctionBodyAllocator(ModuleID moduleId, IMethodMalloc **ppMalloc) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::SetILFunctionBody(ModuleID moduleId, mdMethodDef methodid, LPCBYTE pbNewILMethodHeader) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetAppDomainInfo(AppDomainID appDomainId, ULONG cchName, ULONG *pcchName, WCHAR szName[], ProcessID *pProcessId) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::SetFunctionReJIT(FunctionID functionId) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::SetILInstrumentedCodeMap(FunctionID functionId, BOOL fStartJit, ULONG cILMapEntries, COR_IL_MAP rgILMapEntries[]) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetInprocInspectionInterface(IUnknown **ppicd) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetInprocInspectionIThisThread(IUnknown **ppicd) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetThreadContext(ThreadID threadId, ContextID *pContextId) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::BeginInprocDebugging(BOOL fThisThreadOnly, DWORD *pdwProfilerContext) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::EndInprocDebugging(DWORD dwProfilerContext) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetILToNativeMapping(FunctionID functionId, ULONG32 cMap, ULONG32 *pcMap, COR_DEBUG_IL_TO_NATIVE_MAP map[]) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::DoStackSnapshot(ThreadID thread, StackSnapshotCallback *callback, ULONG32 infoFlags, void *clientData, BYTE context[], ULONG32 contextSize) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::SetEnterLeaveFunctionHooks2(FunctionEnter2 *pFuncEnter, FunctionLeave2 *pFuncLeave, FunctionTailcall2 *pFuncTailcall) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetStringLayout(ULONG *pBufferLengthOffset, ULONG *pStringLengthOffset, ULONG *pBufferOffset) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetClassLayout(ClassID classID, COR_FIELD_OFFSET rFieldOffset[], ULONG cFieldOffset, ULONG *pcFieldOffset, ULONG *pulClassSize) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetClassIDInfo2(ClassID classId, ModuleID *pModuleId, mdTypeDef *pTypeDefToken, ClassID *pParentClassId, ULONG32 cNumTypeArgs, ULONG32 *pcNumTypeArgs, ClassID typeArgs[]) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetCodeInfo2(FunctionID functionID, ULONG32 cCodeInfos, ULONG32 *pcCodeInfos, COR_PRF_CODE_INFO codeInfos[]) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetClassFromTokenAndTypeArgs(ModuleID moduleID, mdTypeDef typeDef, ULONG32 cTypeArgs, ClassID typeArgs[], ClassID *pClassID) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetFunctionFromTokenAndTypeArgs(ModuleID moduleID, mdMethodDef funcDef, ClassID classId, ULONG32 cTypeArgs, ClassID typeArgs[], FunctionID *pFunctionID) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::EnumModuleFrozenObjects(ModuleID moduleID, ICorProfilerObjectEnum **ppEnum) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetArrayObjectInfo(ObjectID objectId, ULONG32 cDimensions, ULONG32 pDimensionSizes[], int pDimensionLowerBounds[], BYTE **ppData) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetBoxClassLayout(ClassID classId, ULONG32 *pBufferOffset) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetThreadAppDomain(ThreadID threadId, AppDomainID *pAppDomainId) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetRVAStaticAddress(ClassID classId, mdFieldDef fieldToken, void **ppAddress) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetAppDomainStaticAddress(ClassID classId, mdFieldDef fieldToken, AppDomainID appDomainId, void **ppAddress) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetThreadStaticAddress(ClassID classId, mdFieldDef fieldToken, ThreadID threadId, void **ppAddress) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetContextStaticAddress(ClassID classId, mdFieldDef fieldToken, ContextID contextId, void **ppAddress) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetStaticFieldInfo(ClassID classId, mdFieldDef fieldToken, COR_PRF_STATIC_TYPE *pFieldInfo) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetGenerationBounds(ULONG cObjectRanges, ULONG *pcObjectRanges, COR_PRF_GC_GENERATION_RANGE ranges[]) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetObjectGeneration(ObjectID objectId, COR_PRF_GC_GENERATION_RANGE *range) {
+	return E_NOTIMPL;
+}
+
+HRESULT FakeProfilerInfo::GetNotifiedExceptionClauseInfo(COR_PRF_EX_CLAUSE_INFO *pinfo) {
+	return E_NOTIMPL;
+}
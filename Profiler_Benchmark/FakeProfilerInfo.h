@@ -0,0 +1,153 @@
+#pragma once
+#include <windows.h>
+#include <cor.h>
+#include <corprof.h>
+#include <string>
+
+/**
+ * Fake metadata import that returns the same assembly props for every module.
+ * Only the methods the profiler calls are implemented.
+ */
+class FakeMetaDataImport : public IMetaDataAssemblyImport {
+public:
+	// IUnknown interface implementation
+	STDMETHOD_(ULONG, AddRef)();
+	STDMETHOD_(ULONG, Release)();
+	STDMETHOD(QueryInterface)(REFIID riid, void **ppInterface);
+
+	// IMetaDataAssemblyImport interface implementation
+	STDMETHOD(GetAssemblyProps)(mdAssembly mda, const void **ppbPublicKey, ULONG *pcbPublicKey, ULONG *pulHashAlgId, LPWSTR szName, ULONG cchName, ULONG *pchName, ASSEMBLYMETADATA *pMetaData, DWORD *pdwAssemblyFlags);
+	STDMETHOD(GetAssemblyRefProps)(mdAssemblyRef mdar, const void **ppbPublicKeyOrToken, ULONG *pcbPublicKeyOrToken, LPWSTR szName, ULONG cchName, ULONG *pchName, ASSEMBLYMETADATA *pMetaData, const void **ppbHashValue, ULONG *pcbHashValue, DWORD *pdwAssemblyRefFlags);
+	STDMETHOD(GetFileProps)(mdFile mdf, LPWSTR szName, ULONG cchName, ULONG *pchName, const void **ppbHashValue, ULONG *pcbHashValue, DWORD *pdwFileFlags);
+	STDMETHOD(GetExportedTypeProps)(mdExportedType mdct, LPWSTR szName, ULONG cchName, ULONG *pchName, mdToken *ptkImplementation, mdTypeDef *ptkTypeDef, DWORD *pdwExportedTypeFlags);
+	STDMETHOD(GetManifestResourceProps)(mdManifestResource mdmr, LPWSTR szName, ULONG cchName, ULONG *pchName, mdToken *ptkImplementation, DWORD *pdwOffset, DWORD *pdwResourceFlags);
+	STDMETHOD(EnumAssemblyRefs)(HCORENUM *phEnum, mdAssemblyRef rAssemblyRefs[], ULONG cMax, ULONG *pcTokens);
+	STDMETHOD(EnumFiles)(HCORENUM *phEnum, mdFile rFiles[], ULONG cMax, ULONG *pcTokens);
+	STDMETHOD(EnumExportedTypes)(HCORENUM *phEnum, mdExportedType rExportedTypes[], ULONG cMax, ULONG *pcTokens);
+	STDMETHOD(EnumManifestResources)(HCORENUM *phEnum, mdManifestResource rManifestResources[], ULONG cMax, ULONG *pcTokens);
+	STDMETHOD(GetAssemblyFromScope)(mdAssembly *ptkAssembly);
+	STDMETHOD(FindExportedTypeByName)(LPCWSTR szName, mdToken mdtExportedType, mdExportedType *ptkExportedType);
+	STDMETHOD(FindManifestResourceByName)(LPCWSTR szName, mdManifestResource *ptkManifestResource);
+	STDMETHOD_(void, CloseEnum)(HCORENUM hEnum);
+	STDMETHOD(FindAssembliesByName)(LPCWSTR szAppBase, LPCWSTR szPrivateBin, LPCWSTR szAssemblyName, IUnknown *ppIUnk[], ULONG cMax, ULONG *pcAssemblies);
+};
+
+/**
+ * Fake .NET profiler info that serves deterministic module, assembly and function IDs and tokens without a CLR.
+ * Used to drive the profiler callbacks in benchmarks.
+ *
+ * Assembly i has the AssemblyID getAssemblyId(i), the ModuleID getModuleId(i) and the name "Assembly<i>".
+ * Method m of assembly i has the FunctionID getFunctionId(i, m) and the token 0x06000001 + m.
+ * Subclasses can serve other IDs by overriding the resolve methods.
+ * All methods are thread-safe.
+ */
+class FakeProfilerInfo : public ICorProfilerInfo2 {
+public:
+	/** Constructor. */
+	FakeProfilerInfo(int assemblyCount);
+
+	/** Destructor. */
+	virtual ~FakeProfilerInfo() { /* nothing to do. */ };
+
+	/** Returns the AssemblyID of the assembly with the given index. */
+	AssemblyID getAssemblyId(int assemblyIndex);
+
+	/** Returns the ModuleID of the assembly with the given index. */
+	ModuleID getModuleId(int assemblyIndex);
+
+	/** Returns the FunctionID of the given method of the assembly with the given index. */
+	FunctionID getFunctionId(int assemblyIndex, int methodIndex);
+
+	/** The event mask last set by the profiler. */
+	DWORD getEventMask() {
+		return eventMask;
+	}
+
+	// IUnknown interface implementation
+	STDMETHOD_(ULONG, AddRef)();
+	STDMETHOD_(ULONG, Release)();
+	STDMETHOD(QueryInterface)(REFIID riid, void **ppInterface);
+
+	// ICorProfilerInfo interface implementation
+	STDMETHOD(GetClassFromObject)(ObjectID objectId, ClassID *pClassId);
+	STDMETHOD(GetClassFromToken)(ModuleID moduleId, mdTypeDef typeDef, ClassID *pClassId);
+	STDMETHOD(GetCodeInfo)(FunctionID functionId, LPCBYTE *pStart, ULONG *pcSize);
+	STDMETHOD(GetEventMask)(DWORD *pdwEvents);
+	STDMETHOD(GetFunctionFromIP)(LPCBYTE ip, FunctionID *pFunctionId);
+	STDMETHOD(GetFunctionFromToken)(ModuleID moduleId, mdToken token, FunctionID *pFunctionId);
+	STDMETHOD(GetHandleFromThread)(ThreadID threadId, HANDLE *phThread);
+	STDMETHOD(GetObjectSize)(ObjectID objectId, ULONG *pcSize);
+	STDMETHOD(IsArrayClass)(ClassID classId, CorElementType *pBaseElemType, ClassID *pBaseClassId, ULONG *pcRank);
+	STDMETHOD(GetThreadInfo)(ThreadID threadId, DWORD *pdwWin32ThreadId);
+	STDMETHOD(GetCurrentThreadID)(ThreadID *pThreadId);
+	STDMETHOD(GetClassIDInfo)(ClassID classId, ModuleID *pModuleId, mdTypeDef *pTypeDefToken);
+	STDMETHOD(GetFunctionInfo)(FunctionID functionId, ClassID *pClassId, ModuleID *pModuleId, mdToken *pToken);
+	STDMETHOD(SetEventMask)(DWORD dwEvents);
+	STDMETHOD(SetEnterLeaveFunctionHooks)(FunctionEnter *pFuncEnter, FunctionLeave *pFuncLeave, FunctionTailcall *pFuncTailcall);
+	STDMETHOD(SetFunctionIDMapper)(FunctionIDMapper *pFunc);
+	STDMETHOD(GetTokenAndMetaDataFromFunction)(FunctionID functionId, REFIID riid, IUnknown **ppImport, mdToken *pToken);
+	STDMETHOD(GetModuleInfo)(ModuleID moduleId, LPCBYTE *ppBaseLoadAddress, ULONG cchName, ULONG *pcchName, WCHAR szName[], AssemblyID *pAssemblyId);
+	STDMETHOD(GetModuleMetaData)(ModuleID moduleId, DWORD dwOpenFlags, REFIID riid, IUnknown **ppOut);
+	STDMETHOD(GetILFunctionBody)(ModuleID moduleId, mdMethodDef methodId, LPCBYTE *ppMethodHeader, ULONG *pcbMethodSize);
+	STDMETHOD(GetILFunctionBodyAllocator)(ModuleID moduleId, IMethodMalloc **ppMalloc);
+	STDMETHOD(SetILFunctionBody)(ModuleID moduleId, mdMethodDef methodid, LPCBYTE pbNewILMethodHeader);
+	STDMETHOD(GetAppDomainInfo)(AppDomainID appDomainId, ULONG cchName, ULONG *pcchName, WCHAR szName[], ProcessID *pProcessId);
+	STDMETHOD(GetAssemblyInfo)(AssemblyID assemblyId, ULONG cchName, ULONG *pcchName, WCHAR szName[], AppDomainID *pAppDomainId, ModuleID *pModuleId);
+	STDMETHOD(SetFunctionReJIT)(FunctionID functionId);
+	STDMETHOD(ForceGC)();
+	STDMETHOD(SetILInstrumentedCodeMap)(FunctionID functionId, BOOL fStartJit, ULONG cILMapEntries, COR_IL_MAP rgILMapEntries[]);
+	STDMETHOD(GetInprocInspectionInterface)(IUnknown **ppicd);
+	STDMETHOD(GetInprocInspectionIThisThread)(IUnknown **ppicd);
+	STDMETHOD(GetThreadContext)(ThreadID threadId, ContextID *pContextId);
+	STDMETHOD(BeginInprocDebugging)(BOOL fThisThreadOnly, DWORD *pdwProfilerContext);
+	STDMETHOD(EndInprocDebugging)(DWORD dwProfilerContext);
+	STDMETHOD(GetILToNativeMapping)(FunctionID functionId, ULONG32 cMap, ULONG32 *pcMap, COR_DEBUG_IL_TO_NATIVE_MAP map[]);
+	// End of ICorProfilerInfo interface implementation
+
+	// ICorProfilerInfo2 interface implementation
+	STDMETHOD(DoStackSnapshot)(ThreadID thread, StackSnapshotCallback *callback, ULONG32 infoFlags, void *clientData, BYTE context[], ULONG32 contextSize);
+	STDMETHOD(SetEnterLeaveFunctionHooks2)(FunctionEnter2 *pFuncEnter, FunctionLeave2 *pFuncLeave, FunctionTailcall2 *pFuncTailcall);
+	STDMETHOD(GetFunctionInfo2)(FunctionID funcId, COR_PRF_FRAME_INFO frameInfo, ClassID *pClassId, ModuleID *pModuleId, mdToken *pToken, ULONG32 cTypeArgs, ULONG32 *pcTypeArgs, ClassID typeArgs[]);
+	STDMETHOD(GetStringLayout)(ULONG *pBufferLengthOffset, ULONG *pStringLengthOffset, ULONG *pBufferOffset);
+	STDMETHOD(GetClassLayout)(ClassID classID, COR_FIELD_OFFSET rFieldOffset[], ULONG cFieldOffset, ULONG *pcFieldOffset, ULONG *pulClassSize);
+	STDMETHOD(GetClassIDInfo2)(ClassID classId, ModuleID *pModuleId, mdTypeDef *pTypeDefToken, ClassID *pParentClassId, ULONG32 cNumTypeArgs, ULONG32 *pcNumTypeArgs, ClassID typeArgs[]);
+	STDMETHOD(GetCodeInfo2)(FunctionID functionID, ULONG32 cCodeInfos, ULONG32 *pcCodeInfos, COR_PRF_CODE_INFO codeInfos[]);
+	STDMETHOD(GetClassFromTokenAndTypeArgs)(ModuleID moduleID, mdTypeDef typeDef, ULONG32 cTypeArgs, ClassID typeArgs[], ClassID *pClassID);
+	STDMETHOD(GetFunctionFromTokenAndTypeArgs)(ModuleID moduleID, mdMethodDef funcDef, ClassID classId, ULONG32 cTypeArgs, ClassID typeArgs[], FunctionID *pFunctionID);
+	STDMETHOD(EnumModuleFrozenObjects)(ModuleID moduleID, ICorProfilerObjectEnum **ppEnum);
+	STDMETHOD(GetArrayObjectInfo)(ObjectID objectId, ULONG32 cDimensions, ULONG32 pDimensionSizes[], int pDimensionLowerBounds[], BYTE **ppData);
+	STDMETHOD(GetBoxClassLayout)(ClassID classId, ULONG32 *pBufferOffset);
+	STDMETHOD(GetThreadAppDomain)(ThreadID threadId, AppDomainID *pAppDomainId);
+	STDMETHOD(GetRVAStaticAddress)(ClassID classId, mdFieldDef fieldToken, void **ppAddress);
+	STDMETHOD(GetAppDomainStaticAddress)(ClassID classId, mdFieldDef fieldToken, AppDomainID appDomainId, void **ppAddress);
+	STDMETHOD(GetThreadStaticAddress)(ClassID classId, mdFieldDef fieldToken, ThreadID threadId, void **ppAddress);
+	STDMETHOD(GetContextStaticAddress)(ClassID classId, mdFieldDef fieldToken, ContextID contextId, void **ppAddress);
+	STDMETHOD(GetStaticFieldInfo)(ClassID classId, mdFieldDef fieldToken, COR_PRF_STATIC_TYPE *pFieldInfo);
+	STDMETHOD(GetGenerationBounds)(ULONG cObjectRanges, ULONG *pcObjectRanges, COR_PRF_GC_GENERATION_RANGE ranges[]);
+	STDMETHOD(GetObjectGeneration)(ObjectID objectId, COR_PRF_GC_GENERATION_RANGE *range);
+	STDMETHOD(GetNotifiedExceptionClauseInfo)(COR_PRF_EX_CLAUSE_INFO *pinfo);
+	// End of ICorProfilerInfo2 interface implementation
+
+protected:
+	/** Resolves a function to its module and token. Returns false for unknown functions. */
+	virtual bool resolveFunction(FunctionID functionId, ModuleID* moduleId, mdToken* token);
+
+	/** Resolves a module to its assembly and file path. Returns false for unknown modules. */
+	virtual bool resolveModule(ModuleID moduleId, AssemblyID* assemblyId, std::wstring* path);
+
+	/** Resolves an assembly to its main module and name. Returns false for unknown assemblies. */
+	virtual bool resolveAssembly(AssemblyID assemblyId, ModuleID* moduleId, std::wstring* name);
+
+private:
+	/** Number of assemblies served by the default resolve methods. */
+	int assemblyCount;
+
+	/** The event mask last set by the profiler. */
+	DWORD eventMask = 0;
+
+	/** Shared by all modules. */
+	FakeMetaDataImport metaDataImport;
+
+	/** Copies the given string into a WinAPI-style output buffer. */
+	static void copyName(const std::wstring& name, ULONG cchName, ULONG* pcchName, WCHAR szName[]);
+};
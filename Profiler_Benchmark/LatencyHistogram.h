@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Log-linear histogram of latencies in CPU cycles with a relative error of at most 12.5%.
+ * Recording never allocates, so it doesn't distort the memory usage of the benchmark.
+ * Not thread-safe. Use one histogram per thread and merge them afterwards.
+ */
+class LatencyHistogram {
+public:
+	LatencyHistogram() : counts(BUCKET_COUNT, 0) {}
+
+	/** Records a single latency. */
+	void record(uint64_t cycles) {
+		counts[getBucket(cycles)]++;
+		total++;
+	}
+
+	/** Adds all latencies recorded in the other histogram to this one. */
+	void merge(const LatencyHistogram& other) {
+		for (size_t i = 0; i < BUCKET_COUNT; i++) {
+			counts[i] += other.counts[i];
+		}
+		total += other.total;
+	}
+
+	/** The number of recorded latencies. */
+	uint64_t getCount() const {
+		return total;
+	}
+
+	/** Returns the lower bound of the bucket that contains the given percentile (0-100), in cycles. */
+	uint64_t getPercentile(double percentile) const {
+		uint64_t threshold = static_cast<uint64_t>(total * percentile / 100.0);
+		uint64_t seen = 0;
+		for (size_t i = 0; i < BUCKET_COUNT; i++) {
+			seen += counts[i];
+			if (seen > threshold) {
+				return getLowerBound(i);
+			}
+		}
+		return 0;
+	}
+
+private:
+	/** Number of linear sub-buckets per power of two. */
+	static const int SUB_BUCKET_BITS = 3;
+	static const size_t SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+	static const size_t BUCKET_COUNT = 64 * SUB_BUCKET_COUNT;
+
+	std::vector<uint64_t> counts;
+	uint64_t total = 0;
+
+	static size_t getBucket(uint64_t value) {
+		if (value < SUB_BUCKET_COUNT) {
+			return static_cast<size_t>(value);
+		}
+		int highestBit = 63;
+		while ((value >> highestBit) == 0) {
+			highestBit--;
+		}
+		size_t subBucket = static_cast<size_t>(value >> (highestBit - SUB_BUCKET_BITS)) & (SUB_BUCKET_COUNT - 1);
+		return (highestBit - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT + subBucket;
+	}
+
+	static uint64_t getLowerBound(size_t bucket) {
+		if (bucket < SUB_BUCKET_COUNT) {
+			return bucket;
+		}
+		int highestBit = static_cast<int>(bucket / SUB_BUCKET_COUNT) + SUB_BUCKET_BITS - 1;
+		uint64_t subBucket = bucket % SUB_BUCKET_COUNT;
+		return (uint64_t(1) << highestBit) | (subBucket << (highestBit - SUB_BUCKET_BITS));
+	}
+};
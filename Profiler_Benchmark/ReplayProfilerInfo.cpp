@@ -0,0 +1,43 @@
+#include "ReplayProfilerInfo.h"
+
+ReplayProfilerInfo::ReplayProfilerInfo(const std::vector<RecordedEvent>& events) : FakeProfilerInfo(0) {
+	for (const RecordedEvent& event : events) {
+		if (event.type == EVENT_ASSEMBLY_LOAD) {
+			assemblies[event.assemblyId] = { event.moduleId, event.assemblyName };
+			modules[event.moduleId] = { event.assemblyId, event.assemblyPath };
+		}
+		else if (event.moduleId != 0) {
+			functions[event.functionId] = { event.moduleId, event.functionToken };
+		}
+	}
+}
+
+bool ReplayProfilerInfo::resolveFunction(FunctionID functionId, ModuleID* moduleId, mdToken* token) {
+	auto entry = functions.find(functionId);
+	if (entry == functions.end()) {
+		return false;
+	}
+	*moduleId = entry->second.moduleId;
+	*token = entry->second.token;
+	return true;
+}
+
+bool ReplayProfilerInfo::resolveModule(ModuleID moduleId, AssemblyID* assemblyId, std::wstring* path) {
+	auto entry = modules.find(moduleId);
+	if (entry == modules.end()) {
+		return false;
+	}
+	*assemblyId = entry->second.assemblyId;
+	*path = entry->second.path;
+	return true;
+}
+
+bool ReplayProfilerInfo::resolveAssembly(AssemblyID assemblyId, ModuleID* moduleId, std::wstring* name) {
+	auto entry = assemblies.find(assemblyId);
+	if (entry == assemblies.end()) {
+		return false;
+	}
+	*moduleId = entry->second.moduleId;
+	*name = entry->second.name;
+	return true;
+}
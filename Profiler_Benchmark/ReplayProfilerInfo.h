@@ -0,0 +1,45 @@
+#pragma once
+#include "FakeProfilerInfo.h"
+#include "recording/EventRecording.h"
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Fake profiler info that serves the IDs, tokens, names and paths of a callback event recording,
+ * so the recorded callbacks can be replayed exactly as the profiler saw them.
+ *
+ * All events must be registered before the replay starts. The resolve methods are then thread-safe.
+ */
+class ReplayProfilerInfo : public FakeProfilerInfo {
+public:
+	/** Constructor. Registers the IDs of all given events. */
+	ReplayProfilerInfo(const std::vector<RecordedEvent>& events);
+
+	/** Destructor. */
+	virtual ~ReplayProfilerInfo() { /* nothing to do. */ };
+
+protected:
+	virtual bool resolveFunction(FunctionID functionId, ModuleID* moduleId, mdToken* token) override;
+	virtual bool resolveModule(ModuleID moduleId, AssemblyID* assemblyId, std::wstring* path) override;
+	virtual bool resolveAssembly(AssemblyID assemblyId, ModuleID* moduleId, std::wstring* name) override;
+
+private:
+	struct FunctionEntry {
+		ModuleID moduleId;
+		mdToken token;
+	};
+
+	struct ModuleEntry {
+		AssemblyID assemblyId;
+		std::wstring path;
+	};
+
+	struct AssemblyEntry {
+		ModuleID moduleId;
+		std::wstring name;
+	};
+
+	std::unordered_map<FunctionID, FunctionEntry> functions;
+	std::unordered_map<ModuleID, ModuleEntry> modules;
+	std::unordered_map<AssemblyID, AssemblyEntry> assemblies;
+};
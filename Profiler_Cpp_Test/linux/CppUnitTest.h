@@ -0,0 +1,148 @@
+#pragma once
+#include <cstdio>
+#include <cwchar>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * The part of the Microsoft C++ unit test framework that the tests use, so the tests that do not depend on Windows
+ * also run on Linux with ctest. CppUnitTestMain.cpp runs all registered tests.
+ */
+namespace Microsoft {
+namespace VisualStudio {
+namespace CppUnitTestFramework {
+
+/** Thrown by a failed assertion. */
+struct AssertFailedException {
+	std::wstring message;
+};
+
+/** A registered test method. */
+struct RegisteredTest {
+	std::string name;
+	std::function<void()> run;
+};
+
+inline std::vector<RegisteredTest>& getRegisteredTests() {
+	static std::vector<RegisteredTest> tests;
+	return tests;
+}
+
+/** Base class of all test classes. */
+template<class T>
+class TestClass {
+protected:
+	typedef T ThisClass;
+
+	/** Runs after each test method, even a failed one. Replaced by TEST_METHOD_CLEANUP. */
+	void cleanUpMethod() {
+		// nothing to clean up by default
+	}
+
+	/** Registers a test method when the program starts. */
+	struct Registration {
+		Registration(const char* name, void (*run)()) {
+			getRegisteredTests().push_back({ name, run });
+		}
+	};
+};
+
+/** Takes values by copy, so static constants of the tested classes need no definition. */
+class Assert {
+public:
+	/** Unlike the Windows framework, allows different types, e.g. uint64_t and unsigned long long literals on Linux. */
+	template<typename T, typename U>
+	static void AreEqual(T expected, U actual, const wchar_t* message = NULL) {
+		if (!(expected == actual)) {
+			std::wostringstream description;
+			description << L"Expected <" << describe(expected) << L"> but was <" << describe(actual) << L">";
+			fail(description.str(), message);
+		}
+	}
+
+	static void AreEqual(const char* expected, const char* actual, const wchar_t* message = NULL) {
+		AreEqual(std::string(expected), std::string(actual), message);
+	}
+
+	static void AreEqual(const wchar_t* expected, const wchar_t* actual, const wchar_t* message = NULL) {
+		AreEqual(std::wstring(expected), std::wstring(actual), message);
+	}
+
+	template<typename T>
+	static void AreNotEqual(T notExpected, T actual, const wchar_t* message = NULL) {
+		if (notExpected == actual) {
+			std::wostringstream description;
+			description << L"Did not expect <" << describe(actual) << L">";
+			fail(description.str(), message);
+		}
+	}
+
+	static void IsTrue(bool condition, const wchar_t* message = NULL) {
+		if (!condition) {
+			fail(L"Expected true", message);
+		}
+	}
+
+	static void IsFalse(bool condition, const wchar_t* message = NULL) {
+		if (condition) {
+			fail(L"Expected false", message);
+		}
+	}
+
+	static void Fail(const wchar_t* message = NULL) {
+		fail(L"Failed", message);
+	}
+
+	template<typename ExpectedException, typename Function>
+	static void ExpectException(Function function, const wchar_t* message = NULL) {
+		try {
+			function();
+		}
+		catch (const ExpectedException&) {
+			return;
+		}
+		catch (...) {
+			fail(L"Threw another exception", message);
+		}
+		fail(L"Expected an exception", message);
+	}
+
+private:
+	template<typename T>
+	static std::wstring describe(const T& value) {
+		std::wostringstream description;
+		description << value;
+		return description.str();
+	}
+
+	static std::wstring describe(const std::string& value) {
+		return std::wstring(value.begin(), value.end());
+	}
+
+	static void fail(const std::wstring& description, const wchar_t* message) {
+		AssertFailedException exception;
+		exception.message = message == NULL ? description : description + L": " + message;
+		throw exception;
+	}
+};
+
+} // namespace CppUnitTestFramework
+} // namespace VisualStudio
+} // namespace Microsoft
+
+#define TEST_CLASS(className) class className : public ::Microsoft::VisualStudio::CppUnitTestFramework::TestClass<className>
+
+#define TEST_METHOD(methodName) \
+	static void methodName##Run() { \
+		ThisClass instance; \
+		try { instance.methodName(); } catch (...) { instance.cleanUpMethod(); throw; } \
+		instance.cleanUpMethod(); \
+	} \
+	static inline Registration methodName##Registration{ #methodName, &methodName##Run }; \
+	void methodName()
+
+#define TEST_METHOD_CLEANUP(methodName) \
+	void cleanUpMethod() { methodName(); } \
+	void methodName()
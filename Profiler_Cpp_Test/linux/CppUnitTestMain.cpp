@@ -0,0 +1,20 @@
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+/** Runs all registered tests and returns the number of failed ones. */
+int main() {
+	int failedCount = 0;
+	for (RegisteredTest& test : getRegisteredTests()) {
+		try {
+			test.run();
+			printf("Passed: %s\n", test.name.c_str());
+		}
+		catch (AssertFailedException& exception) {
+			printf("Failed: %s: %ls\n", test.name.c_str(), exception.message.c_str());
+			failedCount++;
+		}
+	}
+	printf("%zu tests, %d failed\n", getRegisteredTests().size(), failedCount);
+	return failedCount;
+}
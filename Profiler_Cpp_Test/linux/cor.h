@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * The part of the CLR metadata types that the portable profiler classes use, so their tests build on Linux without
+ * the CoreCLR headers. The profiler itself uses the real headers.
+ */
+#define __int64 long long
+
+typedef uint32_t mdToken;
+typedef uint32_t ULONG;
+typedef uint16_t USHORT;
+typedef uint8_t BYTE;
+
+typedef struct _GUID {
+	ULONG Data1;
+	USHORT Data2;
+	USHORT Data3;
+	BYTE Data4[8];
+} GUID;
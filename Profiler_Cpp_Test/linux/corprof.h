@@ -0,0 +1,8 @@
+#pragma once
+#include <cstdint>
+
+/** The IDs of the profiling API that the portable profiler classes use. See cor.h. */
+typedef uintptr_t UINT_PTR;
+typedef UINT_PTR FunctionID;
+typedef UINT_PTR ModuleID;
+typedef UINT_PTR AssemblyID;
@@ -0,0 +1,68 @@
+#include "CppUnitTest.h"
+#include "coverage/CallCounter.h"
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+TEST_CLASS(CallCounterTest)
+{
+public:
+
+	TEST_METHOD(CallsOfAllThreadsAreSummed)
+	{
+		CallCounter counter;
+		UINT_PTR first = 0;
+		UINT_PTR second = 0;
+		Assert::IsTrue(counter.addMethod(1, 0x06000001, &first), L"first method");
+		Assert::IsTrue(counter.addMethod(2, 0x06000002, &second), L"second method");
+
+		counter.countCall(first);
+		counter.countCall(first);
+		std::thread thread([&]() {
+			counter.countCall(first);
+			counter.countCall(second);
+		});
+		thread.join();
+
+		std::vector<std::string> lines;
+		counter.collectCalls(lines);
+		Assert::AreEqual(static_cast<size_t>(2), lines.size(), L"called methods");
+		Assert::AreEqual(std::string("1:100663297:3"), lines[0], L"first method");
+		Assert::AreEqual(std::string("2:100663298:1"), lines[1], L"second method");
+	}
+
+	TEST_METHOD(OnlyNewCallsAreCollected)
+	{
+		CallCounter counter;
+		UINT_PTR first = 0;
+		UINT_PTR second = 0;
+		counter.addMethod(1, 0x06000001, &first);
+		counter.addMethod(1, 0x06000002, &second);
+		counter.countCall(first);
+
+		std::vector<std::string> lines;
+		counter.collectCalls(lines);
+		lines.clear();
+
+		counter.countCall(second);
+		counter.countCall(second);
+		counter.collectCalls(lines);
+		Assert::AreEqual(static_cast<size_t>(1), lines.size(), L"called methods");
+		Assert::AreEqual(std::string("1:100663298:2"), lines[0], L"second method");
+	}
+
+	TEST_METHOD(MethodsBeyondTheFirstPageAreCounted)
+	{
+		CallCounter counter;
+		UINT_PTR id = 0;
+		for (size_t i = 0; i <= CallCounter::PAGE_SIZE; i++) {
+			counter.addMethod(1, 0x06000001 + static_cast<mdToken>(i), &id);
+		}
+		counter.countCall(id);
+
+		std::vector<std::string> lines;
+		counter.collectCalls(lines);
+		Assert::AreEqual(static_cast<size_t>(1), lines.size(), L"called methods");
+		Assert::AreEqual(std::string("1:100667393:1"), lines[0], L"last method");
+	}
+};
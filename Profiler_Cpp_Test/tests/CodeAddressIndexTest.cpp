@@ -0,0 +1,40 @@
+#include "CppUnitTest.h"
+#include "sampling/CodeAddressIndex.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+TEST_CLASS(CodeAddressIndexTest)
+{
+public:
+
+	TEST_METHOD(AddressesAreMappedToTheirFunction)
+	{
+		CodeAddressIndex index;
+		Assert::IsTrue(index.add(0x10000, 0x40, 1), L"first function");
+		Assert::IsTrue(index.add(0x10040, 0x20, 2), L"second function on the same page");
+
+		Assert::AreEqual(static_cast<FunctionID>(1), index.find(0x10000), L"start");
+		Assert::AreEqual(static_cast<FunctionID>(1), index.find(0x1003F), L"last byte");
+		Assert::AreEqual(static_cast<FunctionID>(2), index.find(0x10040), L"next function");
+		Assert::AreEqual(static_cast<FunctionID>(0), index.find(0x10060), L"after the code");
+		Assert::AreEqual(static_cast<FunctionID>(0), index.find(0x20000), L"unknown page");
+	}
+
+	TEST_METHOD(RangesSpanningPagesAreFoundOnEachPage)
+	{
+		CodeAddressIndex index;
+		Assert::IsTrue(index.add(0x10F00, 0x2200, 3), L"add");
+
+		Assert::AreEqual(static_cast<FunctionID>(3), index.find(0x10F00), L"first page");
+		Assert::AreEqual(static_cast<FunctionID>(3), index.find(0x11800), L"middle page");
+		Assert::AreEqual(static_cast<FunctionID>(3), index.find(0x130FF), L"last page");
+		Assert::AreEqual(static_cast<FunctionID>(0), index.find(0x13100), L"after the code");
+	}
+
+	TEST_METHOD(FullIndexRejectsRanges)
+	{
+		CodeAddressIndex index(2);
+		Assert::IsTrue(index.add(0x10000, 0x10, 1), L"first range");
+		Assert::IsFalse(index.add(0x10FF0, 0x20, 2), L"needs two more ranges");
+	}
+};
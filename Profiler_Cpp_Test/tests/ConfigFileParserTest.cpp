@@ -86,6 +86,7 @@ match:
 private:
 
 	ConfigFile parse(std::string content) {
-		return ConfigParser::parse(std::stringstream(content));
+		std::stringstream stream(content);
+		return ConfigParser::parse(stream);
 	}
 };
\ No newline at end of file
@@ -155,7 +155,11 @@ match:
       targetdir: forward
 )", emptyEnvironment);
 
+#ifdef _WIN32
 		Assert::AreEqual(std::string("backward"), config.getTargetDir(), L"Should match paths using backward slashes");
+#else
+		Assert::AreEqual(std::string("forward"), config.getTargetDir(), L"Should match paths using forward slashes");
+#endif
 	}
 
 	TEST_METHOD(ConfigProblemsMustBeLoggable)
@@ -223,16 +227,103 @@ match:
 		Assert::AreEqual(false, config.shouldUseLightMode(), L"should not use light mode when overwritten in config file");
 	}
 
+	TEST_METHOD(SpoolTimeoutHasDefault)
+	{
+		Config config = parse("", emptyEnvironment);
+
+		Assert::AreEqual(size_t(500), config.getSpoolTimeout(), L"should use default spool timeout");
+	}
+
+	TEST_METHOD(InvalidNumericOptionFallsBackToDefault)
+	{
+		Config config = parse(R"(
+match:
+  - executablePathRegex: ".*"
+    profiler:
+      spool_timeout: soon
+      eagerness: 10
+)", emptyEnvironment);
+
+		Assert::AreEqual(size_t(500), config.getSpoolTimeout(), L"should use default spool timeout");
+		Assert::AreEqual(size_t(10), config.getEagerness(), L"should use configured eagerness");
+		Assert::AreEqual(size_t(1), config.getProblems().size(), L"must log a problem for the invalid value");
+	}
+
+	TEST_METHOD(SpoolTimeoutIsLimitedToTheShutdownWait)
+	{
+		Config config = parse(R"(
+match:
+  - executablePathRegex: ".*"
+    profiler:
+      spool_timeout: 4000
+)", emptyEnvironment);
+		Assert::AreEqual(size_t(4000), config.getSpoolTimeout(), L"should use largest allowed timeout");
+		Assert::AreEqual(size_t(0), config.getProblems().size(), L"no problem for the largest allowed timeout");
+
+		config = parse(R"(
+match:
+  - executablePathRegex: ".*"
+    profiler:
+      spool_timeout: 60000
+)", emptyEnvironment);
+		Assert::AreEqual(size_t(4000), config.getSpoolTimeout(), L"should use largest allowed timeout instead");
+		Assert::AreEqual(size_t(1), config.getProblems().size(), L"must log a problem for the oversized timeout");
+	}
+
+	TEST_METHOD(SamplingRateMustBeAFraction)
+	{
+		Assert::AreEqual(1.0, parse("", emptyEnvironment).getSamplingRate(), L"should profile all processes by default");
+
+		Config config = parse(R"(
+match:
+  - executablePathRegex: ".*"
+    profiler:
+      sampling_rate: 0.25
+)", emptyEnvironment);
+		Assert::AreEqual(0.25, config.getSamplingRate(), L"should use configured rate");
+
+		config = parse(R"(
+match:
+  - executablePathRegex: ".*"
+    profiler:
+      sampling_rate: 25
+)", emptyEnvironment);
+		Assert::AreEqual(1.0, config.getSamplingRate(), L"should use default for rate above 1");
+		Assert::AreEqual(size_t(1), config.getProblems().size(), L"must log a problem for the invalid rate");
+	}
+
+	TEST_METHOD(NumbersMustBeNonNegativeAndFitInto32Bits)
+	{
+		Config config = parse(R"(
+match:
+  - executablePathRegex: ".*"
+    profiler:
+      eagerness: -1
+      startup_jit_order: 4294967296
+      jit_costs: 12abc
+      sampling_interval: 4294967295
+)", emptyEnvironment);
+		Assert::AreEqual(size_t(0), config.getEagerness(), L"should use default for negative number");
+		Assert::AreEqual(size_t(0), config.getStartupJitOrderSeconds(), L"should use default for number above 32 bits");
+		Assert::AreEqual(size_t(0), config.getJitCostMethods(), L"should use default for trailing garbage");
+		Assert::AreEqual(size_t(4294967295u), config.getSamplingInterval(), L"should use largest 32 bit number");
+		Assert::AreEqual(size_t(3), config.getProblems().size(), L"must log a problem for each invalid number");
+	}
+
 private:
 
 	Config parse(std::string yaml, EnvironmentVariableReader* reader) {
 		Config config(reader);
 		std::stringstream stream(yaml);
+#ifdef _WIN32
 		config.load(stream, "c:\\company\\program.exe");
+#else
+		config.load(stream, "/company/program.exe");
+#endif
 		return config;
 	}
 
-	static std::string emptyEnvironment(std::string suffix) {
+	static std::string emptyEnvironment(std::string) {
 		return "";
 	};
 };
\ No newline at end of file
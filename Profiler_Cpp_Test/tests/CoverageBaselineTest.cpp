@@ -0,0 +1,104 @@
+#include "CppUnitTest.h"
+#include "coverage/CoverageBaseline.h"
+#include "platform/Platform.h"
+#include <string>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+TEST_CLASS(CoverageBaselineTest)
+{
+public:
+
+	TEST_METHOD_CLEANUP(RemoveTestDirectory)
+	{
+		std::string directory = getTestDirectory();
+		removeFiles(directory);
+		Platform::removeDirectory(directory);
+	}
+
+	TEST_METHOD(ReportedMethodsAreKnownToTheNextRun)
+	{
+		std::string directory = createEmptyDirectory();
+		CoverageBaseline firstRun;
+		Assert::IsTrue(firstRun.open(directory), L"open");
+		firstRun.addAssembly(1, MVID, 100);
+		Assert::IsFalse(firstRun.contains(1, 0x06000005), L"empty baseline");
+		firstRun.add(1, 0x06000005);
+		firstRun.add(1, 0x06000005);
+		firstRun.add(1, 0x06000064);
+		Assert::AreEqual(static_cast<size_t>(2), firstRun.getAddedMethodCount(), L"added");
+		Assert::IsFalse(firstRun.contains(1, 0x06000005), L"unchanged until saved");
+		size_t failedCount = 0;
+		Assert::AreEqual(static_cast<size_t>(1), firstRun.save(failedCount), L"saved");
+		Assert::AreEqual(static_cast<size_t>(0), failedCount, L"failed");
+
+		// the module may get another number in the next run
+		CoverageBaseline secondRun;
+		Assert::IsTrue(secondRun.open(directory), L"reopen");
+		secondRun.addAssembly(3, MVID, 100);
+		Assert::IsTrue(secondRun.contains(3, 0x06000005), L"first method");
+		Assert::IsTrue(secondRun.contains(3, 0x06000064), L"last method");
+		Assert::IsFalse(secondRun.contains(3, 0x06000006), L"unreported method");
+		Assert::IsFalse(secondRun.contains(1, 0x06000005), L"other assembly");
+	}
+
+	TEST_METHOD(ConcurrentRunsAreMerged)
+	{
+		std::string directory = createEmptyDirectory();
+		CoverageBaseline first;
+		CoverageBaseline second;
+		Assert::IsTrue(first.open(directory) && second.open(directory), L"open");
+		first.addAssembly(1, MVID, 10);
+		second.addAssembly(1, MVID, 10);
+		first.add(1, 0x06000001);
+		second.add(1, 0x06000002);
+		size_t failedCount = 0;
+		first.save(failedCount);
+		second.save(failedCount);
+
+		CoverageBaseline next;
+		Assert::IsTrue(next.open(directory), L"reopen");
+		next.addAssembly(1, MVID, 10);
+		Assert::IsTrue(next.contains(1, 0x06000001) && next.contains(1, 0x06000002), L"both runs");
+	}
+
+	TEST_METHOD(BaselineOfOtherModuleVersionIsIgnored)
+	{
+		std::string directory = createEmptyDirectory();
+		CoverageBaseline firstRun;
+		Assert::IsTrue(firstRun.open(directory), L"open");
+		firstRun.addAssembly(1, MVID, 10);
+		firstRun.add(1, 0x06000001);
+		firstRun.add(1, 0x06000020);
+		Assert::AreEqual(static_cast<size_t>(1), firstRun.getAddedMethodCount(), L"out of range RID");
+		size_t failedCount = 0;
+		firstRun.save(failedCount);
+
+		CoverageBaseline secondRun;
+		Assert::IsTrue(secondRun.open(directory), L"reopen");
+		secondRun.addAssembly(1, MVID, 11);
+		Assert::IsFalse(secondRun.contains(1, 0x06000001), L"different method count");
+	}
+
+private:
+	static const char* const MVID;
+
+	static std::string getTestDirectory() {
+		return Platform::getTempDirectory() + "CoverageBaselineTest";
+	}
+
+	static std::string createEmptyDirectory() {
+		std::string directory = getTestDirectory();
+		Platform::createDirectory(directory);
+		removeFiles(directory);
+		return directory;
+	}
+
+	static void removeFiles(const std::string& directory) {
+		for (const std::string& file : Platform::listFiles(directory)) {
+			Platform::removeFile(directory + Platform::PATH_SEPARATOR + file);
+		}
+	}
+};
+
+const char* const CoverageBaselineTest::MVID = "0b0fc2a3-5e3c-4a43-9c31-6a0c1b5f2d7e";
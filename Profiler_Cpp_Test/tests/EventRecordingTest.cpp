@@ -0,0 +1,76 @@
+#include "CppUnitTest.h"
+#include "recording/EventRecording.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+TEST_CLASS(EventRecordingTest)
+{
+public:
+
+	TEST_METHOD(EventsSurviveRoundTrip)
+	{
+		RecordedEvent assemblyLoad;
+		assemblyLoad.type = EVENT_ASSEMBLY_LOAD;
+		assemblyLoad.threadId = 4711;
+		assemblyLoad.timestamp = 123456789;
+		assemblyLoad.assemblyId = 0x7FF812345678;
+		assemblyLoad.moduleId = 0x7FF8AAAA0000;
+		assemblyLoad.assemblyName = L"mscorlib";
+		assemblyLoad.assemblyPath = L"C:\\Windows\\mscorlib.dll";
+		assemblyLoad.version[0] = 4;
+		assemblyLoad.version[3] = 65535;
+
+		RecordedEvent inlining;
+		inlining.type = EVENT_JIT_INLINING;
+		inlining.callerId = 5;
+		inlining.functionId = 0xFFFFFFFFFFFFFFFF;
+		inlining.moduleId = 7;
+		inlining.functionToken = 0x06000123;
+
+		std::string buffer;
+		EventRecording::writeHeader(buffer);
+		EventRecording::writeEvent(assemblyLoad, buffer);
+		EventRecording::writeEvent(inlining, buffer);
+
+		const char* position = buffer.data();
+		const char* end = position + buffer.size();
+		RecordedEvent event;
+		Assert::IsTrue(EventRecording::readHeader(position, end), L"header");
+
+		Assert::IsTrue(EventRecording::readEvent(position, end, &event), L"assembly load");
+		Assert::AreEqual(4711u, event.threadId, L"thread ID");
+		Assert::AreEqual(123456789ull, event.timestamp, L"timestamp");
+		Assert::AreEqual(0x7FF812345678ull, event.assemblyId, L"assembly ID");
+		Assert::AreEqual(std::wstring(L"C:\\Windows\\mscorlib.dll"), event.assemblyPath, L"path");
+		Assert::AreEqual(65535, static_cast<int>(event.version[3]), L"revision");
+
+		Assert::IsTrue(EventRecording::readEvent(position, end, &event), L"inlining");
+		Assert::AreEqual(5ull, event.callerId, L"caller");
+		Assert::AreEqual(0xFFFFFFFFFFFFFFFFull, event.functionId, L"callee");
+		Assert::AreEqual(0x06000123u, event.functionToken, L"token");
+
+		Assert::IsFalse(EventRecording::readEvent(position, end, &event), L"end of recording");
+	}
+
+	TEST_METHOD(TruncatedEventIsNotRead)
+	{
+		RecordedEvent jitCompilation;
+		jitCompilation.functionId = 0x7FF812345678;
+
+		std::string buffer;
+		EventRecording::writeEvent(jitCompilation, buffer);
+		buffer.pop_back();
+
+		const char* position = buffer.data();
+		RecordedEvent event;
+		Assert::IsFalse(EventRecording::readEvent(position, position + buffer.size(), &event), L"truncated event");
+		Assert::IsTrue(position == buffer.data(), L"position must not advance");
+	}
+
+	TEST_METHOD(OtherFilesAreRejected)
+	{
+		std::string buffer = "Info=Teamscale .NET Profiler";
+		const char* position = buffer.data();
+		Assert::IsFalse(EventRecording::readHeader(position, position + buffer.size()), L"trace file is no recording");
+	}
+};
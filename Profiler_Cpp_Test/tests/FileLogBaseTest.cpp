@@ -0,0 +1,238 @@
+#include "CppUnitTest.h"
+#include "log/FileLogBase.h"
+#include "platform/Platform.h"
+#include "utils/StringUtils.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+/** Exposes the protected methods of the log and spools below the given temp directory. */
+class TestLog : public FileLogBase {
+public:
+	TestLog(const std::string& tempDirectory) {
+		this->tempDirectory = tempDirectory + Platform::PATH_SEPARATOR;
+		retryIntervalMillis = 10;
+	}
+
+	void create(const std::string& directory) {
+		createLogFile(directory, "test.log", true, 100);
+	}
+
+	void write(const char* text) {
+		writeToFile(text);
+	}
+
+	void writeTuple(const char* key, const char* value) {
+		writeTupleToFile(key, value);
+	}
+
+	size_t getProblemCount() {
+		problemSection.lock();
+		size_t count = problems.size();
+		problemSection.unlock();
+		return count;
+	}
+
+protected:
+	virtual void logOpenProblem(const std::string& message) override {
+		problemSection.lock();
+		problems.push_back(message);
+		problemSection.unlock();
+	}
+
+private:
+	Mutex problemSection;
+	std::vector<std::string> problems;
+};
+
+TEST_CLASS(FileLogBaseTest)
+{
+public:
+
+	TEST_METHOD_CLEANUP(RemoveTestDirectory)
+	{
+		std::string directory = getTestDirectory();
+		removeDirectoryWithFiles(getSpoolDirectory(directory + Platform::PATH_SEPARATOR + "temp"));
+		removeDirectoryWithFiles(directory + Platform::PATH_SEPARATOR + "temp" + Platform::PATH_SEPARATOR + "TeamscaleProfilerSpool");
+		removeDirectoryWithFiles(directory + Platform::PATH_SEPARATOR + "temp");
+		removeDirectoryWithFiles(directory + Platform::PATH_SEPARATOR + "target");
+		removeDirectoryWithFiles(directory);
+	}
+
+	TEST_METHOD(OutputWrittenWhileOpeningIsKept)
+	{
+		std::string directory = createEmptyDirectory();
+		std::string target = directory + Platform::PATH_SEPARATOR + "target";
+		Platform::createDirectory(target);
+
+		TestLog log(directory + Platform::PATH_SEPARATOR + "temp");
+		log.create(target);
+		log.write("a");
+		log.shutdown();
+		log.write("b");
+		Assert::AreEqual(std::string("a"), readFile(target + Platform::PATH_SEPARATOR + "test.log"), L"content");
+		Assert::AreEqual(static_cast<size_t>(0), log.getProblemCount(), L"problems");
+	}
+
+	TEST_METHOD(SpoolIsMigratedOnceTargetIsAvailable)
+	{
+		std::string directory = createEmptyDirectory();
+		std::string target = directory + Platform::PATH_SEPARATOR + "target";
+		std::string temp = directory + Platform::PATH_SEPARATOR + "temp";
+		Platform::createDirectory(temp);
+		std::string spoolPath = getSpoolDirectory(temp) + Platform::PATH_SEPARATOR + std::to_string(Platform::getProcessId()) + ".test.log";
+		std::string targetPath = target + Platform::PATH_SEPARATOR + "test.log";
+
+		TestLog log(temp);
+		log.create(target);
+		log.write("a");
+		Assert::IsTrue(waitUntil([&] { return readFile(spoolPath) == "a"; }), L"spooled");
+
+		Platform::createDirectory(target);
+		Assert::IsTrue(waitUntil([&] { return readFile(targetPath) == "a"; }), L"migrated");
+		log.write("b");
+		log.shutdown();
+		Assert::AreEqual(std::string("ab"), readFile(targetPath), L"content");
+		Assert::IsFalse(Platform::isFile(spoolPath), L"spool removed");
+		Assert::AreEqual(static_cast<size_t>(0), log.getProblemCount(), L"problems");
+	}
+
+	TEST_METHOD(OnlyOutputInTheTargetDirectoryIsFlushedToTarget)
+	{
+		std::string directory = createEmptyDirectory();
+		std::string target = directory + Platform::PATH_SEPARATOR + "target";
+		std::string temp = directory + Platform::PATH_SEPARATOR + "temp";
+		Platform::createDirectory(temp);
+		std::string spoolPath = getSpoolDirectory(temp) + Platform::PATH_SEPARATOR + std::to_string(Platform::getProcessId()) + ".test.log";
+
+		TestLog log(temp);
+		log.create(target);
+		log.write("a");
+		Assert::IsTrue(waitUntil([&] { return readFile(spoolPath) == "a"; }), L"spooled");
+		Assert::IsFalse(log.flushToTarget(), L"spooled output");
+
+		Platform::createDirectory(target);
+		Assert::IsTrue(waitUntil([&] { return !Platform::isFile(spoolPath); }), L"migrated");
+		Assert::IsTrue(log.flushToTarget(), L"migrated output");
+		log.shutdown();
+		Assert::IsFalse(log.flushToTarget(), L"closed");
+	}
+
+	TEST_METHOD(LongValuesAreWrittenAsOneCompleteLine)
+	{
+		std::string directory = createEmptyDirectory();
+		std::string target = directory + Platform::PATH_SEPARATOR + "target";
+		Platform::createDirectory(target);
+		std::string longValue;
+		for (int i = 0; i < 1000; i++) {
+			longValue += "frame" + std::to_string(i) + ";";
+		}
+		longValue += "leaf 1";
+
+		TestLog log(directory + Platform::PATH_SEPARATOR + "temp");
+		log.create(target);
+		log.writeTuple("Stack", longValue.c_str());
+		log.writeTuple("Info", "next");
+		log.shutdown();
+
+		std::vector<std::string> lines = readLines(target + Platform::PATH_SEPARATOR + "test.log");
+		Assert::AreEqual(static_cast<size_t>(2), lines.size(), L"line count");
+		Assert::AreEqual("Stack=" + longValue, lines[0], L"long line");
+		Assert::AreEqual(std::string("Info=next"), lines[1], L"next line");
+	}
+
+	TEST_METHOD(OutputStaysInMemoryIfNoSpoolFileCanBeCreated)
+	{
+		std::string directory = createEmptyDirectory();
+		std::string target = directory + Platform::PATH_SEPARATOR + "target";
+		// a file where the temp directory should be, so nothing can be created below it
+		std::string blocked = directory + Platform::PATH_SEPARATOR + "blocked";
+		File blocker;
+		Assert::IsTrue(blocker.open(blocked, File::OVERWRITE), L"blocker");
+		blocker.close();
+
+		TestLog log(blocked);
+		log.create(target);
+		log.write("a");
+		Assert::IsTrue(waitUntil([&] { return log.getProblemCount() > 0; }), L"problem logged");
+		log.write("b");
+
+		Platform::createDirectory(target);
+		std::string targetPath = target + Platform::PATH_SEPARATOR + "test.log";
+		Assert::IsTrue(waitUntil([&] { return readFile(targetPath) == "ab"; }), L"written once available");
+		log.shutdown();
+		Assert::AreEqual(static_cast<size_t>(1), log.getProblemCount(), L"logged only once");
+	}
+
+private:
+
+	static std::string getTestDirectory() {
+		return Platform::getTempDirectory() + "FileLogBaseTest";
+	}
+
+	static std::string createEmptyDirectory() {
+		std::string directory = getTestDirectory();
+		Platform::createDirectory(directory);
+		for (const std::string& file : Platform::listFiles(directory)) {
+			Platform::removeFile(directory + Platform::PATH_SEPARATOR + file);
+		}
+		return directory;
+	}
+
+	/** The spool directory that FileLogBase uses for the target directory below the given temp directory. */
+	static std::string getSpoolDirectory(const std::string& temp) {
+		std::string target = getTestDirectory() + Platform::PATH_SEPARATOR + "target";
+		return temp + Platform::PATH_SEPARATOR + "TeamscaleProfilerSpool" + Platform::PATH_SEPARATOR +
+			std::to_string(std::hash<std::string>()(StringUtils::uppercase(target)));
+	}
+
+	static void removeDirectoryWithFiles(const std::string& directory) {
+		for (const std::string& file : Platform::listFiles(directory)) {
+			Platform::removeFile(directory + Platform::PATH_SEPARATOR + file);
+		}
+		Platform::removeDirectory(directory);
+	}
+
+	/** Polls the given condition for up to five seconds. */
+	static bool waitUntil(std::function<bool()> condition) {
+		for (int i = 0; i < 500; i++) {
+			if (condition()) {
+				return true;
+			}
+			Platform::sleep(10);
+		}
+		return condition();
+	}
+
+	/** Splits the file into its CRLF-terminated lines. An unterminated last line is returned as well. */
+	static std::vector<std::string> readLines(const std::string& path) {
+		std::string content = readFile(path);
+		std::vector<std::string> lines;
+		size_t start = 0;
+		size_t end;
+		while ((end = content.find("\r\n", start)) != std::string::npos) {
+			lines.push_back(content.substr(start, end - start));
+			start = end + 2;
+		}
+		if (start < content.size()) {
+			lines.push_back(content.substr(start));
+		}
+		return lines;
+	}
+
+	static std::string readFile(const std::string& path) {
+		File file;
+		if (!file.open(path, File::READ)) {
+			return "";
+		}
+		std::string content;
+		char buffer[256];
+		int length;
+		while ((length = file.read(buffer, sizeof(buffer))) > 0) {
+			content.append(buffer, length);
+		}
+		return content;
+	}
+};
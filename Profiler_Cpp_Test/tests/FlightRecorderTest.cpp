@@ -0,0 +1,78 @@
+#include "CppUnitTest.h"
+#include "platform/Thread.h"
+#include "utils/FlightRecorder.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+TEST_CLASS(FlightRecorderTest)
+{
+public:
+
+	TEST_METHOD(ErrorsKeepTheirStack)
+	{
+		std::unique_ptr<FlightRecorder> recorder(new FlightRecorder());
+		recorder->recordEvent("Initialize");
+		recorder->recordError("Error in JITCompilationFinished");
+
+		std::vector<FlightRecorder::Entry> entries = recorder->getEntriesAfter(0);
+		Assert::AreEqual(static_cast<size_t>(2), entries.size(), L"entries");
+		Assert::AreEqual(std::string("Initialize"), std::string(entries[0].message), L"event");
+		Assert::IsFalse(entries[0].isError, L"event is no error");
+		Assert::AreEqual(0, entries[0].frameCount, L"no stack for events");
+		Assert::IsTrue(entries[1].isError, L"error");
+		Assert::IsTrue(entries[1].frameCount > 0 && entries[1].frames[0] != NULL, L"stack of error");
+		Assert::AreEqual(static_cast<uint64_t>(1), recorder->getErrorCount(), L"errors");
+
+		Assert::AreEqual(static_cast<size_t>(1), recorder->getEntriesAfter(1).size(), L"after first");
+		Assert::AreEqual(static_cast<size_t>(0), recorder->getEntriesAfter(2).size(), L"after last");
+
+		recorder->recordEvent(std::string(500, 'x').c_str());
+		Assert::AreEqual(FlightRecorder::MESSAGE_LENGTH - 1, std::string(recorder->getEntriesAfter(2)[0].message).size(), L"truncated");
+	}
+
+	TEST_METHOD(OnlyTheMostRecentEntriesAreKept)
+	{
+		std::unique_ptr<FlightRecorder> recorder(new FlightRecorder());
+		for (size_t i = 0; i < FlightRecorder::CAPACITY + 10; i++) {
+			recorder->recordEvent(std::to_string(i).c_str());
+		}
+		std::vector<FlightRecorder::Entry> entries = recorder->getEntriesAfter(0);
+		Assert::AreEqual(FlightRecorder::CAPACITY, entries.size(), L"capacity");
+		Assert::AreEqual(std::string("10"), std::string(entries.front().message), L"oldest");
+		Assert::AreEqual(static_cast<uint64_t>(11), entries.front().sequence, L"oldest sequence");
+		Assert::AreEqual(std::to_string(FlightRecorder::CAPACITY + 9), std::string(entries.back().message), L"newest");
+	}
+
+	TEST_METHOD(ConcurrentRecordingKeepsEntriesIntact)
+	{
+		std::unique_ptr<FlightRecorder> recorder(new FlightRecorder());
+		Thread threads[4];
+		for (Thread& thread : threads) {
+			Assert::IsTrue(thread.start(recordErrors, recorder.get()), L"start");
+		}
+		for (Thread& thread : threads) {
+			Assert::IsTrue(thread.join(10000), L"join");
+		}
+
+		Assert::AreEqual(static_cast<uint64_t>(4 * ERRORS_PER_THREAD), recorder->getErrorCount(), L"errors");
+		// a thread that is interrupted while the others wrap around the buffer loses its slot
+		std::vector<FlightRecorder::Entry> entries = recorder->getEntriesAfter(0);
+		Assert::IsTrue(entries.size() > FlightRecorder::CAPACITY / 2 && entries.size() <= FlightRecorder::CAPACITY, L"capacity");
+		for (const FlightRecorder::Entry& entry : entries) {
+			Assert::AreEqual(std::string("Error in test"), std::string(entry.message), L"message");
+		}
+	}
+
+private:
+	static const int ERRORS_PER_THREAD = 1000;
+
+	static void recordErrors(void* parameter) {
+		FlightRecorder* recorder = static_cast<FlightRecorder*>(parameter);
+		for (int i = 0; i < ERRORS_PER_THREAD; i++) {
+			recorder->recordError("Error in test");
+		}
+	}
+};
@@ -0,0 +1,137 @@
+#include "CppUnitTest.h"
+#include "coverage/ILMethodBody.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+TEST_CLASS(ILMethodBodyTest)
+{
+public:
+
+	TEST_METHOD(TinyMethodIsWrittenWithFatHeader)
+	{
+		// nop, ldc.i4.1, ret
+		std::vector<BYTE> body = { (3 << 2) | CorILMethod_TinyFormat, 0x00, 0x17, 0x2A };
+
+		ILMethodBody method;
+		Assert::IsTrue(method.parse(body.data(), static_cast<ULONG>(body.size())), L"parse");
+		Assert::AreEqual(static_cast<size_t>(3), method.code.size(), L"code size");
+		Assert::AreEqual(8, static_cast<int>(method.maxStack), L"tiny max stack");
+
+		method.insertAtStart({ 0x17, 0x26 }, 1);
+		std::vector<BYTE> written;
+		method.write(written);
+
+		ILMethodBody reparsed;
+		Assert::IsTrue(reparsed.parse(written.data(), static_cast<ULONG>(written.size())), L"reparse");
+		Assert::AreEqual(0x3003, written[0] | (written[1] << 8), L"fat header flags");
+		Assert::AreEqual(static_cast<size_t>(5), reparsed.code.size(), L"code size after insertion");
+		Assert::AreEqual(0x17, static_cast<int>(reparsed.code[0]), L"inserted code comes first");
+		Assert::AreEqual(0x2A, static_cast<int>(reparsed.code[4]), L"original code follows");
+	}
+
+	TEST_METHOD(ExceptionClausesAreMoved)
+	{
+		std::vector<BYTE> body = {
+			// fat header with more sections and init locals, max stack 2, 8 bytes of code, local signature 0x11000001
+			0x1B, 0x30, 0x02, 0x00, 0x08, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x11,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2A,
+			// small exception section with a filter clause: try 1+2, handler 4+3, filter at 3
+			0x01, 0x10, 0x00, 0x00,
+			0x01, 0x00, 0x01, 0x00, 0x02, 0x04, 0x00, 0x03, 0x03, 0x00, 0x00, 0x00,
+		};
+
+		ILMethodBody method;
+		Assert::IsTrue(method.parse(body.data(), static_cast<ULONG>(body.size())), L"parse");
+		Assert::AreEqual(static_cast<size_t>(1), method.exceptionClauses.size(), L"clause count");
+
+		method.insertAtStart(std::vector<BYTE>(12, 0x00), 2);
+		std::vector<BYTE> written;
+		method.write(written);
+
+		ILMethodBody reparsed;
+		Assert::IsTrue(reparsed.parse(written.data(), static_cast<ULONG>(written.size())), L"reparse");
+		Assert::IsTrue(reparsed.initLocals, L"init locals");
+		Assert::AreEqual(0x11000001u, static_cast<unsigned int>(reparsed.localVarSigToken), L"local signature");
+		Assert::AreEqual(static_cast<size_t>(1), reparsed.exceptionClauses.size(), L"clause count after insertion");
+
+		ExceptionClause clause = reparsed.exceptionClauses[0];
+		Assert::AreEqual(13u, static_cast<unsigned int>(clause.tryOffset), L"try offset");
+		Assert::AreEqual(2u, static_cast<unsigned int>(clause.tryLength), L"try length");
+		Assert::AreEqual(16u, static_cast<unsigned int>(clause.handlerOffset), L"handler offset");
+		Assert::AreEqual(15u, static_cast<unsigned int>(clause.classTokenOrFilterOffset), L"filter offset");
+	}
+
+	TEST_METHOD(BasicBlocksAreFound)
+	{
+		ILMethodBody method = createLoop();
+		std::vector<ULONG> blocks;
+		Assert::IsTrue(method.findBasicBlocks(blocks), L"decode");
+		Assert::AreEqual(static_cast<size_t>(4), blocks.size(), L"block count");
+		Assert::AreEqual(0u, static_cast<unsigned int>(blocks[0]), L"start");
+		Assert::AreEqual(4u, static_cast<unsigned int>(blocks[1]), L"loop body after branch");
+		Assert::AreEqual(7u, static_cast<unsigned int>(blocks[2]), L"branch target");
+		Assert::AreEqual(10u, static_cast<unsigned int>(blocks[3]), L"after conditional branch");
+	}
+
+	TEST_METHOD(BranchesTargetInsertedCode)
+	{
+		ILMethodBody method = createLoop();
+		std::vector<BYTE> nops = { 0x00, 0x00 };
+		Assert::IsTrue(method.insertAt({ 0, 4, 7, 10 }, { nops, nops, nops, nops }, 2), L"insert");
+		Assert::AreEqual(static_cast<size_t>(25), method.code.size(), L"code size with widened branches");
+		Assert::AreEqual(10, static_cast<int>(method.maxStack), L"max stack");
+
+		// br.s 7 became br to the code inserted before offset 7
+		Assert::AreEqual(0x38, static_cast<int>(method.code[4]), L"widened br");
+		Assert::AreEqual(5, readInt(method.code, 5), L"forward branch");
+
+		// brtrue.s 4 became brtrue to the code inserted before offset 4
+		Assert::AreEqual(0x3A, static_cast<int>(method.code[17]), L"widened brtrue");
+		Assert::AreEqual(-13, readInt(method.code, 18), L"backward branch");
+		Assert::AreEqual(0x2A, static_cast<int>(method.code[24]), L"ret");
+	}
+
+	TEST_METHOD(InsertingAtNoInstructionFails)
+	{
+		ILMethodBody method = createLoop();
+		Assert::IsFalse(method.insertAt({ 3 }, { { 0x00 } }, 0), L"offset within br.s");
+		Assert::AreEqual(static_cast<size_t>(11), method.code.size(), L"unchanged");
+	}
+
+	TEST_METHOD(UnknownSectionsAreRejected)
+	{
+		std::vector<BYTE> body = {
+			0x0B, 0x30, 0x02, 0x00, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x2A,
+			// optimized IL table
+			0x02, 0x04, 0x00, 0x00,
+		};
+
+		ILMethodBody method;
+		Assert::IsFalse(method.parse(body.data(), static_cast<ULONG>(body.size())), L"unknown section");
+	}
+
+private:
+
+	/** Creates a method with a loop: i = 0; while (i) { i + 1; } */
+	static ILMethodBody createLoop() {
+		ILMethodBody method;
+		method.code = {
+			0x16, // 0: ldc.i4.0
+			0x0A, // 1: stloc.0
+			0x2B, 0x03, // 2: br.s 7
+			0x06, // 4: ldloc.0
+			0x17, // 5: ldc.i4.1
+			0x26, // 6: pop
+			0x06, // 7: ldloc.0
+			0x2D, 0xFA, // 8: brtrue.s 4
+			0x2A, // 10: ret
+		};
+		method.maxStack = 8;
+		return method;
+	}
+
+	static int readInt(const std::vector<BYTE>& code, size_t offset) {
+		return code[offset] | (code[offset + 1] << 8) | (code[offset + 2] << 16) | (code[offset + 3] << 24);
+	}
+};
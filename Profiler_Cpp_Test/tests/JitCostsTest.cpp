@@ -0,0 +1,70 @@
+#include "CppUnitTest.h"
+#include "utils/JitCosts.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+TEST_CLASS(JitCostsTest)
+{
+public:
+
+	TEST_METHOD(OnlyTheMostExpensiveMethodsAreKept)
+	{
+		JitCosts costs;
+		costs.enable(2);
+		costs.recordMethod(1, 0x06000001, 300, 10);
+		costs.recordMethod(1, 0x06000002, 100, 20);
+		costs.recordMethod(2, 0x06000003, 500, 30);
+		costs.recordMethod(2, 0x06000004, 200, 40);
+
+		// one cycle per microsecond
+		std::vector<std::string> lines;
+		costs.createMethodReport(1000, lines);
+		Assert::AreEqual(static_cast<size_t>(2), lines.size(), L"top methods");
+		Assert::AreEqual(std::string("2:100663299:500:30"), lines[0], L"most expensive");
+		Assert::AreEqual(std::string("1:100663297:300:10"), lines[1], L"second most expensive");
+	}
+
+	TEST_METHOD(CostsAreSummedPerAssembly)
+	{
+		JitCosts costs;
+		costs.enable(1);
+		costs.recordMethod(1, 0x06000001, 300, 10);
+		costs.recordMethod(1, 0x06000002, 100, 20);
+		costs.recordMethod(2, 0x06000003, 500, 30);
+
+		std::vector<std::string> lines;
+		costs.createAssemblyReport(1000, lines);
+		Assert::AreEqual(static_cast<size_t>(2), lines.size(), L"assemblies");
+		Assert::AreEqual(std::string("2:1:500:30"), lines[0], L"most expensive");
+		Assert::AreEqual(std::string("1:2:400:30"), lines[1], L"summed up");
+	}
+
+	TEST_METHOD(NestedCompilationsAreMeasuredSeparately)
+	{
+		JitCosts costs;
+		costs.enable(2);
+		costs.recordStart(1, 1000);
+		costs.recordStart(2, 1100);
+		costs.recordFinish(2, 1300, 1, 0x06000002, 0);
+		costs.recordFinish(1, 1500, 1, 0x06000001, 0);
+		costs.recordFinish(3, 1600, 1, 0x06000003, 0);
+
+		std::vector<std::string> lines;
+		costs.createMethodReport(1000, lines);
+		Assert::AreEqual(static_cast<size_t>(2), lines.size(), L"started methods only");
+		Assert::AreEqual(std::string("1:100663297:500:0"), lines[0], L"outer");
+		Assert::AreEqual(std::string("1:100663298:200:0"), lines[1], L"inner");
+	}
+
+	TEST_METHOD(CompilationIsStartedUntilFinished)
+	{
+		JitCosts costs;
+		costs.enable(1);
+		Assert::IsFalse(costs.isStarted(1), L"before start");
+		costs.recordStart(1, 1000);
+		Assert::IsTrue(costs.isStarted(1), L"started");
+		Assert::IsFalse(costs.isStarted(2), L"other function");
+		costs.recordFinish(1, 1500, 1, 0x06000001, 0);
+		Assert::IsFalse(costs.isStarted(1), L"finished");
+	}
+};
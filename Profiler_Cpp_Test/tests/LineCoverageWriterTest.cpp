@@ -0,0 +1,68 @@
+#include "CppUnitTest.h"
+#include "TestData.h"
+#include "LineCoverageWriter.h"
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+TEST_CLASS(LineCoverageWriterTest)
+{
+public:
+
+	TEST_METHOD_CLEANUP(RemoveCacheDirectory)
+	{
+		std::string directory = getCacheDirectory();
+		for (const std::string& file : Platform::listFiles(directory)) {
+			Platform::removeFile(directory + Platform::PATH_SEPARATOR + file);
+		}
+		Platform::removeDirectory(directory);
+	}
+
+	TEST_METHOD(WritesSimpleReport)
+	{
+		TraceCoverage coverage;
+		add(coverage, "Assembly=PortablePdbSample:1 Version:1.0.0.0\r\nAssembly=Unknown:2 Version:1.0.0.0\r\n"
+			"Jitted=1:100663298\r\nJitted=1:100663297\r\nInlined=1:100663305\r\nJitted=1:100663299\r\nJitted=2:100663297\r\n");
+
+		SymbolCache cache(getCacheDirectory());
+		LineCoverageWriter writer(getTestDataDirectory(), cache);
+		std::ostringstream report;
+		writer.write(coverage, 2, report);
+
+		Assert::AreEqual(std::string("# isMethodAccurate=true\n"
+			"C:/src/PortablePdbSample/Calculator.cs\n6-8\n11-17\n"
+			"C:/src/PortablePdbSample/Greeter.cs\n13-18\n"), report.str(), L"report");
+		Assert::AreEqual(static_cast<size_t>(3), writer.getResolvedMethodCount(), L"resolved");
+		Assert::AreEqual(static_cast<size_t>(1), writer.getUnresolvedMethodCount(), L"implicit constructor without lines");
+		Assert::AreEqual(static_cast<size_t>(1), writer.getAssembliesWithoutSymbols().size(), L"without symbols");
+		Assert::AreEqual(std::string("Unknown"), writer.getAssembliesWithoutSymbols()[0], L"assembly without symbols");
+	}
+
+	TEST_METHOD(MergesOverlappingAndAdjacentRanges)
+	{
+		std::vector<LineCoverageWriter::LineRange> ranges = { { 20, 25 }, { 1, 3 }, { 4, 6 }, { 10, 12 }, { 11, 11 }, { 22, 30 } };
+		LineCoverageWriter::mergeLineRanges(ranges);
+
+		Assert::AreEqual(static_cast<size_t>(3), ranges.size(), L"merged");
+		Assert::AreEqual(6u, ranges[0].second, L"adjacent");
+		Assert::AreEqual(12u, ranges[1].second, L"contained");
+		Assert::AreEqual(20u, ranges[2].first, L"overlapping start");
+		Assert::AreEqual(30u, ranges[2].second, L"overlapping end");
+	}
+
+private:
+	static std::string getCacheDirectory() {
+		return Platform::getTempDirectory() + "LineCoverageWriterTest";
+	}
+
+	static std::string getTestDataDirectory() {
+		std::string path = getTestDataPath("PortablePdbTest", "PortablePdbSample.pdb");
+		return path.substr(0, path.rfind(Platform::PATH_SEPARATOR));
+	}
+
+	static void add(TraceCoverage& coverage, const std::string& trace) {
+		coverage.addTrace(trace.data(), trace.size());
+	}
+};
@@ -0,0 +1,69 @@
+#include "CppUnitTest.h"
+#include "utils/OverheadGovernor.h"
+#include <string>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+TEST_CLASS(OverheadGovernorTest)
+{
+public:
+
+	TEST_METHOD(DegradesStepByStepAboveBudget)
+	{
+		OverheadGovernor governor;
+		governor.enable(5);
+		Assert::IsFalse(runSecond(governor, 0, 2), L"within budget");
+		Assert::AreEqual(static_cast<int>(OverheadGovernor::LEVEL_FULL), static_cast<int>(governor.getLevel()), L"full");
+
+		Assert::IsTrue(runSecond(governor, 1, 10), L"above budget");
+		Assert::IsFalse(governor.shouldRecordInlining(), L"no inlining");
+		Assert::AreEqual(static_cast<size_t>(1), governor.getFlushFactor(), L"no deferred flush yet");
+
+		Assert::IsTrue(runSecond(governor, 2, 10), L"still above budget");
+		Assert::AreEqual(OverheadGovernor::DEFERRED_FLUSH_FACTOR, governor.getFlushFactor(), L"deferred flush");
+		Assert::IsTrue(governor.shouldRecordDiagnostics(), L"diagnostics");
+
+		Assert::IsTrue(runSecond(governor, 3, 10), L"last level");
+		Assert::IsFalse(governor.shouldRecordDiagnostics(), L"no diagnostics");
+		Assert::IsFalse(runSecond(governor, 4, 10), L"no further level");
+		Assert::AreEqual(std::string("level 3 (diagnostics suspended), 10.0% overhead at 1000 JIT compilations/s with a budget of 5%"),
+			governor.describe(), L"description");
+	}
+
+	TEST_METHOD(RecoversBelowHalfTheBudget)
+	{
+		OverheadGovernor governor;
+		governor.enable(10);
+		Assert::IsTrue(runSecond(governor, 0, 20), L"above budget");
+		Assert::IsTrue(runSecond(governor, 1, 20), L"above budget again");
+		Assert::IsFalse(runSecond(governor, 2, 6), L"between half and full budget");
+		Assert::AreEqual(static_cast<int>(OverheadGovernor::LEVEL_DEFERRED_FLUSH), static_cast<int>(governor.getLevel()), L"kept");
+		Assert::IsTrue(runSecond(governor, 3, 4), L"below half the budget");
+		Assert::IsTrue(runSecond(governor, 4, 0), L"idle");
+		Assert::IsTrue(governor.shouldRecordInlining(), L"full again");
+		Assert::AreEqual(static_cast<size_t>(4), governor.getLevelChangeCount(), L"changes");
+		Assert::AreEqual(static_cast<int>(OverheadGovernor::LEVEL_DEFERRED_FLUSH), static_cast<int>(governor.getHighestLevel()), L"highest");
+	}
+
+private:
+	/** Simulated cycles per microsecond. */
+	static const uint64_t CYCLES_PER_MICROSECOND = 1000;
+
+	/**
+	 * Simulates the given second of the process with 1000 JIT compilations that take the given percent of the time.
+	 * Returns whether the level changed at its end.
+	 */
+	static bool runSecond(OverheadGovernor& governor, uint64_t second, uint64_t overheadPercent) {
+		bool changed = false;
+		if (second == 0) {
+			// the first callback starts the first window
+			governor.recordCallback(0, false, CYCLES_PER_MICROSECOND, 1);
+		}
+		for (uint64_t millisecond = 1; millisecond <= 1000; millisecond++) {
+			uint64_t microseconds = 1 + second * 1000000 + millisecond * 1000;
+			uint64_t cycles = overheadPercent * 1000 * CYCLES_PER_MICROSECOND / 100;
+			changed |= governor.recordCallback(cycles, true, microseconds * CYCLES_PER_MICROSECOND, microseconds);
+		}
+		return changed;
+	}
+};
@@ -0,0 +1,169 @@
+#include "CppUnitTest.h"
+#include "platform/Platform.h"
+#include "platform/Mutex.h"
+#include "platform/Event.h"
+#include "platform/Thread.h"
+#include "platform/File.h"
+#include <algorithm>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+TEST_CLASS(PlatformTest)
+{
+public:
+
+	TEST_METHOD_CLEANUP(RemoveTestDirectory)
+	{
+		std::string directory = getTestDirectory();
+		for (std::string& file : Platform::listFiles(directory)) {
+			Platform::removeFile(directory + Platform::PATH_SEPARATOR + file);
+		}
+		Platform::removeDirectory(directory);
+	}
+
+	TEST_METHOD(MutexIsRecursiveAndExclusive)
+	{
+		Counter counter;
+		counter.mutex.lock();
+		counter.mutex.lock();
+		counter.mutex.unlock();
+
+		Thread threads[4];
+		for (Thread& thread : threads) {
+			Assert::IsTrue(thread.start(incrementCounter, &counter), L"start");
+		}
+		Platform::sleep(100);
+		Assert::AreEqual(0, counter.value, L"threads wait for the lock");
+		counter.mutex.unlock();
+
+		for (Thread& thread : threads) {
+			Assert::IsTrue(thread.join(10000), L"join");
+		}
+		Assert::AreEqual(4 * INCREMENTS, counter.value, L"no lost increments");
+	}
+
+	TEST_METHOD(EventsReleaseWaiters)
+	{
+		Event first;
+		Event second;
+		Event* events[] = { &first, &second };
+		Assert::AreEqual(Event::TIMED_OUT, Event::waitForAny(events, 2, 10), L"nothing set");
+
+		Thread thread;
+		Assert::IsTrue(thread.start(setEvent, &second), L"start");
+		Assert::AreEqual(1, Event::waitForAny(events, 2, 10000), L"second event");
+		Assert::IsTrue(thread.join(10000), L"join");
+		Assert::IsFalse(thread.isStarted(), L"joined");
+
+		first.set();
+		Assert::IsTrue(first.wait(0), L"stays set");
+		Assert::AreEqual(0, Event::waitForAny(events, 2, 0), L"lowest index");
+	}
+
+	TEST_METHOD(FilesAreWrittenAndRead)
+	{
+		std::string directory = createTestDirectory();
+		std::string path = directory + Platform::PATH_SEPARATOR + "test.txt";
+
+		File file;
+		Assert::IsTrue(file.open(path, File::OVERWRITE), L"create");
+		Assert::IsTrue(file.write("abc", 3), L"write");
+		file.close();
+		Assert::IsTrue(file.open(path, File::APPEND), L"append");
+		Assert::IsTrue(file.write("def", 3), L"append write");
+		file.close();
+
+		Assert::AreEqual(std::string("abcdef"), readFile(path), L"content");
+		Assert::IsTrue(Platform::isFile(path), L"is file");
+		Assert::IsFalse(Platform::isFile(directory), L"directory is no file");
+
+		std::vector<std::string> files = Platform::listFiles(directory);
+		Assert::AreEqual(static_cast<size_t>(1), files.size(), L"file count");
+		Assert::AreEqual(std::string("test.txt"), files[0], L"file name");
+
+		Assert::IsTrue(file.open(path, File::READ_EXCLUSIVE), L"read exclusively");
+		Assert::IsTrue(file.deleteOnClose(), L"delete on close");
+		file.close();
+		Assert::IsFalse(Platform::isFile(path), L"deleted");
+		Assert::IsFalse(file.open(path, File::READ), L"missing file");
+	}
+
+	TEST_METHOD(EnvironmentVariablesAreRead)
+	{
+		Assert::AreEqual(std::string(""), Platform::getEnvironmentVariable("PLATFORM_TEST_UNDEFINED_VARIABLE"), L"undefined");
+		Assert::AreNotEqual(std::string(""), Platform::getEnvironmentVariable("PATH"), L"path");
+	}
+
+	TEST_METHOD(HighestSetBitIsFound)
+	{
+		Assert::AreEqual(0u, Platform::getHighestSetBit(1), L"one");
+		Assert::AreEqual(10u, Platform::getHighestSetBit(1500), L"1500");
+		Assert::AreEqual(63u, Platform::getHighestSetBit(0x8000000000000001ull), L"top bit");
+	}
+
+	TEST_METHOD(TimeIsPlausible)
+	{
+		Platform::UtcTime time;
+		Platform::getUtcTime(time);
+		Assert::IsTrue(time.year >= 2020, L"year");
+		Assert::IsTrue(time.month >= 1 && time.month <= 12, L"month");
+		Assert::IsTrue(time.millisecond >= 0 && time.millisecond < 1000, L"millisecond");
+
+		uint64_t start = Platform::getMonotonicMicroseconds();
+		Platform::sleep(20);
+		Assert::IsTrue(Platform::getMonotonicMicroseconds() - start >= 15000, L"waited");
+	}
+
+private:
+
+	static const int INCREMENTS = 10000;
+
+	struct Counter {
+		Mutex mutex;
+		int value = 0;
+	};
+
+	static void incrementCounter(void* parameter) {
+		Counter* counter = static_cast<Counter*>(parameter);
+		for (int i = 0; i < INCREMENTS; i++) {
+			counter->mutex.lock();
+			counter->mutex.lock();
+			// not atomic, so lost updates show up if the mutex does not exclude the other threads
+			int value = counter->value;
+			counter->value = value + 1;
+			counter->mutex.unlock();
+			counter->mutex.unlock();
+		}
+	}
+
+	static void setEvent(void* parameter) {
+		static_cast<Event*>(parameter)->set();
+	}
+
+	static std::string getTestDirectory() {
+		return Platform::getTempDirectory() + "PlatformTest_" + std::to_string(Platform::getProcessId());
+	}
+
+	static std::string createTestDirectory() {
+		std::string directory = getTestDirectory();
+		Platform::createDirectory(directory);
+		for (std::string& file : Platform::listFiles(directory)) {
+			Platform::removeFile(directory + Platform::PATH_SEPARATOR + file);
+		}
+		return directory;
+	}
+
+	static std::string readFile(const std::string& path) {
+		File file;
+		if (!file.open(path, File::READ)) {
+			return "";
+		}
+		std::string content;
+		char buffer[256];
+		int length;
+		while ((length = file.read(buffer, sizeof(buffer))) > 0) {
+			content.append(buffer, length);
+		}
+		return content;
+	}
+};
@@ -0,0 +1,93 @@
+#include "CppUnitTest.h"
+#include "TestData.h"
+#include "MethodLineIndex.h"
+#include "PortablePdb.h"
+#include "platform/MappedFile.h"
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+TEST_CLASS(PortablePdbTest)
+{
+public:
+
+	TEST_METHOD(ReadsSequencePoints)
+	{
+		MappedFile file;
+		PortablePdb pdb;
+		open(file, pdb, "PortablePdbSample.pdb");
+
+		Assert::AreEqual(4u, pdb.getDocumentCount(), L"documents including generated ones");
+		Assert::AreEqual(std::string("C:/src/PortablePdbSample/Calculator.cs"), pdb.getDocumentName(1), L"document name");
+
+		// Calculator.Max, whose if statement has a hidden sequence point
+		std::vector<SequencePoint> points;
+		Assert::IsTrue(pdb.readSequencePoints(2, points), L"read");
+		Assert::AreEqual(static_cast<size_t>(6), points.size(), L"visible sequence points");
+		Assert::AreEqual(11u, points[0].startLine, L"opening brace");
+		Assert::AreEqual(9u, points[0].startColumn, L"opening brace column");
+		Assert::AreEqual(13u, points[2].startLine, L"after the hidden point");
+		Assert::AreEqual(9u, points[2].ilOffset, L"IL offset after the hidden point");
+		Assert::AreEqual(14u, points[3].endLine, L"end line");
+		Assert::AreEqual(30u, points[3].endColumn, L"end column");
+	}
+
+	TEST_METHOD(IndexesLineRangesByToken)
+	{
+		MappedFile file;
+		PortablePdb pdb;
+		open(file, pdb, "PortablePdbSample.pdb");
+		MethodLineIndex index;
+		Assert::IsTrue(index.build(pdb), L"build");
+
+		assertRange(index, 0x06000001, "C:/src/PortablePdbSample/Calculator.cs", 6, 8);
+		assertRange(index, 0x06000002, "C:/src/PortablePdbSample/Calculator.cs", 11, 17);
+		assertRange(index, 0x06000004, "C:/src/PortablePdbSample/Greeter.cs", 8, 10);
+		// the MoveNext method of the Count iterator, whose loop header comes after its body
+		assertRange(index, 0x06000009, "C:/src/PortablePdbSample/Greeter.cs", 13, 18);
+
+		// the iterator method itself only creates the state machine
+		Assert::IsTrue(index.find(0x06000005).first == index.find(0x06000005).second, L"no sequence points");
+		Assert::AreEqual(static_cast<size_t>(4), index.getRanges().size(), L"methods with sequence points");
+	}
+
+	TEST_METHOD(RejectsOtherFiles)
+	{
+		PortablePdb pdb;
+		MappedFile windowsPdb;
+		Assert::IsTrue(windowsPdb.open(getTestDataPath("UploadDaemon.SymbolAnalysis.SymbolCollectionTest", "ProfilerGUI.pdb")), L"open Windows PDB");
+		Assert::IsFalse(pdb.open(windowsPdb.getData(), windowsPdb.getSize()), L"Windows PDB");
+
+		MappedFile file;
+		Assert::IsTrue(file.open(getTestDataPath("PortablePdbTest", "PortablePdbSample.pdb")), L"open");
+		for (size_t size = 0; size < 400; size++) {
+			Assert::IsFalse(pdb.open(file.getData(), size), L"truncated PDB");
+		}
+	}
+
+	TEST_METHOD(RejectsTruncatedHeader)
+	{
+		PortablePdb pdb;
+		for (size_t size = 16; size < 20; size++) {
+			// "BSJB", version 1.1, reserved and an empty version string, cut off before the stream count
+			std::vector<char> header = { 'B', 'S', 'J', 'B', 1, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+			header.resize(size);
+			Assert::IsFalse(pdb.open(header.data(), header.size()), L"truncated header");
+		}
+	}
+
+private:
+	static void open(MappedFile& file, PortablePdb& pdb, const std::string& name) {
+		Assert::IsTrue(file.open(getTestDataPath("PortablePdbTest", name)), L"open file");
+		Assert::IsTrue(pdb.open(file.getData(), file.getSize()), L"open PDB");
+	}
+
+	static void assertRange(const MethodLineIndex& index, uint32_t token, const std::string& document, uint32_t startLine, uint32_t endLine) {
+		std::pair<const MethodLines*, const MethodLines*> ranges = index.find(token);
+		Assert::AreEqual(static_cast<ptrdiff_t>(1), ranges.second - ranges.first, L"one document");
+		Assert::AreEqual(document, index.getDocuments()[ranges.first->document], L"document");
+		Assert::AreEqual(startLine, ranges.first->startLine, L"start line");
+		Assert::AreEqual(endLine, ranges.first->endLine, L"end line");
+	}
+};
@@ -0,0 +1,40 @@
+#include "CppUnitTest.h"
+#include "config/ProcessSampling.h"
+#include <string>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+TEST_CLASS(ProcessSamplingTest)
+{
+public:
+
+	TEST_METHOD(DrawIsDeterministic)
+	{
+		double draw = ProcessSampling::getDraw("build-agent-7", 4711, START_TIME);
+		Assert::IsTrue(draw >= 0 && draw < 1, L"range");
+		Assert::AreEqual(draw, ProcessSampling::getDraw("build-agent-7", 4711, START_TIME), L"same process");
+		Assert::AreNotEqual(draw, ProcessSampling::getDraw("build-agent-8", 4711, START_TIME), L"other machine");
+		Assert::AreNotEqual(draw, ProcessSampling::getDraw("build-agent-7", 4712, START_TIME), L"other process");
+		Assert::AreNotEqual(draw, ProcessSampling::getDraw("build-agent-7", 4711, "2026-10-19T08:15:30.124Z"), L"restarted process");
+
+		Assert::IsTrue(ProcessSampling::isSampled(draw, 1), L"all processes");
+		Assert::IsFalse(ProcessSampling::isSampled(draw, 0), L"no process");
+	}
+
+	TEST_METHOD(SampledFractionMatchesRate)
+	{
+		// consecutive process IDs on one machine, as for a burst of short-lived processes
+		int sampledCount = 0;
+		for (unsigned long processId = 1000; processId < 11000; processId++) {
+			if (ProcessSampling::isSampled(ProcessSampling::getDraw("build-agent-7", processId, START_TIME), 0.1)) {
+				sampledCount++;
+			}
+		}
+		Assert::IsTrue(sampledCount > 900 && sampledCount < 1100, L"about a tenth");
+	}
+
+private:
+	static const char* const START_TIME;
+};
+
+const char* const ProcessSamplingTest::START_TIME = "2026-10-19T08:15:30.123Z";
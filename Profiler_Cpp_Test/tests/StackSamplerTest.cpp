@@ -0,0 +1,61 @@
+#include "CppUnitTest.h"
+#include "sampling/StackSampler.h"
+#include <algorithm>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+TEST_CLASS(StackSamplerTest)
+{
+public:
+
+	TEST_METHOD(StacksAreCollapsedFromTheRoot)
+	{
+		StackSampler sampler;
+		FunctionID leafFirst[] = { 3, 2, 1 };
+		FunctionID otherLeaf[] = { 4, 2, 1 };
+		sampler.addStack(leafFirst, 3);
+		sampler.addStack(otherLeaf, 3);
+		sampler.addStack(leafFirst, 3);
+
+		std::vector<std::string> lines;
+		sampler.collapseStacks([](FunctionID functionId) { return "f" + std::to_string(functionId); }, lines);
+		std::sort(lines.begin(), lines.end());
+		Assert::AreEqual(static_cast<size_t>(2), lines.size(), L"distinct stacks");
+		Assert::AreEqual(std::string("f1;f2;f3 2"), lines[0], L"repeated stack");
+		Assert::AreEqual(std::string("f1;f2;f4 1"), lines[1], L"other stack");
+		Assert::AreEqual(static_cast<size_t>(3), sampler.getSampleCount(), L"samples");
+	}
+
+	TEST_METHOD(EachFunctionIsResolvedOnce)
+	{
+		StackSampler sampler;
+		FunctionID leafFirst[] = { 3, 2, 1 };
+		FunctionID otherLeaf[] = { 4, 2, 1 };
+		sampler.addStack(leafFirst, 3);
+		sampler.addStack(otherLeaf, 3);
+
+		std::vector<FunctionID> resolved;
+		std::vector<std::string> lines;
+		sampler.collapseStacks([&resolved](FunctionID functionId) {
+			resolved.push_back(functionId);
+			return "f" + std::to_string(functionId);
+		}, lines);
+		std::sort(resolved.begin(), resolved.end());
+		Assert::AreEqual(static_cast<size_t>(4), resolved.size(), L"resolved names");
+		Assert::IsTrue(std::unique(resolved.begin(), resolved.end()) == resolved.end(), L"no function resolved twice");
+	}
+
+	TEST_METHOD(NewStacksAreDroppedWhenFull)
+	{
+		StackSampler sampler;
+		for (FunctionID i = 1; i <= StackSampler::MAX_STACKS; i++) {
+			Assert::IsTrue(sampler.addStack(&i, 1), L"within capacity");
+		}
+
+		FunctionID newStack = StackSampler::MAX_STACKS + 1;
+		FunctionID knownStack = 1;
+		Assert::IsFalse(sampler.addStack(&newStack, 1), L"new stack");
+		Assert::IsTrue(sampler.addStack(&knownStack, 1), L"known stack");
+		Assert::AreEqual(static_cast<size_t>(1), sampler.getDroppedSampleCount(), L"dropped");
+	}
+};
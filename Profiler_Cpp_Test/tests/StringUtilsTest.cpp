@@ -35,6 +35,7 @@ public:
 		Assert::IsFalse(StringUtils::equalsIgnoreCase("foo", "bar"));
 	}
 
+#ifdef _WIN32
 	TEST_METHOD(LastPartOfPath)
 	{
 		Assert::AreEqual(std::string("test.exe"), StringUtils::getLastPartOfPath("C:\\foo\\bar\\test.exe"));
@@ -46,4 +47,17 @@ public:
 		Assert::AreEqual(std::string("C:\\foo\\bar"), StringUtils::removeLastPartOfPath("C:\\foo\\bar\\test.exe"));
 		Assert::AreEqual(std::string("C:\\foo"), StringUtils::removeLastPartOfPath("C:\\foo\\bar"));
 	}
+#else
+	TEST_METHOD(LastPartOfPath)
+	{
+		Assert::AreEqual(std::string("test.exe"), StringUtils::getLastPartOfPath("/foo/bar/test.exe"));
+		Assert::AreEqual(std::string("bar"), StringUtils::getLastPartOfPath("/foo/bar"));
+	}
+
+	TEST_METHOD(RemoveLastPartOfPath)
+	{
+		Assert::AreEqual(std::string("/foo/bar"), StringUtils::removeLastPartOfPath("/foo/bar/test.exe"));
+		Assert::AreEqual(std::string("/"), StringUtils::removeLastPartOfPath("/foo"));
+	}
+#endif
 };
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include "CppUnitTest.h"
+#include "TestData.h"
+#include "SymbolCache.h"
+#include "platform/Platform.h"
+#include <fstream>
+#include <iterator>
+#include <string>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+TEST_CLASS(SymbolCacheTest)
+{
+public:
+
+	TEST_METHOD_CLEANUP(RemoveTestDirectory)
+	{
+		std::string directory = getTestDirectory();
+		removeFiles(directory + Platform::PATH_SEPARATOR + "cache");
+		Platform::removeDirectory(directory + Platform::PATH_SEPARATOR + "cache");
+		removeFiles(directory);
+		Platform::removeDirectory(directory);
+	}
+
+	TEST_METHOD(IndexFileMatchesIndex)
+	{
+		SymbolCache cache(createEmptyDirectory());
+		std::unique_ptr<SymbolIndexFile> index = cache.getIndex(getSamplePdbPath());
+		Assert::IsTrue(index != NULL, L"index");
+
+		std::pair<const MethodLines*, const MethodLines*> ranges = index->find(0x06000002);
+		Assert::AreEqual(static_cast<ptrdiff_t>(1), ranges.second - ranges.first, L"one range");
+		Assert::AreEqual(std::string("C:/src/PortablePdbSample/Calculator.cs"), index->getDocumentName(ranges.first->document), L"document");
+		Assert::AreEqual(11u, ranges.first->startLine, L"start line");
+		Assert::AreEqual(17u, ranges.first->endLine, L"end line");
+		Assert::IsTrue(index->find(0x06000003).first == index->find(0x06000003).second, L"no sequence points");
+		Assert::AreEqual(std::string(""), index->getDocumentName(index->getDocumentCount()), L"invalid document");
+	}
+
+	TEST_METHOD(IndexIsReusedUntilPdbChanges)
+	{
+		std::string directory = createEmptyDirectory();
+		std::string pdbPath = directory + Platform::PATH_SEPARATOR + "Sample.pdb";
+		std::string pdb = readFile(getSamplePdbPath());
+		writeFile(pdbPath, pdb);
+
+		SymbolCache cache(directory + Platform::PATH_SEPARATOR + "cache");
+		Assert::IsTrue(cache.getIndex(pdbPath) != NULL, L"first");
+		Assert::IsTrue(cache.getIndex(pdbPath) != NULL, L"second");
+		Assert::AreEqual(static_cast<size_t>(1), cache.getBuiltCount(), L"built once");
+		Assert::AreEqual(static_cast<size_t>(1), cache.getReusedCount(), L"reused once");
+
+		// a rebuild changes the PDB ID, which starts the #Pdb stream right after the stream headers
+		pdb[pdb.find("#Blob") + 8] ^= 1;
+		writeFile(pdbPath, pdb);
+		Assert::IsTrue(cache.getIndex(pdbPath) != NULL, L"changed");
+		Assert::AreEqual(static_cast<size_t>(2), cache.getBuiltCount(), L"rebuilt");
+	}
+
+	TEST_METHOD(CorruptIndexIsRebuilt)
+	{
+		std::string directory = createEmptyDirectory();
+		SymbolCache cache(directory);
+		Assert::IsTrue(cache.getIndex(getSamplePdbPath()) != NULL, L"build");
+
+		std::string indexPath = directory + Platform::PATH_SEPARATOR + Platform::listFiles(directory)[0];
+		std::string contents = readFile(indexPath);
+		writeFile(indexPath, contents.substr(0, contents.size() - 1));
+		SymbolIndexFile truncated;
+		Assert::IsFalse(truncated.open(indexPath), L"truncated");
+
+		Assert::IsTrue(cache.getIndex(getSamplePdbPath()) != NULL, L"rebuild");
+		Assert::AreEqual(static_cast<size_t>(2), cache.getBuiltCount(), L"built twice");
+		Assert::AreEqual(contents, readFile(indexPath), L"same index");
+	}
+
+	TEST_METHOD(WindowsPdbIsRejected)
+	{
+		SymbolCache cache(createEmptyDirectory());
+		Assert::IsTrue(cache.getIndex(getTestDataPath("UploadDaemon.SymbolAnalysis.SymbolCollectionTest", "ProfilerGUI.pdb")) == NULL, L"Windows PDB");
+	}
+
+private:
+	static std::string getSamplePdbPath() {
+		return getTestDataPath("PortablePdbTest", "PortablePdbSample.pdb");
+	}
+
+	static std::string getTestDirectory() {
+		return Platform::getTempDirectory() + "SymbolCacheTest";
+	}
+
+	static std::string createEmptyDirectory() {
+		std::string directory = getTestDirectory();
+		Platform::createDirectory(directory);
+		removeFiles(directory + Platform::PATH_SEPARATOR + "cache");
+		removeFiles(directory);
+		return directory;
+	}
+
+	static void removeFiles(const std::string& directory) {
+		for (const std::string& file : Platform::listFiles(directory)) {
+			Platform::removeFile(directory + Platform::PATH_SEPARATOR + file);
+		}
+	}
+
+	static std::string readFile(const std::string& path) {
+		std::ifstream file(path, std::ios::binary);
+		return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	static void writeFile(const std::string& path, const std::string& contents) {
+		std::ofstream(path, std::ios::binary | std::ios::trunc) << contents;
+	}
+};
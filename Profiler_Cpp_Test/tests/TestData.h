@@ -0,0 +1,16 @@
+#pragma once
+#include "platform/Platform.h"
+#include <string>
+
+/**
+ * Returns the path of a file in the test-data directory of the repository, which is searched in the parents of the
+ * working directory, i.e. the output directory in Visual Studio and the repository with CTest.
+ */
+inline std::string getTestDataPath(const std::string& directory, const std::string& name) {
+	std::string relativePath = std::string("test-data") + Platform::PATH_SEPARATOR + directory + Platform::PATH_SEPARATOR + name;
+	std::string parents;
+	for (int i = 0; i < 5 && !Platform::isFile(parents + relativePath); i++) {
+		parents += std::string("..") + Platform::PATH_SEPARATOR;
+	}
+	return parents + relativePath;
+}
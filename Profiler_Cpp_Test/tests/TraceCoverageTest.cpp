@@ -0,0 +1,75 @@
+#include "CppUnitTest.h"
+#include "TraceCoverage.h"
+#include <string>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+TEST_CLASS(TraceCoverageTest)
+{
+public:
+
+	TEST_METHOD(MapsAssembliesAcrossTracesByIdentity)
+	{
+		TraceCoverage coverage;
+		add(coverage, "Process=app.exe\r\nAssembly=A:1 Version:1.0.0.0\r\nAssembly=B:2 Version:2.0.0.0\r\nJitted=1:100663297\r\nJitted=2:100663298\r\n");
+		add(coverage, "Process=app.exe\r\nAssembly=B:1 Version:2.0.0.0\r\nAssembly=A:2 Version:1.0.0.0\r\nJitted=1:100663298\r\nJitted=2:100663299\r\n");
+
+		Assert::AreEqual(std::string("Info=Merged 2 trace files\r\nProcess=app.exe\r\n"
+			"Assembly=A:1 Version:1.0.0.0\r\nAssembly=B:2 Version:2.0.0.0\r\n"
+			"Jitted=1:100663297\r\nJitted=1:100663299\r\nJitted=2:100663298\r\n"), coverage.write(), L"merged trace");
+		Assert::AreEqual(static_cast<size_t>(3), coverage.getMethodCount(), L"duplicate method counted once");
+	}
+
+	TEST_METHOD(DistinguishesAssembliesByMvid)
+	{
+		TraceCoverage coverage;
+		add(coverage, "Assembly=A:1 Version:1.0.0.0 Mvid:11111111-0000-0000-0000-000000000000\r\nJitted=1:100663297\r\n");
+		add(coverage, "Assembly=A:1 Version:1.0.0.0 Mvid:22222222-0000-0000-0000-000000000000\r\nJitted=1:100663297\r\n");
+
+		Assert::AreEqual(static_cast<size_t>(2), coverage.getMethodCount(), L"same version, different builds");
+	}
+
+	TEST_METHOD(ResolvesCoverageBeforeAssemblyLines)
+	{
+		TraceCoverage coverage;
+		add(coverage, "Inlined=1:100663300\nJitted=3:100663301\nAssembly=A:1 Version:1.0.0.0\n");
+
+		Assert::AreEqual(std::string("Info=Merged 1 trace files\r\nAssembly=A:1 Version:1.0.0.0\r\nInlined=1:100663300\r\n"),
+			coverage.write(), L"forward reference with LF line endings");
+		Assert::AreEqual(static_cast<size_t>(1), coverage.getUnresolvedLineCount(), L"assembly 3 is unknown");
+	}
+
+	TEST_METHOD(ParsesCoverageWithThreeParts)
+	{
+		TraceCoverage coverage;
+		add(coverage, "Assembly=A:1 Version:1.0.0.0\r\nJitted=1:5:100663301\r\nJitted=1:x\r\nTest=Start:1:T\r\nJitted=1:100663297");
+
+		Assert::AreEqual(std::string("Info=Merged 1 trace files\r\nAssembly=A:1 Version:1.0.0.0\r\n"
+			"Jitted=1:100663297\r\nJitted=1:100663301\r\n"), coverage.write(), L"middle part skipped, malformed lines ignored");
+	}
+
+	TEST_METHOD(MergeIsIndependentOfOrder)
+	{
+		TraceCoverage first;
+		add(first, "Started=20240102_0000000000\r\nAssembly=A:1 Version:1.0.0.0 Path:/a\r\nJitted=1:100663999\r\nStopped=20240102_0100000000\r\n");
+		TraceCoverage second;
+		add(second, "Started=20240101_0000000000\r\nAssembly=A:4 Version:1.0.0.0 Path:/b\r\nInlined=4:100663297\r\nStopped=20240101_0100000000\r\n");
+
+		TraceCoverage forward;
+		forward.merge(first);
+		forward.merge(second);
+		TraceCoverage backward;
+		backward.merge(second);
+		backward.merge(first);
+
+		Assert::AreEqual(forward.write(), backward.write(), L"same output");
+		Assert::AreEqual(std::string("Info=Merged 2 trace files\r\nStarted=20240101_0000000000\r\n"
+			"Assembly=A:1 Version:1.0.0.0 Path:/a\r\nInlined=1:100663297\r\nJitted=1:100663999\r\n"
+			"Stopped=20240102_0100000000\r\n"), forward.write(), L"earliest start, latest stop, bitmaps ORed");
+	}
+
+private:
+	static void add(TraceCoverage& coverage, const std::string& trace) {
+		coverage.addTrace(trace.data(), trace.size());
+	}
+};
@@ -0,0 +1,179 @@
+#include "CppUnitTest.h"
+#include "TraceCompression.h"
+#include "TracePack.h"
+#include "platform/File.h"
+#include "platform/Platform.h"
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+TEST_CLASS(TracePackTest)
+{
+public:
+
+	TEST_METHOD_CLEANUP(RemoveTestDirectory)
+	{
+		std::string directory = getTestDirectory();
+		removeFiles(directory);
+		Platform::removeDirectory(directory);
+	}
+
+	TEST_METHOD(CompressionRoundTrips)
+	{
+		std::string trace = "Info=TIA Profiler\r\nAssembly=Sample:1 Version:1.0.0.0\r\n";
+		for (int i = 0; i < 5000; i++) {
+			trace += "Jitted=1:" + std::to_string(100663297 + i) + "\r\n";
+		}
+		std::string compressed = compressTrace(trace.data(), trace.size());
+		Assert::IsTrue(compressed.size() * 3 < trace.size(), L"compresses");
+		assertRoundTrips(trace);
+
+		std::string noise;
+		uint32_t state = 1;
+		for (int i = 0; i < 100000; i++) {
+			state = state * 1103515245 + 12345;
+			noise += static_cast<char>(state >> 24);
+		}
+		assertRoundTrips(noise);
+		assertRoundTrips(std::string(70000, 'x'));
+		assertRoundTrips("");
+		assertRoundTrips("abc");
+	}
+
+	TEST_METHOD(MalformedCompressedDataIsRejected)
+	{
+		std::string trace(1000, 'a');
+		std::string compressed = compressTrace(trace.data(), trace.size());
+		std::string output;
+		Assert::IsFalse(decompressTrace(compressed.data(), compressed.size(), trace.size() - 1, output), L"too long");
+		Assert::IsFalse(decompressTrace(compressed.data(), compressed.size(), trace.size() + 1, output), L"too short");
+		Assert::IsFalse(decompressTrace(compressed.data(), compressed.size() - 1, trace.size(), output), L"truncated");
+	}
+
+	TEST_METHOD(TracesAreListedByTime)
+	{
+		std::string directory = createEmptyDirectory();
+		TracePack pack(directory);
+		Assert::IsTrue(pack.append("coverage_1_1.txt", "first", 5, DAY), L"first");
+		Assert::IsTrue(pack.append("coverage_1_2.txt", "second", 6, DAY + 60), L"second");
+		Assert::IsTrue(pack.append("coverage_1_3.txt", "third", 5, 2 * DAY + 60), L"next day");
+		// times within a segment never decrease
+		Assert::IsTrue(pack.append("coverage_1_4.txt", "fourth", 6, 2 * DAY), L"earlier");
+
+		std::vector<TracePack::Entry> entries = pack.list(DAY + 1, INT64_MAX);
+		Assert::AreEqual(static_cast<size_t>(3), entries.size(), L"count");
+		Assert::AreEqual(std::string("coverage_1_2.txt"), entries[0].name, L"name");
+		Assert::AreEqual(std::string("1970-01-02"), entries[0].segment, L"segment");
+		Assert::AreEqual(std::string("1970-01-03"), entries[1].segment, L"next segment");
+		Assert::IsTrue(entries[2].time == 2 * DAY + 60, L"raised time");
+
+		std::string contents;
+		Assert::IsTrue(pack.read(entries[2], contents), L"read");
+		Assert::AreEqual(std::string("fourth"), contents, L"contents");
+		Assert::AreEqual(static_cast<size_t>(1), pack.list(0, DAY + 1).size(), L"before");
+	}
+
+	TEST_METHOD(PurgeDeletesWholeSegments)
+	{
+		std::string directory = createEmptyDirectory();
+		TracePack pack(directory);
+		Assert::IsTrue(pack.append("coverage_1_1.txt", "old", 3, DAY), L"old");
+		Assert::IsTrue(pack.append("coverage_1_2.txt", "new", 3, 2 * DAY), L"new");
+		Assert::IsTrue(pack.append("coverage_1_3.txt", "newer", 5, 2 * DAY + 100), L"newer");
+
+		// the second segment still has a trace newer than the cutoff
+		Assert::AreEqual(static_cast<size_t>(1), pack.purge(2 * DAY + 50), L"purged");
+		Assert::AreEqual(static_cast<size_t>(2), pack.list(INT64_MIN, INT64_MAX).size(), L"remaining");
+		Assert::AreEqual(static_cast<size_t>(2), Platform::listFiles(directory).size(), L"files");
+
+		Assert::AreEqual(static_cast<size_t>(2), pack.purge(2 * DAY + 100), L"purged all");
+		Assert::IsTrue(pack.append("coverage_1_4.txt", "again", 5, 2 * DAY + 200), L"append after purge");
+		Assert::AreEqual(static_cast<size_t>(1), pack.list(INT64_MIN, INT64_MAX).size(), L"appended");
+	}
+
+	TEST_METHOD(TornAndCorruptRecordsAreSkipped)
+	{
+		std::string directory = createEmptyDirectory();
+		{
+			TracePack pack(directory);
+			Assert::IsTrue(pack.append("coverage_1_1.txt", "first", 5, DAY), L"first");
+			Assert::IsTrue(pack.append("coverage_1_2.txt", "second", 6, DAY + 1), L"second");
+		}
+		std::string indexPath = directory + Platform::PATH_SEPARATOR + "1970-01-02" + TracePack::INDEX_EXTENSION;
+		std::string packPath = directory + Platform::PATH_SEPARATOR + "1970-01-02" + TracePack::PACK_EXTENSION;
+
+		// a crash while writing the index leaves half an entry
+		appendToFile(indexPath, std::string(7, '\x01'));
+		TracePack pack(directory);
+		Assert::AreEqual(static_cast<size_t>(2), pack.list(INT64_MIN, INT64_MAX).size(), L"torn entry");
+		Assert::IsTrue(pack.append("coverage_1_3.txt", "third", 5, DAY + 2), L"third");
+		std::vector<TracePack::Entry> entries = pack.list(INT64_MIN, INT64_MAX);
+		Assert::AreEqual(static_cast<size_t>(3), entries.size(), L"appended after torn entry");
+
+		// a damaged payload fails the checksum
+		std::string contents = readFile(packPath);
+		contents[static_cast<size_t>(entries[2].offset) - 1] ^= 1;
+		std::ofstream(packPath, std::ios::binary | std::ios::trunc) << contents;
+		std::string trace;
+		Assert::IsFalse(pack.read(entries[1], trace), L"corrupt");
+		Assert::IsTrue(pack.read(entries[2], trace), L"intact");
+		Assert::AreEqual(std::string("third"), trace, L"third contents");
+	}
+
+	TEST_METHOD(SegmentNamesAreUtcDays)
+	{
+		Assert::AreEqual(std::string("1970-01-01"), TracePack::getSegmentName(0), L"epoch");
+		Assert::AreEqual(std::string("2000-02-29"), TracePack::getSegmentName(951782400 + DAY - 1), L"leap day");
+		Assert::AreEqual(std::string("2000-03-01"), TracePack::getSegmentName(951782400 + DAY), L"after leap day");
+
+		Platform::UtcTime now;
+		Platform::getUtcTime(now);
+		char today[16];
+		snprintf(today, sizeof(today), "%04d-%02d-%02d", now.year, now.month, now.day);
+		// may fail right at midnight
+		Assert::AreEqual(std::string(today), TracePack::getSegmentName(TracePack::getCurrentTime()), L"today");
+		Assert::IsTrue(TracePack::isSegmentFile("2000-03-01.traceindex.tmp"), L"temporary index");
+		Assert::IsFalse(TracePack::isSegmentFile("coverage_1_1.txt"), L"trace");
+	}
+
+private:
+	static const int64_t DAY = 86400;
+
+	static void assertRoundTrips(const std::string& trace) {
+		std::string compressed = compressTrace(trace.data(), trace.size());
+		std::string output = "stale";
+		Assert::IsTrue(decompressTrace(compressed.data(), compressed.size(), trace.size(), output), L"decompresses");
+		Assert::IsTrue(trace == output, L"round trip");
+	}
+
+	static std::string getTestDirectory() {
+		return Platform::getTempDirectory() + "TracePackTest";
+	}
+
+	static std::string createEmptyDirectory() {
+		std::string directory = getTestDirectory();
+		Platform::createDirectory(directory);
+		removeFiles(directory);
+		return directory;
+	}
+
+	static void removeFiles(const std::string& directory) {
+		for (const std::string& file : Platform::listFiles(directory)) {
+			Platform::removeFile(directory + Platform::PATH_SEPARATOR + file);
+		}
+	}
+
+	static std::string readFile(const std::string& path) {
+		std::ifstream file(path, std::ios::binary);
+		return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	static void appendToFile(const std::string& path, const std::string& contents) {
+		File file;
+		Assert::IsTrue(file.open(path, File::APPEND), L"open");
+		Assert::IsTrue(file.write(contents.data(), contents.size()), L"write");
+	}
+};
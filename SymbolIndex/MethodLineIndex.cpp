@@ -0,0 +1,54 @@
+#include "MethodLineIndex.h"
+#include <algorithm>
+
+/** The table of method definitions, which the MethodDebugInformation table is parallel to. */
+static const uint32_t METHOD_DEF_TABLE = 0x06000000;
+
+bool MethodLineIndex::build(const PortablePdb& pdb) {
+	ranges.clear();
+	documents.clear();
+	for (uint32_t document = 1; document <= pdb.getDocumentCount(); document++) {
+		documents.push_back(pdb.getDocumentName(document));
+	}
+
+	std::vector<SequencePoint> points;
+	for (uint32_t method = 1; method <= pdb.getMethodCount(); method++) {
+		if (!pdb.readSequencePoints(method, points)) {
+			return false;
+		}
+
+		// methods rarely span more than one document, so a linear search of the method's ranges is enough
+		size_t methodStart = ranges.size();
+		for (const SequencePoint& point : points) {
+			if (point.document < 1 || point.document > documents.size()) {
+				return false;
+			}
+			uint32_t document = point.document - 1;
+			std::vector<MethodLines>::iterator range = std::find_if(ranges.begin() + methodStart, ranges.end(),
+				[document](const MethodLines& lines) { return lines.document == document; });
+			if (range == ranges.end()) {
+				ranges.push_back({ METHOD_DEF_TABLE | method, document, point.startLine, point.endLine });
+				continue;
+			}
+			range->startLine = std::min(range->startLine, point.startLine);
+			range->endLine = std::max(range->endLine, point.endLine);
+		}
+		std::sort(ranges.begin() + methodStart, ranges.end(), [](const MethodLines& first, const MethodLines& second) {
+			return first.document < second.document;
+		});
+	}
+	return true;
+}
+
+std::pair<const MethodLines*, const MethodLines*> MethodLineIndex::find(uint32_t token) const {
+	const MethodLines* begin = ranges.data();
+	const MethodLines* end = begin + ranges.size();
+	const MethodLines* first = std::lower_bound(begin, end, token, [](const MethodLines& lines, uint32_t value) {
+		return lines.token < value;
+	});
+	const MethodLines* last = first;
+	while (last != end && last->token == token) {
+		last++;
+	}
+	return std::make_pair(first, last);
+}
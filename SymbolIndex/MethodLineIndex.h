@@ -0,0 +1,46 @@
+#pragma once
+#include "PortablePdb.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/** The lines of one document that a method spans. */
+struct MethodLines {
+	uint32_t token;
+
+	/** The index of the document in MethodLineIndex::getDocuments(). */
+	uint32_t document;
+
+	/** The first and last line (both inclusive) of the method's sequence points in the document. */
+	uint32_t startLine;
+	uint32_t endLine;
+};
+
+/**
+ * Maps method tokens to the line ranges of their sequence points, like the upload daemon's SymbolCollection maps them
+ * to source locations. Methods whose sequence points span several documents, e.g. because of #line directives or
+ * partial methods, have one range per document. Methods without (visible) sequence points have none.
+ */
+class MethodLineIndex
+{
+public:
+	/** Adds all methods of the given PDB. Returns false if one of them has malformed sequence points. */
+	bool build(const PortablePdb& pdb);
+
+	/** The ranges of all methods, sorted by token and then by document. */
+	const std::vector<MethodLines>& getRanges() const {
+		return ranges;
+	}
+
+	/** The document names, e.g. "C:/src/Program.cs". */
+	const std::vector<std::string>& getDocuments() const {
+		return documents;
+	}
+
+	/** Returns the ranges of the given method as the start and end of a part of getRanges(). Both are equal if there are none. */
+	std::pair<const MethodLines*, const MethodLines*> find(uint32_t token) const;
+
+private:
+	std::vector<MethodLines> ranges;
+	std::vector<std::string> documents;
+};
@@ -0,0 +1,296 @@
+#include "PortablePdb.h"
+#include <bitset>
+#include <cstring>
+
+/** The signature of a metadata root, "BSJB". */
+static const uint32_t METADATA_SIGNATURE = 0x424A5342;
+
+/** The first table of Portable PDBs. Lower tables are type system tables, which only exist in embedded PDBs. */
+static const int DOCUMENT_TABLE = 0x30;
+static const int METHOD_DEBUG_INFORMATION_TABLE = 0x31;
+
+/** Flags of the HeapSizes field of the #~ stream. */
+static const uint8_t LARGE_GUID_HEAP = 0x02;
+static const uint8_t LARGE_BLOB_HEAP = 0x04;
+static const uint8_t EXTRA_DATA = 0x40;
+
+static uint32_t readUInt32(const uint8_t* position) {
+	return position[0] | (position[1] << 8) | (position[2] << 16) | (static_cast<uint32_t>(position[3]) << 24);
+}
+
+static uint64_t readUInt64(const uint8_t* position) {
+	return readUInt32(position) | (static_cast<uint64_t>(readUInt32(position + 4)) << 32);
+}
+
+bool PortablePdb::open(const char* data, size_t size) {
+	const uint8_t* root = reinterpret_cast<const uint8_t*>(data);
+	// the signature, version, reserved field and version length, and after the version the flags and stream count
+	if (size < 20 || readUInt32(root) != METADATA_SIGNATURE) {
+		return false;
+	}
+	uint32_t versionLength = readUInt32(root + 12);
+	if (versionLength > size - 20) {
+		return false;
+	}
+
+	const uint8_t* pdbStream = NULL;
+	uint32_t pdbStreamSize = 0;
+	const uint8_t* tableStream = NULL;
+	uint32_t tableStreamSize = 0;
+	const uint8_t* end = root + size;
+	const uint8_t* header = root + 16 + versionLength;
+	uint16_t streamCount = header[2] | (header[3] << 8);
+	header += 4;
+	for (uint16_t i = 0; i < streamCount; i++) {
+		if (end - header < 12) {
+			return false;
+		}
+		uint32_t offset = readUInt32(header);
+		uint32_t streamSize = readUInt32(header + 4);
+		const char* name = reinterpret_cast<const char*>(header + 8);
+		size_t nameLength = strnlen(name, end - header - 8);
+		if (offset > size || streamSize > size - offset || nameLength == static_cast<size_t>(end - header - 8)) {
+			return false;
+		}
+		header += 8 + (nameLength + 4) / 4 * 4;
+
+		const uint8_t* stream = root + offset;
+		if (strcmp(name, "#Pdb") == 0) {
+			pdbStream = stream;
+			pdbStreamSize = streamSize;
+		}
+		else if (strcmp(name, "#~") == 0) {
+			tableStream = stream;
+			tableStreamSize = streamSize;
+		}
+		else if (strcmp(name, "#Blob") == 0) {
+			blobHeap = stream;
+			blobHeapSize = streamSize;
+		}
+		else if (strcmp(name, "#GUID") == 0) {
+			guidHeap = stream;
+			guidHeapSize = streamSize;
+		}
+	}
+
+	// the #Pdb stream starts with the PDB ID, the entry point and the referenced type system tables
+	if (pdbStream == NULL || pdbStreamSize < ID_LENGTH + 12 || tableStream == NULL || tableStreamSize < 24) {
+		return false;
+	}
+	memcpy(id, pdbStream, ID_LENGTH);
+	return openTables(tableStream, tableStreamSize, tableStream[6]);
+}
+
+bool PortablePdb::openTables(const uint8_t* stream, uint32_t size, uint8_t heapSizes) {
+	uint64_t presentTables = readUInt64(stream + 8);
+	if ((presentTables & ((static_cast<uint64_t>(1) << DOCUMENT_TABLE) - 1)) != 0) {
+		return false;
+	}
+	guidIndexSize = (heapSizes & LARGE_GUID_HEAP) ? 4 : 2;
+	blobIndexSize = (heapSizes & LARGE_BLOB_HEAP) ? 4 : 2;
+
+	size_t tableCount = std::bitset<64>(presentTables).count();
+	const uint8_t* rowCounts = stream + 24;
+	const uint8_t* tables = rowCounts + tableCount * 4 + ((heapSizes & EXTRA_DATA) ? 4 : 0);
+	if (tables > stream + size) {
+		return false;
+	}
+
+	// the row counts are ordered by table number like the tables, so the first two are those of the tables we need
+	if (presentTables & (static_cast<uint64_t>(1) << DOCUMENT_TABLE)) {
+		documentTable.rowCount = readUInt32(rowCounts);
+		rowCounts += 4;
+	}
+	if (presentTables & (static_cast<uint64_t>(1) << METHOD_DEBUG_INFORMATION_TABLE)) {
+		methodTable.rowCount = readUInt32(rowCounts);
+	}
+	documentIndexSize = documentTable.rowCount < 0x10000 ? 2 : 4;
+
+	// Name, HashAlgorithm, Hash and Language
+	documentTable.rowSize = blobIndexSize + guidIndexSize + blobIndexSize + guidIndexSize;
+	documentTable.rows = tables;
+	// Document and SequencePoints
+	methodTable.rowSize = documentIndexSize + blobIndexSize;
+	methodTable.rows = tables + static_cast<uint64_t>(documentTable.rowCount) * documentTable.rowSize;
+
+	uint64_t tablesSize = static_cast<uint64_t>(documentTable.rowCount) * documentTable.rowSize +
+		static_cast<uint64_t>(methodTable.rowCount) * methodTable.rowSize;
+	return tablesSize <= static_cast<uint64_t>(stream + size - tables);
+}
+
+std::string PortablePdb::getDocumentName(uint32_t document) const {
+	std::string name;
+	if (document < 1 || document > documentTable.rowCount) {
+		return name;
+	}
+	const uint8_t* row = documentTable.rows + static_cast<size_t>(document - 1) * documentTable.rowSize;
+	Blob blob = getBlob(readIndex(row, blobIndexSize));
+	if (blob.data == blob.end) {
+		return name;
+	}
+
+	// the separator, e.g. '/', followed by the blob indices of the parts between separators
+	char separator = static_cast<char>(*blob.data++);
+	uint32_t partIndex = 0;
+	for (bool first = true; readCompressedUnsigned(blob, partIndex); first = false) {
+		if (!first && separator != 0) {
+			name += separator;
+		}
+		Blob part = getBlob(partIndex);
+		name.append(reinterpret_cast<const char*>(part.data), part.end - part.data);
+	}
+	return name;
+}
+
+bool PortablePdb::readSequencePoints(uint32_t method, std::vector<SequencePoint>& points) const {
+	points.clear();
+	if (method < 1 || method > methodTable.rowCount) {
+		return false;
+	}
+	const uint8_t* row = methodTable.rows + static_cast<size_t>(method - 1) * methodTable.rowSize;
+	uint32_t document = readIndex(row, documentIndexSize);
+	Blob blob = getBlob(readIndex(row + documentIndexSize, blobIndexSize));
+	if (blob.data == blob.end) {
+		// e.g. abstract methods or methods without source
+		return true;
+	}
+
+	uint32_t localSignature = 0;
+	if (!readCompressedUnsigned(blob, localSignature) || (document == 0 && !readCompressedUnsigned(blob, document))) {
+		return false;
+	}
+
+	SequencePoint point = { 0, document, 0, 0, 0, 0 };
+	bool first = true;
+	bool hasPreviousLines = false;
+	while (blob.data < blob.end) {
+		uint32_t ilOffsetDelta = 0;
+		if (!readCompressedUnsigned(blob, ilOffsetDelta)) {
+			return false;
+		}
+		if (!first && ilOffsetDelta == 0) {
+			// a document record switches the document of the following sequence points
+			if (!readCompressedUnsigned(blob, point.document)) {
+				return false;
+			}
+			continue;
+		}
+		point.ilOffset += ilOffsetDelta;
+		first = false;
+
+		uint32_t lineDelta = 0;
+		int32_t columnDelta = 0;
+		if (!readCompressedUnsigned(blob, lineDelta)) {
+			return false;
+		}
+		if (lineDelta == 0) {
+			uint32_t unsignedColumnDelta = 0;
+			if (!readCompressedUnsigned(blob, unsignedColumnDelta)) {
+				return false;
+			}
+			columnDelta = static_cast<int32_t>(unsignedColumnDelta);
+		}
+		else if (!readCompressedSigned(blob, columnDelta)) {
+			return false;
+		}
+		if (lineDelta == 0 && columnDelta == 0) {
+			// hidden sequence point
+			continue;
+		}
+
+		// the start of the first visible sequence point is absolute, later ones are relative to the previous one
+		if (hasPreviousLines) {
+			int32_t startLineDelta = 0;
+			int32_t startColumnDelta = 0;
+			if (!readCompressedSigned(blob, startLineDelta) || !readCompressedSigned(blob, startColumnDelta)) {
+				return false;
+			}
+			point.startLine += startLineDelta;
+			point.startColumn += startColumnDelta;
+		}
+		else if (!readCompressedUnsigned(blob, point.startLine) || !readCompressedUnsigned(blob, point.startColumn)) {
+			return false;
+		}
+		hasPreviousLines = true;
+		point.endLine = point.startLine + lineDelta;
+		point.endColumn = point.startColumn + columnDelta;
+		points.push_back(point);
+	}
+	return true;
+}
+
+PortablePdb::Blob PortablePdb::getBlob(uint32_t index) const {
+	Blob blob = { blobHeap, blobHeap };
+	if (index == 0 || index >= blobHeapSize) {
+		return blob;
+	}
+	Blob heap = { blobHeap + index, blobHeap + blobHeapSize };
+	uint32_t length = 0;
+	if (!readCompressedUnsigned(heap, length) || length > static_cast<size_t>(heap.end - heap.data)) {
+		return blob;
+	}
+	blob.data = heap.data;
+	blob.end = heap.data + length;
+	return blob;
+}
+
+uint32_t PortablePdb::readIndex(const uint8_t* position, uint32_t size) {
+	if (size == 2) {
+		return position[0] | (position[1] << 8);
+	}
+	return readUInt32(position);
+}
+
+bool PortablePdb::readCompressedUnsigned(Blob& blob, uint32_t& value) {
+	if (blob.data >= blob.end) {
+		return false;
+	}
+	uint8_t first = blob.data[0];
+	if ((first & 0x80) == 0) {
+		value = first;
+		blob.data++;
+		return true;
+	}
+	if ((first & 0xC0) == 0x80) {
+		if (blob.end - blob.data < 2) {
+			return false;
+		}
+		value = ((first & 0x3F) << 8) | blob.data[1];
+		blob.data += 2;
+		return true;
+	}
+	if ((first & 0xE0) == 0xC0) {
+		if (blob.end - blob.data < 4) {
+			return false;
+		}
+		value = (static_cast<uint32_t>(first & 0x1F) << 24) | (blob.data[1] << 16) | (blob.data[2] << 8) | blob.data[3];
+		blob.data += 4;
+		return true;
+	}
+	return false;
+}
+
+bool PortablePdb::readCompressedSigned(Blob& blob, int32_t& value) {
+	const uint8_t* start = blob.data;
+	uint32_t rotated = 0;
+	if (!readCompressedUnsigned(blob, rotated)) {
+		return false;
+	}
+
+	// the sign bit is rotated into the lowest bit and must be extended according to the encoded length
+	value = static_cast<int32_t>(rotated >> 1);
+	if (rotated & 1) {
+		switch (blob.data - start) {
+		case 1:
+			value -= 0x40;
+			break;
+		case 2:
+			value -= 0x2000;
+			break;
+		default:
+			value -= 0x10000000;
+			break;
+		}
+	}
+	return true;
+}
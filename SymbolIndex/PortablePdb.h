@@ -0,0 +1,107 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/** A sequence point of a method, i.e. the source range of an IL offset. */
+struct SequencePoint {
+	uint32_t ilOffset;
+
+	/** The row of the document in the Document table, starting at 1. */
+	uint32_t document;
+
+	uint32_t startLine;
+	uint32_t startColumn;
+	uint32_t endLine;
+	uint32_t endColumn;
+};
+
+/**
+ * Reads the sequence points of a Portable PDB as specified in
+ * https://github.com/dotnet/runtime/blob/main/src/libraries/System.Reflection.Metadata/specs/PortablePdb-Metadata.md
+ *
+ * The reader only locates the #Pdb, #~, #Blob and #GUID streams and the Document and MethodDebugInformation tables
+ * when opened. Everything else is decoded on demand from the given memory, which must outlive the reader, e.g. a
+ * MappedFile. Windows PDBs and PDBs embedded into assemblies are not supported.
+ */
+class PortablePdb
+{
+public:
+	/** The length of the PDB ID, i.e. the GUID and the timestamp that the assembly's debug directory references. */
+	static const size_t ID_LENGTH = 20;
+
+	/** Locates the tables in the given PDB contents. Returns false if they are not a valid Portable PDB. */
+	bool open(const char* data, size_t size);
+
+	/** The 20 bytes of the PDB ID. */
+	const uint8_t* getId() const {
+		return id;
+	}
+
+	/** The number of rows in the Document table. */
+	uint32_t getDocumentCount() const {
+		return documentTable.rowCount;
+	}
+
+	/** Decodes the name of the document with the given row, usually its path. Returns the empty string if it is invalid. */
+	std::string getDocumentName(uint32_t document) const;
+
+	/** The number of rows in the MethodDebugInformation table, which is the number of rows in the MethodDef table. */
+	uint32_t getMethodCount() const {
+		return methodTable.rowCount;
+	}
+
+	/**
+	 * Replaces the given sequence points with those of the method with the given row. Hidden sequence points are
+	 * skipped. Returns false if the sequence points are malformed.
+	 */
+	bool readSequencePoints(uint32_t method, std::vector<SequencePoint>& points) const;
+
+private:
+	/** A table in the #~ stream. */
+	struct Table {
+		const uint8_t* rows = NULL;
+		uint32_t rowCount = 0;
+		uint32_t rowSize = 0;
+	};
+
+	/** A blob or its remaining bytes. */
+	struct Blob {
+		const uint8_t* data;
+		const uint8_t* end;
+	};
+
+	uint8_t id[ID_LENGTH] = {};
+
+	/** The bounds of the #Blob and #GUID heaps. */
+	const uint8_t* blobHeap = NULL;
+	uint32_t blobHeapSize = 0;
+	const uint8_t* guidHeap = NULL;
+	uint32_t guidHeapSize = 0;
+
+	/** The size of blob and GUID heap indices, which is 2 or 4 bytes. */
+	uint32_t blobIndexSize = 2;
+	uint32_t guidIndexSize = 2;
+
+	/** The size of Document row indices, which is 2 or 4 bytes. */
+	uint32_t documentIndexSize = 2;
+
+	Table documentTable;
+	Table methodTable;
+
+	/** Parses the #~ stream. */
+	bool openTables(const uint8_t* stream, uint32_t size, uint8_t heapSizes);
+
+	/** Returns the blob at the given index into the #Blob heap. The blob is empty if the index is invalid. */
+	Blob getBlob(uint32_t index) const;
+
+	/** Reads a 2 or 4 byte index from a row. */
+	static uint32_t readIndex(const uint8_t* position, uint32_t size);
+
+	/** Reads a compressed unsigned integer (ECMA-335 II.23.2). Returns false if the blob ends first. */
+	static bool readCompressedUnsigned(Blob& blob, uint32_t& value);
+
+	/** Reads a compressed signed integer as specified for Portable PDBs. Returns false if the blob ends first. */
+	static bool readCompressedSigned(Blob& blob, int32_t& value);
+};
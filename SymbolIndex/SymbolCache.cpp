@@ -0,0 +1,58 @@
+#include "SymbolCache.h"
+#include "PortablePdb.h"
+#include "platform/Platform.h"
+#include <cstdio>
+
+SymbolCache::SymbolCache(const std::string& directory) : directory(directory) {
+	Platform::createDirectory(directory);
+}
+
+std::unique_ptr<SymbolIndexFile> SymbolCache::getIndex(const std::string& pdbPath) {
+	MappedFile pdbFile;
+	PortablePdb pdb;
+	if (!pdbFile.open(pdbPath) || !pdb.open(pdbFile.getData(), pdbFile.getSize())) {
+		return NULL;
+	}
+
+	std::string indexPath = getIndexPath(pdb.getId());
+	std::unique_ptr<SymbolIndexFile> index(new SymbolIndexFile());
+	if (index->open(indexPath) && index->isIndexOf(pdb.getId(), pdbFile.getSize())) {
+		reusedCount++;
+		return index;
+	}
+
+	MethodLineIndex methodLines;
+	if (!methodLines.build(pdb)) {
+		return NULL;
+	}
+	// the index must not be mapped while it is replaced, and a half-written file must never have the final name
+	index.reset(new SymbolIndexFile());
+	std::string temporaryPath = indexPath + "." + std::to_string(Platform::getProcessId()) + "." +
+		std::to_string(Platform::getThreadId()) + ".tmp";
+	if (!SymbolIndexFile::write(temporaryPath, pdb.getId(), pdbFile.getSize(), methodLines)) {
+		Platform::removeFile(temporaryPath);
+		return NULL;
+	}
+	if (std::rename(temporaryPath.c_str(), indexPath.c_str()) != 0) {
+		// on Windows, renaming fails if another process wrote the same index in the meantime
+		Platform::removeFile(indexPath);
+		if (std::rename(temporaryPath.c_str(), indexPath.c_str()) != 0) {
+			Platform::removeFile(temporaryPath);
+		}
+	}
+	if (!index->open(indexPath) || !index->isIndexOf(pdb.getId(), pdbFile.getSize())) {
+		return NULL;
+	}
+	builtCount++;
+	return index;
+}
+
+std::string SymbolCache::getIndexPath(const uint8_t* pdbId) const {
+	std::string name;
+	char hex[3];
+	for (size_t i = 0; i < PortablePdb::ID_LENGTH; i++) {
+		snprintf(hex, sizeof(hex), "%02x", pdbId[i]);
+		name += hex;
+	}
+	return directory + Platform::PATH_SEPARATOR + name + ".symbols";
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "SymbolIndexFile.h"
+#include <atomic>
+#include <memory>
+#include <string>
+
+/**
+ * A directory of index files, one per PDB. Index files are named after the ID of their PDB, which changes whenever the
+ * PDB is rebuilt. Finding the index of a PDB thus only reads the PDB's headers, and a changed PDB gets a new index
+ * instead of a stale one. Index files of PDBs that no longer exist are never read again and may be deleted at any time.
+ *
+ * Several threads and processes may share the directory: index files are written to a temporary file and then renamed.
+ */
+class SymbolCache
+{
+public:
+	/** Uses the given directory, which is created if it does not exist. */
+	SymbolCache(const std::string& directory);
+
+	/** Returns the index of the given Portable PDB, building it if it is not cached yet. Returns NULL if the PDB cannot be read. */
+	std::unique_ptr<SymbolIndexFile> getIndex(const std::string& pdbPath);
+
+	/** The number of indices that getIndex() built or found in the directory. */
+	size_t getBuiltCount() const {
+		return builtCount;
+	}
+	size_t getReusedCount() const {
+		return reusedCount;
+	}
+
+private:
+	std::string directory;
+	std::atomic<size_t> builtCount{ 0 };
+	std::atomic<size_t> reusedCount{ 0 };
+
+	/** Returns the path of the index of the PDB with the given ID. */
+	std::string getIndexPath(const uint8_t* pdbId) const;
+};
@@ -0,0 +1,84 @@
+#include "SymbolIndexFile.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+/** Changes whenever the layout of index files changes, so old files are rebuilt instead of misread. */
+static const char MAGIC[8] = { 'T', 'S', 'S', 'Y', 'M', 'I', 'X', '1' };
+
+bool SymbolIndexFile::write(const std::string& path, const uint8_t* pdbId, uint64_t pdbSize, const MethodLineIndex& index) {
+	Header header;
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	memcpy(header.pdbId, pdbId, PortablePdb::ID_LENGTH);
+	header.rangeCount = static_cast<uint32_t>(index.getRanges().size());
+	header.pdbSize = pdbSize;
+	header.documentCount = static_cast<uint32_t>(index.getDocuments().size());
+
+	std::vector<uint32_t> nameOffsets;
+	std::string names;
+	for (const std::string& document : index.getDocuments()) {
+		nameOffsets.push_back(static_cast<uint32_t>(names.size()));
+		names += document;
+	}
+	nameOffsets.push_back(static_cast<uint32_t>(names.size()));
+	header.namesSize = static_cast<uint32_t>(names.size());
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(index.getRanges().data()), index.getRanges().size() * sizeof(MethodLines));
+	file.write(reinterpret_cast<const char*>(nameOffsets.data()), nameOffsets.size() * sizeof(uint32_t));
+	file.write(names.data(), names.size());
+	file.close();
+	return !file.fail();
+}
+
+bool SymbolIndexFile::open(const std::string& path) {
+	header = NULL;
+	if (!file.open(path) || file.getSize() < sizeof(Header)) {
+		return false;
+	}
+	const Header* candidate = reinterpret_cast<const Header*>(file.getData());
+	if (memcmp(candidate->magic, MAGIC, sizeof(MAGIC)) != 0) {
+		return false;
+	}
+	uint64_t expectedSize = sizeof(Header) + static_cast<uint64_t>(candidate->rangeCount) * sizeof(MethodLines) +
+		(static_cast<uint64_t>(candidate->documentCount) + 1) * sizeof(uint32_t) + candidate->namesSize;
+	if (file.getSize() != expectedSize) {
+		// e.g. a process that wrote it crashed
+		return false;
+	}
+
+	header = candidate;
+	ranges = reinterpret_cast<const MethodLines*>(file.getData() + sizeof(Header));
+	nameOffsets = reinterpret_cast<const uint32_t*>(ranges + header->rangeCount);
+	names = reinterpret_cast<const char*>(nameOffsets + header->documentCount + 1);
+	return true;
+}
+
+bool SymbolIndexFile::isIndexOf(const uint8_t* pdbId, uint64_t pdbSize) const {
+	return header != NULL && header->pdbSize == pdbSize && memcmp(header->pdbId, pdbId, PortablePdb::ID_LENGTH) == 0;
+}
+
+std::pair<const MethodLines*, const MethodLines*> SymbolIndexFile::find(uint32_t token) const {
+	const MethodLines* end = ranges + header->rangeCount;
+	const MethodLines* first = std::lower_bound(ranges, end, token, [](const MethodLines& lines, uint32_t value) {
+		return lines.token < value;
+	});
+	const MethodLines* last = first;
+	while (last != end && last->token == token) {
+		last++;
+	}
+	return std::make_pair(first, last);
+}
+
+std::string SymbolIndexFile::getDocumentName(uint32_t document) const {
+	if (document >= header->documentCount) {
+		return "";
+	}
+	uint32_t start = nameOffsets[document];
+	uint32_t end = nameOffsets[document + 1];
+	if (start > end || end > header->namesSize) {
+		return "";
+	}
+	return std::string(names + start, end - start);
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "MethodLineIndex.h"
+#include "platform/MappedFile.h"
+#include <cstdint>
+#include <string>
+
+/**
+ * A MethodLineIndex stored in a file that is used by mapping it into memory, so looking up methods needs no parsing.
+ *
+ * The file starts with a header that identifies the PDB it was built from, followed by the ranges sorted by token,
+ * the offsets of the document names and the names themselves. All numbers are little-endian.
+ */
+class SymbolIndexFile
+{
+public:
+	/** Writes the index of the PDB with the given ID and size. Returns false if that fails. */
+	static bool write(const std::string& path, const uint8_t* pdbId, uint64_t pdbSize, const MethodLineIndex& index);
+
+	/** Maps the given index file. Returns false if it cannot be read or is not a complete index file of this version. */
+	bool open(const std::string& path);
+
+	/** Whether the index was built from the PDB with the given ID and size. */
+	bool isIndexOf(const uint8_t* pdbId, uint64_t pdbSize) const;
+
+	/** Returns the ranges of the given method like MethodLineIndex::find(). */
+	std::pair<const MethodLines*, const MethodLines*> find(uint32_t token) const;
+
+	/** The number of documents. */
+	uint32_t getDocumentCount() const {
+		return header->documentCount;
+	}
+
+	/** Returns the name of the document with the given index or the empty string if the index is invalid. */
+	std::string getDocumentName(uint32_t document) const;
+
+private:
+	/** The first bytes of an index file. */
+	struct Header {
+		/** Identifies index files and their version. */
+		char magic[8];
+		uint8_t pdbId[PortablePdb::ID_LENGTH];
+		uint32_t rangeCount;
+		/** The size of the PDB, in case a tool rewrote the PDB in place and kept its ID. */
+		uint64_t pdbSize;
+		uint32_t documentCount;
+		uint32_t namesSize;
+	};
+
+	MappedFile file;
+	const Header* header = NULL;
+	const MethodLines* ranges = NULL;
+	/** The offsets of all document names and the end of the last one. */
+	const uint32_t* nameOffsets = NULL;
+	const char* names = NULL;
+};
@@ -0,0 +1,66 @@
+#include "SymbolCache.h"
+#include "platform/Platform.h"
+#include <cctype>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * Builds the index files of Portable PDBs ahead of time, e.g. right after the build that produced them, so converting
+ * traces to line coverage later only maps the indices.
+ *
+ * Usage: SymbolIndexer.exe --cache=<index directory> <PDB file or directory>...
+ *
+ * Directories are expanded to the *.pdb files they contain. Windows PDBs are skipped, as the upload daemon reads those.
+ */
+
+/** Whether the given file name ends with .pdb in any case. */
+static bool isPdbFileName(const std::string& name) {
+	if (name.size() < 4) {
+		return false;
+	}
+	std::string extension = name.substr(name.size() - 4);
+	for (char& character : extension) {
+		character = static_cast<char>(tolower(character));
+	}
+	return extension == ".pdb";
+}
+
+int main(int argc, char** argv) {
+	std::string cacheDirectory;
+	std::vector<std::string> paths;
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		if (argument.compare(0, 8, "--cache=") == 0) {
+			cacheDirectory = argument.substr(8);
+		}
+		else if (Platform::isFile(argument)) {
+			paths.push_back(argument);
+		}
+		else {
+			for (const std::string& name : Platform::listFiles(argument)) {
+				if (isPdbFileName(name)) {
+					paths.push_back(argument + Platform::PATH_SEPARATOR + name);
+				}
+			}
+		}
+	}
+	if (cacheDirectory.empty() || paths.empty()) {
+		fprintf(stderr, "Usage: SymbolIndexer --cache=<index directory> <PDB file or directory>...\n");
+		return 2;
+	}
+
+	SymbolCache cache(cacheDirectory);
+	size_t skippedCount = 0;
+	uint64_t start = Platform::getMonotonicMicroseconds();
+	for (const std::string& path : paths) {
+		if (cache.getIndex(path) == NULL) {
+			printf("Skipped %s, which is not a readable Portable PDB\n", path.c_str());
+			skippedCount++;
+		}
+	}
+	double milliseconds = (Platform::getMonotonicMicroseconds() - start) / 1000.0;
+	printf("Built %zu, reused %zu and skipped %zu symbol indices in %.1f ms\n", cache.getBuiltCount(), cache.getReusedCount(),
+		skippedCount, milliseconds);
+	return 0;
+}
@@ -0,0 +1,143 @@
+#include "TraceCompression.h"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/** Shorter matches would take more bytes than the literals they replace. */
+static const size_t MIN_MATCH = 4;
+
+/** Distances are stored in 16 bits. */
+static const size_t MAX_DISTANCE = 0xFFFF;
+
+/** The hash table maps the hashes of 4 bytes to their last position, so it fits into the L2 cache. */
+static const int HASH_BITS = 14;
+
+/** A length that does not fit into its half of the token is stored as 15 followed by the rest in bytes of up to 255. */
+static const size_t LENGTH_MASK = 15;
+
+static uint32_t read32(const uint8_t* position) {
+	uint32_t value;
+	memcpy(&value, position, sizeof(value));
+	return value;
+}
+
+static void writeLength(std::string& output, size_t length) {
+	for (; length >= 255; length -= 255) {
+		output += static_cast<char>(255);
+	}
+	output += static_cast<char>(length);
+}
+
+/** Writes a sequence of literals followed by a match. The last sequence has only literals and no distance. */
+static void writeSequence(std::string& output, const uint8_t* literals, size_t literalLength, size_t distance, size_t matchLength) {
+	bool isLast = matchLength == 0;
+	size_t matchExtra = isLast ? 0 : matchLength - MIN_MATCH;
+	size_t literalNibble = literalLength < LENGTH_MASK ? literalLength : LENGTH_MASK;
+	size_t matchNibble = matchExtra < LENGTH_MASK ? matchExtra : LENGTH_MASK;
+	output += static_cast<char>((literalNibble << 4) | matchNibble);
+	if (literalNibble == LENGTH_MASK) {
+		writeLength(output, literalLength - LENGTH_MASK);
+	}
+	output.append(reinterpret_cast<const char*>(literals), literalLength);
+	if (isLast) {
+		return;
+	}
+	output += static_cast<char>(distance & 0xFF);
+	output += static_cast<char>(distance >> 8);
+	if (matchNibble == LENGTH_MASK) {
+		writeLength(output, matchExtra - LENGTH_MASK);
+	}
+}
+
+/** Reads the rest of a length whose nibble was 15. Returns false if the data ends first. */
+static bool readLength(const uint8_t*& position, const uint8_t* end, size_t& length) {
+	uint8_t part;
+	do {
+		if (position >= end) {
+			return false;
+		}
+		part = *position++;
+		length += part;
+	} while (part == 255);
+	return true;
+}
+
+std::string compressTrace(const char* data, size_t size) {
+	const uint8_t* input = reinterpret_cast<const uint8_t*>(data);
+	std::string output;
+	output.reserve(size / 4 + 16);
+
+	// positions are stored plus 1, so 0 marks empty slots
+	std::vector<uint32_t> table(static_cast<size_t>(1) << HASH_BITS, 0);
+	size_t literalStart = 0;
+	size_t position = 0;
+	while (position + MIN_MATCH <= size) {
+		uint32_t bytes = read32(input + position);
+		uint32_t hash = (bytes * 2654435761u) >> (32 - HASH_BITS);
+		size_t candidate = table[hash];
+		table[hash] = static_cast<uint32_t>(position + 1);
+		if (candidate == 0 || position - (candidate - 1) > MAX_DISTANCE || read32(input + candidate - 1) != bytes) {
+			// skip faster through data that does not compress, like LZ4 does
+			position += 1 + ((position - literalStart) >> 6);
+			continue;
+		}
+		candidate--;
+
+		size_t length = MIN_MATCH;
+		while (position + length < size && input[candidate + length] == input[position + length]) {
+			length++;
+		}
+		writeSequence(output, input + literalStart, position - literalStart, position - candidate, length);
+		position += length;
+		literalStart = position;
+	}
+	writeSequence(output, input + literalStart, size - literalStart, 0, 0);
+	return output;
+}
+
+bool decompressTrace(const char* data, size_t size, size_t originalSize, std::string& output) {
+	const uint8_t* position = reinterpret_cast<const uint8_t*>(data);
+	const uint8_t* end = position + size;
+	output.assign(originalSize, '\0');
+	char* target = &output[0];
+	size_t written = 0;
+
+	// the data always ends with a sequence of only literals, so data that ends after a match was truncated
+	while (position < end) {
+		uint8_t token = *position++;
+		size_t literalLength = token >> 4;
+		if (literalLength == LENGTH_MASK && !readLength(position, end, literalLength)) {
+			return false;
+		}
+		if (literalLength > static_cast<size_t>(end - position) || literalLength > originalSize - written) {
+			return false;
+		}
+		memcpy(target + written, position, literalLength);
+		position += literalLength;
+		written += literalLength;
+		if (position == end) {
+			return written == originalSize;
+		}
+
+		if (end - position < 2) {
+			return false;
+		}
+		size_t distance = position[0] | (position[1] << 8);
+		position += 2;
+		size_t matchLength = token & LENGTH_MASK;
+		if (matchLength == LENGTH_MASK && !readLength(position, end, matchLength)) {
+			return false;
+		}
+		matchLength += MIN_MATCH;
+		if (distance == 0 || distance > written || matchLength > originalSize - written) {
+			return false;
+		}
+		// matches may overlap their own output, e.g. runs of the same byte, so copy byte by byte
+		const char* source = target + written - distance;
+		for (size_t i = 0; i < matchLength; i++) {
+			target[written + i] = source[i];
+		}
+		written += matchLength;
+	}
+	return false;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+/**
+ * Compresses the given bytes with a byte-oriented LZ77 coder in the style of LZ4's block format: each sequence is a
+ * token with the literal and match lengths, the literals and the 16-bit distance of the match. Trace files repeat their
+ * line prefixes and most digits of the tokens, so this already shrinks them several times at memcpy-like speed, and the
+ * tools need no compression library.
+ */
+std::string compressTrace(const char* data, size_t size);
+
+/**
+ * Replaces output with the decompressed bytes. Returns false if the data is malformed or does not decompress to
+ * exactly the given size, which is stored next to the compressed bytes.
+ */
+bool decompressTrace(const char* data, size_t size, size_t originalSize, std::string& output);
@@ -0,0 +1,254 @@
+#include "TracePack.h"
+#include "TraceCompression.h"
+#include "platform/MappedFile.h"
+#include "platform/Platform.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+const char* const TracePack::PACK_EXTENSION = ".tracepack";
+const char* const TracePack::INDEX_EXTENSION = ".traceindex";
+
+/** Changes whenever the layout of records or index entries changes. */
+static const char MAGIC[8] = { 'T', 'S', 'T', 'R', 'P', 'A', 'K', '1' };
+
+static const int64_t SECONDS_PER_DAY = 86400;
+
+/** Returns the days since 1970-01-01 of the given date, see http://howardhinnant.github.io/date_algorithms.html */
+static int64_t getDaysSinceEpoch(int year, int month, int day) {
+	year -= month <= 2;
+	int64_t era = (year >= 0 ? year : year - 399) / 400;
+	int64_t yearOfEra = year - era * 400;
+	int64_t dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+	int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+	return era * 146097 + dayOfEra - 719468;
+}
+
+TracePack::TracePack(const std::string& directory) : directory(directory) {
+	Platform::createDirectory(directory);
+}
+
+bool TracePack::append(const std::string& name, const char* data, size_t size, int64_t time) {
+	if (size > UINT32_MAX || name.size() > UINT32_MAX) {
+		return false;
+	}
+	std::string segmentName = getSegmentName(time);
+	if (segmentName != segment && !openSegment(segmentName)) {
+		return false;
+	}
+	time = std::max(time, latestTime);
+
+	std::string compressed = compressTrace(data, size);
+	if (compressed.size() > UINT32_MAX) {
+		return false;
+	}
+	RecordHeader header;
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.time = time;
+	header.originalSize = static_cast<uint32_t>(size);
+	header.compressedSize = static_cast<uint32_t>(compressed.size());
+	header.nameLength = static_cast<uint32_t>(name.size());
+	header.checksum = computeChecksum(data, size);
+	IndexEntry entry = { time, packSize, header.originalSize, header.compressedSize, header.nameLength, header.checksum };
+
+	std::string record(reinterpret_cast<const char*>(&header), sizeof(header));
+	record += name;
+	record += compressed;
+	if (!packFile.write(record.data(), record.size())) {
+		// the pack's size is unknown now, so the next append reopens the segment
+		closeSegment();
+		return false;
+	}
+	packSize += record.size();
+	if (!indexFile.write(reinterpret_cast<const char*>(&entry), sizeof(entry))) {
+		closeSegment();
+		return false;
+	}
+	latestTime = time;
+	return true;
+}
+
+bool TracePack::openSegment(const std::string& name) {
+	closeSegment();
+	std::string indexPath = getPath(name, INDEX_EXTENSION);
+	latestTime = 0;
+	int64_t indexSize = Platform::getFileSize(indexPath);
+	if (indexSize > 0) {
+		MappedFile index;
+		if (!index.open(indexPath)) {
+			return false;
+		}
+		size_t count = index.getSize() / sizeof(IndexEntry);
+		if (count > 0) {
+			IndexEntry latest;
+			memcpy(&latest, index.getData() + (count - 1) * sizeof(IndexEntry), sizeof(IndexEntry));
+			latestTime = latest.time;
+		}
+
+		if (index.getSize() % sizeof(IndexEntry) != 0) {
+			// a crash tore the last entry. Appending after it would misalign all later ones, so the index is rewritten
+			std::string temporaryPath = indexPath + ".tmp";
+			std::ofstream rewritten(temporaryPath, std::ios::binary | std::ios::trunc);
+			rewritten.write(index.getData(), count * sizeof(IndexEntry));
+			rewritten.close();
+			index.close();
+			if (!rewritten || !Platform::removeFile(indexPath) || std::rename(temporaryPath.c_str(), indexPath.c_str()) != 0) {
+				Platform::removeFile(temporaryPath);
+				return false;
+			}
+		}
+	}
+
+	std::string packPath = getPath(name, PACK_EXTENSION);
+	int64_t size = Platform::getFileSize(packPath);
+	packSize = size > 0 ? static_cast<uint64_t>(size) : 0;
+	if (!packFile.open(packPath, File::APPEND) || !indexFile.open(indexPath, File::APPEND)) {
+		closeSegment();
+		return false;
+	}
+	segment = name;
+	return true;
+}
+
+void TracePack::closeSegment() {
+	packFile.close();
+	indexFile.close();
+	segment.clear();
+}
+
+std::vector<TracePack::Entry> TracePack::list(int64_t from, int64_t to) const {
+	std::vector<Entry> entries;
+	for (const std::string& segmentName : listSegments()) {
+		MappedFile index;
+		MappedFile pack;
+		if (!index.open(getPath(segmentName, INDEX_EXTENSION)) || !pack.open(getPath(segmentName, PACK_EXTENSION))) {
+			continue;
+		}
+		const IndexEntry* first = reinterpret_cast<const IndexEntry*>(index.getData());
+		const IndexEntry* last = first + index.getSize() / sizeof(IndexEntry);
+		const IndexEntry* start = std::lower_bound(first, last, from, [](const IndexEntry& entry, int64_t time) {
+			return entry.time < time;
+		});
+		for (const IndexEntry* entry = start; entry != last && entry->time < to; entry++) {
+			if (!isValid(*entry, pack.getData(), pack.getSize())) {
+				continue;
+			}
+			const char* name = pack.getData() + entry->offset + sizeof(RecordHeader);
+			entries.push_back({ entry->time, std::string(name, entry->nameLength), segmentName, entry->offset,
+				entry->originalSize, entry->compressedSize, entry->checksum });
+		}
+	}
+	return entries;
+}
+
+bool TracePack::read(const Entry& entry, std::string& contents) const {
+	contents.clear();
+	MappedFile pack;
+	if (!pack.open(getPath(entry.segment, PACK_EXTENSION))) {
+		return false;
+	}
+	uint64_t dataOffset = entry.offset + sizeof(RecordHeader) + entry.name.size();
+	if (dataOffset > pack.getSize() || entry.compressedSize > pack.getSize() - dataOffset) {
+		return false;
+	}
+	const char* data = pack.getData() + dataOffset;
+	return decompressTrace(data, entry.compressedSize, entry.originalSize, contents) &&
+		computeChecksum(contents.data(), contents.size()) == entry.checksum;
+}
+
+size_t TracePack::purge(int64_t cutoff) {
+	size_t deletedCount = 0;
+	for (const std::string& segmentName : listSegments()) {
+		std::string indexPath = getPath(segmentName, INDEX_EXTENSION);
+		size_t count = 0;
+		{
+			MappedFile index;
+			if (!index.open(indexPath)) {
+				continue;
+			}
+			count = index.getSize() / sizeof(IndexEntry);
+			if (count > 0 && reinterpret_cast<const IndexEntry*>(index.getData())[count - 1].time > cutoff) {
+				continue;
+			}
+		}
+
+		// Windows cannot delete open files
+		if (segmentName == segment) {
+			closeSegment();
+		}
+		// without its index, nothing in the pack is visible anymore, so the index goes first
+		if (Platform::removeFile(indexPath)) {
+			Platform::removeFile(getPath(segmentName, PACK_EXTENSION));
+			deletedCount += count;
+		}
+	}
+	return deletedCount;
+}
+
+int64_t TracePack::getCurrentTime() {
+	Platform::UtcTime now;
+	Platform::getUtcTime(now);
+	return getDaysSinceEpoch(now.year, now.month, now.day) * SECONDS_PER_DAY + now.hour * 3600 + now.minute * 60 + now.second;
+}
+
+std::string TracePack::getSegmentName(int64_t time) {
+	// the inverse of getDaysSinceEpoch(), see there
+	int64_t days = (time >= 0 ? time : time - SECONDS_PER_DAY + 1) / SECONDS_PER_DAY + 719468;
+	int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+	int64_t dayOfEra = days - era * 146097;
+	int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+	int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+	int64_t shiftedMonth = (5 * dayOfYear + 2) / 153;
+	int64_t day = dayOfYear - (153 * shiftedMonth + 2) / 5 + 1;
+	int64_t month = shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9;
+	int64_t year = yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+
+	// large enough for three 64 bit numbers, so the name is never truncated
+	char name[64];
+	snprintf(name, sizeof(name), "%04lld-%02lld-%02lld", static_cast<long long>(year), static_cast<long long>(month),
+		static_cast<long long>(day));
+	return name;
+}
+
+bool TracePack::isSegmentFile(const std::string& name) {
+	// also matches the temporary files of rewritten indices
+	return name.find(PACK_EXTENSION) != std::string::npos || name.find(INDEX_EXTENSION) != std::string::npos;
+}
+
+std::vector<std::string> TracePack::listSegments() const {
+	std::vector<std::string> segments;
+	size_t extensionLength = strlen(INDEX_EXTENSION);
+	for (const std::string& name : Platform::listFiles(directory)) {
+		if (name.size() > extensionLength && name.compare(name.size() - extensionLength, extensionLength, INDEX_EXTENSION) == 0) {
+			segments.push_back(name.substr(0, name.size() - extensionLength));
+		}
+	}
+	// the names are dates, so this is the time order
+	std::sort(segments.begin(), segments.end());
+	return segments;
+}
+
+std::string TracePack::getPath(const std::string& segmentName, const char* extension) const {
+	return directory + Platform::PATH_SEPARATOR + segmentName + extension;
+}
+
+bool TracePack::isValid(const IndexEntry& entry, const char* pack, size_t packSize) {
+	if (entry.offset > packSize || sizeof(RecordHeader) > packSize - entry.offset) {
+		return false;
+	}
+	RecordHeader header;
+	memcpy(&header, pack + entry.offset, sizeof(header));
+	uint64_t recordSize = sizeof(RecordHeader) + static_cast<uint64_t>(entry.nameLength) + entry.compressedSize;
+	return memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 && header.time == entry.time &&
+		header.originalSize == entry.originalSize && header.compressedSize == entry.compressedSize &&
+		header.nameLength == entry.nameLength && header.checksum == entry.checksum && recordSize <= packSize - entry.offset;
+}
+
+uint32_t TracePack::computeChecksum(const char* data, size_t size) {
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < size; i++) {
+		hash = (hash ^ static_cast<uint8_t>(data[i])) * 16777619u;
+	}
+	return hash;
+}
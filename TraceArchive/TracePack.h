@@ -0,0 +1,119 @@
+#pragma once
+#include "platform/File.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * An archive directory of the upload daemon (e.g. uploaded or empty-traces) whose traces are appended to one pack
+ * segment per UTC day instead of being kept as one file each, so adding a trace is an append and purging deletes whole
+ * days.
+ *
+ * Each segment consists of two files named after its day:
+ *  - <yyyy-mm-dd>.tracepack holds the records, i.e. a header, the trace's file name and its compressed contents.
+ *  - <yyyy-mm-dd>.traceindex holds one fixed-size entry per record, ordered by archive time.
+ * A record only becomes visible once its index entry is written, so a crash in between leaves unreferenced bytes in
+ * the pack but never a broken trace. Entries that do not match their record are skipped.
+ *
+ * Only one process may append to a directory at a time, which the upload daemon and the packer tool ensure by
+ * running one after the other. Listing and reading work while another process appends.
+ */
+class TracePack
+{
+public:
+	/** A trace in the pack. */
+	struct Entry {
+		/** The archive time in seconds since 1970-01-01 UTC. */
+		int64_t time;
+		/** The file name of the trace. */
+		std::string name;
+		/** The day of the segment that holds the trace, which names its files. */
+		std::string segment;
+		uint64_t offset;
+		uint32_t originalSize;
+		uint32_t compressedSize;
+		uint32_t checksum;
+	};
+
+	/** File name extensions of segment files. */
+	static const char* const PACK_EXTENSION;
+	static const char* const INDEX_EXTENSION;
+
+	/** Uses the given directory, which is created if it does not exist. */
+	TracePack(const std::string& directory);
+
+	/**
+	 * Compresses and appends the given trace with the given archive time. Times within a segment never decrease, so a
+	 * time earlier than the latest one of its segment is raised to it. Returns false if writing fails.
+	 */
+	bool append(const std::string& name, const char* data, size_t size, int64_t time);
+
+	/** Returns the traces archived at or after from and before to, ordered by time. */
+	std::vector<Entry> list(int64_t from, int64_t to) const;
+
+	/** Replaces contents with the decompressed trace. Returns false if it cannot be read or is corrupt. */
+	bool read(const Entry& entry, std::string& contents) const;
+
+	/** Deletes the segments whose latest trace is not newer than the given time. Returns the number of deleted traces. */
+	size_t purge(int64_t cutoff);
+
+	/** The current time in seconds since 1970-01-01 UTC. */
+	static int64_t getCurrentTime();
+
+	/** The name of the segment that holds traces archived at the given time, i.e. its UTC day. */
+	static std::string getSegmentName(int64_t time);
+
+	/** Whether the given file name is that of a segment file, so it is not mistaken for a trace. */
+	static bool isSegmentFile(const std::string& name);
+
+private:
+	/** An entry of the index file. All numbers are little-endian. */
+	struct IndexEntry {
+		int64_t time;
+		uint64_t offset;
+		uint32_t originalSize;
+		uint32_t compressedSize;
+		uint32_t nameLength;
+		/** The FNV-1a hash of the original trace, which detects corrupt records. */
+		uint32_t checksum;
+	};
+
+	/** The header of a record in the pack file, which repeats its index entry but the offset. */
+	struct RecordHeader {
+		/** Identifies records and their version. */
+		char magic[8];
+		int64_t time;
+		uint32_t originalSize;
+		uint32_t compressedSize;
+		uint32_t nameLength;
+		uint32_t checksum;
+	};
+
+	std::string directory;
+
+	/** The segment that the open files belong to or the empty string if none is open. */
+	std::string segment;
+	File packFile;
+	File indexFile;
+	uint64_t packSize = 0;
+	int64_t latestTime = 0;
+
+	/** Opens the files of the given segment for appending. Returns false if that fails. */
+	bool openSegment(const std::string& name);
+
+	/** Closes the files of the open segment. */
+	void closeSegment();
+
+	/** Returns the sorted names of all segments that have an index file. */
+	std::vector<std::string> listSegments() const;
+
+	/** Returns the path of the given file of the given segment. */
+	std::string getPath(const std::string& segmentName, const char* extension) const;
+
+	/** Whether the index entry matches its record in the given pack contents. */
+	static bool isValid(const IndexEntry& entry, const char* pack, size_t packSize);
+
+	/** Computes the checksum of a trace. */
+	static uint32_t computeChecksum(const char* data, size_t size);
+};
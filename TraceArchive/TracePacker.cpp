@@ -0,0 +1,148 @@
+#include "TracePack.h"
+#include "platform/MappedFile.h"
+#include "platform/Platform.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Maintains the packed trace archives of the upload daemon, see TracePack.
+ *
+ * Usage: TracePacker.exe pack <archive directory> [<trace file or directory>...]
+ *        TracePacker.exe list <archive directory>
+ *        TracePacker.exe extract <archive directory> <output directory>
+ *        TracePacker.exe purge <archive directory> <maximum age in days>
+ *
+ * pack appends the given traces to the archive and deletes them. Without traces, it packs the loose files in the
+ * archive directory itself, e.g. those that the upload daemon moved to its uploaded directory. Traces are archived
+ * with their modification time, so purging treats them like the daemon treats loose files.
+ */
+
+/** Appends the file or, if it is a directory, the files in it that are not segment files. */
+static void addFiles(const std::string& path, std::vector<std::string>& paths) {
+	if (Platform::isFile(path)) {
+		paths.push_back(path);
+		return;
+	}
+	for (const std::string& name : Platform::listFiles(path)) {
+		if (!TracePack::isSegmentFile(name)) {
+			paths.push_back(path + Platform::PATH_SEPARATOR + name);
+		}
+	}
+}
+
+/** Returns the file name of the given path. */
+static std::string getFileName(const std::string& path) {
+	size_t separator = path.find_last_of("/\\");
+	return separator == std::string::npos ? path : path.substr(separator + 1);
+}
+
+static int pack(TracePack& archive, const std::string& archiveDirectory, const std::vector<std::string>& sources) {
+	std::vector<std::string> paths;
+	if (sources.empty()) {
+		addFiles(archiveDirectory, paths);
+	}
+	for (const std::string& source : sources) {
+		addFiles(source, paths);
+	}
+
+	// oldest first, so the times in each segment are the modification times
+	std::vector<std::pair<int64_t, std::string>> files;
+	for (const std::string& path : paths) {
+		files.push_back(std::make_pair(Platform::getModificationTime(path), path));
+	}
+	std::sort(files.begin(), files.end());
+
+	size_t packedCount = 0;
+	uint64_t originalSize = 0;
+	uint64_t start = Platform::getMonotonicMicroseconds();
+	for (const std::pair<int64_t, std::string>& file : files) {
+		MappedFile trace;
+		if (file.first < 0 || !trace.open(file.second)) {
+			fprintf(stderr, "Could not read %s\n", file.second.c_str());
+			continue;
+		}
+		if (!archive.append(getFileName(file.second), trace.getData(), trace.getSize(), file.first)) {
+			fprintf(stderr, "Could not archive %s: %s\n", file.second.c_str(), Platform::getLastErrorMessage().c_str());
+			return 1;
+		}
+		originalSize += trace.getSize();
+		trace.close();
+		// the trace is safely archived, so failing to delete it only archives it twice
+		if (!Platform::removeFile(file.second)) {
+			fprintf(stderr, "Could not delete %s after archiving it\n", file.second.c_str());
+		}
+		packedCount++;
+	}
+	double milliseconds = (Platform::getMonotonicMicroseconds() - start) / 1000.0;
+	printf("Packed %zu traces of %.1f MB in %.1f ms\n", packedCount, originalSize / 1e6, milliseconds);
+	return 0;
+}
+
+static int list(const TracePack& archive) {
+	uint64_t originalSize = 0;
+	uint64_t compressedSize = 0;
+	std::vector<TracePack::Entry> entries = archive.list(INT64_MIN, INT64_MAX);
+	for (const TracePack::Entry& entry : entries) {
+		printf("%s %lld %u %s\n", entry.segment.c_str(), static_cast<long long>(entry.time), entry.originalSize, entry.name.c_str());
+		originalSize += entry.originalSize;
+		compressedSize += entry.compressedSize;
+	}
+	printf("%zu traces, %.1f MB compressed to %.1f MB\n", entries.size(), originalSize / 1e6, compressedSize / 1e6);
+	return 0;
+}
+
+static int extract(const TracePack& archive, const std::string& outputDirectory) {
+	Platform::createDirectory(outputDirectory);
+	int exitCode = 0;
+	std::string contents;
+	for (const TracePack::Entry& entry : archive.list(INT64_MIN, INT64_MAX)) {
+		std::string path = outputDirectory + Platform::PATH_SEPARATOR + getFileName(entry.name);
+		if (!archive.read(entry, contents)) {
+			fprintf(stderr, "Skipped %s from %s, which is corrupt\n", entry.name.c_str(), entry.segment.c_str());
+			exitCode = 1;
+			continue;
+		}
+		std::ofstream output(path, std::ios::binary | std::ios::trunc);
+		output << contents;
+		output.close();
+		if (!output) {
+			fprintf(stderr, "Could not write %s\n", path.c_str());
+			return 1;
+		}
+	}
+	return exitCode;
+}
+
+int main(int argc, char** argv) {
+	std::string command = argc > 2 ? argv[1] : "";
+	bool isValid = command == "pack" || command == "list" || (argc == 4 && (command == "extract" || command == "purge"));
+	if (!isValid) {
+		fprintf(stderr, "Usage: TracePacker pack <archive directory> [<trace file or directory>...]\n");
+		fprintf(stderr, "       TracePacker list <archive directory>\n");
+		fprintf(stderr, "       TracePacker extract <archive directory> <output directory>\n");
+		fprintf(stderr, "       TracePacker purge <archive directory> <maximum age in days>\n");
+		return 2;
+	}
+
+	std::string archiveDirectory = argv[2];
+	TracePack archive(archiveDirectory);
+	if (command == "pack") {
+		return pack(archive, archiveDirectory, std::vector<std::string>(argv + 3, argv + argc));
+	}
+	if (command == "list") {
+		return list(archive);
+	}
+	if (command == "extract") {
+		return extract(archive, argv[3]);
+	}
+
+	int64_t maximumAge = static_cast<int64_t>(atof(argv[3]) * 86400);
+	size_t deletedCount = archive.purge(TracePack::getCurrentTime() - maximumAge);
+	printf("Purged %zu traces\n", deletedCount);
+	return 0;
+}
@@ -0,0 +1,187 @@
+#include "MergeBenchmark.h"
+#include "ParallelMerge.h"
+#include "platform/Platform.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <regex>
+#include <vector>
+
+/** A reference trace split into the lines that the corpus generator rewrites. */
+struct ReferenceTrace {
+	/** Info=, Started=, Process= and any other lines before the first Assembly= line. */
+	std::vector<std::string> header;
+
+	/** The part of each Assembly= line before the number, e.g. "mscorlib", and the part after it. */
+	std::vector<std::pair<std::string, std::string>> assemblies;
+
+	/** Each coverage line as its key ("Jitted=" or "Inlined="), assembly number and token. */
+	std::vector<std::pair<std::string, std::pair<unsigned int, unsigned int>>> methods;
+};
+
+/** A xorshift generator, so every run generates the same corpus. */
+static uint32_t nextRandom(uint32_t& state) {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+/** Reads the reference traces in the given directory. Lines other than the header, assemblies and methods are dropped. */
+static std::vector<ReferenceTrace> readReferenceTraces(const std::string& directory) {
+	std::vector<ReferenceTrace> traces;
+	for (const std::string& name : Platform::listFiles(directory)) {
+		std::ifstream file(directory + Platform::PATH_SEPARATOR + name);
+		ReferenceTrace trace;
+		std::string line;
+		while (std::getline(file, line)) {
+			if (!line.empty() && line.back() == '\r') {
+				line.pop_back();
+			}
+			unsigned int assemblyNumber = 0;
+			unsigned int token = 0;
+			size_t separator = line.find(':');
+			if (line.compare(0, 9, "Assembly=") == 0 && separator != std::string::npos) {
+				size_t attributes = line.find_first_not_of("0123456789", separator + 1);
+				trace.assemblies.push_back(std::make_pair(line.substr(9, separator - 9),
+					attributes == std::string::npos ? "" : line.substr(attributes)));
+			}
+			else if (sscanf(line.c_str(), "Jitted=%u:%u", &assemblyNumber, &token) == 2) {
+				trace.methods.push_back(std::make_pair("Jitted=", std::make_pair(assemblyNumber, token)));
+			}
+			else if (sscanf(line.c_str(), "Inlined=%u:%u", &assemblyNumber, &token) == 2) {
+				trace.methods.push_back(std::make_pair("Inlined=", std::make_pair(assemblyNumber, token)));
+			}
+			else if (trace.assemblies.empty() && line.find('=') != std::string::npos) {
+				trace.header.push_back(line);
+			}
+		}
+		if (!trace.assemblies.empty()) {
+			traces.push_back(trace);
+		}
+	}
+	return traces;
+}
+
+/**
+ * Writes the corpus and returns the paths of its files. Each file is a reference trace with its assemblies numbered
+ * differently and a random half of its methods, so merging has to map identities and the union grows with every file.
+ */
+static std::vector<std::string> generateCorpus(const std::vector<ReferenceTrace>& traces, const std::string& directory, int fileCount) {
+	std::vector<std::string> paths;
+	uint32_t random = 0x9E3779B9;
+	for (int i = 0; i < fileCount; i++) {
+		const ReferenceTrace& trace = traces[i % traces.size()];
+		size_t assemblyCount = trace.assemblies.size();
+		std::string contents;
+		for (const std::string& line : trace.header) {
+			contents += line + "\r\n";
+		}
+		for (size_t assembly = 0; assembly < assemblyCount; assembly++) {
+			size_t number = (assembly + i) % assemblyCount + 1;
+			contents += "Assembly=" + trace.assemblies[assembly].first + ":" + std::to_string(number) +
+				trace.assemblies[assembly].second + "\r\n";
+		}
+		for (const auto& method : trace.methods) {
+			if (nextRandom(random) % 2 == 0 || method.second.first < 1 || method.second.first > assemblyCount) {
+				continue;
+			}
+			size_t number = (method.second.first - 1 + i) % assemblyCount + 1;
+			contents += method.first + std::to_string(number) + ":" + std::to_string(method.second.second) + "\r\n";
+		}
+		contents += "Stopped=20240101_0000000000\r\n";
+
+		std::string path = directory + "coverage_" + std::to_string(i) + "_0.txt";
+		std::ofstream(path, std::ios::binary) << contents;
+		paths.push_back(path);
+	}
+	return paths;
+}
+
+/** Scans the files like the upload daemon's ParsedTraceFile and returns the number of matched lines. */
+static size_t scanWithRegularExpressions(const std::vector<std::string>& paths) {
+	std::regex assemblyLine("^Assembly=([^:]+):(\\d+)");
+	std::regex coverageLine("^(?:Inlined|Jitted)=(\\d+):(?:\\d+:)?(\\d+)");
+	size_t matches = 0;
+	for (const std::string& path : paths) {
+		std::ifstream file(path);
+		std::string line;
+		std::smatch match;
+		while (std::getline(file, line)) {
+			if (std::regex_search(line, match, assemblyLine) || std::regex_search(line, match, coverageLine)) {
+				matches++;
+			}
+		}
+	}
+	return matches;
+}
+
+/** Prints a timing and returns the elapsed seconds. */
+static double printTiming(const char* name, uint64_t startMicroseconds, size_t fileCount, double megabytes) {
+	double seconds = (Platform::getMonotonicMicroseconds() - startMicroseconds) / 1000000.0;
+	printf("%-28s %10.1f %12.0f %10.1f\n", name, seconds * 1000, fileCount / seconds, megabytes / seconds);
+	return seconds;
+}
+
+int runMergeBenchmark(const MergeBenchmarkOptions& options) {
+	std::vector<ReferenceTrace> traces = readReferenceTraces(options.referenceDirectory);
+	if (traces.empty()) {
+		fprintf(stderr, "Found no reference traces in %s\n", options.referenceDirectory.c_str());
+		return 1;
+	}
+
+	std::string directory = Platform::getTempDirectory() + "TraceMergerBenchmark";
+	Platform::createDirectory(directory);
+	directory += Platform::PATH_SEPARATOR;
+	for (const std::string& name : Platform::listFiles(directory)) {
+		Platform::removeFile(directory + name);
+	}
+	std::vector<std::string> paths = generateCorpus(traces, directory, options.files);
+
+	double megabytes = 0;
+	for (const std::string& path : paths) {
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		megabytes += static_cast<double>(file.tellg()) / (1024 * 1024);
+	}
+	printf("Corpus: %zu files (%.1f MB) generated from %zu reference traces in %s\n\n", paths.size(), megabytes,
+		traces.size(), directory.c_str());
+	printf("%-28s %10s %12s %10s\n", "Merge", "Time [ms]", "Files/sec", "MB/sec");
+
+	// warms up the page cache, so all runs read from memory
+	std::vector<std::string> failedPaths;
+	mergeTraceFiles(paths, options.threads, failedPaths);
+
+	uint64_t start = Platform::getMonotonicMicroseconds();
+	std::string sequential = mergeTraceFiles(paths, 1, failedPaths).write();
+	double sequentialSeconds = printTiming("Scanner, 1 thread", start, paths.size(), megabytes);
+
+	start = Platform::getMonotonicMicroseconds();
+	TraceCoverage merged = mergeTraceFiles(paths, options.threads, failedPaths);
+	std::string parallel = merged.write();
+	std::string name = "Scanner, " + std::to_string(options.threads) + " threads";
+	double parallelSeconds = printTiming(name.c_str(), start, paths.size(), megabytes);
+
+	if (options.regexBaseline) {
+		// the regular expressions are two orders of magnitude slower, so they only scan a sample
+		std::vector<std::string> sample(paths.begin(), paths.begin() + std::min<size_t>(paths.size(), 100));
+		start = Platform::getMonotonicMicroseconds();
+		scanWithRegularExpressions(sample);
+		double regexSeconds = printTiming("Regex scan only, 1 thread", start, sample.size(), megabytes * sample.size() / paths.size());
+		regexSeconds *= static_cast<double>(paths.size()) / sample.size();
+		printf("\nSpeedup over the regex scan: %.1fx on 1 thread, %.1fx on %i threads\n", regexSeconds / sequentialSeconds,
+			regexSeconds / parallelSeconds, options.threads);
+	}
+	printf("\nParallel speedup: %.1fx. Merged %zu methods of %zu trace files\n", sequentialSeconds / parallelSeconds,
+		merged.getMethodCount(), merged.getTraceCount());
+
+	if (!failedPaths.empty()) {
+		fprintf(stderr, "Could not map %zu trace files, e.g. %s\n", failedPaths.size(), failedPaths[0].c_str());
+		return 1;
+	}
+	if (sequential != parallel) {
+		fprintf(stderr, "The parallel merge differs from the sequential one\n");
+		return 1;
+	}
+	return 0;
+}
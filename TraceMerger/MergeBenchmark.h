@@ -0,0 +1,23 @@
+#pragma once
+#include <string>
+
+/** Options of a merge benchmark run. */
+struct MergeBenchmarkOptions {
+	/** The directory with the trace files that the corpus is generated from. */
+	std::string referenceDirectory = "test-data/reference-traces";
+
+	/** Number of generated trace files. */
+	int files = 2000;
+
+	/** Number of threads of the parallel merge. */
+	int threads = 4;
+
+	/** Whether to also time a scan of the first 100 files with the upload daemon's regular expressions for comparison. */
+	bool regexBaseline = true;
+};
+
+/**
+ * Generates a corpus of trace files from the reference traces and times merging it on one and on several threads.
+ * Returns the exit code of the tool.
+ */
+int runMergeBenchmark(const MergeBenchmarkOptions& options);
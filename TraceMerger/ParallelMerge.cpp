@@ -0,0 +1,95 @@
+#include "ParallelMerge.h"
+#include "platform/MappedFile.h"
+#include "platform/Mutex.h"
+#include "platform/Platform.h"
+#include "platform/Thread.h"
+#include <atomic>
+#include <memory>
+
+/** The state shared by all merge threads. */
+struct MergeJob {
+	const std::vector<std::string>* paths;
+
+	/** The index of the next path to scan. */
+	std::atomic<size_t> nextPath;
+
+	/** Guards failedPaths. */
+	Mutex failedPathsSynchronization;
+	std::vector<std::string>* failedPaths;
+};
+
+/** The work of one merge thread. */
+struct MergeWorker {
+	MergeJob* job;
+	TraceCoverage coverage;
+};
+
+/** Scans files until all are taken. Small files make this balance better than splitting the paths up front. */
+static void runMergeWorker(void* parameter) {
+	MergeWorker* worker = static_cast<MergeWorker*>(parameter);
+	MergeJob* job = worker->job;
+	MappedFile file;
+	for (size_t i = job->nextPath++; i < job->paths->size(); i = job->nextPath++) {
+		const std::string& path = (*job->paths)[i];
+		if (!file.open(path)) {
+			job->failedPathsSynchronization.lock();
+			job->failedPaths->push_back(path);
+			job->failedPathsSynchronization.unlock();
+			continue;
+		}
+		worker->coverage.addTrace(file.getData(), file.getSize());
+	}
+	file.close();
+}
+
+/** Whether the given file name is one of a trace file, i.e. matches coverage_*.txt like in the upload daemon. */
+static bool isTraceFileName(const std::string& name) {
+	return name.compare(0, 9, "coverage_") == 0 && name.size() > 13 && name.compare(name.size() - 4, 4, ".txt") == 0;
+}
+
+void addTraceFiles(const std::string& path, std::vector<std::string>& paths) {
+	if (Platform::isFile(path)) {
+		paths.push_back(path);
+		return;
+	}
+	for (const std::string& name : Platform::listFiles(path)) {
+		if (isTraceFileName(name)) {
+			paths.push_back(path + Platform::PATH_SEPARATOR + name);
+		}
+	}
+}
+
+TraceCoverage mergeTraceFiles(const std::vector<std::string>& paths, int threadCount, std::vector<std::string>& failedPaths) {
+	MergeJob job;
+	job.paths = &paths;
+	job.nextPath = 0;
+	job.failedPaths = &failedPaths;
+
+	if (threadCount < 1) {
+		threadCount = 1;
+	}
+	std::vector<std::unique_ptr<MergeWorker>> workers;
+	std::vector<std::unique_ptr<Thread>> threads;
+	for (int i = 0; i < threadCount; i++) {
+		workers.emplace_back(new MergeWorker());
+		workers.back()->job = &job;
+	}
+
+	// the calling thread is the first worker
+	for (int i = 1; i < threadCount; i++) {
+		threads.emplace_back(new Thread());
+		if (!threads.back()->start(runMergeWorker, workers[i].get())) {
+			threads.pop_back();
+		}
+	}
+	runMergeWorker(workers[0].get());
+	for (std::unique_ptr<Thread>& thread : threads) {
+		thread->join(Platform::INFINITE_WAIT);
+	}
+
+	TraceCoverage merged;
+	for (std::unique_ptr<MergeWorker>& worker : workers) {
+		merged.merge(worker->coverage);
+	}
+	return merged;
+}
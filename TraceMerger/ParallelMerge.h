@@ -0,0 +1,14 @@
+#pragma once
+#include "TraceCoverage.h"
+#include <string>
+#include <vector>
+
+/** Adds the given file or, if it is a directory, the trace files in it, i.e. those named coverage_*.txt. */
+void addTraceFiles(const std::string& path, std::vector<std::string>& paths);
+
+/**
+ * Maps the given trace files and merges their coverage on the given number of threads. Each thread scans into its own
+ * TraceCoverage, which are merged once all files are scanned, so the threads share nothing but the next file index.
+ * Paths that cannot be mapped are added to failedPaths.
+ */
+TraceCoverage mergeTraceFiles(const std::vector<std::string>& paths, int threadCount, std::vector<std::string>& failedPaths);
@@ -0,0 +1,299 @@
+#include "TraceCoverage.h"
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+
+/** Marks assembly numbers of a trace without an Assembly= line. */
+static const size_t NO_ASSEMBLY = static_cast<size_t>(-1);
+
+/** The table of method definitions, which all jitted and inlined methods belong to. */
+static const uint32_t METHOD_DEF_TABLE = 0x06000000;
+
+/** Returns the position after the given prefix if the line starts with it or NULL otherwise. */
+static const char* skipPrefix(const char* line, const char* end, const char* prefix, size_t prefixLength) {
+	if (static_cast<size_t>(end - line) < prefixLength || memcmp(line, prefix, prefixLength) != 0) {
+		return NULL;
+	}
+	return line + prefixLength;
+}
+
+/** Parses a decimal number and advances the position behind it. Returns false if there is no digit. */
+static bool parseNumber(const char*& position, const char* end, uint32_t& value) {
+	const char* start = position;
+	value = 0;
+	while (position < end && *position >= '0' && *position <= '9') {
+		value = value * 10 + static_cast<uint32_t>(*position - '0');
+		position++;
+	}
+	return position > start;
+}
+
+/**
+ * Parses the value of a coverage line, i.e. "<assembly>:<token>" or "<assembly>:<anything>:<token>" like the
+ * upload daemon does. Returns false if the line is malformed.
+ */
+static bool parseMethod(const char* position, const char* end, uint32_t& assemblyNumber, uint32_t& token) {
+	if (!parseNumber(position, end, assemblyNumber) || position >= end || *position != ':') {
+		return false;
+	}
+	position++;
+	if (!parseNumber(position, end, token)) {
+		return false;
+	}
+	if (position < end && *position == ':') {
+		position++;
+		return parseNumber(position, end, token);
+	}
+	return true;
+}
+
+/** Returns the value of the attribute with the given key, e.g. " Mvid:", or the empty string. */
+static std::string getAttribute(const std::string& attributes, const char* key) {
+	size_t start = attributes.find(key);
+	if (start == std::string::npos) {
+		return "";
+	}
+	start += strlen(key);
+	size_t end = attributes.find(' ', start);
+	return attributes.substr(start, end == std::string::npos ? std::string::npos : end - start);
+}
+
+void TraceCoverage::addTrace(const char* data, size_t size) {
+	traceCount++;
+
+	// Assembly numbers are small and consecutive, so a vector maps them to indices in assemblies
+	std::vector<size_t> indicesByNumber;
+	std::vector<PendingMethod> pendingMethods;
+
+	const char* end = data + size;
+	const char* line = data;
+	while (line < end) {
+		const char* lineEnd = static_cast<const char*>(memchr(line, '\n', end - line));
+		const char* nextLine = end;
+		if (lineEnd == NULL) {
+			lineEnd = end;
+		}
+		else {
+			nextLine = lineEnd + 1;
+		}
+		if (lineEnd > line && lineEnd[-1] == '\r') {
+			lineEnd--;
+		}
+
+		const char* value = NULL;
+		Kind kind = JITTED;
+		switch (*line) {
+		case 'J':
+			value = skipPrefix(line, lineEnd, "Jitted=", 7);
+			break;
+		case 'I':
+			value = skipPrefix(line, lineEnd, "Inlined=", 8);
+			kind = INLINED;
+			break;
+		case 'A':
+			value = skipPrefix(line, lineEnd, "Assembly=", 9);
+			if (value != NULL) {
+				const char* separator = static_cast<const char*>(memchr(value, ':', lineEnd - value));
+				const char* position = separator + 1;
+				uint32_t number = 0;
+				if (separator != NULL && parseNumber(position, lineEnd, number)) {
+					size_t index = getAssemblyIndex(std::string(value, separator), std::string(position, lineEnd));
+					if (number >= indicesByNumber.size()) {
+						indicesByNumber.resize(number + 1, NO_ASSEMBLY);
+					}
+					indicesByNumber[number] = index;
+				}
+			}
+			value = NULL;
+			break;
+		case 'P':
+			value = skipPrefix(line, lineEnd, "Process=", 8);
+			if (value != NULL) {
+				addProcess(std::string(value, lineEnd));
+			}
+			value = NULL;
+			break;
+		case 'S':
+			value = skipPrefix(line, lineEnd, "Started=", 8);
+			if (value != NULL) {
+				addStarted(std::string(value, lineEnd));
+			}
+			value = skipPrefix(line, lineEnd, "Stopped=", 8);
+			if (value != NULL) {
+				addStopped(std::string(value, lineEnd));
+			}
+			value = NULL;
+			break;
+		}
+
+		uint32_t assemblyNumber = 0;
+		uint32_t token = 0;
+		if (value != NULL && parseMethod(value, lineEnd, assemblyNumber, token)) {
+			if (assemblyNumber < indicesByNumber.size() && indicesByNumber[assemblyNumber] != NO_ASSEMBLY) {
+				setMethod(assemblies[indicesByNumber[assemblyNumber]].bitmaps[kind], token);
+			}
+			else {
+				// Assembly= lines normally come first, but the file does not guarantee it
+				pendingMethods.push_back({ assemblyNumber, token, kind });
+			}
+		}
+		line = nextLine;
+	}
+
+	for (PendingMethod& method : pendingMethods) {
+		if (method.assemblyNumber < indicesByNumber.size() && indicesByNumber[method.assemblyNumber] != NO_ASSEMBLY) {
+			setMethod(assemblies[indicesByNumber[method.assemblyNumber]].bitmaps[method.kind], method.token);
+		}
+		else {
+			unresolvedLineCount++;
+		}
+	}
+}
+
+size_t TraceCoverage::getAssemblyIndex(const std::string& name, const std::string& attributes) {
+	std::string identity = name + "\t" + getAttribute(attributes, " Mvid:");
+	if (identity.size() == name.size() + 1) {
+		identity += "Version:" + getAttribute(attributes, " Version:");
+	}
+
+	std::unordered_map<std::string, size_t>::iterator known = assemblyIndices.find(identity);
+	if (known != assemblyIndices.end()) {
+		// e.g. the path differs between processes. Keep the smallest attributes, so the result does not depend on the order
+		Assembly& assembly = assemblies[known->second];
+		if (attributes < assembly.attributes) {
+			assembly.attributes = attributes;
+		}
+		return known->second;
+	}
+
+	assemblies.push_back(Assembly());
+	assemblies.back().name = name;
+	assemblies.back().attributes = attributes;
+	assemblyIndices[identity] = assemblies.size() - 1;
+	return assemblies.size() - 1;
+}
+
+uint32_t TraceCoverage::getRid(size_t word, uint64_t bits) {
+	return static_cast<uint32_t>(word * 64 + std::bitset<64>((bits & (0 - bits)) - 1).count());
+}
+
+void TraceCoverage::setMethod(std::vector<uint64_t>& bitmap, uint32_t token) {
+	uint32_t rid = token & 0x00FFFFFF;
+	if (rid / 64 >= bitmap.size()) {
+		bitmap.resize(rid / 64 + 1);
+	}
+	bitmap[rid / 64] |= static_cast<uint64_t>(1) << (rid % 64);
+}
+
+void TraceCoverage::addProcess(const std::string& process) {
+	if (std::find(processes.begin(), processes.end(), process) == processes.end()) {
+		processes.push_back(process);
+	}
+}
+
+void TraceCoverage::addStarted(const std::string& timestamp) {
+	if (started.empty() || timestamp < started) {
+		started = timestamp;
+	}
+}
+
+void TraceCoverage::addStopped(const std::string& timestamp) {
+	if (timestamp > stopped) {
+		stopped = timestamp;
+	}
+}
+
+void TraceCoverage::merge(const TraceCoverage& other) {
+	traceCount += other.traceCount;
+	unresolvedLineCount += other.unresolvedLineCount;
+	for (const std::string& process : other.processes) {
+		addProcess(process);
+	}
+	if (!other.started.empty()) {
+		addStarted(other.started);
+	}
+	addStopped(other.stopped);
+
+	for (const Assembly& otherAssembly : other.assemblies) {
+		Assembly& assembly = assemblies[getAssemblyIndex(otherAssembly.name, otherAssembly.attributes)];
+		for (int kind = 0; kind < KIND_COUNT; kind++) {
+			const std::vector<uint64_t>& otherBitmap = otherAssembly.bitmaps[kind];
+			std::vector<uint64_t>& bitmap = assembly.bitmaps[kind];
+			if (otherBitmap.size() > bitmap.size()) {
+				bitmap.resize(otherBitmap.size());
+			}
+			for (size_t i = 0; i < otherBitmap.size(); i++) {
+				bitmap[i] |= otherBitmap[i];
+			}
+		}
+	}
+}
+
+size_t TraceCoverage::getMethodCount() const {
+	size_t count = 0;
+	for (const Assembly& assembly : assemblies) {
+		const std::vector<uint64_t>& jitted = assembly.bitmaps[JITTED];
+		const std::vector<uint64_t>& inlined = assembly.bitmaps[INLINED];
+		for (size_t i = 0; i < std::max(jitted.size(), inlined.size()); i++) {
+			uint64_t methods = (i < jitted.size() ? jitted[i] : 0) | (i < inlined.size() ? inlined[i] : 0);
+			count += std::bitset<64>(methods).count();
+		}
+	}
+	return count;
+}
+
+std::vector<uint32_t> TraceCoverage::getMethods(size_t assembly) const {
+	std::vector<uint32_t> tokens;
+	const std::vector<uint64_t>& jitted = assemblies[assembly].bitmaps[JITTED];
+	const std::vector<uint64_t>& inlined = assemblies[assembly].bitmaps[INLINED];
+	for (size_t word = 0; word < std::max(jitted.size(), inlined.size()); word++) {
+		uint64_t methods = (word < jitted.size() ? jitted[word] : 0) | (word < inlined.size() ? inlined[word] : 0);
+		for (; methods != 0; methods &= methods - 1) {
+			tokens.push_back(METHOD_DEF_TABLE | getRid(word, methods));
+		}
+	}
+	return tokens;
+}
+
+std::string TraceCoverage::write() const {
+	std::vector<size_t> order;
+	for (size_t i = 0; i < assemblies.size(); i++) {
+		order.push_back(i);
+	}
+	std::sort(order.begin(), order.end(), [this](size_t first, size_t second) {
+		const Assembly& a = assemblies[first];
+		const Assembly& b = assemblies[second];
+		return a.name < b.name || (a.name == b.name && a.attributes < b.attributes);
+	});
+
+	std::string output = "Info=Merged " + std::to_string(traceCount) + " trace files\r\n";
+	if (!started.empty()) {
+		output += "Started=" + started + "\r\n";
+	}
+	if (!processes.empty()) {
+		output += "Process=" + *std::min_element(processes.begin(), processes.end()) + "\r\n";
+	}
+	for (size_t number = 1; number <= order.size(); number++) {
+		const Assembly& assembly = assemblies[order[number - 1]];
+		output += "Assembly=" + assembly.name + ":" + std::to_string(number) + assembly.attributes + "\r\n";
+	}
+
+	const char* keys[KIND_COUNT] = { "Jitted=", "Inlined=" };
+	char line[64];
+	for (int kind = INLINED; kind >= JITTED; kind--) {
+		for (size_t number = 1; number <= order.size(); number++) {
+			const std::vector<uint64_t>& bitmap = assemblies[order[number - 1]].bitmaps[kind];
+			for (size_t word = 0; word < bitmap.size(); word++) {
+				for (uint64_t bits = bitmap[word]; bits != 0; bits &= bits - 1) {
+					int length = snprintf(line, sizeof(line), "%s%zu:%u\r\n", keys[kind], number, METHOD_DEF_TABLE | getRid(word, bits));
+					output.append(line, length);
+				}
+			}
+		}
+	}
+
+	if (!stopped.empty()) {
+		output += "Stopped=" + stopped + "\r\n";
+	}
+	return output;
+}
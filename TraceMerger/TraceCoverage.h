@@ -0,0 +1,112 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * The methods that one or more trace files report as jitted or inlined, as one bitmap of method RIDs per assembly.
+ *
+ * Assembly numbers are only valid within their trace file, so assemblies are identified across files by their name
+ * and MVID, or by their name and version for traces written without MVIDs. Like the upload daemon, all other lines
+ * (e.g. test segments, blocks or calls) are ignored, so a merged trace contains the union of all method coverage.
+ *
+ * Not thread-safe. Parallel merges scan into one object per thread and merge those at the end.
+ */
+class TraceCoverage
+{
+public:
+	/** Scans the given contents of a trace file and adds their coverage. */
+	void addTrace(const char* data, size_t size);
+
+	/** Adds all coverage of the given object. */
+	void merge(const TraceCoverage& other);
+
+	/** Writes the merged coverage in the format of the profiler's trace files, with assemblies sorted by identity. */
+	std::string write() const;
+
+	/** The number of trace files that were added. */
+	size_t getTraceCount() const {
+		return traceCount;
+	}
+
+	/** The number of distinct Process= lines, which should be 1 as the upload daemon maps each trace by its process. */
+	size_t getProcessCount() const {
+		return processes.size();
+	}
+
+	/** The number of coverage lines that referenced an assembly number without an Assembly= line. */
+	size_t getUnresolvedLineCount() const {
+		return unresolvedLineCount;
+	}
+
+	/** The number of distinct covered methods. */
+	size_t getMethodCount() const;
+
+	/** The number of distinct assemblies. */
+	size_t getAssemblyCount() const {
+		return assemblies.size();
+	}
+
+	/** The name of the assembly with the given index. */
+	const std::string& getAssemblyName(size_t assembly) const {
+		return assemblies[assembly].name;
+	}
+
+	/** Returns the tokens of the jitted or inlined methods of the assembly with the given index in ascending order. */
+	std::vector<uint32_t> getMethods(size_t assembly) const;
+
+private:
+	/** Coverage line kinds, which index the bitmaps. */
+	enum Kind {
+		JITTED = 0,
+		INLINED = 1,
+		KIND_COUNT = 2,
+	};
+
+	/** An assembly and the RIDs of its covered methods. */
+	struct Assembly {
+		/** The assembly name. */
+		std::string name;
+		/** The rest of its Assembly= line after the number, e.g. " Version:1.0.0.0 Mvid:...". */
+		std::string attributes;
+		std::vector<uint64_t> bitmaps[KIND_COUNT];
+	};
+
+	/** A coverage line whose Assembly= line was not scanned yet. */
+	struct PendingMethod {
+		uint32_t assemblyNumber;
+		uint32_t token;
+		Kind kind;
+	};
+
+	std::vector<Assembly> assemblies;
+
+	/** Maps identities to indices in assemblies. */
+	std::unordered_map<std::string, size_t> assemblyIndices;
+
+	/** All distinct Process= lines. */
+	std::vector<std::string> processes;
+
+	/** The earliest Started= and latest Stopped= timestamps, which sort like the times. */
+	std::string started;
+	std::string stopped;
+
+	size_t traceCount = 0;
+	size_t unresolvedLineCount = 0;
+
+	/** Returns the index of the assembly with the given name and attributes, adding it if it is new. */
+	size_t getAssemblyIndex(const std::string& name, const std::string& attributes);
+
+	/** Returns the RID of the lowest set bit of the given word of a bitmap. */
+	static uint32_t getRid(size_t word, uint64_t bits);
+
+	/** Sets the bit of the given token's RID in the bitmap. */
+	static void setMethod(std::vector<uint64_t>& bitmap, uint32_t token);
+
+	/** Adds a Process=, Started= or Stopped= value. */
+	void addProcess(const std::string& process);
+	void addStarted(const std::string& timestamp);
+	void addStopped(const std::string& timestamp);
+};
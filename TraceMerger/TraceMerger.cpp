@@ -0,0 +1,86 @@
+#include "MergeBenchmark.h"
+#include "ParallelMerge.h"
+#include "platform/Platform.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * Merges the method coverage of many trace files into one trace file, e.g. to upload one trace per day instead of
+ * tens of thousands. The files are memory-mapped, scanned in parallel and merged as one bitmap of method RIDs per
+ * assembly. See TraceCoverage for which lines are kept.
+ *
+ * Usage: TraceMerger.exe [--threads=N] --out=<merged trace> <trace file or directory>...
+ *        TraceMerger.exe --benchmark [--threads=N] [--files=N] [--reference=<directory>]
+ *
+ * Directories are expanded to the coverage_*.txt files they contain. The merged trace should not be written to one
+ * of these directories, or the next merge would count it twice.
+ */
+
+/** Returns the value of the given integer option or the default value if the argument is not that option. */
+static int parseIntOption(const std::string& argument, const std::string& name, int defaultValue) {
+	std::string prefix = "--" + name + "=";
+	if (argument.compare(0, prefix.size(), prefix) != 0) {
+		return defaultValue;
+	}
+	return atoi(argument.substr(prefix.size()).c_str());
+}
+
+int main(int argc, char** argv) {
+	MergeBenchmarkOptions benchmarkOptions;
+	benchmarkOptions.threads = Platform::getProcessorCount();
+	bool benchmark = false;
+	std::string outputPath;
+	std::vector<std::string> paths;
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		if (argument.compare(0, 2, "--") != 0) {
+			addTraceFiles(argument, paths);
+			continue;
+		}
+		benchmarkOptions.threads = parseIntOption(argument, "threads", benchmarkOptions.threads);
+		benchmarkOptions.files = parseIntOption(argument, "files", benchmarkOptions.files);
+		if (argument.compare(0, 6, "--out=") == 0) {
+			outputPath = argument.substr(6);
+		}
+		if (argument.compare(0, 12, "--reference=") == 0) {
+			benchmarkOptions.referenceDirectory = argument.substr(12);
+		}
+		if (argument == "--benchmark") {
+			benchmark = true;
+		}
+	}
+
+	if (benchmark) {
+		return runMergeBenchmark(benchmarkOptions);
+	}
+	if (outputPath.empty() || paths.empty()) {
+		fprintf(stderr, "Usage: TraceMerger [--threads=N] --out=<merged trace> <trace file or directory>...\n");
+		fprintf(stderr, "       TraceMerger --benchmark [--threads=N] [--files=N] [--reference=<directory>]\n");
+		return 2;
+	}
+
+	std::vector<std::string> failedPaths;
+	TraceCoverage merged = mergeTraceFiles(paths, benchmarkOptions.threads, failedPaths);
+	for (const std::string& path : failedPaths) {
+		fprintf(stderr, "Could not read %s\n", path.c_str());
+	}
+	if (merged.getProcessCount() > 1) {
+		fprintf(stderr, "The traces belong to %zu processes. The merged trace only names the first one\n", merged.getProcessCount());
+	}
+	if (merged.getUnresolvedLineCount() > 0) {
+		fprintf(stderr, "Skipped %zu coverage lines without an Assembly= line\n", merged.getUnresolvedLineCount());
+	}
+
+	std::ofstream output(outputPath, std::ios::binary);
+	output << merged.write();
+	output.close();
+	if (!output) {
+		fprintf(stderr, "Could not write %s\n", outputPath.c_str());
+		return 1;
+	}
+	printf("Merged %zu methods of %zu trace files into %s\n", merged.getMethodCount(), merged.getTraceCount(), outputPath.c_str());
+	return failedPaths.empty() ? 0 : 1;
+}
@@ -0,0 +1,19 @@
+namespace PortablePdbSample
+{
+    public class Calculator
+    {
+        public int Add(int first, int second)
+        {
+            return first + second;
+        }
+
+        public int Max(int first, int second)
+        {
+            if (first > second)
+            {
+                return first;
+            }
+            return second;
+        }
+    }
+}
@@ -0,0 +1,20 @@
+using System.Collections.Generic;
+
+namespace PortablePdbSample
+{
+    public class Greeter
+    {
+        public string Greet(string name)
+        {
+            return "Hello " + name;
+        }
+
+        public IEnumerable<int> Count(int limit)
+        {
+            for (int i = 0; i < limit; i++)
+            {
+                yield return i;
+            }
+        }
+    }
+}